@@ -0,0 +1,49 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "bench_utils.h"
+#include <map>
+#include <mutex>
+
+namespace sanescan {
+
+const SyntheticPage& get_synthetic_page(int dpi)
+{
+    static std::mutex mutex;
+    static std::map<int, SyntheticPage> pages;
+
+    std::lock_guard lock{mutex};
+    auto it = pages.find(dpi);
+    if (it == pages.end()) {
+        SyntheticPageOptions options;
+        options.dpi = dpi;
+        it = pages.emplace(dpi, generate_synthetic_page(options)).first;
+    }
+    return it->second;
+}
+
+void apply_dpi_args(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgName("dpi");
+    for (auto dpi : BENCH_DPIS) {
+        bench->Arg(dpi);
+    }
+}
+
+} // namespace sanescan
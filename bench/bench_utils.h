@@ -0,0 +1,47 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_BENCH_BENCH_UTILS_H
+#define SANESCAN_BENCH_BENCH_UTILS_H
+
+#include "synthetic_page.h"
+#include <benchmark/benchmark.h>
+
+namespace sanescan {
+
+/// Resolutions at which all image benchmarks are run
+inline constexpr int BENCH_DPIS[] = {150, 300, 600};
+
+/** Returns a deterministic synthetic page rendered at the given resolution. Pages are generated
+    once per resolution and cached, so that the setup cost does not affect measurements.
+*/
+const SyntheticPage& get_synthetic_page(int dpi);
+
+/// Registers benchmark arguments for each of the resolutions in BENCH_DPIS
+void apply_dpi_args(benchmark::internal::Benchmark* bench);
+
+/// Environment variable pointing to a directory of captured OCR bundles to benchmark
+inline constexpr const char* BENCH_BUNDLE_DIR_ENV_VARIABLE = "SANESCAN_BENCH_BUNDLE_DIR";
+
+/// Registers a benchmark for each OCR bundle in the directory given by the environment variable
+void register_bundle_benchmarks();
+
+} // namespace sanescan
+
+#endif // SANESCAN_BENCH_BENCH_UTILS_H
@@ -0,0 +1,92 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "../bench_utils.h"
+#include "lib/buffer_manager.h"
+#include <algorithm>
+#include <cstring>
+
+namespace sanescan {
+
+namespace {
+
+// Mirrors the limits used by SaneDeviceWrapper
+constexpr std::size_t MAX_BUFFER_SIZE = 128 * 1024 * 1024;
+constexpr std::size_t MAX_SINGLE_READ_SIZE = 128 * 1024;
+constexpr std::size_t MIN_SINGLE_READ_LINES = 16;
+
+/*  Simulates transfer of a whole color page through the buffer manager in the same chunk sizes
+    as SaneDeviceWrapper uses. The reader trails the writer by the given number of chunks to
+    exercise sub-buffer reuse.
+*/
+void BM_BufferManagerPageTransfer(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    std::size_t read_lag = state.range(1);
+
+    std::size_t lines = page.image.size.p[0];
+    std::size_t line_bytes = page.image.step[0];
+    std::size_t chunk_lines = std::max(MIN_SINGLE_READ_LINES, MAX_SINGLE_READ_SIZE / line_bytes);
+    const char* src_data = reinterpret_cast<const char*>(page.image.data);
+
+    BufferManager manager{MAX_BUFFER_SIZE};
+    std::vector<char> dst_data(lines * line_bytes);
+
+    auto read_one = [&]()
+    {
+        auto read = manager.get_read();
+        if (!read.has_value()) {
+            return false;
+        }
+        std::memcpy(dst_data.data() + read->first_line() * line_bytes, read->data(),
+                    read->size());
+        read->finish();
+        return true;
+    };
+
+    for (auto _ : state) {
+        std::size_t pending_reads = 0;
+        for (std::size_t first_line = 0; first_line < lines; first_line += chunk_lines) {
+            auto last_line = std::min(lines, first_line + chunk_lines);
+            auto write = manager.get_write(first_line, last_line, line_bytes);
+            if (!write.has_value()) {
+                state.SkipWithError("Buffer manager is full");
+                return;
+            }
+            std::memcpy(write->data(), src_data + first_line * line_bytes, write->size());
+            write->finish(write->size());
+
+            if (++pending_reads > read_lag && read_one()) {
+                pending_reads--;
+            }
+        }
+        while (read_one()) {}
+        manager.reset();
+        benchmark::DoNotOptimize(dst_data.data());
+    }
+    state.SetBytesProcessed(state.iterations() * lines * line_bytes);
+}
+BENCHMARK(BM_BufferManagerPageTransfer)
+    ->ArgNames({"dpi", "read_lag"})
+    ->ArgsProduct({{std::begin(BENCH_DPIS), std::end(BENCH_DPIS)}, {0, 8}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+} // namespace sanescan
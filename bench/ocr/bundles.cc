@@ -0,0 +1,64 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "../bench_utils.h"
+#include "ocr/ocr_bundle.h"
+#include "ocr/ocr_pipeline_run.h"
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+
+namespace sanescan {
+
+namespace {
+
+void run_bundle(benchmark::State& state, const std::shared_ptr<const OcrBundle>& bundle)
+{
+    for (auto _ : state) {
+        OcrPipelineRun run{bundle->source_image, bundle->options, bundle->old_options,
+                           bundle->old_results};
+        setup_ocr_bundle_run(run, *bundle);
+        run.execute();
+        benchmark::DoNotOptimize(run.results().paragraphs.data());
+    }
+    state.counters["recorded_sec"] = bundle->duration_sec;
+}
+
+} // namespace
+
+void register_bundle_benchmarks()
+{
+    const char* dir = std::getenv(BENCH_BUNDLE_DIR_ENV_VARIABLE);
+    if (dir == nullptr || *dir == '\0') {
+        return;
+    }
+
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (!entry.is_directory()) {
+            continue;
+        }
+        auto bundle = std::make_shared<const OcrBundle>(read_ocr_bundle(entry.path()));
+        auto name = "BM_OcrBundle/" + entry.path().filename().string();
+        benchmark::RegisterBenchmark(name.c_str(), run_bundle, bundle)
+                ->Unit(benchmark::kMillisecond)
+                ->UseRealTime();
+    }
+}
+
+} // namespace sanescan
@@ -0,0 +1,60 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "../bench_utils.h"
+#include "ocr/hocr.h"
+#include <sstream>
+
+namespace sanescan {
+
+namespace {
+
+void BM_WriteHocr(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    std::size_t output_size = 0;
+
+    for (auto _ : state) {
+        std::ostringstream stream;
+        write_hocr(stream, page.paragraphs);
+        output_size = stream.tellp();
+    }
+    state.SetBytesProcessed(state.iterations() * output_size);
+}
+BENCHMARK(BM_WriteHocr)->Apply(apply_dpi_args)->Unit(benchmark::kMillisecond);
+
+void BM_ReadHocr(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    std::ostringstream output;
+    write_hocr(output, page.paragraphs);
+    auto hocr = output.str();
+
+    for (auto _ : state) {
+        std::istringstream stream(hocr);
+        auto paragraphs = read_hocr(stream);
+        benchmark::DoNotOptimize(paragraphs.data());
+    }
+    state.SetBytesProcessed(state.iterations() * hocr.size());
+}
+BENCHMARK(BM_ReadHocr)->Apply(apply_dpi_args)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+} // namespace sanescan
@@ -0,0 +1,118 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "../bench_utils.h"
+#include "ocr/blur_detection.h"
+#include "ocr/line_erasure.h"
+#include "ocr/ocr_options.h"
+#include "ocr/tesseract.h"
+#include "util/image.h"
+#include "util/math.h"
+#include <leptonica/allheaders.h>
+
+namespace sanescan {
+
+namespace {
+
+void set_pixels_processed(benchmark::State& state, const cv::Mat& image)
+{
+    state.SetItemsProcessed(state.iterations() * image.total());
+}
+
+void BM_CvMatToPix(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    for (auto _ : state) {
+        auto* pix = cv_mat_to_pix(page.image);
+        benchmark::DoNotOptimize(pix);
+        pixDestroy(&pix);
+    }
+    set_pixels_processed(state, page.image);
+}
+BENCHMARK(BM_CvMatToPix)->Apply(apply_dpi_args)->Unit(benchmark::kMillisecond);
+
+void BM_ImageColorToGray(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    for (auto _ : state) {
+        auto gray = image_color_to_gray(page.image);
+        benchmark::DoNotOptimize(gray.data);
+    }
+    set_pixels_processed(state, page.image);
+}
+BENCHMARK(BM_ImageColorToGray)->Apply(apply_dpi_args)->Unit(benchmark::kMillisecond);
+
+void BM_EraseStraightVHLines(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto image = page.image.clone();
+        state.ResumeTiming();
+        // Same parameters as used in OcrPipelineRun
+        erase_straight_vh_lines(image, page.image_gray, 4, 4, 100);
+        benchmark::DoNotOptimize(image.data);
+    }
+    set_pixels_processed(state, page.image);
+}
+BENCHMARK(BM_EraseStraightVHLines)->Apply(apply_dpi_args)->Unit(benchmark::kMillisecond);
+
+void BM_ComputeBlurData(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    for (auto _ : state) {
+        auto data = compute_blur_data(page.image_gray);
+        benchmark::DoNotOptimize(data.sobel_transform.data);
+    }
+    set_pixels_processed(state, page.image_gray);
+}
+BENCHMARK(BM_ComputeBlurData)->Apply(apply_dpi_args)->Unit(benchmark::kMillisecond);
+
+void BM_DetectBlurAreas(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    auto data = compute_blur_data(page.image_gray);
+    for (auto _ : state) {
+        auto areas = detect_blur_areas(data, page.paragraphs,
+                                       OcrOptions{}.blur_detection_coef);
+        benchmark::DoNotOptimize(areas.data());
+    }
+    set_pixels_processed(state, page.image_gray);
+}
+BENCHMARK(BM_DetectBlurAreas)->Apply(apply_dpi_args)->Unit(benchmark::kMillisecond);
+
+void BM_ImageRotateCentered(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    // Slight skew, which is the common case when fixing text rotation
+    auto angle = deg_to_rad(state.range(1) / 10.0);
+    for (auto _ : state) {
+        auto rotated = image_rotate_centered(page.image, angle);
+        benchmark::DoNotOptimize(rotated.data);
+    }
+    set_pixels_processed(state, page.image);
+}
+BENCHMARK(BM_ImageRotateCentered)
+    ->ArgNames({"dpi", "decideg"})
+    ->ArgsProduct({{std::begin(BENCH_DPIS), std::end(BENCH_DPIS)}, {15, 900}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+} // namespace sanescan
@@ -0,0 +1,65 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "../bench_utils.h"
+#include "ocr/ocr_utils.h"
+#include "util/math.h"
+#include <opencv2/core.hpp>
+
+namespace sanescan {
+
+namespace {
+
+void BM_GetAllTextAngles(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    for (auto _ : state) {
+        auto angles = get_all_text_angles(page.paragraphs);
+        benchmark::DoNotOptimize(angles.data());
+    }
+}
+BENCHMARK(BM_GetAllTextAngles)->Apply(apply_dpi_args)->Unit(benchmark::kMicrosecond);
+
+// The number of input angles is the parameter, as it does not depend on the resolution
+void BM_GetDominantAngle(benchmark::State& state)
+{
+    cv::RNG rng(state.range(0));
+    std::vector<std::pair<double, double>> angles;
+    for (std::int64_t i = 0; i < state.range(0); ++i) {
+        // Mostly slightly skewed text with some vertical text and outliers
+        auto angle = rng.uniform(0, 10) == 0 ? rng.uniform(0.0, deg_to_rad(360))
+                                             : rng.gaussian(deg_to_rad(1)) + deg_to_rad(2);
+        if (rng.uniform(0, 5) == 0) {
+            angle += deg_to_rad(90);
+        }
+        angles.emplace_back(angle, rng.uniform(1, 12));
+    }
+
+    for (auto _ : state) {
+        auto result = get_dominant_angle(angles, deg_to_rad(90), deg_to_rad(5));
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * angles.size());
+}
+BENCHMARK(BM_GetDominantAngle)->RangeMultiplier(8)->Range(64, 32768)
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+} // namespace sanescan
@@ -0,0 +1,91 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "../bench_utils.h"
+#include "ocr/pdf.h"
+#include "ocr/pdf_canvas.h"
+#include <sstream>
+
+namespace sanescan {
+
+namespace {
+
+std::size_t count_words(const std::vector<OcrParagraph>& paragraphs)
+{
+    std::size_t count = 0;
+    for (const auto& par : paragraphs) {
+        for (const auto& line : par.lines) {
+            count += line.words.size();
+        }
+    }
+    return count;
+}
+
+// Emits the same kind of operator stream as PdfWriter does for the invisible text layer
+void BM_PdfCanvasTextLayer(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    double height = page.image.size.p[0];
+
+    for (auto _ : state) {
+        PdfCanvas canvas;
+        for (const auto& par : page.paragraphs) {
+            for (const auto& line : par.lines) {
+                canvas.begin_text();
+                canvas.set_text_mode(PdfCanvas::TextMode::INVISIBLE);
+                auto matrix = compute_affine_matrix_for_line(line.baseline.angle);
+                canvas.set_text_matrix(matrix.a, matrix.b, matrix.c, matrix.d,
+                                       line.box.x1, height - line.box.y2);
+                double old_x = line.box.x1;
+                for (const auto& word : line.words) {
+                    canvas.translate_text_matrix(word.box.x1 - old_x, 0);
+                    old_x = word.box.x1;
+                    canvas.set_font("F1", word.font_size);
+                    canvas.set_horizontal_stretch(100);
+                    canvas.show_text(boost::locale::conv::utf_to_utf<char32_t>(word.content));
+                }
+                canvas.end_text();
+                canvas.separator();
+            }
+        }
+        auto result = canvas.get_string();
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count_words(page.paragraphs));
+}
+BENCHMARK(BM_PdfCanvasTextLayer)->Apply(apply_dpi_args)->Unit(benchmark::kMicrosecond);
+
+void BM_WritePdf(benchmark::State& state)
+{
+    const auto& page = get_synthetic_page(state.range(0));
+    std::size_t output_size = 0;
+
+    for (auto _ : state) {
+        std::ostringstream stream;
+        write_pdf(stream, page.image, page.paragraphs);
+        output_size = stream.tellp();
+    }
+    state.SetItemsProcessed(state.iterations() * count_words(page.paragraphs));
+    state.counters["output_bytes"] = output_size;
+}
+BENCHMARK(BM_WritePdf)->Apply(apply_dpi_args)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+} // namespace sanescan
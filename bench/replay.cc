@@ -0,0 +1,240 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*  Replays OCR bundles captured by sanescan (see OcrCaptureOptions) and compares the timings of
+    the pipeline stages with the timings of the original run.
+*/
+
+#include "ocr/ocr_bundle.h"
+#include "ocr/ocr_pipeline_run.h"
+#include "ocr/tesseract.h"
+#include "util/trace.h"
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace sanescan {
+
+namespace {
+
+struct StageSummary {
+    double recorded_sec = 0;
+    std::vector<double> replayed_sec;
+};
+
+struct BundleSummary {
+    std::string path;
+    std::string recorded_versions;
+    double recorded_sec = 0;
+    std::vector<double> replayed_sec;
+    // Stages in the order of the first execution
+    std::vector<std::string> stage_order;
+    std::map<std::string, StageSummary> stages;
+};
+
+double median(std::vector<double> values)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+void add_stage_timings(BundleSummary& summary, const std::vector<OcrStageTiming>& timings,
+                       bool recorded)
+{
+    // Stages may repeat, e.g. when multiple regions are recognized. Their durations are summed.
+    std::map<std::string, double> durations;
+    for (const auto& timing : timings) {
+        if (!summary.stages.count(timing.name)) {
+            summary.stage_order.push_back(timing.name);
+        }
+        summary.stages[timing.name];
+        durations[timing.name] += timing.duration_sec;
+    }
+    for (const auto& [name, duration] : durations) {
+        if (recorded) {
+            summary.stages[name].recorded_sec = duration;
+        } else {
+            summary.stages[name].replayed_sec.push_back(duration);
+        }
+    }
+}
+
+BundleSummary replay_bundle(const std::string& path, unsigned iterations)
+{
+    auto bundle = read_ocr_bundle(path);
+
+    BundleSummary summary;
+    summary.path = path;
+    summary.recorded_versions = "sanescan " + bundle.sanescan_version +
+            ", tesseract " + bundle.tesseract_version;
+    summary.recorded_sec = bundle.duration_sec;
+    add_stage_timings(summary, bundle.stage_timings, true);
+
+    for (unsigned i = 0; i < iterations; ++i) {
+        OcrPipelineRun run{bundle.source_image, bundle.options, bundle.old_options,
+                           bundle.old_results};
+        setup_ocr_bundle_run(run, bundle);
+        auto start = std::chrono::steady_clock::now();
+        run.execute();
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+        summary.replayed_sec.push_back(duration.count());
+        add_stage_timings(summary, run.stage_timings(), false);
+    }
+    return summary;
+}
+
+void print_summary(std::ostream& stream, const BundleSummary& summary)
+{
+    stream << summary.path << " (recorded with " << summary.recorded_versions << ")\n"
+           << std::fixed << std::setprecision(3)
+           << "  " << std::left << std::setw(24) << "stage" << std::right
+           << std::setw(14) << "recorded (s)" << std::setw(14) << "median (s)"
+           << std::setw(14) << "min (s)" << "\n";
+
+    auto print_row = [&](const std::string& name, double recorded,
+                         const std::vector<double>& replayed)
+    {
+        auto min = replayed.empty() ? 0 : *std::min_element(replayed.begin(), replayed.end());
+        stream << "  " << std::left << std::setw(24) << name << std::right
+               << std::setw(14) << recorded << std::setw(14) << median(replayed)
+               << std::setw(14) << min << "\n";
+    };
+
+    for (const auto& name : summary.stage_order) {
+        const auto& stage = summary.stages.at(name);
+        print_row(name, stage.recorded_sec, stage.replayed_sec);
+    }
+    print_row("total", summary.recorded_sec, summary.replayed_sec);
+}
+
+void write_json(std::ostream& stream, const std::vector<BundleSummary>& summaries)
+{
+    stream.imbue(std::locale::classic());
+    stream << std::setprecision(6) << "[\n";
+    for (std::size_t i = 0; i < summaries.size(); ++i) {
+        const auto& summary = summaries[i];
+        stream << "  {\"path\": \"" << summary.path << "\", "
+               << "\"recorded_sec\": " << summary.recorded_sec << ", "
+               << "\"median_sec\": " << median(summary.replayed_sec) << ", "
+               << "\"stages\": [";
+        for (std::size_t j = 0; j < summary.stage_order.size(); ++j) {
+            const auto& name = summary.stage_order[j];
+            const auto& stage = summary.stages.at(name);
+            stream << (j == 0 ? "" : ", ")
+                   << "{\"name\": \"" << name << "\", "
+                   << "\"recorded_sec\": " << stage.recorded_sec << ", "
+                   << "\"median_sec\": " << median(stage.replayed_sec) << "}";
+        }
+        stream << "]}" << (i + 1 < summaries.size() ? ",\n" : "\n");
+    }
+    stream << "]\n";
+}
+
+} // namespace
+
+} // namespace sanescan
+
+struct Options {
+    static constexpr const char* HELP = "help";
+    static constexpr const char* BUNDLE = "bundle";
+    static constexpr const char* ITERATIONS = "iterations";
+    static constexpr const char* JSON_OUTPUT = "json-output";
+};
+
+int main(int argc, char* argv[])
+{
+    namespace po = boost::program_options;
+
+    std::vector<std::string> bundle_paths;
+    unsigned iterations = 0;
+    std::string json_output_path;
+
+    po::positional_options_description positional_options_desc;
+    positional_options_desc.add(Options::BUNDLE, -1);
+
+    auto introduction_desc = R"(Usage:
+    sanescan_replay [OPTION]... bundle_path...
+
+Replays OCR bundles captured by sanescan when SANESCAN_OCR_CAPTURE_DIR is set and compares the
+timings with the original run. Set SANESCAN_TRACE to record a trace of the replay.
+)";
+
+    po::options_description options_desc("Options");
+    options_desc.add_options()
+            (Options::HELP, "produce this help message")
+            (Options::BUNDLE, po::value(&bundle_paths), "the path to the bundle directory")
+            (Options::ITERATIONS, po::value(&iterations)->default_value(3),
+             "the number of times to replay each bundle")
+            (Options::JSON_OUTPUT, po::value(&json_output_path),
+             "the path to write results in JSON format to");
+
+    po::variables_map options;
+    try {
+        po::store(po::command_line_parser(argc, argv)
+                      .options(options_desc)
+                      .positional(positional_options_desc)
+                      .run(),
+                  options);
+        po::notify(options);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to parse options: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (options.count(Options::HELP)) {
+        std::cout << introduction_desc << "\n" << options_desc << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    if (bundle_paths.empty()) {
+        std::cerr << "Must specify at least one bundle path\n";
+        return EXIT_FAILURE;
+    }
+
+    sanescan::trace_start_from_env();
+    std::cout << "Tesseract version: " << sanescan::tesseract_version() << "\n";
+
+    std::vector<sanescan::BundleSummary> summaries;
+    try {
+        for (const auto& path : bundle_paths) {
+            summaries.push_back(sanescan::replay_bundle(path, iterations));
+            sanescan::print_summary(std::cout, summaries.back());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to replay bundle: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    sanescan::trace_stop();
+
+    if (!json_output_path.empty()) {
+        std::ofstream stream(json_output_path);
+        sanescan::write_json(stream, summaries);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,244 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*  Measures how fast a scanner delivers data for a matrix of scanner option combinations. For
+    each combination a scan is performed and the time to the first line, the sustained read rate
+    and the stalls of the read loop are reported.
+*/
+
+#include "lib/sane_device_wrapper.h"
+#include "lib/sane_wrapper.h"
+#include "lib/scan_profiler.h"
+#include "util/trace.h"
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sanescan {
+
+namespace {
+
+constexpr auto POLL_INTERVAL = std::chrono::milliseconds(5);
+
+ScanProfileResult profile_config(SaneDeviceWrapper& device,
+                                 const std::vector<SaneOptionGroupDestriptor>& groups,
+                                 const ScanProfileConfig& config)
+{
+    ScanProfileResult result;
+    result.config = config;
+    try {
+        std::vector<SaneOptionIndexedValue> values;
+        for (const auto& [name, value] : config) {
+            auto desc = find_option_descriptor(groups, name);
+            if (!desc.has_value()) {
+                throw std::invalid_argument("Unknown option " + name);
+            }
+            values.emplace_back(desc->index, parse_sane_option_value(desc.value(), value));
+        }
+        device.set_option_values(values).get();
+        auto params = device.get_parameters().get();
+
+        device.start().get();
+        while (!device.finished()) {
+            // The data is discarded immediately so that the read loop never waits for free buffer
+            // space and only the scanner limits the read rate.
+            device.receive_read_lines([](std::size_t, const char*, std::size_t) {});
+            std::this_thread::sleep_for(POLL_INTERVAL);
+        }
+        device.receive_read_lines([](std::size_t, const char*, std::size_t) {});
+        device.cancel();
+
+        auto stats = device.read_stats();
+        // The number of lines is negative if it's not known in advance
+        auto expected_bytes = static_cast<std::size_t>(params.bytes_per_line) * params.lines;
+        if (params.lines > 0 && stats.total_bytes < expected_bytes) {
+            throw std::runtime_error("Incomplete scan");
+        }
+        result.stats = stats;
+    } catch (const std::exception& e) {
+        device.cancel();
+        result.error = e.what();
+    }
+    return result;
+}
+
+} // namespace
+
+} // namespace sanescan
+
+struct Options {
+    static constexpr const char* HELP = "help";
+    static constexpr const char* LIST_DEVICES = "list-devices";
+    static constexpr const char* DEVICE = "device";
+    static constexpr const char* OPTION = "option";
+    static constexpr const char* DPI = "dpi";
+};
+
+int main(int argc, char* argv[])
+{
+    namespace po = boost::program_options;
+
+    std::string device_name;
+    std::vector<std::string> option_specs;
+    double target_dpi = 0;
+
+    auto introduction_desc = R"(Usage:
+    sanescan_scanner_profile [OPTION]...
+
+Scans once for each combination of the given scanner option values and reports the time until
+the first line has been read, the sustained read rate and the number and maximum length of stalls
+of the read loop. The configuration that finishes the scan fastest while scanning at least at the
+target resolution is recommended.
+
+If the values of the mode or resolution options are not given, all modes and the resolutions
+between the target resolution and twice of it are profiled. The scanned area can be reduced to
+make the profiling faster, e.g. via --option br-y=100.
+)";
+
+    po::options_description options_desc("Options");
+    options_desc.add_options()
+            (Options::HELP, "produce this help message")
+            (Options::LIST_DEVICES, "list the available devices and exit")
+            (Options::DEVICE, po::value(&device_name),
+             "the name of the device to profile. The first available device is used by default")
+            (Options::OPTION, po::value(&option_specs)->composing(),
+             "the values of a scanner option to profile in the form of name=value1,value2,... "
+             "Can be given multiple times")
+            (Options::DPI, po::value(&target_dpi)->default_value(300),
+             "the target resolution to recommend the fastest configuration for");
+
+    po::variables_map options;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(options_desc).run(), options);
+        po::notify(options);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to parse options: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (options.count(Options::HELP)) {
+        std::cout << introduction_desc << "\n" << options_desc << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<sanescan::ScanProfileDimension> dimensions;
+    try {
+        for (const auto& spec : option_specs) {
+            dimensions.push_back(sanescan::parse_scan_profile_dimension(spec));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    sanescan::trace_start_from_env();
+
+    try {
+        sanescan::SaneWrapper wrapper;
+        auto devices = wrapper.get_device_info().get();
+        if (options.count(Options::LIST_DEVICES)) {
+            for (const auto& device : devices) {
+                std::cout << device.name << " (" << device.vendor << " " << device.model << ")\n";
+            }
+            return EXIT_SUCCESS;
+        }
+
+        if (device_name.empty()) {
+            if (devices.empty()) {
+                std::cerr << "No scanners found\n";
+                return EXIT_FAILURE;
+            }
+            device_name = devices.front().name;
+        }
+
+        auto device = wrapper.open_device(device_name).get();
+        auto groups = device->get_option_groups().get();
+
+        auto has_dimension = [&](const std::string& name)
+        {
+            for (const auto& dimension : dimensions) {
+                if (dimension.option_name == name) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        auto mode_desc = sanescan::find_option_descriptor(groups, "mode");
+        if (!has_dimension("mode") && mode_desc.has_value()) {
+            const auto* modes =
+                    std::get_if<sanescan::SaneConstraintStringList>(&mode_desc->constraint);
+            if (modes != nullptr && !modes->strings.empty()) {
+                dimensions.push_back({"mode", modes->strings});
+            }
+        }
+
+        auto resolution_desc = sanescan::find_option_descriptor(groups, "resolution");
+        if (!has_dimension("resolution") && resolution_desc.has_value()) {
+            auto resolutions = sanescan::get_option_values_in_range(resolution_desc.value(),
+                                                                    target_dpi, target_dpi * 2);
+            if (resolutions.empty()) {
+                std::cerr << "The scanner does not support the resolution of " << target_dpi
+                          << " dpi\n";
+                return EXIT_FAILURE;
+            }
+            dimensions.push_back({"resolution", resolutions});
+        }
+
+        auto configs = sanescan::build_scan_profile_matrix(dimensions);
+        std::cout << "Profiling " << device_name << " in " << configs.size()
+                  << " configurations\n";
+
+        std::vector<sanescan::ScanProfileResult> results;
+        for (const auto& config : configs) {
+            for (const auto& [name, value] : config) {
+                std::cout << name << "=" << value << " ";
+            }
+            std::cout << "...\n";
+            results.push_back(sanescan::profile_config(*device, groups, config));
+        }
+        sanescan::trace_stop();
+
+        std::cout << "\n";
+        sanescan::write_scan_profile_table(std::cout, results);
+        std::cout << "\n";
+
+        auto fastest = sanescan::find_fastest_scan_profile_result(results, target_dpi);
+        if (!fastest.has_value()) {
+            std::cout << "No configuration scanned at least at " << target_dpi << " dpi\n";
+            return EXIT_FAILURE;
+        }
+        const auto& fastest_result = results[fastest.value()];
+        std::cout << "Fastest configuration for " << target_dpi << " dpi:";
+        for (const auto& [name, value] : fastest_result.config) {
+            std::cout << " " << name << "=" << value;
+        }
+        std::cout << " (" << fastest_result.stats->total_duration_sec << " s)\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to profile scanner: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "synthetic_page.h"
+#include "util/image.h"
+#include "util/math.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace sanescan {
+
+namespace {
+
+constexpr double PAGE_WIDTH_INCH = 8.27;
+constexpr double PAGE_HEIGHT_INCH = 11.69;
+constexpr double MARGIN_INCH = 1;
+constexpr double PHOTO_HEIGHT_INCH = 2;
+constexpr int LINES_PER_PARAGRAPH = 6;
+constexpr int PARAGRAPHS_BEFORE_PHOTO = 2;
+constexpr std::uint64_t RNG_SEED_BASE = 0x5a4e5343;
+
+// Real words are used so that the language model of the OCR engine behaves as on real documents
+const char* const VOCABULARY[] = {
+    "the", "of", "and", "to", "in", "is", "that", "for", "it", "as", "was", "with", "be", "by",
+    "on", "not", "he", "this", "are", "or", "his", "from", "at", "which", "but", "have", "an",
+    "had", "they", "you", "were", "their", "one", "all", "we", "can", "her", "has", "there",
+    "been", "if", "more", "when", "will", "would", "who", "so", "no", "time", "about", "people",
+    "into", "only", "other", "new", "some", "could", "these", "two", "may", "first", "then",
+    "any", "like", "such", "over", "also", "years", "after", "most", "made", "should", "state",
+    "between", "world", "through", "under", "before", "government", "system", "number",
+    "general", "during", "however", "without", "against", "example", "development", "report",
+    "information", "company", "document", "page", "scanner", "paper", "letter", "account",
+    "payment", "invoice", "total", "amount", "address", "signature", "service", "contract",
+};
+
+std::string random_word(cv::RNG& rng)
+{
+    return VOCABULARY[rng.uniform(0, static_cast<int>(std::size(VOCABULARY)))];
+}
+
+OcrWord render_word(cv::Mat& image, const std::string& text, int x, int baseline_y,
+                    int font, double font_scale, int thickness)
+{
+    OcrWord word;
+    word.content = text;
+    word.confidence = 1;
+    word.font_size = font_scale * 22;
+
+    int prev_x = x;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        int descent = 0;
+        auto prefix_size = cv::getTextSize(text.substr(0, i + 1), font, font_scale, thickness,
+                                           &descent);
+        word.char_boxes.push_back(OcrBox{prev_x, baseline_y - prefix_size.height,
+                                         x + prefix_size.width, baseline_y + descent});
+        prev_x = x + prefix_size.width;
+    }
+
+    int descent = 0;
+    auto size = cv::getTextSize(text, font, font_scale, thickness, &descent);
+    word.box = OcrBox{x, baseline_y - size.height, x + size.width, baseline_y + descent};
+    word.baseline = OcrBaseline{0, -static_cast<double>(descent), 0};
+
+    cv::putText(image, text, cv::Point(x, baseline_y), font, font_scale, cv::Scalar(20, 20, 20),
+                thickness, cv::LINE_AA);
+    return word;
+}
+
+OcrBox union_box(const OcrBox& a, const OcrBox& b)
+{
+    return OcrBox{std::min(a.x1, b.x1), std::min(a.y1, b.y1),
+                  std::max(a.x2, b.x2), std::max(a.y2, b.y2)};
+}
+
+void draw_table(cv::Mat& image, int x1, int y1, int x2, int y2, int rows, int cols, int thickness)
+{
+    auto color = cv::Scalar(30, 30, 30);
+    for (int r = 0; r <= rows; ++r) {
+        int y = y1 + (y2 - y1) * r / rows;
+        cv::line(image, cv::Point(x1, y), cv::Point(x2, y), color, thickness);
+    }
+    for (int c = 0; c <= cols; ++c) {
+        int x = x1 + (x2 - x1) * c / cols;
+        cv::line(image, cv::Point(x, y1), cv::Point(x, y2), color, thickness);
+    }
+}
+
+// Draws a smooth colorful area with some texture which resembles a photo to the page segmenter
+void draw_photo(cv::Mat& image, const cv::Rect& rect, cv::RNG& rng)
+{
+    cv::Mat small(8, 8, CV_8UC3);
+    rng.fill(small, cv::RNG::UNIFORM, cv::Scalar::all(40), cv::Scalar::all(220));
+    cv::Mat photo;
+    cv::resize(small, photo, rect.size(), 0, 0, cv::INTER_CUBIC);
+
+    cv::Mat texture(rect.size(), CV_8UC3);
+    rng.fill(texture, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(30));
+    photo += texture;
+    photo.copyTo(image(rect));
+}
+
+} // namespace
+
+SyntheticPage generate_synthetic_page(const SyntheticPageOptions& options)
+{
+    cv::RNG rng(RNG_SEED_BASE + options.seed);
+
+    SyntheticPage page;
+    page.options = options;
+
+    auto dpi = options.dpi;
+    int width = static_cast<int>(std::round(PAGE_WIDTH_INCH * dpi));
+    int height = static_cast<int>(std::round(PAGE_HEIGHT_INCH * dpi));
+    int margin = static_cast<int>(std::round(MARGIN_INCH * dpi));
+
+    cv::Mat image(height, width, CV_8UC3, cv::Scalar(235, 235, 235));
+
+    // Approximately 11pt text regardless of resolution
+    int font = cv::FONT_HERSHEY_SIMPLEX;
+    double font_scale = dpi / 300.0 * 1.2;
+    int thickness = std::max(1, dpi / 150);
+    int text_height = cv::getTextSize("Xg", font, font_scale, thickness, nullptr).height;
+    int line_spacing = text_height * 2;
+    int space_width = text_height / 2;
+
+    // The top two thirds of the page contain text, the rest contains a table if enabled
+    int text_bottom = options.ruled_lines ? margin + (height - 2 * margin) * 2 / 3
+                                          : height - margin;
+    int y = margin + text_height;
+
+    while (y < text_bottom) {
+        if (options.photos && page.paragraphs.size() == PARAGRAPHS_BEFORE_PHOTO) {
+            int photo_height = static_cast<int>(PHOTO_HEIGHT_INCH * dpi);
+            if (y + photo_height < text_bottom) {
+                int photo_width = (width - 2 * margin) / 2;
+                draw_photo(image, cv::Rect((width - photo_width) / 2, y - text_height,
+                                           photo_width, photo_height), rng);
+                y += photo_height + line_spacing;
+            }
+        }
+
+        OcrParagraph paragraph;
+        for (int l = 0; l < LINES_PER_PARAGRAPH && y < text_bottom; ++l) {
+            OcrLine line;
+            int x = margin;
+            while (true) {
+                auto text = random_word(rng);
+                auto text_width = cv::getTextSize(text, font, font_scale, thickness,
+                                                  nullptr).width;
+                if (x + text_width > width - margin) {
+                    break;
+                }
+                auto word = render_word(image, text, x, y, font, font_scale, thickness);
+                line.box = line.words.empty() ? word.box : union_box(line.box, word.box);
+                line.words.push_back(std::move(word));
+                x += text_width + space_width;
+            }
+            line.baseline = OcrBaseline{0, static_cast<double>(y - line.box.y2), 0};
+            paragraph.box = paragraph.lines.empty() ? line.box
+                                                    : union_box(paragraph.box, line.box);
+            paragraph.lines.push_back(std::move(line));
+            y += line_spacing;
+        }
+        page.paragraphs.push_back(std::move(paragraph));
+        y += line_spacing;
+    }
+
+    if (options.ruled_lines) {
+        draw_table(image, margin, text_bottom + line_spacing, width - margin, height - margin,
+                   8, 4, thickness);
+    }
+
+    if (options.skew_deg != 0) {
+        image = image_rotate_centered_noflip(image, deg_to_rad(options.skew_deg));
+    }
+
+    // Imitate scanner output: blur of the edges and sensor noise
+    if (options.blur_sigma > 0) {
+        cv::GaussianBlur(image, image, cv::Size(0, 0), options.blur_sigma * dpi / 300);
+    } else {
+        cv::GaussianBlur(image, image, cv::Size(3, 3), 0);
+    }
+
+    if (options.noise_sigma > 0) {
+        cv::Mat noise(height, width, CV_16SC3);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0),
+                 cv::Scalar::all(options.noise_sigma));
+        cv::Mat image16;
+        image.convertTo(image16, CV_16SC3);
+        image16 += noise;
+        image16.convertTo(image, CV_8UC3);
+    }
+
+    page.image = image;
+    page.image_gray = image_color_to_gray(image);
+    return page;
+}
+
+std::vector<std::string> get_page_words(const std::vector<OcrParagraph>& paragraphs)
+{
+    std::vector<std::string> words;
+    for (const auto& par : paragraphs) {
+        for (const auto& line : par.lines) {
+            for (const auto& word : line.words) {
+                words.push_back(word.content);
+            }
+        }
+    }
+    return words;
+}
+
+double compute_word_accuracy(const std::vector<std::string>& expected,
+                             const std::vector<std::string>& recognized)
+{
+    if (expected.empty()) {
+        return recognized.empty() ? 1 : 0;
+    }
+
+    // Standard dynamic programming solution keeping only two rows of the table
+    std::vector<std::size_t> prev(recognized.size() + 1, 0);
+    std::vector<std::size_t> curr(recognized.size() + 1, 0);
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        for (std::size_t j = 0; j < recognized.size(); ++j) {
+            curr[j + 1] = expected[i] == recognized[j] ? prev[j] + 1
+                                                       : std::max(prev[j + 1], curr[j]);
+        }
+        std::swap(prev, curr);
+    }
+    return static_cast<double>(prev.back()) / expected.size();
+}
+
+} // namespace sanescan
@@ -0,0 +1,73 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_BENCH_SYNTHETIC_PAGE_H
+#define SANESCAN_BENCH_SYNTHETIC_PAGE_H
+
+#include "ocr/ocr_paragraph.h"
+#include <opencv2/core/mat.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sanescan {
+
+struct SyntheticPageOptions {
+    int dpi = 300;
+    // Counter-clockwise rotation of the whole page in degrees
+    double skew_deg = 0;
+    // Whether to draw a ruled table on the bottom part of the page
+    bool ruled_lines = true;
+    // Standard deviation of the gaussian noise added to pixel values
+    double noise_sigma = 4;
+    // Standard deviation of the gaussian blur in pixels at 300 dpi. Zero means minimal blur.
+    double blur_sigma = 0;
+    // Whether to place a color photo in the middle of the text
+    bool photos = false;
+    // Different seeds produce different text and noise
+    std::uint64_t seed = 0;
+};
+
+struct SyntheticPage {
+    SyntheticPageOptions options;
+    // A4 page with text and optionally ruled lines and photos
+    cv::Mat image;
+    cv::Mat image_gray;
+    /** The layout of the rendered text as if it was recognized without errors. The coordinates
+        are of the page before skew is applied.
+    */
+    std::vector<OcrParagraph> paragraphs;
+};
+
+/// Renders a synthetic page. The output depends only on the passed options.
+SyntheticPage generate_synthetic_page(const SyntheticPageOptions& options);
+
+/// Returns all words of the page in reading order
+std::vector<std::string> get_page_words(const std::vector<OcrParagraph>& paragraphs);
+
+/** Returns the fraction of expected words that were recognized in the correct order. This is
+    computed as the length of the longest common subsequence divided by the number of expected
+    words.
+*/
+double compute_word_accuracy(const std::vector<std::string>& expected,
+                             const std::vector<std::string>& recognized);
+
+} // namespace sanescan
+
+#endif // SANESCAN_BENCH_SYNTHETIC_PAGE_H
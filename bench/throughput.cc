@@ -0,0 +1,359 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*  Measures end-to-end throughput of the OCR pipeline including PDF export on a deterministic
+    synthetic corpus. Each configuration is a combination of resolution and the number of pages
+    processed concurrently.
+*/
+
+#include "synthetic_page.h"
+#include "ocr/ocr_options.h"
+#include "ocr/ocr_pipeline_run.h"
+#include "ocr/pdf.h"
+#include "util/trace.h"
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sanescan {
+
+namespace {
+
+struct PageResult {
+    double latency_sec = 0;
+    std::size_t output_size = 0;
+    double word_accuracy = 0;
+};
+
+struct ConfigResult {
+    int dpi = 0;
+    int concurrency = 0;
+    std::size_t pages = 0;
+    double pages_per_min = 0;
+    double latency_p50_sec = 0;
+    double latency_p99_sec = 0;
+    std::size_t peak_rss_kb = 0;
+    std::size_t output_size = 0;
+    double word_accuracy = 0;
+};
+
+// Resets the peak resident set size of the process. Supported only on Linux.
+void reset_peak_rss()
+{
+    std::ofstream stream("/proc/self/clear_refs");
+    stream << "5";
+}
+
+std::size_t read_peak_rss_kb()
+{
+    std::ifstream stream("/proc/self/status");
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.starts_with("VmHWM:")) {
+            return std::stoull(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    auto rank = static_cast<std::size_t>(std::ceil(fraction * values.size()));
+    return values[std::clamp<std::size_t>(rank, 1, values.size()) - 1];
+}
+
+PageResult process_page(const SyntheticPage& page, const OcrOptions& options,
+                        const std::shared_ptr<OcrBatchContext>& batch_context)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    OcrPipelineRun run{page.image, options, options, {}};
+    if (batch_context) {
+        run.set_batch_context(batch_context);
+    }
+    run.execute();
+    const auto& results = run.results();
+
+    std::ostringstream stream;
+    write_pdf(stream, results.adjusted_image, results.adjusted_paragraphs);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    PageResult result;
+    result.latency_sec = elapsed.count();
+    result.output_size = stream.tellp();
+    result.word_accuracy = compute_word_accuracy(get_page_words(page.paragraphs),
+                                                 get_page_words(results.adjusted_paragraphs));
+    return result;
+}
+
+ConfigResult run_config(const std::vector<SyntheticPage>& corpus, int concurrency,
+                        const OcrOptions& options, bool use_batch_context)
+{
+    // Each configuration starts without any knowledge about the corpus
+    std::shared_ptr<OcrBatchContext> batch_context;
+    if (use_batch_context) {
+        batch_context = std::make_shared<OcrBatchContext>();
+    }
+
+    std::vector<PageResult> page_results(corpus.size());
+    std::atomic<std::size_t> next_page = 0;
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    reset_peak_rss();
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < concurrency; ++i) {
+        workers.emplace_back([&]()
+        {
+            try {
+                for (auto index = next_page++; index < corpus.size(); index = next_page++) {
+                    page_results[index] = process_page(corpus[index], options, batch_context);
+                }
+            } catch (...) {
+                std::lock_guard lock{error_mutex};
+                error = std::current_exception();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    ConfigResult result;
+    result.dpi = corpus.empty() ? 0 : corpus.front().options.dpi;
+    result.concurrency = concurrency;
+    result.pages = corpus.size();
+    result.pages_per_min = corpus.size() * 60 / elapsed.count();
+    result.peak_rss_kb = read_peak_rss_kb();
+
+    std::vector<double> latencies;
+    double accuracy_sum = 0;
+    for (const auto& page_result : page_results) {
+        latencies.push_back(page_result.latency_sec);
+        result.output_size += page_result.output_size;
+        accuracy_sum += page_result.word_accuracy;
+    }
+    result.latency_p50_sec = percentile(latencies, 0.5);
+    result.latency_p99_sec = percentile(latencies, 0.99);
+    result.word_accuracy = corpus.empty() ? 0 : accuracy_sum / corpus.size();
+    return result;
+}
+
+void print_result(std::ostream& stream, const ConfigResult& r)
+{
+    stream << std::fixed << std::setprecision(2)
+           << std::setw(5) << r.dpi
+           << std::setw(13) << r.concurrency
+           << std::setw(11) << r.pages_per_min
+           << std::setw(11) << r.latency_p50_sec
+           << std::setw(11) << r.latency_p99_sec
+           << std::setw(13) << r.peak_rss_kb / 1024.0
+           << std::setw(13) << r.output_size / r.pages / 1024.0
+           << std::setw(10) << r.word_accuracy
+           << std::endl;
+}
+
+void write_json(std::ostream& stream, const SyntheticPageOptions& page_options,
+                const std::vector<ConfigResult>& results)
+{
+    stream.imbue(std::locale::classic());
+    stream << std::setprecision(6);
+    stream << "{\n"
+           << "  \"corpus\": {"
+           << "\"skew_deg\": " << page_options.skew_deg << ", "
+           << "\"ruled_lines\": " << (page_options.ruled_lines ? "true" : "false") << ", "
+           << "\"noise_sigma\": " << page_options.noise_sigma << ", "
+           << "\"blur_sigma\": " << page_options.blur_sigma << ", "
+           << "\"photos\": " << (page_options.photos ? "true" : "false") << "},\n"
+           << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        stream << "    {"
+               << "\"dpi\": " << r.dpi << ", "
+               << "\"concurrency\": " << r.concurrency << ", "
+               << "\"pages\": " << r.pages << ", "
+               << "\"pages_per_min\": " << r.pages_per_min << ", "
+               << "\"latency_p50_sec\": " << r.latency_p50_sec << ", "
+               << "\"latency_p99_sec\": " << r.latency_p99_sec << ", "
+               << "\"peak_rss_kb\": " << r.peak_rss_kb << ", "
+               << "\"output_bytes\": " << r.output_size << ", "
+               << "\"word_accuracy\": " << r.word_accuracy << "}"
+               << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    stream << "  ]\n}\n";
+}
+
+} // namespace
+
+} // namespace sanescan
+
+struct Options {
+    static constexpr const char* HELP = "help";
+    static constexpr const char* PAGES = "pages";
+    static constexpr const char* DPI = "dpi";
+    static constexpr const char* CONCURRENCY = "concurrency";
+    static constexpr const char* SKEW = "skew";
+    static constexpr const char* NO_RULED_LINES = "no-ruled-lines";
+    static constexpr const char* NOISE = "noise";
+    static constexpr const char* BLUR = "blur";
+    static constexpr const char* PHOTOS = "photos";
+    static constexpr const char* PROFILE = "profile";
+    static constexpr const char* BATCH_CONTEXT = "batch-context";
+    static constexpr const char* JSON_OUTPUT = "json-output";
+};
+
+int main(int argc, char* argv[])
+{
+    namespace po = boost::program_options;
+
+    std::size_t page_count = 0;
+    std::vector<int> dpis;
+    std::vector<int> concurrencies;
+    std::string json_output_path;
+    std::string profile_name;
+    sanescan::SyntheticPageOptions page_options;
+
+    auto introduction_desc = R"(Usage:
+    sanescan_throughput [OPTION]...
+
+Runs the OCR pipeline and PDF export on a generated corpus of pages and reports pages per minute,
+per-page latency, peak RSS, average output size and word accuracy for each configuration. Peak
+RSS includes the memory used by the generated corpus.
+)";
+
+    po::options_description options_desc("Options");
+    options_desc.add_options()
+            (Options::HELP, "produce this help message")
+            (Options::PAGES, po::value(&page_count)->default_value(8),
+             "the number of pages in the corpus")
+            (Options::DPI, po::value(&dpis)->multitoken()->default_value({300}, "300"),
+             "the resolutions to render the corpus at")
+            (Options::CONCURRENCY,
+             po::value(&concurrencies)->multitoken()->default_value({1, 2, 4}, "1 2 4"),
+             "the numbers of pages to process concurrently")
+            (Options::SKEW, po::value(&page_options.skew_deg)->default_value(0),
+             "maximum page skew in degrees. Pages alternate between skew to the left and right")
+            (Options::NO_RULED_LINES, "don't draw ruled tables on the pages")
+            (Options::NOISE, po::value(&page_options.noise_sigma)->default_value(4),
+             "standard deviation of pixel noise")
+            (Options::BLUR, po::value(&page_options.blur_sigma)->default_value(0),
+             "standard deviation of blur in pixels at 300 dpi")
+            (Options::PHOTOS, "place photos on the pages")
+            (Options::PROFILE, po::value(&profile_name)->default_value("balanced"),
+             "the OCR profile to use: fast, balanced or best")
+            (Options::BATCH_CONTEXT,
+             "carry page properties such as languages and ruled lines across the pages")
+            (Options::JSON_OUTPUT, po::value(&json_output_path),
+             "the path to write results in JSON format to");
+
+    po::variables_map options;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(options_desc).run(), options);
+        po::notify(options);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to parse options: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (options.count(Options::HELP)) {
+        std::cout << introduction_desc << "\n" << options_desc << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    if (page_count == 0) {
+        std::cerr << "Must specify at least one page\n";
+        return EXIT_FAILURE;
+    }
+
+    page_options.ruled_lines = !options.count(Options::NO_RULED_LINES);
+    page_options.photos = options.count(Options::PHOTOS);
+
+    sanescan::OcrOptions ocr_options;
+    auto profile = sanescan::parse_ocr_profile(profile_name);
+    if (!profile.has_value()) {
+        std::cerr << "Unknown OCR profile " << profile_name << "\n";
+        return EXIT_FAILURE;
+    }
+    ocr_options.profile = profile.value();
+
+    bool use_batch_context = options.count(Options::BATCH_CONTEXT);
+
+    std::vector<sanescan::ConfigResult> results;
+    sanescan::trace_start_from_env();
+
+    std::cout << "OCR profile: " << ocr_options.profile << "\n";
+    std::cout << "  dpi  concurrency  pages/min    p50 (s)    p99 (s)  peak RSS (MB)"
+                 "  avg out (KB)  accuracy\n";
+
+    try {
+        for (auto dpi : dpis) {
+            std::vector<sanescan::SyntheticPage> corpus;
+            for (std::size_t i = 0; i < page_count; ++i) {
+                auto curr_page_options = page_options;
+                curr_page_options.dpi = dpi;
+                curr_page_options.seed = i;
+                if (i % 2 == 1) {
+                    curr_page_options.skew_deg = -page_options.skew_deg;
+                }
+                corpus.push_back(sanescan::generate_synthetic_page(curr_page_options));
+            }
+
+            for (auto concurrency : concurrencies) {
+                results.push_back(sanescan::run_config(corpus, std::max(concurrency, 1),
+                                                       ocr_options, use_batch_context));
+                sanescan::print_result(std::cout, results.back());
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to run benchmark: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    sanescan::trace_stop();
+
+    if (!json_output_path.empty()) {
+        std::ofstream stream(json_output_path);
+        sanescan::write_json(stream, page_options, results);
+    }
+
+    return EXIT_SUCCESS;
+}
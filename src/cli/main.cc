@@ -22,6 +22,8 @@
 #include "util/math.h"
 #include "ocr/pdf.h"
 #include "ocr/ocr_pipeline_run.h"
+#include "util/telemetry.h"
+#include "util/trace.h"
 
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -57,6 +59,12 @@ struct Options {
     static constexpr const char* HELP = "help";
     static constexpr const char* DEBUG_CHAR_BOXES = "debug-char-boxes";
     static constexpr const char* DEBUG_WORD_ORDER = "debug-word-order";
+    static constexpr const char* TRACE = "trace";
+    static constexpr const char* TELEMETRY_OUTPUT = "telemetry-output";
+
+    static constexpr const char* PROFILE = "ocr-profile";
+    static constexpr const char* LANGUAGES = "ocr-languages";
+    static constexpr const char* DETECT_LANGUAGES_ENABLE = "ocr-enable-language-detection";
 
     static constexpr const char* FIX_ROTATION_ENABLE = "ocr-enable-fix-text-rotation";
     static constexpr const char* FIX_ROTATION_FRACTION = "ocr-fix-text-rotation-min-text-fraction";
@@ -67,6 +75,10 @@ struct Options {
     static constexpr const char* FIX_ORIENTATION_ANGLE = "ocr-fix-page-orientation-max-angle-diff";
 
     static constexpr const char* MIN_WORD_CONFIDENCE = "ocr-min-word-confidence";
+
+    static constexpr const char* RERECOGNIZE_ENABLE = "ocr-enable-rerecognize-lines";
+    static constexpr const char* RERECOGNIZE_CONFIDENCE = "ocr-rerecognize-max-word-confidence";
+    static constexpr const char* RERECOGNIZE_SCALE = "ocr-rerecognize-scale";
 };
 
 int main(int argc, char* argv[])
@@ -75,6 +87,9 @@ int main(int argc, char* argv[])
 
     std::string input_path;
     std::string output_path;
+    std::string trace_path;
+    std::string telemetry_path;
+    std::string profile_name;
 
     po::positional_options_description positional_options_desc;
     positional_options_desc.add(Options::INPUT_PATH, 1);
@@ -93,13 +108,27 @@ input_path and output_path options can be passed either as positional or named a
             (Options::OUTPUT_PATH, po::value(&output_path), "the path to the output PDF file")
             (Options::HELP, "produce this help message")
             (Options::DEBUG_CHAR_BOXES, "enable character box debugging in output PDF file")
-            (Options::DEBUG_WORD_ORDER, "enable word order debugging in output PDF file");
+            (Options::DEBUG_WORD_ORDER, "enable word order debugging in output PDF file")
+            (Options::TRACE, po::value(&trace_path),
+             "write Chrome trace-event JSON to the given path. Tracing can also be enabled via "
+             "the SANESCAN_TRACE environment variable")
+            (Options::TELEMETRY_OUTPUT, po::value(&telemetry_path),
+             "write the collected telemetry (counters, gauges and latency histograms) as JSON to "
+             "the given path after processing. Use - to write to standard output");
 
     sanescan::OcrOptions ocr_options;
 
     po::options_description ocr_options_desc("OCR options");
 
     ocr_options_desc.add_options()
+            (Options::PROFILE, po::value(&profile_name)->default_value("balanced"),
+             "the trade-off between OCR speed and accuracy: fast, balanced or best")
+            (Options::LANGUAGES,
+             po::value(&ocr_options.languages)->multitoken()->default_value({"eng"}, "eng"),
+             "the Tesseract languages to recognize, e.g. eng deu")
+            (Options::DETECT_LANGUAGES_ENABLE,
+             "enable detecting the scripts on the page and loading only the languages that are "
+             "written in these scripts")
             (Options::FIX_ROTATION_ENABLE,
              "enable adjusting image rotation to make text lines level")
             (Options::FIX_ROTATION_FRACTION,
@@ -124,6 +153,14 @@ input_path and output_path options can be passed either as positional or named a
             (Options::MIN_WORD_CONFIDENCE,
              po::value(&ocr_options.min_word_confidence)->default_value(0),
              "minimum confidence value for a OCR'ed word in order for inclusion to the results")
+            (Options::RERECOGNIZE_ENABLE,
+             "enable recognizing lines with low confidence words once more using upscaled image")
+            (Options::RERECOGNIZE_CONFIDENCE,
+             po::value(&ocr_options.rerecognize_max_word_confidence)->default_value(0.6, "0.6"),
+             "lines that contain a word with lower confidence are recognized once more")
+            (Options::RERECOGNIZE_SCALE,
+             po::value(&ocr_options.rerecognize_scale)->default_value(2),
+             "the factor to upscale the lines by when recognizing them once more")
     ;
 
     po::options_description all_options_desc;
@@ -190,7 +227,16 @@ input_path and output_path options can be passed either as positional or named a
         }
     }
 
+    auto profile = sanescan::parse_ocr_profile(profile_name);
+    if (!profile.has_value()) {
+        std::cerr << "Unknown OCR profile " << profile_name << "\n";
+        return EXIT_FAILURE;
+    }
+    ocr_options.profile = profile.value();
+    ocr_options.detect_languages = options.count(Options::DETECT_LANGUAGES_ENABLE);
+
     ocr_options.fix_text_rotation = options.count(Options::FIX_ROTATION_ENABLE);
+    ocr_options.rerecognize_low_confidence_lines = options.count(Options::RERECOGNIZE_ENABLE);
     ocr_options.fix_page_orientation = options.count(Options::FIX_ORIENTATION_ENABLE);
     ocr_options.fix_page_orientation_max_angle_diff =
             sanescan::deg_to_rad(ocr_options.fix_page_orientation_max_angle_diff);
@@ -205,12 +251,32 @@ input_path and output_path options can be passed either as positional or named a
         write_pdf_flags = write_pdf_flags | sanescan::WritePdfFlags::DEBUG_WORD_ORDER;
     }
 
+    if (!trace_path.empty()) {
+        sanescan::trace_start(trace_path);
+    } else {
+        sanescan::trace_start_from_env();
+    }
+
     try {
         if (!sanescan::read_ocr_write(input_path, output_path,
                                       write_pdf_flags, ocr_options)) {
             std::cerr << "Unknown failure";
             return EXIT_FAILURE;
         }
+        sanescan::trace_stop();
+
+        if (telemetry_path == "-") {
+            sanescan::write_telemetry_json(std::cout,
+                                           sanescan::TelemetryRegistry::instance().snapshot());
+        } else if (!telemetry_path.empty()) {
+            std::ofstream stream(telemetry_path);
+            if (!stream) {
+                std::cerr << "Could not open telemetry output " << telemetry_path << "\n";
+                return EXIT_FAILURE;
+            }
+            sanescan::write_telemetry_json(stream,
+                                           sanescan::TelemetryRegistry::instance().snapshot());
+        }
     } catch (const std::exception& e) {
         std::cerr << "Failed to do OCR: " << e.what() << "\n";
         return EXIT_FAILURE;
@@ -0,0 +1,93 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "duplicate_page_job.h"
+#include "util/trace.h"
+
+namespace sanescan {
+
+namespace {
+
+// The maximum number of differing bits of perceptual hashes of images for them to be checked
+// as near-duplicates.
+constexpr unsigned MAX_DUPLICATE_HASH_DISTANCE = 32;
+
+// See OcrJob for why the worker thread must not do any ref-counting operations on the images.
+cv::Mat make_unowned_mat(const cv::Mat& image)
+{
+    return cv::Mat(image.size.dims(), image.size.p, image.type(), image.data, image.step.p);
+}
+
+} // namespace
+
+DuplicatePageJob::DuplicatePageJob(const cv::Mat& image,
+                                   const std::vector<EarlierPage>& earlier_pages,
+                                   std::function<void()> on_finish) :
+    image_{image},
+    earlier_pages_{earlier_pages},
+    on_finish_{std::move(on_finish)}
+{
+}
+
+DuplicatePageJob::~DuplicatePageJob() = default;
+
+void DuplicatePageJob::execute()
+{
+    {
+        SANESCAN_TRACE_SPAN("page_manager", "duplicate_page_job");
+        auto image = make_unowned_mat(image_);
+        result_.image_hash = compute_image_hash(image);
+
+        for (const auto& earlier_page : earlier_pages_) {
+            auto earlier_image = make_unowned_mat(earlier_page.image);
+            auto earlier_hash = earlier_page.hash.has_value()
+                    ? earlier_page.hash.value() : compute_image_hash(earlier_image);
+            if (get_hash_distance(result_.image_hash, earlier_hash) >
+                    MAX_DUPLICATE_HASH_DISTANCE) {
+                continue;
+            }
+            if (!are_images_near_identical(image, earlier_image)) {
+                continue;
+            }
+            result_.near_duplicate_page_index = earlier_page.page_index;
+            result_.identical = are_images_identical(image, earlier_image);
+            break;
+        }
+    }
+
+    // The mutex is held until the job is no longer accessed from the worker thread. This ensures
+    // that the job is not destroyed by observers of finished() while on_finish_ is still running.
+    std::lock_guard lock{finished_mutex_};
+    finished_ = true;
+    finished_cv_.notify_all();
+    on_finish_();
+}
+
+bool DuplicatePageJob::finished() const
+{
+    std::lock_guard lock{finished_mutex_};
+    return finished_;
+}
+
+void DuplicatePageJob::wait_finished()
+{
+    std::unique_lock lock{finished_mutex_};
+    finished_cv_.wait(lock, [this]() { return finished_; });
+}
+
+} // namespace sanescan
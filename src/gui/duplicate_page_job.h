@@ -0,0 +1,82 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SANESCAN_GUI_DUPLICATE_PAGE_JOB_H
+#define SANESCAN_GUI_DUPLICATE_PAGE_JOB_H
+
+#include "lib/job_queue.h"
+#include "ocr/image_hash.h"
+
+#include <opencv2/core/mat.hpp>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace sanescan {
+
+/** Computes the perceptual hash of a scanned page and searches the earlier pages for a
+    near-duplicate of it. The work touches the whole image, thus it is done on a worker thread.
+*/
+struct DuplicatePageJob : IJob {
+public:
+    struct EarlierPage {
+        std::size_t page_index = 0;
+        cv::Mat image;
+        // Computed by the job if not set, e.g. if the job of the page has not completed yet
+        std::optional<ImageHash> hash;
+    };
+
+    struct Result {
+        ImageHash image_hash;
+        // The earlier page whose image is a near-duplicate of the image of the job
+        std::optional<std::size_t> near_duplicate_page_index;
+        // Set if the image of near_duplicate_page_index is identical to the image of the job
+        bool identical = false;
+    };
+
+    /** The images are copied in the constructor so that the worker thread does not need to
+        copy any cv::Mat instances.
+    */
+    DuplicatePageJob(const cv::Mat& image, const std::vector<EarlierPage>& earlier_pages,
+                     std::function<void()> on_finish);
+    ~DuplicatePageJob() override;
+
+    void execute() override;
+
+    const Result& result() const { return result_; }
+    bool finished() const;
+
+    /// Blocks the calling thread until the job finishes execution.
+    void wait_finished();
+
+private:
+    cv::Mat image_;
+    std::vector<EarlierPage> earlier_pages_;
+    Result result_;
+
+    mutable std::mutex finished_mutex_;
+    std::condition_variable finished_cv_;
+    bool finished_ = false;
+    std::function<void()> on_finish_;
+};
+
+} // namespace sanescan
+
+#endif // SANESCAN_GUI_DUPLICATE_PAGE_JOB_H
@@ -0,0 +1,67 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "image_tile_pyramid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace sanescan {
+
+ImageTilePyramid::ImageTilePyramid(const QImage& image)
+{
+    levels_.push_back(image);
+    if (image.isNull()) {
+        return;
+    }
+
+    while (levels_.back().width() > TILE_SIZE || levels_.back().height() > TILE_SIZE) {
+        const auto& prev = levels_.back();
+        auto next = prev.scaled(std::max(1, prev.width() / 2), std::max(1, prev.height() / 2),
+                                Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+        // Downscaled levels are painted much more often than they are built, so it makes sense to
+        // convert them to the format that is fastest to paint.
+        levels_.push_back(next.convertToFormat(QImage::Format_RGB32));
+    }
+}
+
+int ImageTilePyramid::level_for_scale(double scale) const
+{
+    if (scale <= 0) {
+        return level_count() - 1;
+    }
+    int level = static_cast<int>(std::floor(std::log2(1 / scale)));
+    return std::clamp(level, 0, level_count() - 1);
+}
+
+QSize ImageTilePyramid::tile_count(int level) const
+{
+    const auto& image = level_image(level);
+    return QSize((image.width() + TILE_SIZE - 1) / TILE_SIZE,
+                 (image.height() + TILE_SIZE - 1) / TILE_SIZE);
+}
+
+QRect ImageTilePyramid::tile_rect(int level, int tile_x, int tile_y) const
+{
+    const auto& image = level_image(level);
+    return QRect(tile_x * TILE_SIZE, tile_y * TILE_SIZE, TILE_SIZE, TILE_SIZE)
+            .intersected(image.rect());
+}
+
+} // namespace sanescan
@@ -0,0 +1,60 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_GUI_IMAGE_TILE_PYRAMID_H
+#define SANESCAN_GUI_IMAGE_TILE_PYRAMID_H
+
+#include <QtGui/QImage>
+#include <vector>
+
+namespace sanescan {
+
+/** Multi-resolution representation of an image. Level 0 refers to the original image, each
+    subsequent level is downscaled by a factor of 2 until the image fits into a single tile.
+    Building the pyramid is expensive, thus it should be done outside the GUI thread. The
+    pyramid is immutable once built.
+*/
+class ImageTilePyramid {
+public:
+    static constexpr int TILE_SIZE = 512;
+
+    explicit ImageTilePyramid(const QImage& image);
+
+    int level_count() const { return levels_.size(); }
+    const QImage& level_image(int level) const { return levels_.at(level); }
+    QSize full_size() const { return levels_.front().size(); }
+
+    /** Returns the level with the lowest resolution that still has at least one image pixel per
+        screen pixel when the full resolution image is painted with the given scale.
+    */
+    int level_for_scale(double scale) const;
+
+    /// Returns the number of tiles in a given level
+    QSize tile_count(int level) const;
+
+    /// Returns the area of a tile in level image coordinates
+    QRect tile_rect(int level, int tile_x, int tile_y) const;
+
+private:
+    std::vector<QImage> levels_;
+};
+
+} // namespace sanescan
+
+#endif // SANESCAN_GUI_IMAGE_TILE_PYRAMID_H
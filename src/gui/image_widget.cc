@@ -17,11 +17,17 @@
 */
 
 #include "image_widget.h"
+#include "image_tile_pyramid.h"
 #include "image_widget_highlight_item.h"
 #include "image_widget_selection_item.h"
+#include <QtCore/QCache>
 #include <QtWidgets/QScrollBar>
+#include <QtGui/QPainter>
+#include <QtGui/QPixmap>
 #include <QtGui/QWheelEvent>
 #include <QtWidgets/QGraphicsRectItem>
+#include <algorithm>
+#include <cmath>
 
 namespace sanescan {
 
@@ -30,12 +36,24 @@ namespace {
     {
         bar->setValue(int(scale_mult * bar->value() + ((scale_mult - 1) * bar->pageStep() / 2)));
     }
+
+    // The maximum total size of tiles uploaded as pixmaps, in kilobytes
+    constexpr int TILE_CACHE_SIZE_KB = 256 * 1024;
+
+    // Zoom factor for a single wheel step (120 units of angle delta)
+    constexpr double WHEEL_STEP_ZOOM = 1.1;
 }
 
 struct ImageWidget::Private {
     QGraphicsScene* scene = nullptr; // parent widget is an owner
     QImage image;
+    std::shared_ptr<const ImageTilePyramid> pyramid;
+
+    // Tiles that have been converted to pixmaps. The key is computed by tile_cache_key()
+    QCache<std::uint64_t, QPixmap> tile_cache{TILE_CACHE_SIZE_KB};
+
     bool selection_enabled = false;
+    std::optional<QRectF> last_text_selection;
 
     ImageWidgetHighlightItem* highlight_item = nullptr;
     ImageWidgetSelectionItem* selection_item = nullptr;
@@ -47,19 +65,48 @@ ImageWidget::ImageWidget(QWidget *parent) :
 {
     d_->scene = new QGraphicsScene(this);
     setScene(d_->scene);
+
+    connect(this, &QGraphicsView::rubberBandChanged,
+            [this](QRect rubber_band_rect, QPointF from_scene_point, QPointF to_scene_point)
+    {
+        // Null rectangle is passed when the rubber band selection ends
+        if (rubber_band_rect.isNull()) {
+            if (d_->last_text_selection.has_value()) {
+                Q_EMIT text_selection_finished(d_->last_text_selection.value());
+                d_->last_text_selection.reset();
+            }
+            return;
+        }
+        d_->last_text_selection = QRectF(from_scene_point, to_scene_point).normalized();
+    });
 }
 
 ImageWidget::~ImageWidget() = default;
 
-void ImageWidget::set_image(const QImage& image)
+namespace {
+
+std::uint64_t tile_cache_key(int level, int tile_x, int tile_y)
+{
+    return (static_cast<std::uint64_t>(level) << 48) |
+            (static_cast<std::uint64_t>(tile_y) << 24) |
+            static_cast<std::uint64_t>(tile_x);
+}
+
+} // namespace
+
+void ImageWidget::set_image(const QImage& image, std::shared_ptr<const ImageTilePyramid> pyramid)
 {
     d_->image = image;
+    d_->tile_cache.clear();
+    d_->pyramid = std::move(pyramid);
+
     if (!image.isNull()) {
         d_->scene->setSceneRect(0, 0, image.width(), image.height());
         fitInView(d_->image.rect(), Qt::KeepAspectRatio);
     } else {
         d_->scene->setSceneRect(0, 0, 300, 400);
     }
+    Q_EMIT visible_area_changed();
 }
 
 void ImageWidget::set_selection_enabled(bool enabled)
@@ -106,6 +153,31 @@ std::optional<QRectF> ImageWidget::get_selection() const
     return d_->selection_item->rect();
 }
 
+void ImageWidget::set_text_selection_enabled(bool enabled)
+{
+    setDragMode(enabled ? QGraphicsView::RubberBandDrag : QGraphicsView::NoDrag);
+}
+
+QRectF ImageWidget::visible_image_area() const
+{
+    if (d_->image.isNull()) {
+        return {};
+    }
+    return mapToScene(viewport()->rect()).boundingRect().intersected(QRectF(d_->image.rect()));
+}
+
+void ImageWidget::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    Q_EMIT visible_area_changed();
+}
+
+void ImageWidget::resizeEvent(QResizeEvent* event)
+{
+    QGraphicsView::resizeEvent(event);
+    Q_EMIT visible_area_changed();
+}
+
 void ImageWidget::wheelEvent(QWheelEvent* event)
 {
     if (event->modifiers().testFlag(Qt::ControlModifier)) {
@@ -113,10 +185,12 @@ void ImageWidget::wheelEvent(QWheelEvent* event)
         if (event->angleDelta().y() == 0)
             return;
 
-        // FIXME: this will work horrible with hi-res scrolling (too frequent updates)
-        float scaled_delta = (event->angleDelta().y() / 120.0f) * 0.1f;
-        float new_scale = scaled_delta >= 0 ? (1 + scaled_delta) : 1 / (1 - scaled_delta);
+        // Hi-res wheels send many events with small deltas. The zoom is computed so that these
+        // compose to the same total zoom as a single step. Painting cost does not depend on
+        // the image resolution, so frequent updates are cheap.
+        double new_scale = std::pow(WHEEL_STEP_ZOOM, event->angleDelta().y() / 120.0);
         scale(new_scale, new_scale);
+        Q_EMIT visible_area_changed();
     } else {
         QGraphicsView::wheelEvent(event);
     }
@@ -131,12 +205,75 @@ void ImageWidget::drawBackground(QPainter* painter, const QRectF& rect)
         if (image_rect != rect) {
             painter->fillRect(rect, background_color);
         }
-        painter->drawImage(image_rect, d_->image, image_rect);
+        if (d_->pyramid) {
+            draw_image_from_pyramid(painter, image_rect);
+        } else {
+            painter->drawImage(image_rect, d_->image, image_rect);
+        }
     } else {
         painter->fillRect(rect, background_color);
     }
 }
 
+void ImageWidget::draw_image_from_pyramid(QPainter* painter, const QRectF& image_rect)
+{
+    const auto& pyramid = *d_->pyramid;
+    auto transform = painter->worldTransform();
+    auto scale = std::hypot(transform.m11(), transform.m12());
+    auto level = pyramid.level_for_scale(scale);
+
+    const auto& level_image = pyramid.level_image(level);
+    double level_scale_x = static_cast<double>(d_->image.width()) / level_image.width();
+    double level_scale_y = static_cast<double>(d_->image.height()) / level_image.height();
+
+    // Range of visible tiles
+    auto tile_count = pyramid.tile_count(level);
+    double tile_scene_width = level_scale_x * ImageTilePyramid::TILE_SIZE;
+    double tile_scene_height = level_scale_y * ImageTilePyramid::TILE_SIZE;
+    auto to_tile_index = [](double value, int max_value)
+    {
+        return std::clamp(static_cast<int>(value), 0, max_value);
+    };
+    int tile_x1 = to_tile_index(std::floor(image_rect.left() / tile_scene_width),
+                                tile_count.width());
+    int tile_y1 = to_tile_index(std::floor(image_rect.top() / tile_scene_height),
+                                tile_count.height());
+    int tile_x2 = to_tile_index(std::ceil(image_rect.right() / tile_scene_width),
+                                tile_count.width());
+    int tile_y2 = to_tile_index(std::ceil(image_rect.bottom() / tile_scene_height),
+                                tile_count.height());
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, scale < 1);
+
+    for (int tile_y = tile_y1; tile_y < tile_y2; ++tile_y) {
+        for (int tile_x = tile_x1; tile_x < tile_x2; ++tile_x) {
+            auto tile_rect = pyramid.tile_rect(level, tile_x, tile_y);
+
+            // Only visible tiles are converted to pixmaps
+            auto key = tile_cache_key(level, tile_x, tile_y);
+            auto* pixmap = d_->tile_cache.object(key);
+            if (pixmap == nullptr) {
+                pixmap = new QPixmap(QPixmap::fromImage(level_image.copy(tile_rect)));
+                auto cost_kb = std::max(1, pixmap->width() * pixmap->height() *
+                                           pixmap->depth() / 8 / 1024);
+                if (!d_->tile_cache.insert(key, pixmap, cost_kb)) {
+                    // The tile is larger than the whole cache, in such case pixmap has already
+                    // been deleted.
+                    continue;
+                }
+            }
+
+            QRectF target_rect{tile_rect.x() * level_scale_x, tile_rect.y() * level_scale_y,
+                               tile_rect.width() * level_scale_x,
+                               tile_rect.height() * level_scale_y};
+            painter->drawPixmap(target_rect, *pixmap, QRectF(pixmap->rect()));
+        }
+    }
+
+    painter->restore();
+}
+
 void ImageWidget::mousePressEvent(QMouseEvent* event)
 {
     if (event->button() == Qt::LeftButton) {
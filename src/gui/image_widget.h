@@ -25,6 +25,8 @@
 
 namespace sanescan {
 
+class ImageTilePyramid;
+
 class ImageWidget : public QGraphicsView
 {
     Q_OBJECT
@@ -33,9 +35,16 @@ public:
     explicit ImageWidget(QWidget *parent = nullptr);
     ~ImageWidget() override;
 
-    /// Note that QImage uses reference semantics, so internally the widget refers to the under
-    /// lying data of the argument even after the call.
-    void set_image(const QImage& image);
+    /** Note that QImage uses reference semantics, so internally the widget refers to the under
+        lying data of the argument even after the call.
+
+        If the tile pyramid of the image is passed, then the image is painted from it, so that
+        the painting cost does not depend on the image resolution. Otherwise the full resolution
+        image is painted directly. The pyramid is expensive to build, so it is the
+        responsibility of the caller to prepare it outside the GUI thread.
+    */
+    void set_image(const QImage& image,
+                   std::shared_ptr<const ImageTilePyramid> pyramid = nullptr);
 
     /// Enables or disables selection box. In case selection is disabled the current selection
     /// is cleared.
@@ -51,17 +60,36 @@ public:
     /// Returns the current selection. If there's none, returns empty optional.
     std::optional<QRectF> get_selection() const;
 
+    /** Enables or disables text selection via rubber band. Text selection is independent of
+        the selection box and is not persistent: only `text_selection_finished` signal is emitted
+        once the user finishes dragging.
+    */
+    void set_text_selection_enabled(bool enabled);
+
+    /// Returns the part of the image that is currently visible, in image coordinates.
+    QRectF visible_image_area() const;
+
 Q_SIGNALS:
     /// Emitted when the selection box is changed. The coordinates are in image coordinates.
     void selection_changed(std::optional<QRectF> rect);
 
+    /// Emitted when the user finishes text selection. The coordinates are in image coordinates.
+    void text_selection_finished(QRectF rect);
+
+    /// Emitted when the visible part of the image changes due to scrolling, zooming or resizing.
+    void visible_area_changed();
+
 protected:
 
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent* event) override;
     void wheelEvent(QWheelEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void drawBackground(QPainter* painter, const QRectF& rect) override;
 
 private:
+    void draw_image_from_pyramid(QPainter* painter, const QRectF& image_rect);
+
     void setup_selection_items(const QRectF& rect, bool force_resizing_on_first_click);
     void destroy_selection_items();
 
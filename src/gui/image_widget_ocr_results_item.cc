@@ -0,0 +1,237 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "image_widget_ocr_results_item.h"
+#include <QtGui/QPainter>
+#include <QtGui/QPen>
+#include <QtWidgets/QGraphicsSceneHoverEvent>
+#include <QtWidgets/QStyleOptionGraphicsItem>
+
+namespace sanescan {
+
+namespace {
+
+// Text that would be smaller than this number of pixels on the screen is not painted
+constexpr double MIN_VISIBLE_TEXT_SIZE = 4;
+
+// Character boxes that would be smaller than this number of pixels on the screen are not painted
+constexpr double MIN_VISIBLE_CHAR_BOX_SIZE = 3;
+
+constexpr double BLUR_WARNING_PEN_WIDTH = 4;
+
+const QColor HIGHLIGHT_COLOR{255, 220, 0, 110};
+
+} // namespace
+
+struct ImageWidgetOcrResultsItem::Private {
+    std::shared_ptr<const OcrOverlayData> data;
+
+    bool show_text = true;
+    bool show_text_white_background = true;
+    bool show_bounding_boxes = true;
+    bool show_blur_warning_boxes = true;
+
+    std::vector<QRectF> highlighted_boxes;
+
+    QPen char_bounding_boxes_pen;
+    QPen blur_warning_pen;
+
+    // Reused across paint() calls to avoid allocations
+    std::vector<const OcrOverlayWord*> visible_words;
+};
+
+ImageWidgetOcrResultsItem::ImageWidgetOcrResultsItem() :
+    d_{std::make_unique<Private>()}
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptHoverEvents(true);
+    setAcceptedMouseButtons(Qt::NoButton);
+
+    d_->char_bounding_boxes_pen.setWidth(1);
+    d_->char_bounding_boxes_pen.setColor(Qt::black);
+    d_->char_bounding_boxes_pen.setStyle(Qt::SolidLine);
+
+    d_->blur_warning_pen.setWidth(BLUR_WARNING_PEN_WIDTH);
+    d_->blur_warning_pen.setColor(Qt::red);
+    d_->blur_warning_pen.setStyle(Qt::SolidLine);
+}
+
+ImageWidgetOcrResultsItem::~ImageWidgetOcrResultsItem() = default;
+
+void ImageWidgetOcrResultsItem::set_data(std::shared_ptr<const OcrOverlayData> data)
+{
+    prepareGeometryChange();
+    d_->data = std::move(data);
+    setToolTip({});
+    update();
+}
+
+void ImageWidgetOcrResultsItem::clear()
+{
+    d_->highlighted_boxes.clear();
+    set_data(nullptr);
+}
+
+void ImageWidgetOcrResultsItem::set_show_text(bool show)
+{
+    d_->show_text = show;
+    update();
+}
+
+void ImageWidgetOcrResultsItem::set_show_text_white_background(bool show)
+{
+    d_->show_text_white_background = show;
+    update();
+}
+
+void ImageWidgetOcrResultsItem::set_show_bounding_boxes(bool show)
+{
+    d_->show_bounding_boxes = show;
+    update();
+}
+
+void ImageWidgetOcrResultsItem::set_show_blur_warning_boxes(bool show)
+{
+    d_->show_blur_warning_boxes = show;
+    update();
+}
+
+void ImageWidgetOcrResultsItem::set_highlighted_boxes(const std::vector<QRectF>& boxes)
+{
+    d_->highlighted_boxes = boxes;
+    update();
+}
+
+void ImageWidgetOcrResultsItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option,
+                                      QWidget* widget)
+{
+    if (!d_->data) {
+        return;
+    }
+
+    const auto& data = *d_->data;
+    const auto& exposed_rect = option->exposedRect;
+    auto lod = option->levelOfDetailFromTransform(painter->worldTransform());
+
+    auto& visible_words = d_->visible_words;
+    visible_words.clear();
+    for (const auto& word : data.words) {
+        if (word.bounds.intersects(exposed_rect)) {
+            visible_words.push_back(&word);
+        }
+    }
+
+    painter->save();
+
+    // The painting order corresponds to the order in which separate layers would be stacked:
+    // text background, text, character boxes, blur warnings.
+    if (d_->show_text_white_background) {
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(Qt::white);
+        for (const auto* word : visible_words) {
+            painter->drawPolygon(word->background);
+        }
+    }
+
+    if (d_->show_text) {
+        auto world_transform = painter->worldTransform();
+        painter->setPen(Qt::black);
+
+        std::size_t curr_font_index = data.fonts.size();
+        for (const auto* word : visible_words) {
+            const auto& font = data.fonts[word->font_index];
+            if (font.pixel_size * lod < MIN_VISIBLE_TEXT_SIZE) {
+                continue;
+            }
+            if (word->font_index != curr_font_index) {
+                painter->setFont(font.font);
+                curr_font_index = word->font_index;
+            }
+            for (const auto& run : word->glyph_runs) {
+                painter->setWorldTransform(run.transform * world_transform);
+                painter->drawText(QPointF(0, font.ascent), run.text);
+            }
+        }
+        painter->setWorldTransform(world_transform);
+    }
+
+    if (d_->show_bounding_boxes) {
+        painter->setPen(d_->char_bounding_boxes_pen);
+        painter->setBrush(Qt::NoBrush);
+        for (const auto* word : visible_words) {
+            if (word->box.height() * lod < MIN_VISIBLE_CHAR_BOX_SIZE) {
+                continue;
+            }
+            for (const auto& box : word->char_boxes) {
+                painter->drawRect(box);
+            }
+        }
+    }
+
+    if (d_->show_blur_warning_boxes) {
+        painter->setPen(d_->blur_warning_pen);
+        painter->setBrush(Qt::NoBrush);
+        for (const auto& box : data.blur_boxes) {
+            if (box.intersects(exposed_rect)) {
+                painter->drawRect(box);
+            }
+        }
+    }
+
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(HIGHLIGHT_COLOR);
+    for (const auto& box : d_->highlighted_boxes) {
+        if (box.intersects(exposed_rect)) {
+            painter->drawRect(box);
+        }
+    }
+
+    painter->restore();
+}
+
+QRectF ImageWidgetOcrResultsItem::boundingRect() const
+{
+    if (!d_->data) {
+        return {};
+    }
+    auto margin = BLUR_WARNING_PEN_WIDTH / 2;
+    return d_->data->bounds.adjusted(-margin, -margin, margin, margin);
+}
+
+void ImageWidgetOcrResultsItem::hoverMoveEvent(QGraphicsSceneHoverEvent* event)
+{
+    QString tooltip;
+    if (d_->data) {
+        auto pos = event->pos();
+        const auto* word = (d_->show_text || d_->show_bounding_boxes)
+                ? d_->data->word_at(pos) : nullptr;
+        if (word) {
+            tooltip = word->tooltip;
+        } else if (d_->show_blur_warning_boxes &&
+                   !d_->data->index->blurred_words_at(static_cast<std::int32_t>(pos.x()),
+                                                      static_cast<std::int32_t>(pos.y())).empty())
+        {
+            tooltip = QString("The text is blurry");
+        }
+    }
+    setToolTip(tooltip);
+    QGraphicsItem::hoverMoveEvent(event);
+}
+
+} // namespace sanescan
@@ -0,0 +1,63 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_GUI_IMAGE_WIDGET_OCR_RESULTS_ITEM_H
+#define SANESCAN_GUI_IMAGE_WIDGET_OCR_RESULTS_ITEM_H
+
+#include "ocr_overlay_data.h"
+#include <QtWidgets/QGraphicsItem>
+#include <memory>
+
+namespace sanescan {
+
+/** Paints OCR results of a whole page. A single item is used instead of one item per character
+    so that scene construction is cheap and only the exposed part of the page is painted. Text
+    and character boxes are not painted when they would be too small to be legible.
+*/
+class ImageWidgetOcrResultsItem : public QGraphicsItem {
+public:
+    ImageWidgetOcrResultsItem();
+    ~ImageWidgetOcrResultsItem() override;
+
+    void set_data(std::shared_ptr<const OcrOverlayData> data);
+    void clear();
+
+    void set_show_text(bool show);
+    void set_show_text_white_background(bool show);
+    void set_show_bounding_boxes(bool show);
+    void set_show_blur_warning_boxes(bool show);
+
+    /// Sets boxes that are highlighted on top of the OCR results, e.g. search hits
+    void set_highlighted_boxes(const std::vector<QRectF>& boxes);
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+    QRectF boundingRect() const override;
+
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent* event) override;
+
+private:
+
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
+
+} // namespace sanescan
+
+#endif // SANESCAN_GUI_IMAGE_WIDGET_OCR_RESULTS_ITEM_H
@@ -19,7 +19,8 @@
 #ifndef SANESCAN_GUI_IMAGE_WIDGET_OCR_RESULTS_MANAGER_H
 #define SANESCAN_GUI_IMAGE_WIDGET_OCR_RESULTS_MANAGER_H
 
-#include "ocr/ocr_paragraph.h"
+#include "ocr_overlay_data.h"
+#include "ocr/ocr_results.h"
 
 #include <QtWidgets/QGraphicsScene>
 #include <memory>
@@ -32,20 +33,15 @@ public:
     ~ImageWidgetOcrResultsManager();
 
     void clear();
-    void setup(const std::vector<OcrParagraph>& results,
-               const std::vector<OcrBox>& blurry_areas);
+    void setup(const OcrResults& results);
+    void setup(std::shared_ptr<const OcrOverlayData> data);
     void set_show_text(bool show);
     void set_show_text_white_background(bool show);
     void set_show_bounding_boxes(bool show);
     void set_show_blur_warning_boxes(bool show);
+    void set_highlighted_boxes(const std::vector<QRectF>& boxes);
 
 private:
-    void clear_items(std::vector<QGraphicsItem*>& items);
-
-    void setup_word(const OcrWord& word);
-    void setup_blur_warning_area(const OcrBox& area);
-    void set_tooltip(QGraphicsItem* item, const OcrWord& word);
-
     struct Private;
     std::unique_ptr<Private> d_;
 };
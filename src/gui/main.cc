@@ -18,6 +18,8 @@
 
 #include "main_window.h"
 #include "version.h"
+#include "util/trace.h"
+#include <QtCore/QCommandLineParser>
 #include <QtWidgets/QApplication>
 
 int main(int argc, char* argv[])
@@ -27,8 +29,31 @@ int main(int argc, char* argv[])
     QCoreApplication::setApplicationName("sanescan");
     QCoreApplication::setApplicationVersion(SANESCAN_VERSION);
 
-    sanescan::MainWindow main_window;
-    main_window.show();
-
-    return app.exec();
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption trace_option("trace",
+                                    "Write Chrome trace-event JSON to the given file. Tracing can "
+                                    "also be enabled via the SANESCAN_TRACE environment variable.",
+                                    "path");
+    parser.addOption(trace_option);
+    parser.process(app);
+
+    if (parser.isSet(trace_option)) {
+        sanescan::trace_start(parser.value(trace_option).toStdString());
+    } else {
+        sanescan::trace_start_from_env();
+    }
+    sanescan::trace_set_thread_name("GUI");
+
+    int result = 0;
+    {
+        sanescan::MainWindow main_window;
+        main_window.show();
+        result = app.exec();
+    }
+
+    // The main window is destroyed first so that the trace includes the shutdown of OCR jobs
+    sanescan::trace_stop();
+    return result;
 }
@@ -21,18 +21,28 @@
 #include "page_manager.h"
 #include "image_widget.h"
 #include "image_widget_ocr_results_manager.h"
+#include "page_display_cache.h"
 #include "qimage_utils.h"
 #include "scan_settings_widget.h"
 #include "scan_page.h"
+#include "telemetry_dialog.h"
 #include "ui_main_window.h"
 #include "pagelist/page_list_model.h"
 #include "pagelist/page_list_view_delegate.h"
+#include "pagelist/thumbnail_generator.h"
 #include "../util/math.h"
+#include "../ocr/ocr_search_index.h"
+#include "../ocr/ocr_spatial_index.h"
 #include "../lib/scan_area_utils.h"
 
+#include <QtGui/QClipboard>
+#include <QtGui/QGuiApplication>
+#include <QtWidgets/QActionGroup>
 #include <QtWidgets/QFileDialog>
+#include <QtWidgets/QInputDialog>
 #include <QtWidgets/QMessageBox>
 
+#include <cmath>
 #include <filesystem>
 #include <iostream>
 #include <optional>
@@ -42,6 +52,26 @@ namespace sanescan {
 
 namespace {
 
+// The memory the display data of recently viewed pages may use. A 300 dpi A4 color page needs
+// about 45 MB including its tile pyramid.
+constexpr std::size_t DISPLAY_CACHE_MAX_SIZE_BYTES = 512 * 1024 * 1024;
+
+// Display data is prefetched for pages that are at most this many positions away from the
+// active page.
+constexpr unsigned PREFETCH_PAGE_DISTANCE = 2;
+
+// Search queries of at least this length also match words that differ by a single character,
+// which helps to find words that have been recognized with small mistakes.
+constexpr int FUZZY_SEARCH_MIN_QUERY_LENGTH = 5;
+
+QImage placeholder_thumbnail()
+{
+    // TODO: add a proper placeholder image here
+    auto image = QImage(100, 100, QImage::Format_Mono);
+    image.fill(255);
+    return image;
+}
+
 QRectF scan_space_to_scene_space(const QRectF& rect, double dpi)
 {
     return QRectF{mm_to_inch(rect.left()) * dpi,
@@ -57,10 +87,17 @@ struct MainWindow::Private {
     PageManager manager;
 
     std::unique_ptr<ImageWidgetOcrResultsManager> ocr_results_manager;
+    PageDisplayCache display_cache{DISPLAY_CACHE_MAX_SIZE_BYTES};
 
     std::unique_ptr<PageListModel> page_list_model;
+    ThumbnailGenerator thumbnail_generator;
 
     unsigned active_page_index = 0;
+
+    OcrSearchIndex search_index;
+    std::vector<OcrSearchHit> search_hits;
+    std::size_t curr_search_hit = 0;
+    QString last_search_query;
 };
 
 MainWindow::MainWindow(QWidget *parent) :
@@ -79,12 +116,42 @@ MainWindow::MainWindow(QWidget *parent) :
             std::make_unique<ImageWidgetOcrResultsManager>(d_->ui->image_area->scene());
 
     connect(d_->ui->action_about, &QAction::triggered, [this](){ present_about_dialog(); });
+    connect(d_->ui->action_show_telemetry, &QAction::triggered,
+            [this](){ present_telemetry_dialog(); });
     connect(d_->ui->action_save_current_image, &QAction::triggered,
             [this](){ save_current_page(); });
     connect(d_->ui->action_save_all_pages, &QAction::triggered,
             [this](){ save_all_pages(); });
     connect(d_->ui->action_save_all_pages_with_ocr, &QAction::triggered,
             [this](){ save_all_pages_with_ocr(); });
+    connect(d_->ui->action_share_duplicate_page_images, &QAction::toggled,
+            [this](bool checked){ d_->manager.set_share_duplicate_page_images(checked); });
+
+    auto* ocr_policy_group = new QActionGroup(this);
+    ocr_policy_group->addAction(d_->ui->action_ocr_immediately);
+    ocr_policy_group->addAction(d_->ui->action_ocr_when_idle);
+    ocr_policy_group->addAction(d_->ui->action_ocr_on_demand);
+    connect(d_->ui->action_ocr_immediately, &QAction::triggered,
+            [this](){ d_->manager.set_ocr_policy(PageManager::OCR_IMMEDIATELY); });
+    connect(d_->ui->action_ocr_when_idle, &QAction::triggered,
+            [this](){ d_->manager.set_ocr_policy(PageManager::OCR_WHEN_IDLE); });
+    connect(d_->ui->action_ocr_on_demand, &QAction::triggered,
+            [this](){ d_->manager.set_ocr_policy(PageManager::OCR_ON_DEMAND); });
+    connect(d_->ui->action_select_ocr_regions, &QAction::toggled,
+            [this](bool){ update_ocr_results_manager(); });
+    connect(d_->ui->action_clear_ocr_regions, &QAction::triggered,
+            [this](){ clear_ocr_regions(); });
+    connect(d_->ui->action_rotate_page_cw, &QAction::triggered,
+            [this](){ add_geometric_edit(OcrGeometricEditType::ROTATE_90_CW); });
+    connect(d_->ui->action_rotate_page_ccw, &QAction::triggered,
+            [this](){ add_geometric_edit(OcrGeometricEditType::ROTATE_90_CCW); });
+    connect(d_->ui->action_find_text, &QAction::triggered, [this](){ find_text(); });
+    connect(d_->ui->action_find_next, &QAction::triggered, [this]()
+    {
+        if (!d_->search_hits.empty()) {
+            show_search_hit((d_->curr_search_hit + 1) % d_->search_hits.size());
+        }
+    });
 
     connect(&d_->manager, &PageManager::available_devices_changed, [this]()
     {
@@ -132,17 +199,16 @@ MainWindow::MainWindow(QWidget *parent) :
 
     connect(&d_->manager, &PageManager::page_image_changed, [this](unsigned page_index)
     {
+        auto& page = d_->manager.page(page_index);
+        d_->display_cache.invalidate(page.scan_id);
+        update_page_thumbnail(page);
         if (d_->active_page_index != page_index) {
             return;
         }
-        auto& page = d_->manager.page(page_index);
         if (!page.scanned_image.has_value()) {
             throw std::runtime_error("Document image changed, but it is not set");
         }
         d_->ui->image_area->set_image(qimage_from_cv_mat(page.scanned_image.value()));
-
-        // FIXME: should probably change thumbnails even for inactive images
-        d_->page_list_model->set_image(page.scan_id, get_page_thumbnail(page));
     });
 
     connect(&d_->manager, &PageManager::page_preview_image_changed,
@@ -157,7 +223,7 @@ MainWindow::MainWindow(QWidget *parent) :
             }
         }
 
-        d_->page_list_model->set_image(page.scan_id, get_page_thumbnail(page));
+        update_page_thumbnail(page);
         update_selection_to_settings();
     });
 
@@ -179,8 +245,13 @@ MainWindow::MainWindow(QWidget *parent) :
     {
         d_->ui->action_save_current_image->setEnabled(true);
         d_->ui->action_save_all_pages->setEnabled(true);
+        if (after_scan) {
+            // OCR is performed on save for pages that don't have OCR results yet
+            d_->ui->action_save_all_pages_with_ocr->setEnabled(true);
+        }
         auto& page = d_->manager.page(page_index);
-        d_->page_list_model->add_page(page.scan_id, get_page_thumbnail(page));
+        d_->page_list_model->add_page(page.scan_id, placeholder_thumbnail());
+        update_page_thumbnail(page);
         if (after_scan) {
             switch_to_page(page_index);
         }
@@ -190,12 +261,22 @@ MainWindow::MainWindow(QWidget *parent) :
     {
         d_->ui->action_save_all_pages_with_ocr->setEnabled(true);
 
+        auto& page = d_->manager.page(page_index);
+        d_->display_cache.invalidate(page.scan_id);
+        update_search_index(page);
         if (d_->active_page_index != page_index) {
             return;
         }
 
-        auto& page = d_->manager.page(page_index);
-        d_->ui->image_area->set_image(get_page_image(page));
+        show_page_image(page);
+        update_ocr_results_manager();
+    });
+    connect(&d_->manager, &PageManager::page_ocr_partial_results_changed,
+            [this](unsigned page_index)
+    {
+        if (d_->active_page_index != page_index) {
+            return;
+        }
         update_ocr_results_manager();
     });
 
@@ -219,13 +300,22 @@ MainWindow::MainWindow(QWidget *parent) :
 
     connect(d_->ui->image_area, &ImageWidget::selection_changed,
             [this](const auto& rect) { image_area_selection_changed(rect); });
+    connect(d_->ui->image_area, &ImageWidget::text_selection_finished,
+            [this](const QRectF& rect) { text_area_selected(rect); });
+    connect(d_->ui->image_area, &ImageWidget::visible_area_changed,
+            [this]() { update_ocr_priority_area(); });
 
     connect(d_->ui->tabs, &QTabWidget::currentChanged,
-            [this](int)
+            [this](int index)
     {
+        if (index == TAB_OCR) {
+            update_ocr_priority_area();
+            d_->manager.request_page_ocr(d_->active_page_index);
+        }
         auto& page = d_->manager.page(d_->active_page_index);
-        d_->ui->image_area->set_image(get_page_image(page));
+        show_page_image(page);
         update_ocr_results_manager();
+        prefetch_neighbour_pages(d_->active_page_index);
     });
 
     connect(d_->ui->ocr_settings, &OcrSettingsWidget::options_changed,
@@ -246,6 +336,18 @@ MainWindow::MainWindow(QWidget *parent) :
     d_->ui->page_list->setModel(d_->page_list_model.get());
     d_->ui->page_list->setItemDelegate(new PageListViewDelegate(d_->ui->page_list));
 
+    connect(&d_->thumbnail_generator, &ThumbnailGenerator::thumbnails_ready,
+            [this](std::uint64_t identifier, const std::vector<QImage>& levels)
+    {
+        d_->page_list_model->set_images(identifier, levels);
+    });
+    connect(d_->page_list_model.get(), &PageListModel::thumbnail_size_changed, [this]()
+    {
+        for (unsigned i = 0; i < d_->manager.page_count(); ++i) {
+            update_page_thumbnail(d_->manager.page(i));
+        }
+    });
+
     connect(d_->ui->page_list->selectionModel(), &QItemSelectionModel::selectionChanged,
             [this](const QItemSelection& selected, const QItemSelection& deselected)
     {
@@ -263,6 +365,14 @@ void MainWindow::present_about_dialog()
     dialog.exec();
 }
 
+void MainWindow::present_telemetry_dialog()
+{
+    // The dialog is not modal so that the metrics can be observed while scanning
+    auto* dialog = new TelemetryDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
 void MainWindow::start_scanning(ScanType type)
 {
     d_->manager.start_scan(d_->active_page_index, type);
@@ -271,32 +381,43 @@ void MainWindow::start_scanning(ScanType type)
     }
 }
 
-QImage MainWindow::get_page_thumbnail(const ScanPage& page)
+void MainWindow::update_page_thumbnail(const ScanPage& page)
 {
-    // FIXME: resize images to smaller size to avoid wasting excessive amounts of memory
+    // Only the downscaled thumbnails are kept in the page list model. Pages without any image
+    // keep the placeholder thumbnail.
+    const cv::Mat* image = nullptr;
     if (page.scanned_image.has_value()) {
-        return qimage_from_cv_mat(page.scanned_image.value()).copy();
+        image = &page.scanned_image.value();
+    } else if (page.preview_image.has_value()) {
+        image = &page.preview_image.value();
     }
-    if (page.preview_image.has_value()) {
-        return qimage_from_cv_mat(page.preview_image.value()).copy();
+    if (image == nullptr) {
+        return;
     }
-    // TODO: add a placeholder image here
-    auto image = QImage(100, 100, QImage::Format_Mono);
-    image.fill(255);
-    return image;
+    d_->thumbnail_generator.generate(page.scan_id, *image,
+                                     d_->page_list_model->thumbnail_size());
 }
 
-QImage MainWindow::get_page_image(const ScanPage& page)
+void MainWindow::show_page_image(const ScanPage& page)
 {
     if (d_->ui->tabs->currentIndex() == TAB_OCR && page.ocr_results.has_value()) {
-        // FIXME: store a reference somewhere so the copy is not needed
-        return qimage_from_cv_mat(page.ocr_results->adjusted_image).copy();
+        auto data = d_->display_cache.get(page, true);
+        d_->ui->image_area->set_image(data->image, data->pyramid);
+        return;
     }
     if (page.scanned_image.has_value()) {
-        return qimage_from_cv_mat(page.scanned_image.value()).copy();
+        if (!page.scan_progress.has_value()) {
+            auto data = d_->display_cache.get(page, false);
+            d_->ui->image_area->set_image(data->image, data->pyramid);
+            return;
+        }
+        // The image is changing during the scan, so there's no point in caching it
+        d_->ui->image_area->set_image(qimage_from_cv_mat(page.scanned_image.value()));
+        return;
     }
     if (page.preview_image.has_value()) {
-        return qimage_from_cv_mat(page.preview_image.value()).copy();
+        d_->ui->image_area->set_image(qimage_from_cv_mat(page.preview_image.value()));
+        return;
     }
     throw std::runtime_error("Could not get page image. This should never happen");
 }
@@ -318,17 +439,45 @@ void MainWindow::switch_to_page(unsigned page_index)
     if (page.scanned_image.has_value()) {
         d_->ui->tabs->setTabEnabled(TAB_OCR, true);
         update_ocr_tab_to_settings();
+        if (d_->ui->tabs->currentIndex() == TAB_OCR) {
+            d_->manager.request_page_ocr(page_index);
+        }
     } else {
         d_->ui->tabs->setTabEnabled(TAB_OCR, false);
         d_->ui->tabs->setCurrentIndex(TAB_SCANNING);
     }
-    d_->ui->image_area->set_image(get_page_image(page));
+    show_page_image(page);
     d_->ui->label_ocr_progress->setVisible(page.ocr_progress.has_value());
     d_->ui->label_blurry_warning->setVisible(page.ocr_results.has_value() &&
                                              page.ocr_results->blurred_words.size() > 2);
 
     update_ocr_results_manager();
     update_selection_to_settings();
+    prefetch_neighbour_pages(page_index);
+}
+
+void MainWindow::prefetch_neighbour_pages(unsigned page_index)
+{
+    bool ocr_tab = d_->ui->tabs->currentIndex() == TAB_OCR;
+
+    auto prefetch_page = [&](unsigned index)
+    {
+        if (index >= d_->manager.page_count()) {
+            return;
+        }
+        auto& page = d_->manager.page(index);
+        if (page.scan_progress.has_value()) {
+            return;
+        }
+        d_->display_cache.prefetch(page, ocr_tab && page.ocr_results.has_value());
+    };
+
+    for (unsigned distance = 1; distance <= PREFETCH_PAGE_DISTANCE; ++distance) {
+        prefetch_page(page_index + distance);
+        if (page_index >= distance) {
+            prefetch_page(page_index - distance);
+        }
+    }
 }
 
 void MainWindow::update_selection_to_settings()
@@ -400,6 +549,7 @@ void MainWindow::update_ocr_results_manager()
 {
     auto& page = d_->manager.page(d_->active_page_index);
 
+    bool selecting_regions = d_->ui->action_select_ocr_regions->isChecked();
     if (d_->ui->tabs->currentIndex() == TAB_OCR && page.ocr_results) {
         bool should_highlight = d_->ui->ocr_settings->should_highlight_text();
         d_->ocr_results_manager->set_show_bounding_boxes(should_highlight);
@@ -407,10 +557,218 @@ void MainWindow::update_ocr_results_manager()
         d_->ocr_results_manager->set_show_text_white_background(should_highlight);
         d_->ocr_results_manager->set_show_blur_warning_boxes(should_highlight);
 
-        d_->ocr_results_manager->setup(page.ocr_results->adjusted_paragraphs,
-                                       page.ocr_results->blurred_words);
+        d_->ocr_results_manager->setup(d_->display_cache.get(page, true)->overlay);
+        d_->ui->image_area->set_text_selection_enabled(true);
+
+        std::vector<QRectF> highlighted_boxes;
+        for (const auto& hit : d_->search_hits) {
+            if (hit.page_id == page.scan_id) {
+                highlighted_boxes.emplace_back(hit.box.x1, hit.box.y1,
+                                               hit.box.width(), hit.box.height());
+            }
+        }
+        d_->ocr_results_manager->set_highlighted_boxes(highlighted_boxes);
+    } else if (d_->ui->tabs->currentIndex() == TAB_OCR && !page.ocr_partial_paragraphs.empty()) {
+        // Partial results are shown as they arrive. They are small compared to the final
+        // results, so they are not cached.
+        OcrResults partial_results;
+        partial_results.adjusted_paragraphs = page.ocr_partial_paragraphs;
+        partial_results.adjusted_index = std::make_shared<const OcrSpatialIndex>(
+                    partial_results.adjusted_paragraphs, std::vector<OcrBox>{});
+        d_->ocr_results_manager->setup(partial_results);
+        d_->ocr_results_manager->set_highlighted_boxes({});
+        d_->ui->image_area->set_text_selection_enabled(selecting_regions);
     } else {
         d_->ocr_results_manager->clear();
+        d_->ui->image_area->set_text_selection_enabled(
+                    selecting_regions && d_->ui->tabs->currentIndex() == TAB_OCR);
+    }
+}
+
+void MainWindow::update_ocr_priority_area()
+{
+    if (d_->ui->tabs->currentIndex() != TAB_OCR ||
+        d_->active_page_index >= d_->manager.page_count())
+    {
+        return;
+    }
+    auto& page = d_->manager.page(d_->active_page_index);
+    if (page.ocr_results.has_value()) {
+        return;
+    }
+
+    // Until OCR results are available the scanned image is shown, so image coordinates are the
+    // same as the coordinates that OCR uses.
+    auto area = d_->ui->image_area->visible_image_area();
+    d_->manager.set_ocr_priority_area(d_->active_page_index,
+                                      OcrBox{static_cast<std::int32_t>(std::floor(area.left())),
+                                             static_cast<std::int32_t>(std::floor(area.top())),
+                                             static_cast<std::int32_t>(std::ceil(area.right())),
+                                             static_cast<std::int32_t>(std::ceil(area.bottom()))});
+}
+
+void MainWindow::copy_text_in_area(const QRectF& rect)
+{
+    auto& page = d_->manager.page(d_->active_page_index);
+    if (d_->ui->tabs->currentIndex() != TAB_OCR || !page.ocr_results.has_value() ||
+        !page.ocr_results->adjusted_index)
+    {
+        return;
+    }
+
+    OcrBox area{static_cast<std::int32_t>(std::floor(rect.left())),
+                static_cast<std::int32_t>(std::floor(rect.top())),
+                static_cast<std::int32_t>(std::ceil(rect.right())),
+                static_cast<std::int32_t>(std::ceil(rect.bottom()))};
+    auto words = page.ocr_results->adjusted_index->words_in_rect(area);
+    if (words.empty()) {
+        return;
+    }
+
+    auto text = get_text_in_reading_order(page.ocr_results->adjusted_paragraphs, words);
+    QGuiApplication::clipboard()->setText(QString::fromStdString(text));
+    statusBar()->showMessage(tr("Copied %1 words to clipboard").arg(words.size()), 3000);
+}
+
+void MainWindow::text_area_selected(const QRectF& rect)
+{
+    if (d_->ui->action_select_ocr_regions->isChecked()) {
+        add_ocr_region(rect);
+    } else {
+        copy_text_in_area(rect);
+    }
+}
+
+void MainWindow::add_ocr_region(const QRectF& rect)
+{
+    auto& page = d_->manager.page(d_->active_page_index);
+    if (d_->ui->tabs->currentIndex() != TAB_OCR || !page.scanned_image.has_value()) {
+        return;
+    }
+
+    // Regions are in the coordinates of the scanned image. These are the same as the
+    // coordinates of the displayed image unless the image has been rotated during OCR or edited.
+    if (!page.ocr_options.geometric_edits.empty()) {
+        statusBar()->showMessage(tr("Areas can't be selected on a page that has been rotated."),
+                                 5000);
+        return;
+    }
+    if (page.ocr_results.has_value() && page.ocr_results->adjust_angle != 0) {
+        statusBar()->showMessage(tr("Areas can't be selected on a page that has been rotated "
+                                    "during OCR. Select \"Recognize whole page\" first."), 5000);
+        return;
+    }
+
+    OcrBox region{static_cast<std::int32_t>(std::floor(rect.left())),
+                  static_cast<std::int32_t>(std::floor(rect.top())),
+                  static_cast<std::int32_t>(std::ceil(rect.right())),
+                  static_cast<std::int32_t>(std::ceil(rect.bottom()))};
+    if (region.width() <= 0 || region.height() <= 0) {
+        return;
+    }
+
+    auto options = page.ocr_options;
+    options.regions.push_back(region);
+    d_->manager.set_page_ocr_options(d_->active_page_index, options);
+    update_ocr_tab_to_settings();
+    statusBar()->showMessage(tr("Recognizing %1 selected areas").arg(options.regions.size()),
+                             3000);
+}
+
+void MainWindow::clear_ocr_regions()
+{
+    d_->ui->action_select_ocr_regions->setChecked(false);
+    auto& page = d_->manager.page(d_->active_page_index);
+    if (!page.scanned_image.has_value() || page.ocr_options.regions.empty()) {
+        return;
+    }
+    auto options = page.ocr_options;
+    options.regions.clear();
+    d_->manager.set_page_ocr_options(d_->active_page_index, options);
+    update_ocr_tab_to_settings();
+}
+
+void MainWindow::add_geometric_edit(OcrGeometricEditType type)
+{
+    auto& page = d_->manager.page(d_->active_page_index);
+    if (!page.scanned_image.has_value()) {
+        return;
+    }
+
+    // If the page has already been recognized, the results are transformed without running
+    // the recognition again
+    auto options = page.ocr_options;
+    OcrGeometricEdit edit;
+    edit.type = type;
+    options.geometric_edits.push_back(edit);
+    d_->manager.set_page_ocr_options(d_->active_page_index, options);
+    update_ocr_tab_to_settings();
+}
+
+void MainWindow::find_text()
+{
+    bool ok = false;
+    auto query = QInputDialog::getText(this, tr("Find text"), tr("Text to find in all pages:"),
+                                       QLineEdit::Normal, d_->last_search_query, &ok).trimmed();
+    if (!ok || query.isEmpty()) {
+        return;
+    }
+    d_->last_search_query = query;
+
+    OcrSearchOptions options;
+    options.prefix = true;
+    options.max_edit_distance = query.size() >= FUZZY_SEARCH_MIN_QUERY_LENGTH ? 1 : 0;
+    d_->search_hits = d_->search_index.search(query.toStdString(), options);
+    d_->ui->action_find_next->setEnabled(!d_->search_hits.empty());
+
+    if (d_->search_hits.empty()) {
+        statusBar()->showMessage(tr("No matches found"), 3000);
+        update_ocr_results_manager();
+        return;
+    }
+    show_search_hit(0);
+}
+
+void MainWindow::show_search_hit(std::size_t hit_index)
+{
+    d_->curr_search_hit = hit_index;
+    const auto& hit = d_->search_hits.at(hit_index);
+
+    for (unsigned i = 0; i < d_->manager.page_count(); ++i) {
+        if (d_->manager.page(i).scan_id != hit.page_id) {
+            continue;
+        }
+        if (i != d_->active_page_index) {
+            switch_to_page(i);
+        }
+        if (d_->ui->tabs->currentIndex() != TAB_OCR) {
+            d_->ui->tabs->setCurrentIndex(TAB_OCR);
+        }
+        update_ocr_results_manager();
+        d_->ui->image_area->centerOn(hit.box.x1 + hit.box.width() / 2.0,
+                                     hit.box.y1 + hit.box.height() / 2.0);
+        statusBar()->showMessage(tr("Match %1 of %2 on page %3").arg(hit_index + 1)
+                                 .arg(d_->search_hits.size()).arg(i + 1));
+        return;
+    }
+}
+
+void MainWindow::update_search_index(const ScanPage& page)
+{
+    if (page.ocr_results.has_value()) {
+        d_->search_index.set_page(page.scan_id, page.ocr_results->adjusted_paragraphs);
+    } else {
+        d_->search_index.remove_page(page.scan_id);
+    }
+
+    // Hits of the page refer to the previous results
+    auto removed = std::erase_if(d_->search_hits, [&](const auto& hit)
+    {
+        return hit.page_id == page.scan_id;
+    });
+    if (removed > 0) {
+        d_->curr_search_hit = 0;
+        d_->ui->action_find_next->setEnabled(!d_->search_hits.empty());
     }
 }
 
@@ -41,19 +41,31 @@ public:
     ~MainWindow() override;
 
     void present_about_dialog();
+    void present_telemetry_dialog();
 
 private:
     void start_scanning(ScanType type);
 
-    QImage get_page_thumbnail(const ScanPage& page);
-    QImage get_page_image(const ScanPage& page);
+    void update_page_thumbnail(const ScanPage& page);
+    void show_page_image(const ScanPage& page);
 
     void switch_to_page(unsigned page_index);
+    void prefetch_neighbour_pages(unsigned page_index);
 
     void update_selection_to_settings();
     void image_area_selection_changed(const std::optional<QRectF>& rect);
     void update_ocr_tab_to_settings();
     void update_ocr_results_manager();
+    void update_ocr_priority_area();
+    void copy_text_in_area(const QRectF& rect);
+    void text_area_selected(const QRectF& rect);
+    void add_ocr_region(const QRectF& rect);
+    void clear_ocr_regions();
+    void add_geometric_edit(OcrGeometricEditType type);
+
+    void find_text();
+    void show_search_hit(std::size_t hit_index);
+    void update_search_index(const ScanPage& page);
 
     void save_all_pages();
     void save_all_pages_with_ocr();
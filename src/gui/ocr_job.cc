@@ -20,12 +20,33 @@
 #include "ocr/ocr_results_evaluator.h"
 #include "ocr/tesseract.h"
 #include "ocr/ocr_results_evaluator.h"
+#include "util/trace.h"
+#include "version.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
 
 namespace sanescan {
 
+namespace {
+
+std::filesystem::path get_capture_bundle_path(const std::filesystem::path& output_dir)
+{
+    static std::atomic<unsigned> next_bundle_index = 0;
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    return output_dir / ("ocr-" + std::to_string(now) + "-" +
+                         std::to_string(next_bundle_index++));
+}
+
+} // namespace
+
 OcrJob::OcrJob(const cv::Mat& source_image, const OcrOptions& options,
                const OcrOptions& old_options, const std::optional<OcrResults>& old_results,
-               std::size_t job_id, std::function<void()> on_finish) :
+               std::size_t job_id, std::function<void()> on_finish,
+               PartialResultsCallback on_partial_results,
+               const std::optional<OcrCaptureOptions>& capture_options) :
     source_image_storage_{source_image},
     run_{cv::Mat(source_image_storage_.size.dims(),
                  source_image_storage_.size.p,
@@ -34,21 +55,105 @@ OcrJob::OcrJob(const cv::Mat& source_image, const OcrOptions& options,
                  source_image_storage_.step.p),
          options, old_options, old_results},
     job_id_{job_id},
-    on_finish_{on_finish}
+    on_finish_{on_finish},
+    on_partial_results_{std::move(on_partial_results)},
+    capture_options_{capture_options}
 {
+    if (capture_options_) {
+        capture_bundle_.emplace();
+        capture_bundle_->source_image = source_image_storage_;
+        capture_bundle_->options = options;
+        capture_bundle_->old_options = old_options;
+        capture_bundle_->old_results = old_results;
+        capture_bundle_->sanescan_version = SANESCAN_VERSION;
+        capture_bundle_->tesseract_version = tesseract_version();
+    }
+
+    if (on_partial_results_) {
+        run_.set_progress_callbacks([this]()
+        {
+            std::lock_guard lock{priority_area_mutex_};
+            return priority_area_;
+        }, on_partial_results_);
+    }
 }
 
 OcrJob::~OcrJob() = default;
 
+void OcrJob::set_reference(const OcrResults& reference)
+{
+    run_.set_reference(reference);
+    if (capture_bundle_) {
+        capture_bundle_->reference = reference;
+    }
+}
+
+void OcrJob::set_batch_context(std::shared_ptr<OcrBatchContext> context)
+{
+    run_.set_batch_context(std::move(context));
+    has_batch_context_ = true;
+}
+
 void OcrJob::execute()
 {
-    run_.execute();
+    {
+        SANESCAN_TRACE_SPAN("ocr", "ocr_job");
+        auto start = std::chrono::steady_clock::now();
+        run_.execute();
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        maybe_capture(duration.count());
+    }
+
+    // The mutex is held until the job is no longer accessed from the worker thread. This ensures
+    // that the job is not destroyed by observers of finished() while on_finish_ is still running.
+    std::lock_guard lock{finished_mutex_};
     finished_ = true;
+    finished_cv_.notify_all();
     on_finish_();
 }
 
+bool OcrJob::finished() const
+{
+    std::lock_guard lock{finished_mutex_};
+    return finished_;
+}
+
+void OcrJob::wait_finished()
+{
+    std::unique_lock lock{finished_mutex_};
+    finished_cv_.wait(lock, [this]() { return finished_; });
+}
+
+void OcrJob::set_priority_area(const OcrBox& area)
+{
+    std::lock_guard lock{priority_area_mutex_};
+    priority_area_ = area;
+}
+
 void OcrJob::cancel()
 {
 }
 
+void OcrJob::maybe_capture(double duration_sec)
+{
+    if (!capture_options_ || duration_sec < capture_options_->min_duration_sec) {
+        return;
+    }
+
+    capture_bundle_->duration_sec = duration_sec;
+    capture_bundle_->stage_timings = run_.stage_timings();
+    if (has_batch_context_) {
+        // The priors are known only once the run has started
+        capture_bundle_->priors = run_.priors();
+    }
+
+    // Failure to capture must not affect the results of the job
+    try {
+        write_ocr_bundle(get_capture_bundle_path(capture_options_->output_dir),
+                         *capture_bundle_);
+    } catch (const std::exception& e) {
+        std::cerr << "SaneScan: Could not write OCR capture bundle: " << e.what() << "\n";
+    }
+}
+
 } // namespace sanescan
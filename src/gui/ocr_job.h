@@ -20,10 +20,12 @@
 #define SANESCAN_GUI_OCR_JOB_H
 
 #include "lib/job_queue.h"
+#include "ocr/ocr_bundle.h"
 #include "ocr/ocr_pipeline_run.h"
 
 #include <opencv2/core/mat.hpp>
-#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <optional>
 
 namespace sanescan {
@@ -31,9 +33,27 @@ namespace sanescan {
 // Note that we must
 struct OcrJob : IJob {
 public:
+    using PartialResultsCallback = std::function<void(const std::vector<OcrParagraph>&)>;
+
+    /** on_partial_results is called from the worker thread with the paragraphs of each text
+        block as soon as they are recognized. It may be empty if partial results are not needed.
+
+        If capture_options is set, then a bundle allowing to replay the job is written if the
+        job takes longer than the configured threshold.
+    */
     OcrJob(const cv::Mat& source_image, const OcrOptions& options,
            const OcrOptions& old_options, const std::optional<OcrResults>& old_results,
-           std::size_t job_id, std::function<void()> on_finish);
+           std::size_t job_id, std::function<void()> on_finish,
+           PartialResultsCallback on_partial_results = {},
+           const std::optional<OcrCaptureOptions>& capture_options = {});
+
+    /** Sets the results of a previous scan of the same page to reuse for the unchanged areas of
+        the source image. Must be called before the job is submitted.
+    */
+    void set_reference(const OcrResults& reference);
+
+    /// Sets the context of the batch of pages. Must be called before the job is submitted.
+    void set_batch_context(std::shared_ptr<OcrBatchContext> context);
 
     ~OcrJob() override;
     void execute() override;
@@ -41,9 +61,19 @@ public:
 
     OcrResults& results() { return run_.results(); }
     std::size_t job_id() const { return job_id_; }
-    bool finished() const { return finished_; }
+    bool finished() const;
+
+    /// Blocks the calling thread until the job finishes execution.
+    void wait_finished();
+
+    /** Sets the area of the source image whose text should be recognized first. May be called
+        while the job is executing.
+    */
+    void set_priority_area(const OcrBox& area);
 
 private:
+    void maybe_capture(double duration_sec);
+
     cv::Mat source_image_storage_;
 
     // cv::Mat contains an internal ref-counter. Thus simply doing cv::Mat x = run.source_image_; in
@@ -55,8 +85,21 @@ private:
 
     OcrPipelineRun run_;
     std::size_t job_id_ = 0;
-    std::atomic<bool> finished_;
+
+    mutable std::mutex finished_mutex_;
+    std::condition_variable finished_cv_;
+    bool finished_ = false;
     std::function<void()> on_finish_;
+    PartialResultsCallback on_partial_results_;
+
+    mutable std::mutex priority_area_mutex_;
+    OcrBox priority_area_;
+
+    // The bundle is prepared in the constructor so that the worker thread does not need to
+    // copy any cv::Mat instances. Only set if capture is enabled.
+    std::optional<OcrCaptureOptions> capture_options_;
+    std::optional<OcrBundle> capture_bundle_;
+    bool has_batch_context_ = false;
 };
 
 } // namespace sanescan
@@ -0,0 +1,313 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr_overlay_data.h"
+#include "font_metrics_cache.h"
+#include "ocr/ocr_geometry.h"
+#include <boost/locale/encoding.hpp>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#define SANESCAN_GUI_OCR_RESULTS_DEBUG 0
+
+namespace sanescan {
+
+namespace {
+    struct ParsedQString {
+        std::vector<QString> symbols;
+        QString string;
+    };
+
+    ParsedQString parse_utf8_string(const std::string& utf8_string)
+    {
+        // FIXME: ideally we should use ICU to properly split the string into graphemes. Currently
+        // we assume that OCR will only output graphemes that correspond to single Unicode code
+        // points.
+        auto text_utf32 = boost::locale::conv::utf_to_utf<char32_t>(utf8_string);
+        ParsedQString parsed;
+        parsed.symbols.reserve(text_utf32.size());
+        parsed.string.reserve(text_utf32.size() * 2);
+
+        for (std::size_t i = 0; i < text_utf32.size(); ++i) {
+            auto ch_utf16 = boost::locale::conv::utf_to_utf<char16_t>(text_utf32.substr(i, 1));
+            auto qch_utf16 = QString::fromStdU16String(ch_utf16);
+
+            parsed.string.append(qch_utf16);
+            parsed.symbols.push_back(std::move(qch_utf16));
+        }
+        return parsed;
+    }
+
+    struct PositioningParams {
+        bool enable_char_positioning = false;
+        double h_scale = 1;
+    };
+
+    PositioningParams get_character_positioning_params(const FontMetricsCache::Entry& font,
+                                                       const ParsedQString& parsed,
+                                                       const OcrWord& word)
+    {
+        auto rect = font.metrics.boundingRect(parsed.string);
+        double h_scale = word.box.width() / static_cast<double>(rect.width());
+
+        if (parsed.symbols.size() != word.char_boxes.size()) {
+            // If there are different number of recognized symbols compared to character boxes then
+            // we can only do word positioning.
+            return PositioningParams{false, h_scale};
+        }
+
+        if (h_scale < 1.5) {
+            // If the text spacing is not too large then it will still appear alright if rendered
+            // without character positioning
+            return PositioningParams{false, h_scale};
+        }
+
+        // Check if any of the character boxes have weird bounds
+        for (std::size_t i = 0; i < parsed.symbols.size(); ++i) {
+            auto symbol_rect = font.metrics.boundingRect(parsed.symbols[i]);
+            const auto& symbol_box = word.char_boxes[i];
+            if (symbol_rect.width() > symbol_box.width() * 1.5) {
+                return PositioningParams{false, h_scale};
+            }
+        }
+
+        return PositioningParams{true, 1.0};
+    }
+
+    QRectF qrectf_from_ocr_box(const OcrBox& box)
+    {
+        return QRectF(box.x1, box.y1, box.width(), box.height());
+    }
+
+    QString get_tooltip(const OcrWord& word)
+    {
+#if SANESCAN_GUI_OCR_RESULTS_DEBUG
+        return QString("%1 %2 %3 %4\n\"%5\"\nFont size: %6\nConfidence: %7")
+                .arg(word.box.x1)
+                .arg(word.box.y1)
+                .arg(word.box.width())
+                .arg(word.box.height())
+                .arg(word.content.c_str())
+                .arg(word.font_size)
+                .arg(static_cast<unsigned>(word.confidence * 100));
+#else
+        return QString("Confidence: %1").arg(static_cast<unsigned>(word.confidence * 100));
+#endif
+    }
+
+    class OverlayBuilder {
+    public:
+        OverlayBuilder(FontMetricsCache& metrics_cache) : metrics_cache_{metrics_cache} {}
+
+        void add_word(const OcrWord& word, const OcrWordRef& ref);
+        void add_blur_warning_area(const OcrBox& area);
+        OcrOverlayData release() { return std::move(data_); }
+
+    private:
+        std::size_t get_font_index(const FontMetricsCache::Entry& font_data);
+
+        // Adds a roughly horizontal word whose positions are mapped to the image by the given
+        // transform. The box is the word box in the image.
+        void add_leveled_word(const OcrWord& word, const OcrBox& box,
+                              const QTransform& to_image, const OcrWordRef& ref);
+
+        FontMetricsCache& metrics_cache_;
+        std::unordered_map<int, std::size_t> font_indices_;
+        OcrOverlayData data_;
+    };
+
+    std::size_t OverlayBuilder::get_font_index(const FontMetricsCache::Entry& font_data)
+    {
+        auto pixel_size = font_data.font.pixelSize();
+        auto it = font_indices_.find(pixel_size);
+        if (it != font_indices_.end()) {
+            return it->second;
+        }
+        auto index = data_.fonts.size();
+        data_.fonts.push_back(OcrOverlayFont{font_data.font,
+                                             static_cast<double>(font_data.metrics.ascent()),
+                                             pixel_size});
+        font_indices_.emplace(pixel_size, index);
+        return index;
+    }
+
+    void OverlayBuilder::add_word(const OcrWord& word, const OcrWordRef& ref)
+    {
+        auto quarter_turns = get_baseline_quarter_turns(word.baseline.angle);
+        if (quarter_turns == 0) {
+            add_leveled_word(word, word.box, QTransform{}, ref);
+            return;
+        }
+
+        // Words at a quarter turn, e.g. on pages rotated by 90 degrees, are positioned as
+        // horizontal words, because the positioning divides by the cosine of the baseline angle.
+        // The leveled word is rotated around the origin, so rotating it back is enough.
+        auto leveled_word = word;
+        level_ocr_word(leveled_word, quarter_turns);
+        QTransform to_image;
+        to_image.rotate(90 * quarter_turns);
+        add_leveled_word(leveled_word, word.box, to_image, ref);
+    }
+
+    void OverlayBuilder::add_leveled_word(const OcrWord& word, const OcrBox& box,
+                                          const QTransform& to_image, const OcrWordRef& ref)
+    {
+        auto parsed_string = parse_utf8_string(word.content);
+        if (parsed_string.symbols.empty()) {
+            return;
+        }
+
+        const auto& font_data = metrics_cache_.get_font_for_size(word.font_size);
+
+        OcrOverlayWord overlay_word;
+        overlay_word.font_index = get_font_index(font_data);
+        overlay_word.box = qrectf_from_ocr_box(box);
+        overlay_word.tooltip = get_tooltip(word);
+
+        // The code below positions character boxes on the canvas. We can't use a
+        // simple transform because all coordinates except character baseline are in
+        // image coordinates.
+        auto angle_sin = std::sin(word.baseline.angle);
+        auto angle_cos = std::cos(word.baseline.angle);
+        auto angle_tan = angle_sin / angle_cos;
+
+        // Get word coordinates at baseline
+        double word_x_baseline = word.box.x1;
+        double word_y_baseline = word.box.y2 +
+                word.baseline.y - word.baseline.x * angle_tan;
+
+        // Get word coordinates at top left corner
+        auto word_x = word_x_baseline + font_data.metrics.ascent() * angle_sin;
+        auto word_y = word_y_baseline - font_data.metrics.ascent() * angle_cos;
+        auto word_y_for_rect = word_y_baseline - font_data.metrics.capHeight() * angle_cos;
+
+        QRectF text_background_rect{word_x, word_y_for_rect,
+                                    (word.box.x2 - word.box.x1) / angle_cos, word.font_size};
+
+        QTransform background_transform;
+        background_transform.translate(word_x, word_y_for_rect);
+        background_transform.rotateRadians(word.baseline.angle);
+        background_transform.translate(-word_x, -word_y_for_rect);
+        background_transform *= to_image;
+        overlay_word.background = background_transform.map(QPolygonF(text_background_rect));
+
+        auto pos_params = get_character_positioning_params(font_data, parsed_string, word);
+
+        if (pos_params.enable_char_positioning) {
+            auto char_x = word_x;
+            auto char_y = word_y;
+
+            double curr_x = word.box.x1;
+
+            overlay_word.glyph_runs.reserve(parsed_string.symbols.size());
+            overlay_word.char_boxes.reserve(parsed_string.symbols.size());
+
+            for (std::size_t i = 0; i < parsed_string.symbols.size(); ++i) {
+                QTransform transform;
+                transform.rotateRadians(word.baseline.angle);
+                transform *= QTransform::fromTranslate(char_x, char_y);
+                transform *= to_image;
+                overlay_word.glyph_runs.push_back({parsed_string.symbols[i], transform});
+                overlay_word.char_boxes.push_back(
+                            to_image.mapRect(qrectf_from_ocr_box(word.char_boxes[i])));
+
+                auto next_x = (i == parsed_string.symbols.size() - 1)
+                        ? word.box.x2
+                        : word.char_boxes[i + 1].x1;
+
+                char_x += angle_cos * (next_x - curr_x);
+                char_y += angle_sin * (next_x - curr_x);
+
+                curr_x = next_x;
+            }
+        } else {
+            // QTransform::rotateRadians operates on counter-clockwise direction as opposed to
+            // QGraphicsItem::setRotation().
+            QTransform transform;
+            transform.scale(pos_params.h_scale, 1.0);
+            transform.rotateRadians(word.baseline.angle);
+            transform *= QTransform::fromTranslate(word_x, word_y);
+            transform *= to_image;
+            overlay_word.glyph_runs.push_back({parsed_string.string, transform});
+        }
+
+        // The text may extend outside the word box, so a margin of one line height is added.
+        auto margin = word.font_size;
+        overlay_word.bounds = overlay_word.background.boundingRect()
+                .united(overlay_word.box)
+                .adjusted(-margin, -margin, margin, margin);
+        data_.bounds = data_.bounds.united(overlay_word.bounds);
+        data_.words.push_back(std::move(overlay_word));
+        data_.word_refs.push_back(ref);
+    }
+
+    void OverlayBuilder::add_blur_warning_area(const OcrBox& area)
+    {
+        auto rect = qrectf_from_ocr_box(area);
+        data_.bounds = data_.bounds.united(rect);
+        data_.blur_boxes.push_back(rect);
+    }
+} // namespace
+
+const OcrOverlayWord* OcrOverlayData::word_at(const QPointF& pos) const
+{
+    if (!index) {
+        return nullptr;
+    }
+    auto refs = index->words_at(static_cast<std::int32_t>(std::floor(pos.x())),
+                                static_cast<std::int32_t>(std::floor(pos.y())));
+    for (const auto& ref : refs) {
+        auto it = std::lower_bound(word_refs.begin(), word_refs.end(), ref);
+        if (it != word_refs.end() && *it == ref) {
+            return &words[it - word_refs.begin()];
+        }
+    }
+    return nullptr;
+}
+
+OcrOverlayData prepare_ocr_overlay(const OcrResults& results, FontMetricsCache& metrics_cache)
+{
+    OverlayBuilder builder{metrics_cache};
+
+    const auto& paragraphs = results.adjusted_paragraphs;
+    for (std::uint32_t ip = 0; ip < paragraphs.size(); ++ip) {
+        const auto& paragraph = paragraphs[ip];
+        for (std::uint32_t il = 0; il < paragraph.lines.size(); ++il) {
+            const auto& line = paragraph.lines[il];
+            for (std::uint32_t iw = 0; iw < line.words.size(); ++iw) {
+                builder.add_word(line.words[iw], OcrWordRef{ip, il, iw});
+            }
+        }
+    }
+
+    for (const auto& area : results.blurred_words) {
+        builder.add_blur_warning_area(area);
+    }
+
+    auto data = builder.release();
+    data.index = results.adjusted_index;
+    if (!data.index) {
+        data.index = std::make_shared<const OcrSpatialIndex>(results.adjusted_paragraphs,
+                                                             results.blurred_words);
+    }
+    return data;
+}
+
+} // namespace sanescan
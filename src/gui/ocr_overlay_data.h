@@ -0,0 +1,86 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_GUI_OCR_OVERLAY_DATA_H
+#define SANESCAN_GUI_OCR_OVERLAY_DATA_H
+
+#include "ocr/ocr_results.h"
+
+#include <QtGui/QFont>
+#include <QtGui/QPolygonF>
+#include <QtGui/QTransform>
+#include <QtCore/QRectF>
+#include <QtCore/QString>
+#include <memory>
+#include <vector>
+
+namespace sanescan {
+
+class FontMetricsCache;
+
+struct OcrOverlayFont {
+    QFont font;
+    double ascent = 0;
+    int pixel_size = 0;
+};
+
+struct OcrOverlayGlyphRun {
+    QString text;
+    // Maps text coordinates (origin at the top left corner of the text) to scene coordinates
+    QTransform transform;
+};
+
+struct OcrOverlayWord {
+    std::size_t font_index = 0;
+    QRectF box;
+    QPolygonF background;
+    std::vector<OcrOverlayGlyphRun> glyph_runs;
+    std::vector<QRectF> char_boxes;
+
+    // Covers everything that is painted for the word
+    QRectF bounds;
+    QString tooltip;
+};
+
+/** Contains everything that is needed to paint OCR results on top of the page image. All
+    positioning computations are performed once when the data is prepared, so that painting
+    does not need to access the original OCR results or font metrics.
+*/
+struct OcrOverlayData {
+    std::vector<OcrOverlayFont> fonts;
+    std::vector<OcrOverlayWord> words;
+
+    // Positions of words within the source paragraphs. words[i] corresponds to word_refs[i].
+    // Words without content are not included, so the refs are sorted, but not contiguous.
+    std::vector<OcrWordRef> word_refs;
+
+    std::vector<QRectF> blur_boxes;
+    std::shared_ptr<const OcrSpatialIndex> index;
+    QRectF bounds;
+
+    /// Returns the word that is painted at the given position or nullptr if there's none.
+    const OcrOverlayWord* word_at(const QPointF& pos) const;
+};
+
+/// Prepares overlay data for the adjusted paragraphs and blurred words of OCR results
+OcrOverlayData prepare_ocr_overlay(const OcrResults& results, FontMetricsCache& metrics_cache);
+
+} // namespace sanescan
+
+#endif // SANESCAN_GUI_OCR_OVERLAY_DATA_H
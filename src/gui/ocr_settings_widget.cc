@@ -24,6 +24,9 @@ namespace sanescan {
 struct OcrSettingsWidget::Private {
     std::unique_ptr<Ui::OcrSettingsWidget> ui;
     bool is_updating_from_code = false;
+
+    // Options that are not edited by this widget (e.g. regions) are preserved from here
+    OcrOptions options;
 };
 
 OcrSettingsWidget::OcrSettingsWidget(QWidget *parent) :
@@ -61,6 +64,7 @@ OcrSettingsWidget::~OcrSettingsWidget() = default;
 
 void OcrSettingsWidget::set_options(const OcrOptions& options)
 {
+    d_->options = options;
     d_->is_updating_from_code = true;
     d_->ui->checkbox_orientation_detect->setChecked(options.fix_page_orientation);
     d_->ui->spinbox_orientation_fraction->setValue(
@@ -91,7 +95,7 @@ void OcrSettingsWidget::options_changed_impl()
         return;
     }
 
-    OcrOptions options;
+    auto options = d_->options;
     options.fix_page_orientation = d_->ui->checkbox_orientation_detect->isChecked();
     options.fix_page_orientation_min_text_fraction =
             d_->ui->spinbox_orientation_fraction->value() / 100.0;
@@ -104,6 +108,7 @@ void OcrSettingsWidget::options_changed_impl()
     options.keep_image_size_after_rotation = d_->ui->checkbox_rotate_keep_size->isChecked();
     options.min_word_confidence = d_->ui->spinbox_word_confidence->value() / 100.0;
     options.blur_detection_coef = d_->ui->spinbox_blur_detect->value();
+    d_->options = options;
     Q_EMIT options_changed(options);
 }
 
@@ -0,0 +1,277 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "page_display_cache.h"
+#include "font_metrics_cache.h"
+#include "qimage_utils.h"
+#include "lib/task_executor.h"
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace sanescan {
+
+namespace {
+
+struct CacheKey {
+    unsigned scan_id = 0;
+    bool with_ocr = false;
+
+    auto operator<=>(const CacheKey&) const = default;
+};
+
+using DisplayDataPtr = std::shared_ptr<const PageDisplayData>;
+
+// Returns the memory used by the display image and tile pyramid prepared from the given image.
+// See qimage_for_display_from_cv_mat() and ImageTilePyramid.
+std::size_t estimate_display_data_size(const cv::Mat& image)
+{
+    std::size_t width = image.size.p[1];
+    std::size_t height = image.size.p[0];
+    // 8-bit grayscale display images share the data with the page image
+    std::size_t bytes_per_pixel = 4;
+    if (image.channels() == 1) {
+        bytes_per_pixel = image.depth() == CV_8U ? 0 : 1;
+    }
+
+    // Level 0 of the pyramid shares the data with the display image
+    auto result = width * height * bytes_per_pixel;
+    while (width > ImageTilePyramid::TILE_SIZE || height > ImageTilePyramid::TILE_SIZE) {
+        width = std::max<std::size_t>(1, width / 2);
+        height = std::max<std::size_t>(1, height / 2);
+        result += width * height * 4;
+    }
+    return result;
+}
+
+bool is_future_ready(const std::shared_future<DisplayDataPtr>& future)
+{
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+} // namespace
+
+struct PageDisplayCache::Private {
+    // The display data of an entry is prepared only once, even if a task preparing it is
+    // scheduled again to run before the pending prefetches.
+    struct Preparation {
+        std::once_flag once;
+
+        // Refers to the data of Entry::image_storage as external data
+        cv::Mat image;
+
+        // Moved into the display image, so that the worker thread does not hold a reference
+        // to the storage once the preparation completes.
+        std::shared_ptr<const cv::Mat> image_storage;
+
+        std::optional<OcrResults> overlay_results;
+        DisplayDataPtr data;
+    };
+
+    struct Entry {
+        CacheKey key;
+
+        // The image is accessed from the worker thread as external data, so that no reference
+        // counting operations of cv::Mat happen outside the main thread. This member keeps the
+        // data alive until the entry and the display image sharing the data are destroyed. See
+        // OcrJob for more details.
+        std::shared_ptr<const cv::Mat> image_storage;
+
+        // Accessed by the scheduled tasks, thus the entry must not be destroyed until all of
+        // them complete.
+        std::unique_ptr<Preparation> preparation;
+        std::vector<std::shared_future<DisplayDataPtr>> tasks;
+
+        // The future of the task that is expected to complete first
+        std::shared_future<DisplayDataPtr> data;
+        bool scheduled_first = false;
+
+        std::size_t size_bytes = 0;
+    };
+
+    std::size_t max_size_bytes = 0;
+    std::size_t size_bytes = 0;
+
+    // Most recently used entries are at the front
+    std::list<Entry> entries;
+
+    // Evicted or invalidated entries whose tasks have not completed yet. The GUI thread does not
+    // wait for them, as the tasks may be queued behind other work.
+    std::list<Entry> pending_destruction;
+
+    // Accessed only from the worker thread
+    FontMetricsCache metrics_cache{"times"};
+
+    // Declared last so that the worker thread is joined before the rest of the members are
+    // destroyed.
+    TaskExecutor executor;
+
+    std::list<Entry>::iterator find(const CacheKey& key)
+    {
+        return std::find_if(entries.begin(), entries.end(),
+                            [&](const auto& entry) { return entry.key == key; });
+    }
+
+    /** Returns the entry of the page, creating it if needed. If first is true, then the
+        preparation of the data is scheduled before any pending prefetches unless it has
+        completed already.
+    */
+    std::list<Entry>::iterator get_or_schedule(const ScanPage& page, bool with_ocr, bool first);
+
+    void schedule(Entry& entry, bool first);
+    DisplayDataPtr prepare(Preparation& preparation);
+
+    void erase(std::list<Entry>::iterator it)
+    {
+        size_bytes -= it->size_bytes;
+        pending_destruction.splice(pending_destruction.end(), entries, it);
+    }
+
+    void release_finished_entries()
+    {
+        pending_destruction.remove_if([](const Entry& entry)
+        {
+            return std::all_of(entry.tasks.begin(), entry.tasks.end(), is_future_ready);
+        });
+    }
+};
+
+std::list<PageDisplayCache::Private::Entry>::iterator
+    PageDisplayCache::Private::get_or_schedule(const ScanPage& page, bool with_ocr, bool first)
+{
+    release_finished_entries();
+
+    CacheKey key{page.scan_id, with_ocr};
+    auto it = find(key);
+    if (it != entries.end()) {
+        entries.splice(entries.begin(), entries, it);
+        auto& entry = entries.front();
+        if (first && !entry.scheduled_first && !is_future_ready(entry.data)) {
+            // A prefetch may be queued behind prefetches of other pages
+            schedule(entry, true);
+        }
+        return entries.begin();
+    }
+
+    if (with_ocr && !page.ocr_results.has_value()) {
+        throw std::invalid_argument("Page does not have OCR results");
+    }
+    if (!with_ocr && !page.scanned_image.has_value()) {
+        throw std::invalid_argument("Page does not have scanned image");
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.image_storage = std::make_shared<const cv::Mat>(
+                with_ocr ? page.ocr_results->adjusted_image : page.scanned_image.value());
+    entry.size_bytes = estimate_display_data_size(*entry.image_storage);
+
+    const auto& storage = *entry.image_storage;
+    entry.preparation = std::make_unique<Preparation>();
+    entry.preparation->image = cv::Mat{storage.size.dims(), storage.size.p, storage.type(),
+                                       storage.data, storage.step.p};
+    entry.preparation->image_storage = entry.image_storage;
+
+    // Only the data needed to prepare the overlay is copied
+    if (with_ocr) {
+        auto& overlay_results = entry.preparation->overlay_results.emplace();
+        overlay_results.adjusted_paragraphs = page.ocr_results->adjusted_paragraphs;
+        overlay_results.blurred_words = page.ocr_results->blurred_words;
+        overlay_results.adjusted_index = page.ocr_results->adjusted_index;
+    }
+
+    schedule(entry, first);
+
+    size_bytes += entry.size_bytes;
+    entries.push_front(std::move(entry));
+
+    while (size_bytes > max_size_bytes && entries.size() > 1) {
+        erase(std::prev(entries.end()));
+    }
+    return entries.begin();
+}
+
+void PageDisplayCache::Private::schedule(Entry& entry, bool first)
+{
+    // The preparation is owned by the entry, which outlives the task, see pending_destruction
+    auto task = [this, preparation = entry.preparation.get()]()
+    {
+        return prepare(*preparation);
+    };
+    entry.data = first ? executor.schedule_task_first<DisplayDataPtr>(task).share()
+                       : executor.schedule_task<DisplayDataPtr>(task).share();
+    entry.tasks.push_back(entry.data);
+    entry.scheduled_first = first;
+}
+
+DisplayDataPtr PageDisplayCache::Private::prepare(Preparation& preparation)
+{
+    std::call_once(preparation.once, [&]()
+    {
+        auto data = std::make_shared<PageDisplayData>();
+        data->image = qimage_for_display_from_cv_mat(preparation.image,
+                                                     std::move(preparation.image_storage));
+        data->pyramid = std::make_shared<const ImageTilePyramid>(data->image);
+        if (preparation.overlay_results.has_value()) {
+            data->overlay = std::make_shared<const OcrOverlayData>(
+                        prepare_ocr_overlay(preparation.overlay_results.value(), metrics_cache));
+        }
+        preparation.data = data;
+    });
+    return preparation.data;
+}
+
+PageDisplayCache::PageDisplayCache(std::size_t max_size_bytes) :
+    d_{std::make_unique<Private>()}
+{
+    d_->max_size_bytes = max_size_bytes;
+}
+
+PageDisplayCache::~PageDisplayCache() = default;
+
+std::shared_ptr<const PageDisplayData> PageDisplayCache::get(const ScanPage& page, bool with_ocr)
+{
+    return d_->get_or_schedule(page, with_ocr, true)->data.get();
+}
+
+void PageDisplayCache::prefetch(const ScanPage& page, bool with_ocr)
+{
+    if (with_ocr ? !page.ocr_results.has_value() : !page.scanned_image.has_value()) {
+        return;
+    }
+    d_->get_or_schedule(page, with_ocr, false);
+}
+
+void PageDisplayCache::invalidate(unsigned scan_id)
+{
+    for (auto it = d_->entries.begin(); it != d_->entries.end();) {
+        auto next_it = std::next(it);
+        if (it->key.scan_id == scan_id) {
+            d_->erase(it);
+        }
+        it = next_it;
+    }
+    d_->release_finished_entries();
+}
+
+} // namespace sanescan
@@ -0,0 +1,76 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_GUI_PAGE_DISPLAY_CACHE_H
+#define SANESCAN_GUI_PAGE_DISPLAY_CACHE_H
+
+#include "image_tile_pyramid.h"
+#include "ocr_overlay_data.h"
+#include "scan_page.h"
+#include <QtGui/QImage>
+#include <memory>
+
+namespace sanescan {
+
+/// Data needed to display a scanned page in the image widget
+struct PageDisplayData {
+    QImage image;
+    std::shared_ptr<const ImageTilePyramid> pyramid;
+
+    // Only set when the data has been prepared for displaying OCR results
+    std::shared_ptr<const OcrOverlayData> overlay;
+};
+
+/** Caches display data of recently viewed pages so that switching between pages does not need
+    to convert images, build tile pyramids and prepare OCR overlays again. The data is prepared
+    in a worker thread, which allows to prefetch data of pages that are likely to be viewed next.
+
+    Only pages that have scanned image can be cached. The cache must be notified via
+    invalidate() whenever the scanned image or OCR results of a page change.
+
+    The cache is bounded by the memory used by the images and tile pyramids of the entries.
+    Least recently used entries are evicted first. The most recently used entry is kept even if
+    it alone exceeds the limit.
+*/
+class PageDisplayCache {
+public:
+    explicit PageDisplayCache(std::size_t max_size_bytes);
+    ~PageDisplayCache();
+
+    /** Returns display data for a page. If the data is not available yet, the function blocks
+        until it's prepared. The preparation is moved ahead of any pending prefetches. If
+        with_ocr is true, then the data is prepared for the adjusted image and OCR results of
+        the page, otherwise for the scanned image.
+    */
+    std::shared_ptr<const PageDisplayData> get(const ScanPage& page, bool with_ocr);
+
+    /// Starts preparing display data for a page in the background unless it's already cached.
+    void prefetch(const ScanPage& page, bool with_ocr);
+
+    /// Removes all cached data of a page
+    void invalidate(unsigned scan_id);
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
+
+} // namespace sanescan
+
+#endif // SANESCAN_GUI_PAGE_DISPLAY_CACHE_H
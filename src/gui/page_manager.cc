@@ -22,11 +22,14 @@
 #include "lib/scan_area_utils.h"
 #include "ocr/pdf_writer.h"
 #include "util/math.h"
+#include "util/telemetry.h"
+#include "util/trace.h"
 
 #include <QtCore/QTimer>
 #include <QtGui/QImage>
 #include <opencv2/imgcodecs.hpp>
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -37,6 +40,13 @@ namespace sanescan {
 
 namespace {
 
+// FIXME: properly set the thread pool size
+constexpr unsigned OCR_THREAD_COUNT = 4;
+
+// The delay after the last scan finishes until OCR is started when OCR_WHEN_IDLE policy is used.
+// This gives the user time to start the next scan without competing with OCR for CPU time.
+constexpr int IDLE_OCR_DELAY_MS = 2000;
+
 PreviewConfig get_default_preview_config()
 {
     // Use A4 size by default. At the given dpi the blank image is relatively small at 163x233
@@ -115,10 +125,27 @@ struct PageManager::Private {
     std::size_t curr_scan_page_index = 0;
     unsigned next_scan_id = 1;
 
+    OcrPolicy ocr_policy = OCR_IMMEDIATELY;
+    bool share_duplicate_page_images = false;
+    bool scan_active = false;
+    QTimer idle_ocr_timer;
+
+    // Carries the properties of scanned pages over to the next pages, which are likely similar.
+    // A new context is created for each batch, so that the jobs of the previous batch that are
+    // still running don't add their pages to the new batch.
+    std::shared_ptr<OcrBatchContext> ocr_batch_context = std::make_shared<OcrBatchContext>();
+
+    // The device and options of the pages of the current batch
+    std::string ocr_batch_device_name;
+    std::map<std::string, SaneOptionValue> ocr_batch_scan_option_values;
+    OcrOptions ocr_batch_ocr_options;
+
+    // Set if slow OCR jobs should be captured for later replay
+    std::optional<OcrCaptureOptions> ocr_capture_options = ocr_capture_options_from_env();
+
     // Note that descroying PageManager will wait until all jobs submitted to the executor
     // complete.
-    // FIXME: properly set the thread pool size
-    JobQueue job_executor{4};
+    JobQueue job_executor{OCR_THREAD_COUNT};
 };
 
 PageManager::PageManager() :
@@ -135,6 +162,10 @@ PageManager::PageManager() :
     connect(&d_->engine, &ScanEngine::image_updated, [this]() { image_updated(); });
     connect(&d_->engine, &ScanEngine::scan_finished, [this]() { scan_finished(); });
 
+    d_->idle_ocr_timer.setSingleShot(true);
+    d_->idle_ocr_timer.setInterval(IDLE_OCR_DELAY_MS);
+    connect(&d_->idle_ocr_timer, &QTimer::timeout, [this]() { process_idle_ocr(); });
+
     d_->job_executor.start();
 }
 
@@ -184,6 +215,9 @@ void PageManager::start_scan(unsigned page_index, ScanType type)
     auto& scan_page = curr_scan_page();
 
     scan_page.scan_type = type;
+    if (type == ScanType::NORMAL) {
+        scan_page.rescanned_page_index.reset();
+    }
 
     if (page_index != d_->curr_scan_page_index) {
         // We want to repeat scan of an existing page. The caller must ensure that the existing
@@ -202,6 +236,7 @@ void PageManager::start_scan(unsigned page_index, ScanType type)
 
         if (type == ScanType::NORMAL) {
             d_->engine.set_option_values(page.scan_option_values);
+            scan_page.rescanned_page_index = page_index;
         }
         // preview scans reset all values below
     }
@@ -233,6 +268,10 @@ void PageManager::start_scan(unsigned page_index, ScanType type)
     scan_page.locked = true;
     Q_EMIT page_locking_changed();
 
+    // Deferred OCR is not started while scanning, already running OCR jobs are left to complete.
+    d_->scan_active = true;
+    d_->idle_ocr_timer.stop();
+
     scan_page.scan_progress = 0.0;
     Q_EMIT page_progress_changed(d_->curr_scan_page_index);
 
@@ -245,6 +284,7 @@ void PageManager::start_scan(unsigned page_index, ScanType type)
 
 void PageManager::on_ocr_complete(unsigned page_index)
 {
+    SANESCAN_TRACE_SPAN("page_manager", "on_ocr_complete");
     auto& page = d_->pages.at(page_index);
 
     bool updated_results = false;
@@ -252,6 +292,7 @@ void PageManager::on_ocr_complete(unsigned page_index)
         if (job->finished()) {
             if (job->job_id() == page.last_ocr_job_id) {
                 page.ocr_results = std::move(job->results());
+                page.ocr_partial_paragraphs.clear();
                 page.ocr_progress.reset();
                 updated_results = true;
             }
@@ -270,6 +311,22 @@ void PageManager::on_ocr_complete(unsigned page_index)
         Q_EMIT page_progress_changed(page_index);
         Q_EMIT page_ocr_results_changed(page_index);
     }
+
+    // A worker thread may have become free, thus more deferred pages can be processed.
+    process_idle_ocr();
+}
+
+void PageManager::on_ocr_partial_results(unsigned page_index, std::size_t job_id,
+                                         const std::vector<OcrParagraph>& paragraphs)
+{
+    auto& page = d_->pages.at(page_index);
+    if (job_id != page.last_ocr_job_id || page.ocr_results.has_value()) {
+        // The results are from an obsolete job
+        return;
+    }
+    page.ocr_partial_paragraphs.insert(page.ocr_partial_paragraphs.end(),
+                                       paragraphs.begin(), paragraphs.end());
+    Q_EMIT page_ocr_partial_results_changed(page_index);
 }
 
 void PageManager::reopen_current_device()
@@ -318,21 +375,49 @@ void PageManager::clear_preview_image(ScanPage& page)
     page.preview_image.reset();
 }
 
-void PageManager::perform_ocr(unsigned page_index, const OcrOptions& new_options)
+void PageManager::perform_ocr(unsigned page_index, const OcrOptions& new_options,
+                              bool use_batch_context)
 {
+    trace_instant("page_manager", "submit_ocr_job");
     auto& page = d_->pages.at(page_index);
+    auto job_id = ++page.last_ocr_job_id;
     page.ocr_jobs.push_back(std::make_unique<OcrJob>(page.scanned_image.value(),
                                                      new_options,
                                                      page.ocr_options,
                                                      page.ocr_results,
-                                                      ++page.last_ocr_job_id,
+                                                     job_id,
                                                      [this, page_index]()
     {
         QMetaObject::invokeMethod(this, "on_ocr_complete", Qt::QueuedConnection,
                                   Q_ARG(unsigned, page_index));
-    }));
+    },
+                                                     [this, page_index, job_id](const auto& pars)
+    {
+        // Queued calls to the same object are delivered in order, so all partial results are
+        // processed before on_ocr_complete().
+        QMetaObject::invokeMethod(this, [this, page_index, job_id, pars]()
+        {
+            on_ocr_partial_results(page_index, job_id, pars);
+        }, Qt::QueuedConnection);
+    },
+                                                     d_->ocr_capture_options));
+    page.ocr_jobs.back()->set_priority_area(page.ocr_priority_area);
+    if (use_batch_context) {
+        page.ocr_jobs.back()->set_batch_context(d_->ocr_batch_context);
+    }
+    auto reference_page_index = page.rescanned_page_index.has_value()
+            ? page.rescanned_page_index : page.duplicate_of_page_index;
+    if (!page.ocr_results.has_value() && reference_page_index.has_value()) {
+        // The reference results are only valid for the options they have been computed with
+        const auto& reference_page = d_->pages.at(reference_page_index.value());
+        if (reference_page.ocr_results.has_value() && reference_page.ocr_options == new_options) {
+            page.ocr_jobs.back()->set_reference(reference_page.ocr_results.value());
+        }
+    }
     page.ocr_options = new_options;
+    page.ocr_pending = false;
     page.ocr_results.reset();
+    page.ocr_partial_paragraphs.clear();
     page.ocr_progress = 0.0;
     d_->job_executor.submit(*(page.ocr_jobs.back().get()));
 
@@ -340,6 +425,160 @@ void PageManager::perform_ocr(unsigned page_index, const OcrOptions& new_options
     Q_EMIT page_progress_changed(page_index);
 }
 
+void PageManager::perform_pending_ocr(unsigned page_index)
+{
+    auto& page = d_->pages.at(page_index);
+
+    // The properties of pages are carried over only between pages scanned with the same device
+    // and options
+    if (page.device.name != d_->ocr_batch_device_name ||
+            page.scan_option_values != d_->ocr_batch_scan_option_values ||
+            page.ocr_options != d_->ocr_batch_ocr_options) {
+        start_new_ocr_batch();
+        d_->ocr_batch_device_name = page.device.name;
+        d_->ocr_batch_scan_option_values = page.scan_option_values;
+        d_->ocr_batch_ocr_options = page.ocr_options;
+    }
+    perform_ocr(page_index, page.ocr_options, true);
+}
+
+void PageManager::start_new_ocr_batch()
+{
+    d_->ocr_batch_context = std::make_shared<OcrBatchContext>();
+}
+
+void PageManager::start_duplicate_page_detection(unsigned page_index)
+{
+    auto& page = d_->pages.at(page_index);
+    page.image_hash.reset();
+    page.duplicate_of_page_index.reset();
+    page.same_image_as_page_index.reset();
+
+    // Rescans are expected to be similar to the original page, but their images must be kept
+    std::vector<DuplicatePageJob::EarlierPage> earlier_pages;
+    if (!page.rescanned_page_index.has_value()) {
+        for (std::size_t i = 0; i < page_index; ++i) {
+            const auto& other_page = d_->pages.at(i);
+            if (!other_page.scanned_image.has_value()) {
+                continue;
+            }
+            earlier_pages.push_back({i, other_page.scanned_image.value(), other_page.image_hash});
+        }
+    }
+
+    // Hashing and comparing the images touches every pixel, which would block the GUI thread
+    page.duplicate_page_job = std::make_unique<DuplicatePageJob>(
+                page.scanned_image.value(), earlier_pages, [this, page_index]()
+    {
+        QMetaObject::invokeMethod(this, [this, page_index]()
+        {
+            on_duplicate_page_detected(page_index);
+        }, Qt::QueuedConnection);
+    });
+    d_->job_executor.submit(*page.duplicate_page_job);
+}
+
+void PageManager::on_duplicate_page_detected(unsigned page_index)
+{
+    static auto& duplicates_counter =
+            TelemetryRegistry::instance().counter("scan.duplicate_pages");
+
+    auto& page = d_->pages.at(page_index);
+    if (!page.duplicate_page_job || !page.duplicate_page_job->finished()) {
+        // The results have already been processed by wait_for_duplicate_page_detection()
+        return;
+    }
+
+    auto result = page.duplicate_page_job->result();
+    page.duplicate_page_job.reset();
+
+    page.image_hash = result.image_hash;
+    if (result.near_duplicate_page_index.has_value()) {
+        auto other_index = result.near_duplicate_page_index.value();
+        page.duplicate_of_page_index =
+                d_->pages.at(other_index).duplicate_of_page_index.value_or(other_index);
+        if (result.identical) {
+            page.same_image_as_page_index = other_index;
+        }
+        duplicates_counter.add();
+    }
+
+    // OCR may reuse the results of the near-duplicate page now
+    if (d_->ocr_policy == OCR_IMMEDIATELY && page.ocr_pending) {
+        perform_pending_ocr(page_index);
+    }
+}
+
+void PageManager::wait_for_duplicate_page_detection(std::size_t first_page_index,
+                                                    std::size_t last_page_index)
+{
+    for (auto i = first_page_index; i < last_page_index; ++i) {
+        auto& page = d_->pages.at(i);
+        if (page.duplicate_page_job) {
+            page.duplicate_page_job->wait_finished();
+            on_duplicate_page_detected(i);
+        }
+    }
+}
+
+void PageManager::wait_for_ocr_results(std::size_t first_page_index,
+                                       std::size_t last_page_index)
+{
+    SANESCAN_TRACE_SPAN("page_manager", "wait_for_ocr_results");
+    // Pending OCR is started only once it's known whether results of another page can be reused
+    wait_for_duplicate_page_detection(first_page_index, last_page_index);
+
+    // Submit all deferred pages first so that they are processed in parallel.
+    for (auto i = first_page_index; i < last_page_index; ++i) {
+        auto& page = d_->pages.at(i);
+        if (page.ocr_pending) {
+            perform_pending_ocr(i);
+        }
+    }
+
+    for (auto i = first_page_index; i < last_page_index; ++i) {
+        auto& page = d_->pages.at(i);
+        for (auto& job : page.ocr_jobs) {
+            if (job->job_id() == page.last_ocr_job_id) {
+                job->wait_finished();
+            }
+        }
+        on_ocr_complete(i);
+    }
+}
+
+void PageManager::schedule_idle_ocr()
+{
+    if (d_->ocr_policy != OCR_WHEN_IDLE || d_->scan_active) {
+        return;
+    }
+    d_->idle_ocr_timer.start();
+}
+
+void PageManager::process_idle_ocr()
+{
+    if (d_->ocr_policy != OCR_WHEN_IDLE || d_->scan_active) {
+        return;
+    }
+
+    // Only as many pages as there are worker threads are submitted at once. This way the pages
+    // are processed in scan order and a newly started scan pauses the remaining work quickly.
+    std::size_t active_ocr_count =
+            std::count_if(d_->pages.begin(), d_->pages.end(),
+                          [](const auto& page) { return !page.ocr_jobs.empty(); });
+
+    for (std::size_t i = 0; i < d_->pages.size(); ++i) {
+        if (active_ocr_count >= OCR_THREAD_COUNT) {
+            break;
+        }
+        auto& page = d_->pages[i];
+        if (page.ocr_pending) {
+            perform_pending_ocr(i);
+            active_ocr_count++;
+        }
+    }
+}
+
 void PageManager::set_page_option(unsigned page_index, const std::string& name,
                                   const SaneOptionValue& value)
 {
@@ -356,6 +595,11 @@ const ScanPage& PageManager::page(unsigned index) const
     return d_->pages.at(index);
 }
 
+unsigned PageManager::page_count() const
+{
+    return d_->pages.size();
+}
+
 unsigned PageManager::curr_scan_page_index() const
 {
     return d_->curr_scan_page_index;
@@ -366,6 +610,53 @@ bool PageManager::are_pages_globally_locked() const
     return d_->all_pages_locked;
 }
 
+void PageManager::set_ocr_policy(OcrPolicy policy)
+{
+    d_->ocr_policy = policy;
+
+    if (policy == OCR_IMMEDIATELY) {
+        for (std::size_t i = 0; i < d_->pages.size(); ++i) {
+            auto& page = d_->pages[i];
+            if (page.ocr_pending) {
+                perform_pending_ocr(i);
+            }
+        }
+    }
+    schedule_idle_ocr();
+}
+
+PageManager::OcrPolicy PageManager::ocr_policy() const
+{
+    return d_->ocr_policy;
+}
+
+void PageManager::set_share_duplicate_page_images(bool share)
+{
+    d_->share_duplicate_page_images = share;
+}
+
+bool PageManager::share_duplicate_page_images() const
+{
+    return d_->share_duplicate_page_images;
+}
+
+void PageManager::request_page_ocr(unsigned page_index)
+{
+    auto& page = d_->pages.at(page_index);
+    if (page.ocr_pending) {
+        perform_pending_ocr(page_index);
+    }
+}
+
+void PageManager::set_ocr_priority_area(unsigned page_index, const OcrBox& area)
+{
+    auto& page = d_->pages.at(page_index);
+    page.ocr_priority_area = area;
+    for (auto& job : page.ocr_jobs) {
+        job->set_priority_area(area);
+    }
+}
+
 void PageManager::set_page_ocr_options(unsigned page_index, const OcrOptions& options)
 {
     auto& page = d_->pages.at(page_index);
@@ -375,14 +666,23 @@ void PageManager::set_page_ocr_options(unsigned page_index, const OcrOptions& op
     if (!page.scanned_image.has_value()) {
         throw std::runtime_error("Document must have scanned image when setting options");
     }
-    perform_ocr(page_index, options);
+    // The pages recognized with the new options are likely to be different from the previous
+    // pages. The page itself is recognized again on user request, so it does not belong to the
+    // batch of scanned pages.
+    start_new_ocr_batch();
+    perform_ocr(page_index, options, false);
 }
 
 void PageManager::save_page(unsigned page_index, SaveMode mode, const std::string& path)
 {
+    SANESCAN_TRACE_SPAN("page_manager", "save_page");
     std::filesystem::path p(path);
     auto is_pdf = p.extension().string() == ".pdf";
 
+    if (mode == SaveMode::WITH_OCR) {
+        wait_for_ocr_results(page_index, page_index + 1);
+    }
+
     auto& page = d_->pages.at(page_index);
 
     auto image = image_to_save(page, mode);
@@ -398,19 +698,42 @@ void PageManager::save_page(unsigned page_index, SaveMode mode, const std::strin
 
 void PageManager::save_all_pages(SaveMode mode, const std::string& path)
 {
+    SANESCAN_TRACE_SPAN("page_manager", "save_all_pages");
     std::filesystem::path base_path(path);
     auto extension = base_path.extension().string();
     auto is_pdf = extension == ".pdf";
 
     // Note that we exclude the last page as it will always contain not yet finished scan.
+    // The pages whose images are shared are known only once duplicate detection completes.
+    wait_for_duplicate_page_detection(0, d_->pages.size() - 1);
+    if (mode == SaveMode::WITH_OCR) {
+        wait_for_ocr_results(0, d_->pages.size() - 1);
+    }
+
     if (is_pdf) {
         std::ofstream out_stream{path};
         PdfWriter writer{out_stream};
         writer.write_header();
         for (std::size_t i = 0; i < d_->pages.size() - 1; ++i) {
             const auto& page = d_->pages.at(i);
-            auto image = image_to_save(page, mode);
 
+            // Pages are written in order, so the index of the PDF page is the same as the page
+            // index. The shared image is paired with the text recognized on it. Near-duplicate
+            // pages may differ in small details, thus only identical images are shared.
+            auto original_index = get_shared_image_page_index(i, mode);
+            if (original_index.has_value()) {
+                if (mode == SaveMode::RAW_SCAN) {
+                    writer.write_page_with_image_of(original_index.value(), {});
+                } else {
+                    const auto& original_page = d_->pages.at(original_index.value());
+                    writer.write_page_with_image_of(
+                                original_index.value(),
+                                original_page.ocr_results->adjusted_paragraphs);
+                }
+                continue;
+            }
+
+            const auto& image = image_to_save(page, mode);
             if (mode == SaveMode::RAW_SCAN) {
                 writer.write_page(image, {});
             } else {
@@ -429,6 +752,31 @@ void PageManager::save_all_pages(SaveMode mode, const std::string& path)
     }
 }
 
+std::optional<std::size_t> PageManager::get_shared_image_page_index(std::size_t page_index,
+                                                                SaveMode mode) const
+{
+    if (!d_->share_duplicate_page_images) {
+        return {};
+    }
+    const auto& page = d_->pages.at(page_index);
+    if (!page.same_image_as_page_index.has_value()) {
+        return {};
+    }
+    auto original_index = page.same_image_as_page_index.value();
+    const auto& original_page = d_->pages.at(original_index);
+
+    // The image is shared only with a page that is itself written with its own image
+    if (original_page.same_image_as_page_index.has_value()) {
+        return {};
+    }
+    // The adjusted images and the recognized text of identical scans differ if the OCR options
+    // differ, e.g. when only one of the pages has been rotated or cropped.
+    if (mode == SaveMode::WITH_OCR && page.ocr_options != original_page.ocr_options) {
+        return {};
+    }
+    return original_index;
+}
+
 void PageManager::periodic_engine_poll()
 {
     try {
@@ -436,14 +784,34 @@ void PageManager::periodic_engine_poll()
     } catch (const std::exception& e) {
         // FIXME: we should show the error in the UI
         std::cerr << "SaneScan: Got error: " << e.what() << "\n";
+        scan_failed();
         reopen_current_device();
     } catch (...) {
         // FIXME: we should show the error in the UI
         std::cerr << "SaneScan: Got error\n";
+        scan_failed();
         reopen_current_device();
     }
 }
 
+void PageManager::scan_failed()
+{
+    // The engine does not emit scan_finished() if the scan fails, e.g. when sane_start() reports
+    // that the document feeder is empty.
+    if (!d_->scan_active) {
+        return;
+    }
+    d_->scan_active = false;
+
+    auto& page = curr_scan_page();
+    page.scan_progress.reset();
+    page.locked = false;
+    Q_EMIT page_progress_changed(d_->curr_scan_page_index);
+    Q_EMIT page_locking_changed();
+
+    schedule_idle_ocr();
+}
+
 void PageManager::devices_refreshed()
 {
     d_->all_pages_locked = false;
@@ -518,6 +886,7 @@ void PageManager::device_closed()
 
 void PageManager::image_updated()
 {
+    SANESCAN_TRACE_SPAN("page_manager", "image_updated");
     auto& page = curr_scan_page();
     if (page.scan_type == ScanType::NORMAL) {
         page.scanned_image = d_->engine.scan_image();
@@ -530,6 +899,8 @@ void PageManager::image_updated()
 
 void PageManager::scan_finished()
 {
+    d_->scan_active = false;
+
     {
         auto& page = curr_scan_page();
         page.scan_progress.reset();
@@ -538,6 +909,9 @@ void PageManager::scan_finished()
 
     // Setup a new page that would serve as a template to repeat the current scan.
     if (curr_scan_page().scan_type == ScanType::NORMAL) {
+        TelemetryRegistry::instance().counter("scan.pages_scanned").add();
+        start_duplicate_page_detection(d_->curr_scan_page_index);
+
         auto new_page_index = d_->pages.size();
         auto& new_page = d_->pages.emplace_back(d_->next_scan_id++);
         auto& page = curr_scan_page();
@@ -550,7 +924,11 @@ void PageManager::scan_finished()
         new_page.scan_option_values = page.scan_option_values;
         d_->curr_scan_page_index = new_page_index;
         Q_EMIT new_page_added(new_page_index, true);
-        perform_ocr(old_page_index, d_->pages.at(old_page_index).ocr_options);
+
+        // If the OCR policy is OCR_IMMEDIATELY, then OCR is started once duplicate detection
+        // completes, so that the results of a near-duplicate page can be reused.
+        d_->pages.at(old_page_index).ocr_pending = true;
+        Q_EMIT page_ocr_results_changed(old_page_index);
     } else {
         auto& page = curr_scan_page();
         page.scan_type = ScanType::NORMAL;
@@ -561,6 +939,8 @@ void PageManager::scan_finished()
     // At least the genesys backend can't perform two scans back to back.
     d_->ignore_next_option_values_change = true;
     reopen_current_device();
+
+    schedule_idle_ocr();
 }
 
 } // namespace sanescan
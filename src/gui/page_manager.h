@@ -33,6 +33,16 @@ public:
         WITH_OCR
     };
 
+    /// Defines when OCR is started for newly scanned pages
+    enum OcrPolicy {
+        /// OCR is started as soon as the scan finishes
+        OCR_IMMEDIATELY,
+        /// OCR is started only when there are no active scans
+        OCR_WHEN_IDLE,
+        /// OCR is started only when the page is viewed or exported
+        OCR_ON_DEMAND
+    };
+
     PageManager();
     ~PageManager() override;
 
@@ -75,13 +85,40 @@ public:
     */
     bool are_pages_globally_locked() const;
 
+    /// Sets the policy that defines when OCR is started for newly scanned pages
+    void set_ocr_policy(OcrPolicy policy);
+    OcrPolicy ocr_policy() const;
+
+    /** Sets whether pages whose scanned image is identical to the image of an earlier page
+        share the image of the earlier page when the document is saved to PDF. This makes the
+        output smaller. Near-duplicate pages that differ in any detail always keep their images.
+        When saving with OCR, the OCR options of the pages must be equal too.
+    */
+    void set_share_duplicate_page_images(bool share);
+    bool share_duplicate_page_images() const;
+
+    /** Starts OCR for a page if it has been deferred according to the OCR policy. Does nothing
+        if the OCR has already been started or completed.
+    */
+    void request_page_ocr(unsigned page_index);
+
+    /** Sets the area of the scanned image of a page whose text should be recognized first. This
+        applies both to OCR that is in progress and OCR that will be started later.
+    */
+    void set_ocr_priority_area(unsigned page_index, const OcrBox& area);
+
     /// Sets OCR options for specific page and restarts OCR processing if needed
     void set_page_ocr_options(unsigned page_index, const OcrOptions& options);
 
-    /// Saves a specific page using given save mode.
+    /** Saves a specific page using given save mode. If OCR results are required and not yet
+        available, blocks until OCR completes.
+    */
     void save_page(unsigned page_index, SaveMode mode, const std::string& path);
 
-    /// Saves whole document using given save mode.
+    /** Saves whole document using given save mode. If OCR results are required, then OCR is
+        performed in parallel for all pages that don't have the results yet and the function
+        blocks until OCR completes.
+    */
     void save_all_pages(SaveMode mode, const std::string& path);
 
 public: Q_SIGNALS:
@@ -97,9 +134,16 @@ public: Q_SIGNALS:
     /// emitted when either ocr_results or ocr_progress of a page changes.
     void page_ocr_results_changed(unsigned page_index);
 
+    /// emitted when ocr_partial_paragraphs of a page changes.
+    void page_ocr_partial_results_changed(unsigned page_index);
+
 private Q_SLOTS:
     void on_ocr_complete(unsigned page_index);
 
+private:
+    void on_ocr_partial_results(unsigned page_index, std::size_t job_id,
+                                const std::vector<OcrParagraph>& paragraphs);
+
 private:
     void reopen_current_device();
     const SaneDeviceInfo& get_available_device_by_name(const std::string& name);
@@ -108,7 +152,18 @@ private:
     void setup_empty_preview_image(ScanPage& page,
                                    const std::optional<cv::Rect2d>& scan_bounds_mm);
     void clear_preview_image(ScanPage& page);
-    void perform_ocr(unsigned page_index, const OcrOptions& new_options);
+    void perform_ocr(unsigned page_index, const OcrOptions& new_options, bool use_batch_context);
+    void perform_pending_ocr(unsigned page_index);
+    void start_new_ocr_batch();
+    void start_duplicate_page_detection(unsigned page_index);
+    void on_duplicate_page_detected(unsigned page_index);
+    void wait_for_duplicate_page_detection(std::size_t first_page_index,
+                                           std::size_t last_page_index);
+    std::optional<std::size_t> get_shared_image_page_index(std::size_t page_index,
+                                                           SaveMode mode) const;
+    void wait_for_ocr_results(std::size_t first_page_index, std::size_t last_page_index);
+    void schedule_idle_ocr();
+    void process_idle_ocr();
 
     void periodic_engine_poll();
     void devices_refreshed();
@@ -118,6 +173,7 @@ private:
     void device_closed();
     void image_updated();
     void scan_finished();
+    void scan_failed();
 
     struct Private;
     std::unique_ptr<Private> d_;
@@ -18,26 +18,47 @@
 
 #include "page_list_model.h"
 #include <QtGui/QPixmap>
+#include <algorithm>
+#include <bit>
 #include <stdexcept>
 
 namespace sanescan {
 
+namespace {
+
+int round_up_to_power_of_2(int value)
+{
+    return static_cast<int>(std::bit_ceil(static_cast<unsigned>(std::max(value, 1))));
+}
+
+} // namespace
+
 struct PageImages {
-    PageImages(const QImage& image) : image{image} {}
+    PageImages(const std::vector<QImage>& levels) : levels{levels} {}
 
     void resize(const QSize& max_size)
     {
-        QPixmap pix = QPixmap::fromImage(image);
+        // Levels are ordered from the largest to the smallest. Scaling down from the closest
+        // level that is still large enough is both fast and has good quality.
+        const QImage* image = &levels.front();
+        for (const auto& level : levels) {
+            if (level.width() < max_size.width() && level.height() < max_size.height()) {
+                break;
+            }
+            image = &level;
+        }
+
+        QPixmap pix = QPixmap::fromImage(*image);
         auto pix_aspect_ratio = static_cast<double>(pix.size().width()) / pix.size().height();
         auto size_aspect_ratio = static_cast<double>(max_size.width()) / max_size.height();
         if (pix_aspect_ratio > size_aspect_ratio) {
-            resized_pixmap = pix.scaledToWidth(max_size.width());
+            resized_pixmap = pix.scaledToWidth(max_size.width(), Qt::SmoothTransformation);
         } else {
-            resized_pixmap = pix.scaledToHeight(max_size.height());
+            resized_pixmap = pix.scaledToHeight(max_size.height(), Qt::SmoothTransformation);
         }
     }
 
-    QImage image;
+    std::vector<QImage> levels;
     QPixmap resized_pixmap;
 };
 
@@ -79,7 +100,7 @@ QVariant PageListModel::data(const QModelIndex& index, int role) const
 
 void PageListModel::add_page(std::uint64_t identifier, const QImage& image)
 {
-    PageImages page_images{image};
+    PageImages page_images{{image}};
     page_images.resize(d_->max_pixmap_size);
 
     d_->pages.push_back(identifier);
@@ -89,11 +110,19 @@ void PageListModel::add_page(std::uint64_t identifier, const QImage& image)
 
 void PageListModel::set_image(std::uint64_t identifier, const QImage& image)
 {
+    set_images(identifier, {image});
+}
+
+void PageListModel::set_images(std::uint64_t identifier, const std::vector<QImage>& levels)
+{
+    if (levels.empty()) {
+        throw std::invalid_argument("Thumbnail levels must not be empty");
+    }
     auto it = d_->images.find(identifier);
     if (it == d_->images.end()) {
         throw std::runtime_error("Image for identifier does not exist");
     }
-    it->second.image = image;
+    it->second.levels = levels;
     it->second.resize(d_->max_pixmap_size);
 
     auto it_pages = std::find(d_->pages.begin(), d_->pages.end(), identifier);
@@ -120,10 +149,20 @@ void PageListModel::set_max_image_size(const QSize& max_size)
     if (max_size == d_->max_pixmap_size) {
         return;
     }
+    auto old_thumbnail_size = thumbnail_size();
     d_->max_pixmap_size = max_size;
     for (auto& [ident, images] : d_->images) {
         images.resize(max_size);
     }
+    if (thumbnail_size() != old_thumbnail_size) {
+        Q_EMIT thumbnail_size_changed();
+    }
+}
+
+QSize PageListModel::thumbnail_size() const
+{
+    return QSize{round_up_to_power_of_2(d_->max_pixmap_size.width()),
+                 round_up_to_power_of_2(d_->max_pixmap_size.height())};
 }
 
 } // namespace sanescan
@@ -20,7 +20,9 @@
 #define SANESCAN_GUI_PAGELIST_PAGE_LIST_MODEL_H
 
 #include <QtCore/QAbstractListModel>
+#include <QtGui/QImage>
 #include <memory>
+#include <vector>
 
 namespace sanescan {
 
@@ -36,10 +38,26 @@ public:
     void add_page(std::uint64_t identifier, const QImage& image);
     void set_image(std::uint64_t identifier, const QImage& image);
 
+    /** Sets a pyramid of thumbnails for a page. The first level is the largest one and each
+        subsequent level is smaller. The smallest level that is not smaller than the current
+        maximum image size is used for display.
+    */
+    void set_images(std::uint64_t identifier, const std::vector<QImage>& levels);
+
     const QPixmap& image_at(std::size_t pos) const;
 
     void set_max_image_size(const QSize& max_size);
 
+    /** Returns the size that thumbnails passed to set_images() should fit into. It is larger than
+        the maximum image size so that the page list can grow somewhat without new thumbnails
+        being needed.
+    */
+    QSize thumbnail_size() const;
+
+Q_SIGNALS:
+    // Emitted when thumbnail_size() changes. Thumbnails should be regenerated in that case.
+    void thumbnail_size_changed();
+
 private:
     struct Private;
     std::unique_ptr<Private> d_;
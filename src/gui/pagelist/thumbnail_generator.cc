@@ -0,0 +1,136 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "thumbnail_generator.h"
+#include "../qimage_utils.h"
+#include "lib/task_executor.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <map>
+
+namespace sanescan {
+
+namespace {
+
+// Pyramid levels are not generated below this size
+constexpr int MIN_THUMBNAIL_SIZE = 32;
+
+std::vector<QImage> make_thumbnail_levels(const cv::Mat& image, const QSize& max_size)
+{
+    if (image.empty()) {
+        return {};
+    }
+
+    double scale = std::min({static_cast<double>(max_size.width()) / image.cols,
+                             static_cast<double>(max_size.height()) / image.rows,
+                             1.0});
+
+    cv::Mat resized;
+    cv::resize(image, resized, cv::Size(), scale, scale, cv::INTER_AREA);
+
+    // Thumbnails don't need high bit depth or alpha, so they're stored in the most compact format
+    if (resized.depth() == CV_16U) {
+        resized.convertTo(resized, CV_8U, 1.0 / 256);
+    }
+    if (resized.channels() == 4) {
+        cv::cvtColor(resized, resized, cv::COLOR_RGBA2RGB);
+    }
+
+    std::vector<QImage> levels;
+    levels.push_back(qimage_from_cv_mat(resized));
+    while (levels.back().width() / 2 >= MIN_THUMBNAIL_SIZE &&
+           levels.back().height() / 2 >= MIN_THUMBNAIL_SIZE)
+    {
+        const auto& prev = levels.back();
+        levels.push_back(prev.scaled(prev.width() / 2, prev.height() / 2,
+                                     Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    }
+    return levels;
+}
+
+} // namespace
+
+struct ThumbnailGenerator::Private {
+    struct Request {
+        cv::Mat image;
+        QSize max_size;
+    };
+
+    // Requests that have not been started yet
+    std::map<std::uint64_t, Request> pending;
+
+    // The images are accessed from the worker thread as external data, so that no reference
+    // counting operations happen outside the main thread. This member keeps the data alive
+    // until the request is finished. See OcrJob for more details.
+    std::map<std::uint64_t, cv::Mat> in_progress;
+
+    // Declared last so that the worker thread is joined before the rest of the members are
+    // destroyed.
+    TaskExecutor executor;
+};
+
+ThumbnailGenerator::ThumbnailGenerator() :
+    d_{std::make_unique<Private>()}
+{
+}
+
+ThumbnailGenerator::~ThumbnailGenerator() = default;
+
+void ThumbnailGenerator::generate(std::uint64_t identifier, const cv::Mat& image,
+                                  const QSize& max_size)
+{
+    d_->pending[identifier] = Private::Request{image, max_size};
+    if (d_->in_progress.count(identifier) == 0) {
+        schedule(identifier);
+    }
+}
+
+void ThumbnailGenerator::schedule(std::uint64_t identifier)
+{
+    auto it = d_->pending.find(identifier);
+    if (it == d_->pending.end()) {
+        return;
+    }
+    auto request = std::move(it->second);
+    d_->pending.erase(it);
+
+    const auto& storage = d_->in_progress[identifier] = request.image;
+    cv::Mat image{storage.size.dims(), storage.size.p, storage.type(), storage.data,
+                  storage.step.p};
+
+    d_->executor.schedule_task<void>([this, identifier, image, max_size = request.max_size]()
+    {
+        auto levels = make_thumbnail_levels(image, max_size);
+        QMetaObject::invokeMethod(this, [this, identifier, levels = std::move(levels)]()
+        {
+            on_finished(identifier, levels);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ThumbnailGenerator::on_finished(std::uint64_t identifier, const std::vector<QImage>& levels)
+{
+    d_->in_progress.erase(identifier);
+    if (!levels.empty()) {
+        Q_EMIT thumbnails_ready(identifier, levels);
+    }
+    // Requests for the same identifier are not started while one is in progress
+    schedule(identifier);
+}
+
+} // namespace sanescan
@@ -0,0 +1,64 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SANESCAN_GUI_PAGELIST_THUMBNAIL_GENERATOR_H
+#define SANESCAN_GUI_PAGELIST_THUMBNAIL_GENERATOR_H
+
+#include <opencv2/core/mat.hpp>
+#include <QtCore/QObject>
+#include <QtCore/QSize>
+#include <QtGui/QImage>
+#include <memory>
+#include <vector>
+
+namespace sanescan {
+
+/** Generates page thumbnails in a background thread.
+
+    For each image a small pyramid of thumbnails is produced. The first level fits into the
+    requested size and each subsequent level is half the size of the previous one. The pyramid
+    allows the page list to be resized without going back to the full resolution image.
+*/
+class ThumbnailGenerator : public QObject {
+    Q_OBJECT
+public:
+    ThumbnailGenerator();
+    ~ThumbnailGenerator() override;
+
+    /** Schedules generation of thumbnails for the given image. The image data is kept alive
+        until the request finishes. The data may be written to concurrently (e.g. by an ongoing
+        scan), in which case the thumbnail reflects the image at an arbitrary point in time. If a
+        previous request for the same identifier has not been started yet, it is replaced by the
+        new one.
+    */
+    void generate(std::uint64_t identifier, const cv::Mat& image, const QSize& max_size);
+
+Q_SIGNALS:
+    void thumbnails_ready(std::uint64_t identifier, const std::vector<QImage>& levels);
+
+private:
+    void schedule(std::uint64_t identifier);
+    void on_finished(std::uint64_t identifier, const std::vector<QImage>& levels);
+
+    struct Private;
+    std::unique_ptr<Private> d_;
+};
+
+} // namespace sanescan
+
+#endif // SANESCAN_GUI_PAGELIST_THUMBNAIL_GENERATOR_H
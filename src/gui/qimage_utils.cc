@@ -17,6 +17,8 @@
 */
 
 #include "qimage_utils.h"
+#include <opencv2/core.hpp>
+#include <QtCore/QtGlobal>
 #include <stdexcept>
 #include <string>
 
@@ -32,6 +34,9 @@ QImage::Format qimage_format_from_depth_channels(int depth, int channels)
     if (depth == 1 && channels == 3) {
         return QImage::Format_RGB888;
     }
+    if (depth == 2 && channels == 1) {
+        return QImage::Format_Grayscale16;
+    }
     if (depth == 2 && channels == 4) {
         return QImage::Format_RGBX64;
     }
@@ -39,6 +44,16 @@ QImage::Format qimage_format_from_depth_channels(int depth, int channels)
                                 " " + std::to_string(channels));
 }
 
+void release_cv_mat(void* info)
+{
+    delete static_cast<cv::Mat*>(info);
+}
+
+void release_cv_mat_owner(void* info)
+{
+    delete static_cast<std::shared_ptr<const cv::Mat>*>(info);
+}
+
 } // namespace
 
 QImage qimage_from_cv_mat(const cv::Mat& mat)
@@ -51,9 +66,60 @@ QImage qimage_from_cv_mat(const cv::Mat& mat)
         throw std::invalid_argument("Unsupported number of dimensions");
     }
 
-    int bytes_per_line = mat.size.p[1] * mat.elemSize1() * mat.channels();
-    return QImage(mat.data, mat.size.p[1], mat.size.p[0], bytes_per_line,
-                  qimage_format_from_depth_channels(mat.elemSize1(), mat.channels()));
+    auto format = qimage_format_from_depth_channels(mat.elemSize1(), mat.channels());
+
+    // The image is constructed from const data so that any attempt to modify it detaches instead
+    // of writing to the buffer of the matrix.
+    const uchar* data = mat.data;
+    return QImage(data, mat.size.p[1], mat.size.p[0], static_cast<int>(mat.step[0]), format,
+                  release_cv_mat, new cv::Mat(mat));
+}
+
+QImage qimage_for_display_from_cv_mat(const cv::Mat& mat,
+                                      std::shared_ptr<const cv::Mat> data_owner)
+{
+    if (mat.empty()) {
+        return {};
+    }
+
+    cv::Mat converted;
+    if (mat.depth() == CV_16U) {
+        mat.convertTo(converted, CV_8U, 1.0 / 256);
+    } else {
+        converted = mat;
+    }
+
+    if (converted.channels() == 1) {
+        // Grayscale images are kept as is, because converting them would quadruple the memory
+        // usage for little gain in painting speed.
+        if (converted.data != mat.data) {
+            return qimage_from_cv_mat(converted);
+        }
+        if (!data_owner) {
+            return qimage_from_cv_mat(mat.clone());
+        }
+        const uchar* data = mat.data;
+        return QImage(data, mat.size.p[1], mat.size.p[0], static_cast<int>(mat.step[0]),
+                      QImage::Format_Grayscale8, release_cv_mat_owner,
+                      new std::shared_ptr<const cv::Mat>(std::move(data_owner)));
+    }
+    if (converted.channels() != 3 && converted.channels() != 4) {
+        throw std::invalid_argument("Unsupported number of channels " +
+                                    std::to_string(converted.channels()));
+    }
+
+    QImage image(converted.size.p[1], converted.size.p[0], QImage::Format_RGB32);
+    cv::Mat dst{image.height(), image.width(), CV_8UC4, image.bits(),
+                static_cast<std::size_t>(image.bytesPerLine())};
+
+    // Format_RGB32 stores pixels as native 0xffRRGGBB values, so the byte order depends on the
+    // endianness of the machine.
+    dst.setTo(cv::Scalar::all(0xff));
+    const int from_to_le[] = {0, 2, 1, 1, 2, 0};
+    const int from_to_be[] = {0, 1, 1, 2, 2, 3};
+    cv::mixChannels(&converted, 1, &dst, 1,
+                    Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? from_to_le : from_to_be, 3);
+    return image;
 }
 
 QRectF qrectf_from_cv_rect2d(const cv::Rect2d& rect)
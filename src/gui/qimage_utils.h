@@ -21,10 +21,27 @@
 
 #include <opencv2/core/mat.hpp>
 #include <QtGui/QImage>
+#include <memory>
 
 namespace sanescan {
 
+/** Returns an image that shares the data of the given matrix without copying it. Row strides of
+    the matrix are respected. The image holds a reference to the matrix, so the data stays alive
+    for as long as the image does. If the matrix does not own its data (e.g. it refers to external
+    data), the caller must ensure that the data outlives the image.
+*/
 QImage qimage_from_cv_mat(const cv::Mat& mat);
+
+/** Converts the given matrix to an image in a format that is fast to paint. High bit depth data
+    is reduced to 8 bits per channel and color images are converted to Format_RGB32. Converting
+    large images is expensive, so this function should be called outside the GUI thread.
+
+    8-bit grayscale images are already fast to paint, so the returned image shares the data of
+    the matrix. data_owner must keep that data alive and is referenced by the returned image. If
+    data_owner is not set, the data is copied, because the matrix may refer to external data.
+*/
+QImage qimage_for_display_from_cv_mat(const cv::Mat& mat,
+                                      std::shared_ptr<const cv::Mat> data_owner = {});
 QRectF qrectf_from_cv_rect2d(const cv::Rect2d& rect);
 
 } // namespace sanescan
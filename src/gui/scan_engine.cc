@@ -19,6 +19,7 @@
 #include "scan_engine.h"
 #include "../lib/sane_wrapper.h"
 #include "../lib/scan_image_buffer.h"
+#include "util/trace.h"
 #include <QtGui/QImage>
 #include <opencv2/core/mat.hpp>
 #include <deque>
@@ -144,6 +145,7 @@ ScanEngine::~ScanEngine() = default; // TODO: maybe wait for thread
 
 void ScanEngine::perform_step()
 {
+    SANESCAN_TRACE_SPAN("scan_engine", "perform_step");
     // Note that pollers may cause signals to be emitted which may cause additional pollers to be
     // added. As a result we can't use iterators because they may be invalidated whenever poll()
     // is called.
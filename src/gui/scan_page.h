@@ -20,8 +20,10 @@
 #define SANESCAN_GUI_SCAN_PAGE_H
 
 #include "scan_type.h"
+#include "duplicate_page_job.h"
 #include "ocr_job.h"
 #include "lib/sane_types.h"
+#include "ocr/image_hash.h"
 #include "ocr/ocr_options.h"
 #include "ocr/ocr_results.h"
 #include "ocr/ocr_paragraph.h"
@@ -53,6 +55,18 @@ struct ScanPage {
     std::optional<double> scan_progress;
     std::optional<cv::Mat> scanned_image;
 
+    // Perceptual hash of scanned_image, computed by duplicate_page_job once the scan finishes
+    std::optional<ImageHash> image_hash;
+
+    // Set when scanned_image is a near-duplicate of the scanned image of an earlier page, e.g.
+    // due to a double feed. Refers to the first page with such image. The OCR results of that
+    // page are reused for the areas that have not changed.
+    std::optional<std::size_t> duplicate_of_page_index;
+
+    // Set when scanned_image is identical at full resolution to the scanned image of an earlier
+    // page. Only in such case the image of that page may be saved instead of scanned_image.
+    std::optional<std::size_t> same_image_as_page_index;
+
     bool locked = false; // scanner name and options won't changed anymore
     SaneDeviceInfo device;
 
@@ -63,11 +77,29 @@ struct ScanPage {
     std::map<std::string, SaneOptionValue> scan_option_values;
 
     OcrOptions ocr_options;
+
+    // Set when the page is a repeated scan of another page. The OCR results of that page are
+    // reused for the areas that have not changed.
+    std::optional<std::size_t> rescanned_page_index;
+
+    // Set when the page has been scanned, but OCR has been deferred according to the OCR policy
+    // of the page manager or until duplicate_page_job completes.
+    bool ocr_pending = false;
     std::optional<double> ocr_progress;
     std::optional<OcrResults> ocr_results;
 
+    // Paragraphs recognized so far by the OCR job that is in progress. The coordinates are in
+    // the coordinates of scanned_image. Cleared once ocr_results are available.
+    std::vector<OcrParagraph> ocr_partial_paragraphs;
+
+    // The area of scanned_image whose text should be recognized first, e.g. the visible area
+    OcrBox ocr_priority_area;
+
     std::vector<std::unique_ptr<OcrJob>> ocr_jobs;
     std::size_t last_ocr_job_id = 0;
+
+    // Set while the near-duplicates of the page are being searched for
+    std::unique_ptr<DuplicatePageJob> duplicate_page_job;
 };
 
 } // namespace sanescan
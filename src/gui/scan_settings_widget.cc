@@ -28,6 +28,9 @@ ScanSettingsWidget::ScanSettingsWidget(QWidget *parent) :
 {
     ui_->setupUi(this);
 
+    layout_ = new QGridLayout();
+    ui_->layout->insertLayout(3, layout_);
+
     connect(ui_->b_refresh_devices, &QPushButton::clicked,
             [this]() { Q_EMIT refresh_devices_clicked(); });
     connect(ui_->b_scan, &QPushButton::clicked,
@@ -58,8 +61,9 @@ void ScanSettingsWidget::set_options(const std::vector<SaneOptionGroupDestriptor
     if (curr_group_descriptors_ == descriptors)
         return;
 
+    auto old_descriptors = std::move(curr_group_descriptors_);
     curr_group_descriptors_ = descriptors;
-    refresh_widgets();
+    refresh_widgets(old_descriptors);
 }
 
 void ScanSettingsWidget::set_option_values(const std::map<std::string, SaneOptionValue>& values)
@@ -67,7 +71,6 @@ void ScanSettingsWidget::set_option_values(const std::map<std::string, SaneOptio
     for (const auto& [name, value] : values) {
         set_option_value(name, value);
     }
-    setting_widgets_need_initial_values_ = false;
 }
 
 void ScanSettingsWidget::set_option_value(const std::string& name, const SaneOptionValue& value)
@@ -78,8 +81,9 @@ void ScanSettingsWidget::set_option_value(const std::string& name, const SaneOpt
     }
 
     auto* setting_widget = it->second;
+    bool needs_value = setting_widgets_needing_values_.count(name) != 0;
     auto curr_value = setting_widget->get_value();
-    if (curr_value == value && !setting_widgets_need_initial_values_) {
+    if (curr_value == value && !needs_value) {
         return;
     }
 
@@ -88,6 +92,7 @@ void ScanSettingsWidget::set_option_value(const std::string& name, const SaneOpt
     }
 
     setting_widget->set_value(value);
+    setting_widgets_needing_values_.erase(name);
 }
 
 void ScanSettingsWidget::set_options_enabled(bool enabled)
@@ -103,48 +108,104 @@ void ScanSettingsWidget::device_selected_impl(int index)
     if (index < 0 || index >= devices_.size())
         return;
 
-    clear_layout();
+    // Options of a different device are not related to the current ones
+    remove_all_widgets();
+    curr_group_descriptors_.clear();
     Q_EMIT device_selected(devices_[index].name);
 }
 
-void ScanSettingsWidget::refresh_widgets()
+void ScanSettingsWidget::refresh_widgets(
+        const std::vector<SaneOptionGroupDestriptor>& old_descriptors)
 {
-    clear_layout();
-    setting_widgets_need_initial_values_ = true;
+    // Backends reload options frequently, e.g. after each change of scan source. Recreating all
+    // widgets in such case is slow when there are many options and causes flicker, so existing
+    // widgets are updated in place whenever possible.
+    std::map<std::string, const SaneOptionDescriptor*> old_descriptors_by_name;
+    for (const auto& group : old_descriptors) {
+        for (const auto& option_descriptor : group.options) {
+            old_descriptors_by_name.emplace(option_descriptor.name, &option_descriptor);
+        }
+    }
+
+    auto old_widgets = std::move(setting_widgets_);
+    setting_widgets_.clear();
+    std::vector<SettingWidget*> ordered_widgets;
+    bool widgets_created = false;
 
-    int curr_row = 0;
     for (const auto& group : curr_group_descriptors_) {
         // TODO: don't ignore groups
         for (const auto& option_descriptor : group.options) {
+            const auto& name = option_descriptor.name;
+
+            auto old_it = old_widgets.find(name);
+            if (old_it != old_widgets.end() &&
+                old_it->second->supports_descriptor(option_descriptor))
+            {
+                auto* widget = old_it->second;
+                old_widgets.erase(old_it);
+
+                auto old_descriptor_it = old_descriptors_by_name.find(name);
+                if (old_descriptor_it == old_descriptors_by_name.end() ||
+                    !(*old_descriptor_it->second == option_descriptor))
+                {
+                    widget->set_option_descriptor(option_descriptor);
+                    setting_widgets_needing_values_.insert(name);
+                }
+                ordered_widgets.push_back(widget);
+                setting_widgets_.emplace(name, widget);
+                continue;
+            }
+
             auto widget = SettingWidget::create_widget_for_descriptor(option_descriptor);
             if (!widget) {
                 continue;
             }
             auto* not_owned_widget = widget.release();
-            layout_->addWidget(not_owned_widget, curr_row++, 0); // takes ownership
+            not_owned_widget->setParent(this);
             not_owned_widget->set_option_descriptor(option_descriptor);
             connect(not_owned_widget, &SettingWidget::value_changed,
-                    [this, name=option_descriptor.name](const auto& new_value)
+                    [this, name](const auto& new_value)
             {
                 Q_EMIT option_value_changed(name, new_value);
             });
 
-            setting_widgets_.emplace(option_descriptor.name, not_owned_widget);
+            setting_widgets_needing_values_.insert(name);
+            widgets_created = true;
+            ordered_widgets.push_back(not_owned_widget);
+            setting_widgets_.emplace(name, not_owned_widget);
+        }
+    }
+
+    // Widgets of options that have disappeared or whose type has changed. Deleting a widget also
+    // removes it from the layout.
+    bool widgets_deleted = !old_widgets.empty();
+    for (const auto& [name, widget] : old_widgets) {
+        if (setting_widgets_.count(name) == 0) {
+            setting_widgets_needing_values_.erase(name);
         }
+        delete widget;
+    }
+
+    if (widgets_created || widgets_deleted || ordered_widgets != ordered_setting_widgets_) {
+        for (auto* widget : ordered_widgets) {
+            layout_->removeWidget(widget);
+        }
+        int curr_row = 0;
+        for (auto* widget : ordered_widgets) {
+            layout_->addWidget(widget, curr_row++, 0);
+        }
+        ordered_setting_widgets_ = std::move(ordered_widgets);
     }
 }
 
-void ScanSettingsWidget::clear_layout()
+void ScanSettingsWidget::remove_all_widgets()
 {
-    if (layout_) {
-        for (const auto& [_, widget] : setting_widgets_) {
-            delete widget;
-        }
-        setting_widgets_.clear();
-        delete layout_;
+    for (const auto& [_, widget] : setting_widgets_) {
+        delete widget;
     }
-    layout_ = new QGridLayout();
-    ui_->layout->insertLayout(3, layout_);
+    setting_widgets_.clear();
+    ordered_setting_widgets_.clear();
+    setting_widgets_needing_values_.clear();
 }
 
 } // namespace sanescan
@@ -25,6 +25,7 @@
 #include <QtWidgets/QGridLayout>
 #include <QtWidgets/QFrame>
 #include <memory>
+#include <set>
 
 namespace sanescan {
 
@@ -65,22 +66,27 @@ Q_SIGNALS:
 
 private:
     void device_selected_impl(int index);
-    void refresh_widgets();
-    void clear_layout();
+    void refresh_widgets(const std::vector<SaneOptionGroupDestriptor>& old_descriptors);
+    void remove_all_widgets();
 
     std::vector<SaneDeviceInfo> devices_;
 
     std::vector<SaneOptionGroupDestriptor> curr_group_descriptors_;
 
-    // Layout widget is not owned, the owner is `this`. Note that we terminate the relationship
-    // by deleting the widget.
+    // Layout widget is not owned, the owner is `this`.
     QGridLayout* layout_ = nullptr;
 
     // Widgets are not owned, the owner is *this. Note that we still need to delete them when
-    // refreshing view.
-    bool setting_widgets_need_initial_values_ = false;
+    // their options disappear.
     std::map<std::string, SettingWidget*> setting_widgets_;
 
+    // Widgets in the order they appear in the layout
+    std::vector<SettingWidget*> ordered_setting_widgets_;
+
+    // Names of widgets that have been created or had their descriptor changed and thus need
+    // their value to be set even if it's the same as the one returned by get_value().
+    std::set<std::string> setting_widgets_needing_values_;
+
     std::unique_ptr<Ui::ScanSettingsWidget> ui_;
 };
 
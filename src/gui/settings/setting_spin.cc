@@ -52,6 +52,9 @@ void SettingSpin::set_option_descriptor(const SaneOptionDescriptor& descriptor)
         ui_->label->setText(QString::fromStdString(descriptor.title));
         ui_->label->setToolTip(QString::fromStdString(descriptor.description));
 
+        // Changing the range clamps the current value, which must not be reported as if the user
+        // has changed it. The widget may already be connected to the scanner options.
+        suppress_value_changed_ = true;
         const auto* constraint = std::get_if<SaneConstraintIntRange>(&descriptor.constraint);
         if (constraint != nullptr) {
             constraint_ = *constraint;
@@ -63,6 +66,7 @@ void SettingSpin::set_option_descriptor(const SaneOptionDescriptor& descriptor)
                                    std::numeric_limits<int>::max());
             ui_->spinbox->setSingleStep(1);
         }
+        suppress_value_changed_ = false;
     }
     set_enabled(false);
 }
@@ -76,6 +76,8 @@ void SettingSpinFloat::set_option_descriptor(const SaneOptionDescriptor& descrip
         ui_->label->setText(QString::fromStdString(descriptor.title));
         ui_->label->setToolTip(QString::fromStdString(descriptor.description));
 
+        // The value clamped by setRange() is not a user change, see SettingSpin
+        suppress_value_changed_ = true;
         const auto* constraint = std::get_if<SaneConstraintFloatRange>(&descriptor.constraint);
         if (constraint != nullptr) {
             constraint_ = *constraint;
@@ -87,6 +89,7 @@ void SettingSpinFloat::set_option_descriptor(const SaneOptionDescriptor& descrip
                                    std::numeric_limits<double>::infinity());
             ui_->spinbox->setSingleStep(1);
         }
+        suppress_value_changed_ = false;
     }
     set_enabled(false);
 }
@@ -28,17 +28,37 @@ namespace {
 struct SettingWidgetFactory {
     std::function<bool(const SaneOptionDescriptor&)> is_supported;
     std::function<std::unique_ptr<SettingWidget>()> create;
+    std::function<bool(const SettingWidget&)> is_instance;
 };
 
+template<class T>
+bool is_instance_of(const SettingWidget& widget)
+{
+    return dynamic_cast<const T*>(&widget) != nullptr;
+}
+
 SettingWidgetFactory g_widget_factories[] = {
     { &SettingCombo::is_descriptor_supported,
-      [](){ return std::make_unique<SettingCombo>(); } },
+      [](){ return std::make_unique<SettingCombo>(); },
+      &is_instance_of<SettingCombo> },
     { &SettingSpin::is_descriptor_supported,
-      [](){ return std::make_unique<SettingSpin>(); } },
+      [](){ return std::make_unique<SettingSpin>(); },
+      &is_instance_of<SettingSpin> },
     { &SettingSpinFloat::is_descriptor_supported,
-      [](){ return std::make_unique<SettingSpinFloat>(); } },
+      [](){ return std::make_unique<SettingSpinFloat>(); },
+      &is_instance_of<SettingSpinFloat> },
 };
 
+const SettingWidgetFactory* find_factory(const SaneOptionDescriptor& descriptor)
+{
+    for (const auto& factory : g_widget_factories) {
+        if (factory.is_supported(descriptor)) {
+            return &factory;
+        }
+    }
+    return nullptr;
+}
+
 } // namespace
 
 SettingWidget::SettingWidget(QWidget* parent) : QWidget(parent) {}
@@ -46,12 +66,17 @@ SettingWidget::SettingWidget(QWidget* parent) : QWidget(parent) {}
 std::unique_ptr<SettingWidget>
     SettingWidget::create_widget_for_descriptor(const SaneOptionDescriptor& descriptor)
 {
-    for (const auto& factory : g_widget_factories) {
-        if (factory.is_supported(descriptor)) {
-            return factory.create();
-        }
+    const auto* factory = find_factory(descriptor);
+    if (factory == nullptr) {
+        return nullptr;
     }
-    return nullptr;
+    return factory->create();
+}
+
+bool SettingWidget::supports_descriptor(const SaneOptionDescriptor& descriptor) const
+{
+    const auto* factory = find_factory(descriptor);
+    return factory != nullptr && factory->is_instance(*this);
 }
 
 } // namespace sanescan
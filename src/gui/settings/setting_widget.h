@@ -41,6 +41,12 @@ public:
     static std::unique_ptr<SettingWidget>
         create_widget_for_descriptor(const SaneOptionDescriptor& descriptor);
 
+    /** Returns true if create_widget_for_descriptor() would create a widget of the same type as
+        this one for the given descriptor. In such case the widget can be reused for the
+        descriptor by calling set_option_descriptor().
+    */
+    bool supports_descriptor(const SaneOptionDescriptor& descriptor) const;
+
     /// Sets whether the value in the widget is editable or not.
     virtual void set_enabled(bool enabled) = 0;
 
@@ -0,0 +1,160 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "telemetry_dialog.h"
+#include "ui_telemetry_dialog.h"
+#include "util/telemetry.h"
+#include <QtCore/QTimer>
+#include <QtWidgets/QHeaderView>
+
+namespace sanescan {
+
+namespace {
+
+constexpr int REFRESH_INTERVAL_MSEC = 1000;
+constexpr auto THROUGHPUT_WINDOW = std::chrono::seconds(60);
+
+constexpr int COLUMN_NAME = 0;
+constexpr int COLUMN_TYPE = 1;
+constexpr int COLUMN_VALUE = 2;
+constexpr int COLUMN_COUNT = 3;
+
+QString format_duration(double seconds)
+{
+    if (seconds < 1e-3) {
+        return QString("%1 us").arg(seconds * 1e6, 0, 'f', 0);
+    }
+    if (seconds < 1) {
+        return QString("%1 ms").arg(seconds * 1e3, 0, 'f', 1);
+    }
+    return QString("%1 s").arg(seconds, 0, 'f', 2);
+}
+
+} // namespace
+
+TelemetryDialog::TelemetryDialog(QWidget *parent) :
+    QDialog(parent),
+    ui_{std::make_unique<Ui::TelemetryDialog>()}
+{
+    ui_->setupUi(this);
+    setWindowTitle(tr("Telemetry"));
+
+    ui_->table->setColumnCount(COLUMN_COUNT);
+    ui_->table->setHorizontalHeaderLabels({tr("Metric"), tr("Type"), tr("Value")});
+    ui_->table->horizontalHeader()->setSectionResizeMode(COLUMN_NAME,
+                                                         QHeaderView::ResizeToContents);
+    ui_->table->horizontalHeader()->setSectionResizeMode(COLUMN_TYPE,
+                                                         QHeaderView::ResizeToContents);
+    ui_->table->horizontalHeader()->setStretchLastSection(true);
+    ui_->table->verticalHeader()->setVisible(false);
+
+    refresh_timer_ = new QTimer(this);
+    connect(refresh_timer_, &QTimer::timeout, [this]() { refresh(); });
+    refresh_timer_->start(REFRESH_INTERVAL_MSEC);
+    refresh();
+}
+
+TelemetryDialog::~TelemetryDialog() = default;
+
+void TelemetryDialog::refresh()
+{
+    auto snapshot = TelemetryRegistry::instance().snapshot();
+    update_summary(snapshot);
+    update_table(snapshot);
+}
+
+void TelemetryDialog::update_summary(const TelemetrySnapshot& snapshot)
+{
+    auto get_counter = [&](const char* name) -> std::uint64_t
+    {
+        auto it = snapshot.counters.find(name);
+        return it != snapshot.counters.end() ? it->second : 0;
+    };
+    auto get_gauge = [&](const char* name) -> std::int64_t
+    {
+        auto it = snapshot.gauges.find(name);
+        return it != snapshot.gauges.end() ? it->second : 0;
+    };
+
+    auto now = std::chrono::steady_clock::now();
+    page_count_samples_.push_back(PageCountSample{now, get_counter("scan.pages_scanned"),
+                                                  get_counter("ocr.pages_completed")});
+    while (page_count_samples_.size() > 2 &&
+           now - page_count_samples_.front().time > THROUGHPUT_WINDOW) {
+        page_count_samples_.pop_front();
+    }
+
+    double scanned_per_min = 0;
+    double ocr_per_min = 0;
+    const auto& first = page_count_samples_.front();
+    const auto& last = page_count_samples_.back();
+    std::chrono::duration<double> window = last.time - first.time;
+    if (window.count() > 0) {
+        scanned_per_min = (last.scanned - first.scanned) * 60 / window.count();
+        ocr_per_min = (last.ocr_completed - first.ocr_completed) * 60 / window.count();
+    }
+
+    ui_->summary_label->setText(
+                tr("Scanned: %1 pages/min, OCR: %2 pages/min, "
+                   "OCR jobs queued: %3, running: %4, uptime: %5 s")
+                .arg(scanned_per_min, 0, 'f', 1)
+                .arg(ocr_per_min, 0, 'f', 1)
+                .arg(get_gauge("job_queue.length"))
+                .arg(get_gauge("job_queue.busy_workers"))
+                .arg(snapshot.uptime_sec, 0, 'f', 0));
+}
+
+void TelemetryDialog::update_table(const TelemetrySnapshot& snapshot)
+{
+    auto row_count = snapshot.counters.size() + snapshot.gauges.size() +
+            snapshot.histograms.size();
+    ui_->table->setRowCount(row_count);
+
+    int row = 0;
+    auto set_row = [&](const std::string& name, const QString& type, const QString& value)
+    {
+        for (int column = 0; column < COLUMN_COUNT; ++column) {
+            if (ui_->table->item(row, column) == nullptr) {
+                ui_->table->setItem(row, column, new QTableWidgetItem());
+            }
+        }
+        ui_->table->item(row, COLUMN_NAME)->setText(QString::fromStdString(name));
+        ui_->table->item(row, COLUMN_TYPE)->setText(type);
+        ui_->table->item(row, COLUMN_VALUE)->setText(value);
+        row++;
+    };
+
+    for (const auto& [name, value] : snapshot.counters) {
+        set_row(name, tr("counter"), QString::number(value));
+    }
+    for (const auto& [name, value] : snapshot.gauges) {
+        set_row(name, tr("gauge"), QString::number(value));
+    }
+    for (const auto& [name, h] : snapshot.histograms) {
+        set_row(name, tr("latency"),
+                tr("count %1, mean %2, p50 %3, p90 %4, p99 %5, max %6")
+                .arg(h.count)
+                .arg(format_duration(h.mean_sec()))
+                .arg(format_duration(h.p50_sec))
+                .arg(format_duration(h.p90_sec))
+                .arg(format_duration(h.p99_sec))
+                .arg(format_duration(h.max_sec)));
+    }
+}
+
+} // namespace sanescan
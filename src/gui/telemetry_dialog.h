@@ -0,0 +1,66 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SANESCAN_GUI_TELEMETRY_DIALOG_H
+#define SANESCAN_GUI_TELEMETRY_DIALOG_H
+
+#include <QtWidgets/QDialog>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+class QTimer;
+
+namespace sanescan {
+
+namespace Ui {
+    class TelemetryDialog;
+}
+
+struct TelemetrySnapshot;
+
+/// Shows the live contents of the telemetry registry
+class TelemetryDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit TelemetryDialog(QWidget *parent = nullptr);
+    ~TelemetryDialog() override;
+
+private:
+    void refresh();
+    void update_summary(const TelemetrySnapshot& snapshot);
+    void update_table(const TelemetrySnapshot& snapshot);
+
+    struct PageCountSample {
+        std::chrono::steady_clock::time_point time;
+        std::uint64_t scanned = 0;
+        std::uint64_t ocr_completed = 0;
+    };
+
+    std::unique_ptr<Ui::TelemetryDialog> ui_;
+    QTimer* refresh_timer_ = nullptr;
+    // Samples of page counters within the last minute, used to compute the current throughput
+    std::deque<PageCountSample> page_count_samples_;
+};
+
+} // namespace sanescan
+
+#endif // SANESCAN_GUI_TELEMETRY_DIALOG_H
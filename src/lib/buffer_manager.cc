@@ -17,6 +17,8 @@
 */
 
 #include "buffer_manager.h"
+#include "util/telemetry.h"
+#include "util/trace.h"
 #include <mutex>
 #include <stdexcept>
 #include <vector>
@@ -130,6 +132,12 @@ struct BufferManager::Private {
     std::size_t next_read_index = 0;
     bool has_data = false;
     std::vector<std::unique_ptr<BufferManagerBuffer>> buffers;
+
+    TelemetryMutexStats mutex_stats{"buffer_manager"};
+    TelemetryGauge& allocated_bytes_gauge =
+            TelemetryRegistry::instance().gauge("buffer_manager.allocated_bytes");
+    TelemetryCounter& buffers_full_counter =
+            TelemetryRegistry::instance().counter("buffer_manager.buffers_full");
 };
 
 BufferManager::BufferManager(std::size_t max_buffer_size) :
@@ -138,13 +146,16 @@ BufferManager::BufferManager(std::size_t max_buffer_size) :
     d_->max_buffer_size = max_buffer_size;
 }
 
-BufferManager::~BufferManager() = default;
+BufferManager::~BufferManager()
+{
+    d_->allocated_bytes_gauge.add(-static_cast<std::int64_t>(d_->curr_buffer_size));
+}
 
 std::optional<BufferWriteRef>
     BufferManager::get_write(std::size_t first_line, std::size_t last_line,
                              std::size_t line_byte_count)
 {
-    std::lock_guard lock{d_->mutex};
+    auto lock = lock_with_telemetry(d_->mutex, d_->mutex_stats);
     if (d_->next_write_index != d_->next_read_index) {
         if (d_->buffers[d_->next_write_index]->in_progress) {
             return maybe_insert_for_writing(first_line, last_line, line_byte_count);
@@ -166,7 +177,7 @@ std::optional<BufferWriteRef>
 
 std::optional<BufferReadRef> BufferManager::get_read()
 {
-    std::lock_guard lock{d_->mutex};
+    auto lock = lock_with_telemetry(d_->mutex, d_->mutex_stats);
     if (!d_->has_data) {
         return {};
     }
@@ -195,7 +206,7 @@ void BufferManager::reset()
 
 void BufferManager::finish_read(std::size_t index)
 {
-    std::lock_guard lock{d_->mutex};
+    auto lock = lock_with_telemetry(d_->mutex, d_->mutex_stats);
     for (auto& buffer_ptr : d_->buffers) {
         if (buffer_ptr->index == index) {
             if (!buffer_ptr->in_progress) {
@@ -210,7 +221,7 @@ void BufferManager::finish_read(std::size_t index)
 
 void BufferManager::finish_write(std::size_t index, std::size_t size)
 {
-    std::lock_guard lock{d_->mutex};
+    auto lock = lock_with_telemetry(d_->mutex, d_->mutex_stats);
     for (auto& buffer_ptr : d_->buffers) {
         if (buffer_ptr->index == index) {
             if (!buffer_ptr->in_progress) {
@@ -234,8 +245,11 @@ std::optional<BufferWriteRef>
                                             std::size_t line_byte_count)
 {
     std::size_t requested_size = (last_line - first_line) * line_byte_count;
-    if (d_->curr_buffer_size + requested_size > d_->max_buffer_size)
+    if (d_->curr_buffer_size + requested_size > d_->max_buffer_size) {
+        trace_instant("buffer_manager", "buffers_full");
+        d_->buffers_full_counter.add();
         return {};
+    }
 
 
     auto insert_pos = d_->buffers.begin() + d_->next_write_index;
@@ -244,6 +258,8 @@ std::optional<BufferWriteRef>
 
     auto& buffer_ptr = *d_->buffers.insert(insert_pos, std::move(ptr_to_insert));
     d_->curr_buffer_size += requested_size;
+    d_->allocated_bytes_gauge.add(requested_size);
+    trace_counter("buffer_manager_allocated_bytes", d_->curr_buffer_size);
 
     maybe_bump_next_read_index_on_insert();
     bump_next_write_index();
@@ -262,6 +278,7 @@ BufferWriteRef BufferManager::setup_for_writing(std::size_t first_line, std::siz
 
     if (buffer_ptr->data.size() < requested_size) {
         d_->curr_buffer_size += requested_size - buffer_ptr->data.size();
+        d_->allocated_bytes_gauge.add(requested_size - buffer_ptr->data.size());
         buffer_ptr->data.resize(requested_size);
     }
 
@@ -17,7 +17,10 @@
 */
 
 #include "job_queue.h"
+#include "util/telemetry.h"
+#include "util/trace.h"
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
@@ -33,13 +36,30 @@ enum JobQueueState {
     STOPPING
 };
 
+struct QueuedJob {
+    IJob* job = nullptr;
+    // Used for tracing only, -1 if tracing was disabled during submission
+    std::int64_t submit_time_us = -1;
+    std::chrono::steady_clock::time_point submit_time;
+};
+
 struct JobQueue::Private {
-    std::queue<IJob*> jobs;
+    std::queue<QueuedJob> jobs;
     std::vector<std::thread> threads;
     std::mutex mutex;
     std::condition_variable cv;
 
     std::atomic<JobQueueState> state = JobQueueState::STOPPED;
+
+    TelemetryMutexStats mutex_stats{"job_queue"};
+    TelemetryGauge& length_gauge = TelemetryRegistry::instance().gauge("job_queue.length");
+    TelemetryGauge& busy_workers_gauge =
+            TelemetryRegistry::instance().gauge("job_queue.busy_workers");
+    TelemetryHistogram& wait_histogram =
+            TelemetryRegistry::instance().histogram("job_queue.wait");
+    TelemetryHistogram& run_histogram = TelemetryRegistry::instance().histogram("job_queue.run");
+    TelemetryCounter& completed_counter =
+            TelemetryRegistry::instance().counter("job_queue.jobs_completed");
 };
 
 JobQueue::JobQueue(unsigned thread_count) :
@@ -67,10 +87,11 @@ void JobQueue::start()
     for (auto& thread : d_->threads) {
         thread = std::thread([this]()
         {
+            trace_set_thread_name("JobQueue worker");
             while (true) {
-                IJob* job = nullptr;
+                QueuedJob job;
                 {
-                    std::unique_lock lock{d_->mutex};
+                    auto lock = lock_with_telemetry(d_->mutex, d_->mutex_stats);
                     while (d_->jobs.empty() && d_->state == JobQueueState::RUNNING) {
                         d_->cv.wait(lock);
                     }
@@ -79,8 +100,22 @@ void JobQueue::start()
                     }
                     job = d_->jobs.front();
                     d_->jobs.pop();
+                    trace_counter("job_queue_length", d_->jobs.size());
+                    d_->length_gauge.add(-1);
+                }
+                auto start_time = std::chrono::steady_clock::now();
+                d_->wait_histogram.record(start_time - job.submit_time);
+                if (job.submit_time_us >= 0) {
+                    trace_complete("job_queue", "wait", job.submit_time_us, trace_now_us());
                 }
-                job->execute();
+                d_->busy_workers_gauge.add(1);
+                {
+                    SANESCAN_TRACE_SPAN("job_queue", "job");
+                    job.job->execute();
+                }
+                d_->busy_workers_gauge.add(-1);
+                d_->run_histogram.record(std::chrono::steady_clock::now() - start_time);
+                d_->completed_counter.add();
             }
         });
     }
@@ -109,8 +144,11 @@ void JobQueue::wait()
 
 void JobQueue::submit(IJob& job)
 {
-    std::unique_lock lock{d_->mutex};
-    d_->jobs.push(&job);
+    auto lock = lock_with_telemetry(d_->mutex, d_->mutex_stats);
+    d_->jobs.push(QueuedJob{&job, trace_enabled() ? trace_now_us() : -1,
+                            std::chrono::steady_clock::now()});
+    trace_counter("job_queue_length", d_->jobs.size());
+    d_->length_gauge.add(1);
     d_->cv.notify_one();
 }
 
@@ -23,10 +23,13 @@
 #include "sane_utils.h"
 #include "task_executor.h"
 #include "sane_types_conv.h"
+#include "util/telemetry.h"
+#include "util/trace.h"
 #include <sane/sane.h>
 #include <algorithm>
 #include <atomic>
 #include <cstring>
+#include <mutex>
 #include <thread>
 
 namespace sanescan {
@@ -79,6 +82,9 @@ struct SaneDeviceWrapper::Private {
     BufferManager buffer_manager;
     std::exception_ptr read_exception = nullptr;
 
+    std::mutex read_stats_mutex;
+    ScanReadStatsCollector read_stats;
+
     // the following variables are supposed to be referenced only from tasks sent to executor
     std::vector<SaneOptionDescriptor> task_option_descriptors;
     SANE_Parameters task_curr_frame_params = {};
@@ -218,6 +224,10 @@ std::future<void> SaneDeviceWrapper::start()
     return d_->executor->schedule_task<void>([this]()
     {
         d_->buffer_manager.reset();
+        {
+            std::lock_guard lock{d_->read_stats_mutex};
+            d_->read_stats.start(std::chrono::steady_clock::now());
+        }
         throw_if_sane_status_not_good(sane_start(d_->handle));
         d_->finished = false;
         task_start_read();
@@ -231,6 +241,10 @@ void SaneDeviceWrapper::task_start_read()
         try {
             throw_if_sane_status_not_good(sane_get_parameters(d_->handle,
                                                               &d_->task_curr_frame_params));
+            {
+                std::lock_guard lock{d_->read_stats_mutex};
+                d_->read_stats.set_line_bytes(d_->task_curr_frame_params.bytes_per_line);
+            }
             d_->task_last_read_line = 0;
             task_schedule_read();
         }  catch (...) {
@@ -268,9 +282,24 @@ void SaneDeviceWrapper::task_schedule_read()
             auto [buffer, write_size] = d_->task_partial_line.before_read(write_buf->data(),
                                                                           write_buf->size());
 
+            static auto& read_histogram = TelemetryRegistry::instance().histogram("sane.read");
+            static auto& read_bytes_counter =
+                    TelemetryRegistry::instance().counter("sane.read_bytes");
+
             SANE_Int bytes_written = 0;
-            auto status = sane_read(d_->handle, reinterpret_cast<SANE_Byte*>(buffer),
-                                    write_size, &bytes_written);
+            SANE_Status status;
+            {
+                SANESCAN_TRACE_SPAN("sane", "sane_read");
+                auto read_start = std::chrono::steady_clock::now();
+                status = sane_read(d_->handle, reinterpret_cast<SANE_Byte*>(buffer),
+                                   write_size, &bytes_written);
+                auto read_end = std::chrono::steady_clock::now();
+                read_histogram.record(read_end - read_start);
+                read_bytes_counter.add(bytes_written);
+
+                std::lock_guard lock{d_->read_stats_mutex};
+                d_->read_stats.add_read(read_end, bytes_written);
+            }
 
             bytes_written = d_->task_partial_line.after_read(buffer, bytes_written,
                                                              bytes_per_line);
@@ -324,6 +353,12 @@ bool SaneDeviceWrapper::finished()
     return d_->finished;
 }
 
+ScanReadStats SaneDeviceWrapper::read_stats()
+{
+    std::lock_guard lock{d_->read_stats_mutex};
+    return d_->read_stats.stats();
+}
+
 void SaneDeviceWrapper::cancel()
 {
     d_->executor->schedule_task<void>([this]()
@@ -22,6 +22,7 @@
 #include <future>
 #include <vector>
 #include "sane_types.h"
+#include "scan_read_stats.h"
 #include "fwd.h"
 
 namespace sanescan {
@@ -70,6 +71,11 @@ public:
     bool finished();
     void cancel();
 
+    /** Returns the timing of data delivery of the current scan or the last scan if no scan is
+        in progress. Can be called from any thread.
+    */
+    ScanReadStats read_stats();
+
 private:
     friend class SaneWrapper;
 
@@ -0,0 +1,289 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "scan_profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <locale>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace sanescan {
+
+namespace {
+
+constexpr double RANGE_SAMPLE_STEP = 100;
+
+std::vector<std::string> split_string(const std::string& str, char separator)
+{
+    std::vector<std::string> result;
+    std::size_t pos = 0;
+    while (true) {
+        auto next = str.find(separator, pos);
+        result.push_back(str.substr(pos, next - pos));
+        if (next == std::string::npos) {
+            return result;
+        }
+        pos = next + 1;
+    }
+}
+
+template<class T>
+T parse_number(const std::string& str)
+{
+    std::istringstream stream(str);
+    stream.imbue(std::locale::classic());
+    T value{};
+    if (!(stream >> value) || !stream.eof()) {
+        throw std::invalid_argument("Could not parse number " + str);
+    }
+    return value;
+}
+
+std::string format_number(double value)
+{
+    std::ostringstream stream;
+    stream.imbue(std::locale::classic());
+    stream << value;
+    return stream.str();
+}
+
+template<class T>
+std::vector<std::string> sample_range(T range_min, T range_max, double min, double max)
+{
+    auto first = std::max<double>(range_min, min);
+    auto last = std::min<double>(range_max, max);
+    if (first > last) {
+        return {};
+    }
+
+    std::vector<std::string> result = {format_number(first)};
+    for (auto value = (std::floor(first / RANGE_SAMPLE_STEP) + 1) * RANGE_SAMPLE_STEP;
+         value < last; value += RANGE_SAMPLE_STEP) {
+        result.push_back(format_number(value));
+    }
+    if (last != first) {
+        result.push_back(format_number(last));
+    }
+    return result;
+}
+
+template<class T>
+std::vector<std::string> filter_list(const std::vector<T>& values, double min, double max)
+{
+    std::vector<std::string> result;
+    for (auto value : values) {
+        if (value >= min && value <= max) {
+            result.push_back(format_number(value));
+        }
+    }
+    return result;
+}
+
+const std::string* find_config_value(const ScanProfileConfig& config, const std::string& name)
+{
+    for (const auto& [option_name, value] : config) {
+        if (option_name == name) {
+            return &value;
+        }
+    }
+    return nullptr;
+}
+
+std::string format_fixed(double value, int precision)
+{
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(precision) << value;
+    return stream.str();
+}
+
+} // namespace
+
+ScanProfileDimension parse_scan_profile_dimension(const std::string& spec)
+{
+    auto separator_pos = spec.find('=');
+    if (separator_pos == std::string::npos || separator_pos == 0) {
+        throw std::invalid_argument("Option values must be given as name=value1,value2,...: " +
+                                    spec);
+    }
+
+    ScanProfileDimension dimension;
+    dimension.option_name = spec.substr(0, separator_pos);
+    dimension.values = split_string(spec.substr(separator_pos + 1), ',');
+    for (const auto& value : dimension.values) {
+        if (value.empty()) {
+            throw std::invalid_argument("Empty value of option " + dimension.option_name);
+        }
+    }
+    return dimension;
+}
+
+std::vector<ScanProfileConfig>
+    build_scan_profile_matrix(const std::vector<ScanProfileDimension>& dimensions)
+{
+    std::vector<ScanProfileConfig> result = {{}};
+    for (const auto& dimension : dimensions) {
+        std::vector<ScanProfileConfig> new_result;
+        new_result.reserve(result.size() * dimension.values.size());
+        for (const auto& config : result) {
+            for (const auto& value : dimension.values) {
+                auto new_config = config;
+                new_config.emplace_back(dimension.option_name, value);
+                new_result.push_back(std::move(new_config));
+            }
+        }
+        result = std::move(new_result);
+    }
+    return result;
+}
+
+SaneOptionValue parse_sane_option_value(const SaneOptionDescriptor& desc,
+                                        const std::string& value)
+{
+    auto value_count = static_cast<std::size_t>(std::max(desc.size, 1));
+    switch (desc.type) {
+        case SaneValueType::BOOL: {
+            if (value == "1" || value == "true" || value == "yes") {
+                return std::vector<bool>(value_count, true);
+            }
+            if (value == "0" || value == "false" || value == "no") {
+                return std::vector<bool>(value_count, false);
+            }
+            throw std::invalid_argument("Could not parse boolean value " + value + " of option " +
+                                        desc.name);
+        }
+        case SaneValueType::INT:
+            return std::vector<int>(value_count, parse_number<int>(value));
+        case SaneValueType::FLOAT:
+            return std::vector<double>(value_count, parse_number<double>(value));
+        case SaneValueType::STRING: {
+            const auto* list = std::get_if<SaneConstraintStringList>(&desc.constraint);
+            if (list != nullptr &&
+                    std::find(list->strings.begin(), list->strings.end(), value) ==
+                        list->strings.end()) {
+                throw std::invalid_argument("Value " + value + " is not supported by option " +
+                                            desc.name);
+            }
+            return value;
+        }
+        default:
+            throw std::invalid_argument("Option " + desc.name + " can't be profiled");
+    }
+}
+
+std::vector<std::string> get_option_values_in_range(const SaneOptionDescriptor& desc,
+                                                    double min, double max)
+{
+    if (const auto* list = std::get_if<SaneConstraintIntList>(&desc.constraint)) {
+        return filter_list(list->numbers, min, max);
+    }
+    if (const auto* list = std::get_if<SaneConstraintFloatList>(&desc.constraint)) {
+        return filter_list(list->numbers, min, max);
+    }
+    if (const auto* range = std::get_if<SaneConstraintIntRange>(&desc.constraint)) {
+        return sample_range(range->min, range->max, min, max);
+    }
+    if (const auto* range = std::get_if<SaneConstraintFloatRange>(&desc.constraint)) {
+        return sample_range(range->min, range->max, min, max);
+    }
+    return {};
+}
+
+std::optional<std::size_t>
+    find_fastest_scan_profile_result(const std::vector<ScanProfileResult>& results,
+                                     double target_dpi)
+{
+    std::optional<std::size_t> best_index;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        if (!result.stats.has_value() || result.stats->total_bytes == 0) {
+            continue;
+        }
+
+        const auto* resolution = find_config_value(result.config, "resolution");
+        if (resolution != nullptr && parse_number<double>(*resolution) < target_dpi) {
+            continue;
+        }
+
+        if (!best_index.has_value() ||
+                result.stats->total_duration_sec <
+                    results[best_index.value()].stats->total_duration_sec) {
+            best_index = i;
+        }
+    }
+    return best_index;
+}
+
+void write_scan_profile_table(std::ostream& stream, const std::vector<ScanProfileResult>& results)
+{
+    if (results.empty()) {
+        return;
+    }
+
+    std::vector<std::vector<std::string>> rows;
+
+    std::vector<std::string> header;
+    for (const auto& [name, value] : results.front().config) {
+        header.push_back(name);
+    }
+    header.insert(header.end(), {"first line (s)", "total (s)", "MB/s", "stalls",
+                                 "max stall (s)"});
+    rows.push_back(header);
+
+    for (const auto& result : results) {
+        std::vector<std::string> row;
+        for (const auto& [name, value] : result.config) {
+            row.push_back(value);
+        }
+        if (result.stats.has_value()) {
+            const auto& stats = result.stats.value();
+            row.push_back(format_fixed(stats.time_to_first_line_sec, 2));
+            row.push_back(format_fixed(stats.total_duration_sec, 2));
+            row.push_back(format_fixed(stats.sustained_bytes_per_sec / (1024 * 1024), 2));
+            row.push_back(std::to_string(stats.stall_count));
+            row.push_back(format_fixed(stats.max_stall_sec, 2));
+        } else {
+            row.push_back("failed: " + result.error);
+        }
+        rows.push_back(std::move(row));
+    }
+
+    std::vector<std::size_t> widths(header.size(), 0);
+    for (const auto& row : rows) {
+        // The error message of failed configurations is not aligned
+        for (std::size_t i = 0; i < std::min(row.size(), widths.size()) - 1; ++i) {
+            widths[i] = std::max(widths[i], row[i].size());
+        }
+    }
+
+    for (const auto& row : rows) {
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            if (i + 1 == row.size()) {
+                stream << row[i];
+            } else {
+                stream << std::left << std::setw(widths[i]) << row[i] << "  ";
+            }
+        }
+        stream << "\n";
+    }
+}
+
+} // namespace sanescan
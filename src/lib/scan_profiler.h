@@ -0,0 +1,85 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_LIB_SCAN_PROFILER_H
+#define SANESCAN_LIB_SCAN_PROFILER_H
+
+#include "sane_types.h"
+#include "scan_read_stats.h"
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sanescan {
+
+/// A scanner option and the values it should take when profiling
+struct ScanProfileDimension {
+    std::string option_name;
+    std::vector<std::string> values;
+};
+
+/// Option name and value pairs of a single profiled configuration
+using ScanProfileConfig = std::vector<std::pair<std::string, std::string>>;
+
+struct ScanProfileResult {
+    ScanProfileConfig config;
+
+    // Set if the scan completed successfully
+    std::optional<ScanReadStats> stats;
+    std::string error;
+};
+
+/** Parses a dimension specification in the form of name=value1,value2,... Throws
+    std::invalid_argument if the specification is malformed.
+*/
+ScanProfileDimension parse_scan_profile_dimension(const std::string& spec);
+
+/// Returns all combinations of the values of the dimensions. The last dimension varies fastest.
+std::vector<ScanProfileConfig>
+    build_scan_profile_matrix(const std::vector<ScanProfileDimension>& dimensions);
+
+/** Converts a value given as a string to the option value of the type expected by the option.
+    Throws std::invalid_argument if the value can't be converted.
+*/
+SaneOptionValue parse_sane_option_value(const SaneOptionDescriptor& desc,
+                                        const std::string& value);
+
+/** Returns the values of the option within the given range of the constraint of the option.
+    Range constraints are sampled at the bounds and at multiples of 100 in between. Returns
+    an empty vector for options that are not numeric.
+*/
+std::vector<std::string> get_option_values_in_range(const SaneOptionDescriptor& desc,
+                                                    double min, double max);
+
+/** Returns the index of the configuration that completed the scan in the shortest time among
+    the configurations that scan at least at the target resolution. Configurations that don't
+    set the resolution option are assumed to satisfy any target.
+*/
+std::optional<std::size_t>
+    find_fastest_scan_profile_result(const std::vector<ScanProfileResult>& results,
+                                     double target_dpi);
+
+/// Writes the results as a table with one configuration per row
+void write_scan_profile_table(std::ostream& stream, const std::vector<ScanProfileResult>& results);
+
+} // namespace sanescan
+
+#endif // SANESCAN_LIB_SCAN_PROFILER_H
@@ -0,0 +1,92 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "scan_read_stats.h"
+#include <algorithm>
+
+namespace sanescan {
+
+ScanReadStatsCollector::ScanReadStatsCollector(Clock::duration stall_threshold) :
+    stall_threshold_{stall_threshold}
+{
+}
+
+void ScanReadStatsCollector::start(Clock::time_point time)
+{
+    start_time_ = time;
+    line_bytes_ = 0;
+    total_bytes_ = 0;
+    first_line_time_.reset();
+    first_line_bytes_ = 0;
+    last_read_time_.reset();
+    stats_ = {};
+}
+
+void ScanReadStatsCollector::set_line_bytes(std::size_t line_bytes)
+{
+    line_bytes_ = line_bytes;
+}
+
+void ScanReadStatsCollector::add_read(Clock::time_point time, std::size_t bytes)
+{
+    if (bytes == 0) {
+        return;
+    }
+
+    if (first_line_time_.has_value() && last_read_time_.has_value()) {
+        auto gap = time - last_read_time_.value();
+        if (gap > stall_threshold_) {
+            stats_.stall_count++;
+            stats_.max_stall_sec = std::max(stats_.max_stall_sec, to_sec(gap));
+            stats_.total_stall_sec += to_sec(gap);
+        }
+    }
+
+    total_bytes_ += bytes;
+    last_read_time_ = time;
+    if (!first_line_time_.has_value() && total_bytes_ >= std::max<std::size_t>(line_bytes_, 1)) {
+        first_line_time_ = time;
+        first_line_bytes_ = total_bytes_;
+    }
+}
+
+ScanReadStats ScanReadStatsCollector::stats() const
+{
+    auto result = stats_;
+    result.total_bytes = total_bytes_;
+    if (!first_line_time_.has_value()) {
+        return result;
+    }
+
+    result.time_to_first_line_sec = to_sec(first_line_time_.value() - start_time_);
+    result.total_duration_sec = to_sec(last_read_time_.value() - start_time_);
+
+    auto sustained_duration = to_sec(last_read_time_.value() - first_line_time_.value());
+    if (sustained_duration > 0) {
+        result.sustained_bytes_per_sec = (total_bytes_ - first_line_bytes_) / sustained_duration;
+    }
+    return result;
+}
+
+double ScanReadStatsCollector::to_sec(Clock::duration duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+} // namespace sanescan
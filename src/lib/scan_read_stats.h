@@ -0,0 +1,85 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_LIB_SCAN_READ_STATS_H
+#define SANESCAN_LIB_SCAN_READ_STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace sanescan {
+
+/// Timing of data delivery by the scanner during a single scan
+struct ScanReadStats {
+    // Time from the start of the scan until the first complete line has been read. This includes
+    // any warm-up and calibration the scanner does.
+    double time_to_first_line_sec = 0;
+
+    // Time from the start of the scan until the last data has been read
+    double total_duration_sec = 0;
+    std::size_t total_bytes = 0;
+
+    // The read rate from the first complete line until the last data has been read
+    double sustained_bytes_per_sec = 0;
+
+    // Gaps between reads returning data that are longer than the stall threshold. Gaps before
+    // the first complete line are not counted.
+    std::size_t stall_count = 0;
+    double max_stall_sec = 0;
+    double total_stall_sec = 0;
+};
+
+/** Collects ScanReadStats from the read loop. The collector is not thread-safe.
+*/
+class ScanReadStatsCollector {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds DEFAULT_STALL_THRESHOLD{100};
+
+    explicit ScanReadStatsCollector(Clock::duration stall_threshold = DEFAULT_STALL_THRESHOLD);
+
+    /// Resets the statistics for a new scan that has been started at the given time
+    void start(Clock::time_point time);
+
+    /// Sets the size of the line of the scanned image. Must be called before any reads are added.
+    void set_line_bytes(std::size_t line_bytes);
+
+    /// Adds a read that has finished at the given time. Reads returning no data are ignored.
+    void add_read(Clock::time_point time, std::size_t bytes);
+
+    ScanReadStats stats() const;
+
+private:
+    static double to_sec(Clock::duration duration);
+
+    Clock::duration stall_threshold_;
+    Clock::time_point start_time_;
+    std::size_t line_bytes_ = 0;
+    std::size_t total_bytes_ = 0;
+    std::optional<Clock::time_point> first_line_time_;
+    std::size_t first_line_bytes_ = 0;
+    std::optional<Clock::time_point> last_read_time_;
+    ScanReadStats stats_;
+};
+
+} // namespace sanescan
+
+#endif // SANESCAN_LIB_SCAN_READ_STATS_H
@@ -17,6 +17,9 @@
 */
 
 #include "task_executor.h"
+#include "util/telemetry.h"
+#include "util/trace.h"
+#include <chrono>
 #include <deque>
 
 namespace sanescan {
@@ -28,6 +31,12 @@ struct TaskExecutor::Private {
     std::thread thread;
     std::atomic_bool active = false;
     std::atomic_bool stop = false;
+
+    TelemetryMutexStats mutex_stats{"task_executor"};
+    TelemetryGauge& queue_length_gauge =
+            TelemetryRegistry::instance().gauge("task_executor.queue_length");
+    TelemetryHistogram& task_histogram =
+            TelemetryRegistry::instance().histogram("task_executor.task");
 };
 
 TaskExecutor::TaskExecutor() :
@@ -35,11 +44,12 @@ TaskExecutor::TaskExecutor() :
 {
     d_->thread = std::thread([this]()
     {
+        trace_set_thread_name("TaskExecutor");
         std::unique_ptr<ITask> task;
 
         while (true) {
             {
-                std::unique_lock lock{d_->mutex};
+                auto lock = lock_with_telemetry(d_->mutex, d_->mutex_stats);
 
                 d_->active = false;
                 d_->cv.wait(lock, [this](){ return !d_->tasks.empty() || d_->stop; });
@@ -53,9 +63,16 @@ TaskExecutor::TaskExecutor() :
 
                 task = std::move(d_->tasks.front());
                 d_->tasks.pop_front();
+                trace_counter("task_executor_queue_length", d_->tasks.size());
+                d_->queue_length_gauge.add(-1);
+            }
+            {
+                SANESCAN_TRACE_SPAN("task_executor", "task");
+                auto start_time = std::chrono::steady_clock::now();
+                task->call();
+                task.reset();
+                d_->task_histogram.record(std::chrono::steady_clock::now() - start_time);
             }
-            task->call();
-            task.reset();
         }
     });
 }
@@ -81,20 +98,27 @@ void TaskExecutor::join_cancel()
     {
         std::unique_lock lock{d_->mutex};
         d_->stop = true;
+        d_->queue_length_gauge.add(-static_cast<std::int64_t>(d_->tasks.size()));
         d_->tasks.clear();
         d_->cv.notify_all();
     }
     d_->thread.join();
 }
 
-void TaskExecutor::schedule_task_impl(std::unique_ptr<ITask>&& task)
+void TaskExecutor::schedule_task_impl(std::unique_ptr<ITask>&& task, bool first)
 {
-    std::unique_lock lock{d_->mutex};
+    auto lock = lock_with_telemetry(d_->mutex, d_->mutex_stats);
     if (!d_->thread.joinable()) {
         throw std::runtime_error("Execution thread has already been stopped");
     }
 
-    d_->tasks.push_back(std::move(task));
+    if (first) {
+        d_->tasks.push_front(std::move(task));
+    } else {
+        d_->tasks.push_back(std::move(task));
+    }
+    trace_counter("task_executor_queue_length", d_->tasks.size());
+    d_->queue_length_gauge.add(1);
     d_->cv.notify_all();
 }
 
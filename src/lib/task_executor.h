@@ -39,7 +39,17 @@ public:
     {
         auto task = std::make_unique<Task<R>>(callable);
         auto future = task->get_future();
-        schedule_task_impl(std::move(task));
+        schedule_task_impl(std::move(task), false);
+        return future;
+    }
+
+    /// Same as schedule_task() except that the task is executed before all pending tasks.
+    template<class R, class F>
+    std::future<R> schedule_task_first(F&& callable)
+    {
+        auto task = std::make_unique<Task<R>>(callable);
+        auto future = task->get_future();
+        schedule_task_impl(std::move(task), true);
         return future;
     }
 
@@ -74,7 +84,7 @@ private:
         std::packaged_task<R()> task_;
     };
 
-    void schedule_task_impl(std::unique_ptr<ITask>&& task);
+    void schedule_task_impl(std::unique_ptr<ITask>&& task, bool first);
 
     struct Private;
     std::unique_ptr<Private> d_;
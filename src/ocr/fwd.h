@@ -29,6 +29,7 @@ struct OcrLine;
 struct OcrOptions;
 struct OcrParagraph;
 struct OcrResults;
+class OcrSpatialIndex;
 struct OcrWord;
 class PdfCanvas;
 class PdfWriter;
@@ -222,6 +222,21 @@ std::string box_to_hocr(const OcrBox& box)
             std::to_string(box.y2);
 }
 
+// Splits UTF-8 encoded string into individual code points
+std::vector<std::string> split_utf8_chars(const std::string& text)
+{
+    std::vector<std::string> result;
+    for (auto ch : text) {
+        bool is_continuation = (static_cast<unsigned char>(ch) & 0xc0) == 0x80;
+        if (is_continuation && !result.empty()) {
+            result.back().push_back(ch);
+        } else {
+            result.emplace_back(1, ch);
+        }
+    }
+    return result;
+}
+
 void write_hocr(std::ostream& output, const std::vector<OcrParagraph>& paragraphs)
 {
     pugi::xml_document doc;
@@ -288,14 +303,24 @@ void write_hocr(std::ostream& output, const std::vector<OcrParagraph>& paragraph
                            << " x_wconf " << word.confidence * 100;
                 e_word.append_attribute("title") = word_title.str().c_str();
 
-                for (const auto& ch_box : word.char_boxes) {
-                    // TODO: character strings are not saved
+                // If the characters don't correspond to the boxes one-to-one, then the whole
+                // content is stored in the first box so that it is still read back correctly.
+                auto chars = split_utf8_chars(word.content);
+                bool has_char_per_box = chars.size() == word.char_boxes.size();
+
+                for (std::size_t i = 0; i < word.char_boxes.size(); ++i) {
                     auto e_ch = e_word.append_child("span");
                     e_ch.append_attribute("class") = "ocrx_cinfo";
 
                     std::ostringstream ch_title;
-                    ch_title << "x_bboxes " << box_to_hocr(ch_box);
+                    ch_title << "x_bboxes " << box_to_hocr(word.char_boxes[i]);
                     e_ch.append_attribute("title") = ch_title.str().c_str();
+
+                    if (has_char_per_box) {
+                        e_ch.text() = chars[i].c_str();
+                    } else if (i == 0) {
+                        e_ch.text() = word.content.c_str();
+                    }
                 }
             }
         }
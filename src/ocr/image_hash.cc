@@ -0,0 +1,124 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "image_hash.h"
+#include "util/image.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace sanescan {
+
+namespace {
+
+// Brightness differences between grid cells that are smaller than this are considered noise.
+// Most of a page is uniform background, so this avoids hashes being dominated by noise.
+constexpr int MIN_HASH_BRIGHTNESS_DIFFERENCE = 2;
+
+// The size of the longer side of the images that are compared to verify near-duplicates
+constexpr int VERIFICATION_IMAGE_SIZE = 200;
+constexpr double MAX_ASPECT_RATIO_DIFFERENCE = 0.02;
+
+// The maximum mean absolute difference of pixel values of the compared images. Text occupies
+// only a small part of a page, so the threshold must be low to distinguish different pages that
+// have similar layout.
+constexpr double MAX_MEAN_PIXEL_DIFFERENCE = 3;
+
+// The maximum difference of any pixel value of images considered identical
+constexpr double MAX_IDENTICAL_PIXEL_DIFFERENCE = 8;
+
+} // namespace
+
+ImageHash compute_image_hash(const cv::Mat& image)
+{
+    constexpr auto size = ImageHash::GRID_SIZE;
+
+    cv::Mat small;
+    cv::resize(image_color_to_gray(image), small, cv::Size(size + 1, size + 1), 0, 0,
+               cv::INTER_AREA);
+
+    ImageHash hash;
+    auto set_bit = [&hash](int bit)
+    {
+        hash.bits[bit / 64] |= std::uint64_t{1} << (bit % 64);
+    };
+
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            auto value = small.at<std::uint8_t>(y, x) + MIN_HASH_BRIGHTNESS_DIFFERENCE;
+            if (value < small.at<std::uint8_t>(y, x + 1)) {
+                set_bit(y * size + x);
+            }
+            if (value < small.at<std::uint8_t>(y + 1, x)) {
+                set_bit(size * size + y * size + x);
+            }
+        }
+    }
+    return hash;
+}
+
+unsigned get_hash_distance(const ImageHash& a, const ImageHash& b)
+{
+    unsigned distance = 0;
+    for (std::size_t i = 0; i < a.bits.size(); ++i) {
+        distance += std::popcount(a.bits[i] ^ b.bits[i]);
+    }
+    return distance;
+}
+
+bool are_images_near_identical(const cv::Mat& a, const cv::Mat& b)
+{
+    double a_aspect = static_cast<double>(a.size.p[1]) / a.size.p[0];
+    double b_aspect = static_cast<double>(b.size.p[1]) / b.size.p[0];
+    if (std::abs(a_aspect / b_aspect - 1) > MAX_ASPECT_RATIO_DIFFERENCE) {
+        return false;
+    }
+
+    auto scale = static_cast<double>(VERIFICATION_IMAGE_SIZE) /
+            std::max(a.size.p[0], a.size.p[1]);
+    cv::Size size{std::max(1, static_cast<int>(a.size.p[1] * scale)),
+                  std::max(1, static_cast<int>(a.size.p[0] * scale))};
+
+    cv::Mat small_a, small_b;
+    cv::resize(image_color_to_gray(a), small_a, size, 0, 0, cv::INTER_AREA);
+    cv::resize(image_color_to_gray(b), small_b, size, 0, 0, cv::INTER_AREA);
+    cv::GaussianBlur(small_a, small_a, cv::Size(3, 3), 0);
+    cv::GaussianBlur(small_b, small_b, cv::Size(3, 3), 0);
+
+    cv::Mat diff;
+    cv::absdiff(small_a, small_b, diff);
+    return cv::mean(diff)[0] <= MAX_MEAN_PIXEL_DIFFERENCE;
+}
+
+bool are_images_identical(const cv::Mat& a, const cv::Mat& b)
+{
+    if (a.size != b.size || a.type() != b.type()) {
+        return false;
+    }
+
+    cv::Mat diff;
+    cv::absdiff(a, b, diff);
+    double max_difference = 0;
+    cv::minMaxLoc(diff.reshape(1), nullptr, &max_difference);
+    return max_difference <= MAX_IDENTICAL_PIXEL_DIFFERENCE;
+}
+
+} // namespace sanescan
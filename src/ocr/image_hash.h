@@ -0,0 +1,63 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_IMAGE_HASH_H
+#define SANESCAN_OCR_IMAGE_HASH_H
+
+#include <opencv2/core/mat.hpp>
+#include <array>
+#include <compare>
+#include <cstdint>
+
+namespace sanescan {
+
+/** Perceptual difference hash of an image. Each bit stores whether the brightness increases
+    between two horizontally or vertically adjacent cells of a grid placed over the image.
+    Similar images have hashes that differ in few bits. Both directions are used, because text
+    lines of a document page are mostly uniform in the horizontal direction.
+*/
+struct ImageHash {
+    static constexpr int GRID_SIZE = 16;
+    static constexpr int BIT_COUNT = GRID_SIZE * GRID_SIZE * 2;
+
+    std::array<std::uint64_t, BIT_COUNT / 64> bits = {};
+
+    auto operator<=>(const ImageHash&) const = default;
+};
+
+ImageHash compute_image_hash(const cv::Mat& image);
+
+/// Returns the number of bits that differ between the two hashes
+unsigned get_hash_distance(const ImageHash& a, const ImageHash& b);
+
+/** Verifies that two images whose hashes are similar are indeed near-identical. The images are
+    compared at low resolution, so that scanner noise and small shifts don't affect the result.
+    Images with different aspect ratios are never near-identical.
+*/
+bool are_images_near_identical(const cv::Mat& a, const cv::Mat& b);
+
+/** Returns whether the two images are identical at full resolution, up to a small difference of
+    each pixel. Unlike are_images_near_identical(), small changes such as an altered number or an
+    added signature are detected, thus one image may be substituted for the other.
+*/
+bool are_images_identical(const cv::Mat& a, const cv::Mat& b);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_IMAGE_HASH_H
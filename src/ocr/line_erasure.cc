@@ -99,7 +99,7 @@ void fixup_dilate_lines(cv::Mat& image, int extra_width)
 
 } // namespace
 
-void erase_straight_vh_lines(cv::Mat& image, const cv::Mat& image_gray,
+bool erase_straight_vh_lines(cv::Mat& image, const cv::Mat& image_gray,
                              int removed_artifact_radius, int extra_width, int line_length)
 {
     cv::Mat thresh_image;
@@ -122,6 +122,8 @@ void erase_straight_vh_lines(cv::Mat& image, const cv::Mat& image_gray,
     cv::morphologyEx(thresh_image, detected_lines_h, cv::MORPH_OPEN, kernel, cv::Point(-1, -1), 2);
     fixup_dilate_lines(detected_lines_h, extra_width);
     apply_horizontal(image, detected_lines_h);
+
+    return cv::countNonZero(detected_lines_v) > 0 || cv::countNonZero(detected_lines_h) > 0;
 }
 
 } // namespace sanescan
@@ -23,7 +23,8 @@
 
 namespace sanescan {
 
-void erase_straight_vh_lines(cv::Mat& image, const cv::Mat& image_gray,
+/// Returns whether any lines have been found. The image is not modified otherwise.
+bool erase_straight_vh_lines(cv::Mat& image, const cv::Mat& image_gray,
                              int removed_artifact_radius, int extra_width, int line_length);
 
 } // namespace sanescan
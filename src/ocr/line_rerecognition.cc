@@ -0,0 +1,124 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "line_rerecognition.h"
+#include "ocr_utils.h"
+#include <algorithm>
+
+namespace sanescan {
+
+namespace {
+
+// The number of characters of the recognized text of a line may change by at most this fraction
+// or MAX_ABSOLUTE_LENGTH_CHANGE characters, whichever is larger, for the new result to be used.
+constexpr double MAX_RELATIVE_LENGTH_CHANGE = 0.25;
+constexpr std::size_t MAX_ABSOLUTE_LENGTH_CHANGE = 2;
+
+std::size_t count_line_chars(const OcrLine& line)
+{
+    std::size_t result = 0;
+    for (const auto& word : line.words) {
+        result += count_utf8_chars(word.content);
+    }
+    return result;
+}
+
+} // namespace
+
+double get_line_score(const OcrLine& line)
+{
+    double confidence_sum = 0;
+    std::size_t char_count = 0;
+    for (const auto& word : line.words) {
+        auto word_char_count = count_utf8_chars(word.content);
+        confidence_sum += word.confidence * word_char_count;
+        char_count += word_char_count;
+    }
+    if (char_count == 0) {
+        return 0;
+    }
+    return confidence_sum / char_count;
+}
+
+bool is_line_length_change_acceptable(std::size_t old_char_count, std::size_t new_char_count)
+{
+    auto change = old_char_count > new_char_count ? old_char_count - new_char_count
+                                                  : new_char_count - old_char_count;
+    return change <= std::max<double>(MAX_ABSOLUTE_LENGTH_CHANGE,
+                                      old_char_count * MAX_RELATIVE_LENGTH_CHANGE);
+}
+
+std::vector<OcrLineLocation>
+    find_low_confidence_lines(const std::vector<OcrParagraph>& paragraphs,
+                              double max_word_confidence)
+{
+    std::vector<OcrLineLocation> result;
+    for (std::size_t ip = 0; ip < paragraphs.size(); ++ip) {
+        const auto& lines = paragraphs[ip].lines;
+        for (std::size_t il = 0; il < lines.size(); ++il) {
+            const auto& words = lines[il].words;
+            auto has_low_confidence = std::any_of(words.begin(), words.end(),
+                                                  [&](const OcrWord& word)
+            {
+                return word.confidence < max_word_confidence;
+            });
+            if (has_low_confidence) {
+                result.push_back(OcrLineLocation{ip, il});
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<OcrWord> get_words_within_line(const std::vector<OcrParagraph>& paragraphs,
+                                           const OcrBox& line_box)
+{
+    std::vector<OcrWord> result;
+    for (const auto& paragraph : paragraphs) {
+        for (const auto& line : paragraph.lines) {
+            for (const auto& word : line.words) {
+                auto center_y2 = word.box.y1 + word.box.y2;
+                if (center_y2 >= line_box.y1 * 2 && center_y2 < line_box.y2 * 2) {
+                    result.push_back(word);
+                }
+            }
+        }
+    }
+    std::stable_sort(result.begin(), result.end(), [](const OcrWord& a, const OcrWord& b)
+    {
+        return a.box.x1 < b.box.x1;
+    });
+    return result;
+}
+
+bool replace_line_words_if_better(OcrLine& line, std::vector<OcrWord> words)
+{
+    OcrLine candidate;
+    candidate.words = std::move(words);
+    if (!is_line_length_change_acceptable(count_line_chars(line), count_line_chars(candidate))) {
+        return false;
+    }
+    if (get_line_score(candidate) <= get_line_score(line)) {
+        return false;
+    }
+    line.words = std::move(candidate.words);
+    return true;
+}
+
+} // namespace sanescan
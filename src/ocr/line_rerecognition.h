@@ -0,0 +1,67 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_LINE_RERECOGNITION_H
+#define SANESCAN_OCR_LINE_RERECOGNITION_H
+
+#include "ocr_paragraph.h"
+#include <cstddef>
+#include <vector>
+
+namespace sanescan {
+
+struct OcrLineLocation {
+    std::size_t paragraph = 0;
+    std::size_t line = 0;
+
+    auto operator<=>(const OcrLineLocation&) const = default;
+};
+
+/*  Returns the score of the recognition of a line that is used to pick the better of two
+    recognition results of the same line. The score is the mean confidence per character, so
+    that text picked up from neighbouring lines or noise does not raise the score by itself.
+*/
+double get_line_score(const OcrLine& line);
+
+/*  Returns true if the number of recognized characters of a line changes little enough that
+    both recognition results are likely to contain the same text.
+*/
+bool is_line_length_change_acceptable(std::size_t old_char_count, std::size_t new_char_count);
+
+/// Returns the locations of lines that contain at least one word below the given confidence
+std::vector<OcrLineLocation>
+    find_low_confidence_lines(const std::vector<OcrParagraph>& paragraphs,
+                              double max_word_confidence);
+
+/*  Returns the words from the results of recognition of a crop of the given line. The crop
+    usually includes parts of the neighbouring lines, so only the words whose vertical center is
+    within the line box are returned. The words are sorted by their horizontal position.
+*/
+std::vector<OcrWord> get_words_within_line(const std::vector<OcrParagraph>& paragraphs,
+                                           const OcrBox& line_box);
+
+/** Replaces the words of the line with the given words if they score higher according to
+    get_line_score() and the length of the text does not change too much according to
+    is_line_length_change_acceptable(). Returns true if the line was changed.
+*/
+bool replace_line_words_if_better(OcrLine& line, std::vector<OcrWord> words);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_LINE_RERECOGNITION_H
@@ -0,0 +1,182 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr_batch_context.h"
+#include "util/math.h"
+#include "util/telemetry.h"
+#include <algorithm>
+#include <cmath>
+
+namespace sanescan {
+
+namespace {
+
+// The weight of the newest page in the running averages
+constexpr double RUNNING_AVERAGE_WEIGHT = 0.2;
+
+// The maximum relative difference of the text height of a page from the running average for the
+// page to agree with the estimate
+constexpr double MAX_TEXT_HEIGHT_DIFFERENCE = 0.2;
+
+double update_running_average(double average, double value)
+{
+    if (average == 0) {
+        return value;
+    }
+    return average + (value - average) * RUNNING_AVERAGE_WEIGHT;
+}
+
+} // namespace
+
+template<class T>
+void OcrBatchContext::Estimate<T>::update(const std::optional<T>& observed)
+{
+    if (!observed.has_value()) {
+        return;
+    }
+    if (value == observed) {
+        agreeing_pages++;
+    } else {
+        value = observed;
+        agreeing_pages = 1;
+    }
+}
+
+OcrBatchContext::OcrBatchContext(std::size_t min_agreeing_pages, std::size_t verify_interval,
+                                 double max_confidence_drop) :
+    min_agreeing_pages_{min_agreeing_pages},
+    verify_interval_{verify_interval},
+    max_confidence_drop_{max_confidence_drop}
+{
+}
+
+OcrBatchPriors OcrBatchContext::priors_for_next_page()
+{
+    std::lock_guard lock{mutex_};
+    page_count_++;
+
+    OcrBatchPriors priors;
+    if (verify_interval_ != 0 && page_count_ % verify_interval_ == 0) {
+        return priors;
+    }
+
+    if (languages_.agreeing_pages >= min_agreeing_pages_) {
+        priors.languages = languages_.value;
+    }
+    if (orientation_.agreeing_pages >= min_agreeing_pages_) {
+        priors.orientation = orientation_.value;
+    }
+    if (has_ruled_lines_.agreeing_pages >= min_agreeing_pages_) {
+        priors.has_ruled_lines = has_ruled_lines_.value;
+    }
+    if (text_height_agreeing_pages_ >= min_agreeing_pages_) {
+        priors.text_height = text_height_;
+    }
+    return priors;
+}
+
+void OcrBatchContext::add_page(const OcrPageObservation& observation)
+{
+    static auto& resets_counter = TelemetryRegistry::instance().counter("ocr.batch_context.resets");
+
+    std::lock_guard lock{mutex_};
+    if (observation.used_priors && mean_word_confidence_.has_value() &&
+            observation.mean_word_confidence < *mean_word_confidence_ - max_confidence_drop_) {
+        // The priors are likely wrong for the current pages, so they are detected from scratch.
+        // The confidence of the page is not used, as it was likely reduced by the wrong priors.
+        resets_counter.add();
+        reset_estimates();
+        return;
+    }
+
+    languages_.update(observation.languages);
+    orientation_.update(observation.orientation);
+    has_ruled_lines_.update(observation.has_ruled_lines);
+    if (observation.text_height > 0) {
+        if (text_height_ != 0 && std::abs(observation.text_height / text_height_ - 1) <=
+                MAX_TEXT_HEIGHT_DIFFERENCE) {
+            text_height_ = update_running_average(text_height_, observation.text_height);
+            text_height_agreeing_pages_++;
+        } else {
+            text_height_ = observation.text_height;
+            text_height_agreeing_pages_ = 1;
+        }
+    }
+    mean_word_confidence_ = update_running_average(mean_word_confidence_.value_or(0),
+                                                   observation.mean_word_confidence);
+}
+
+void OcrBatchContext::reset()
+{
+    std::lock_guard lock{mutex_};
+    page_count_ = 0;
+    reset_estimates();
+}
+
+void OcrBatchContext::reset_estimates()
+{
+    languages_ = {};
+    orientation_ = {};
+    has_ruled_lines_ = {};
+    text_height_ = 0;
+    text_height_agreeing_pages_ = 0;
+    mean_word_confidence_.reset();
+}
+
+double get_median_word_height(const std::vector<OcrParagraph>& paragraphs)
+{
+    std::vector<double> heights;
+    for (const auto& paragraph : paragraphs) {
+        for (const auto& line : paragraph.lines) {
+            for (const auto& word : line.words) {
+                heights.push_back(word.box.height());
+            }
+        }
+    }
+    if (heights.empty()) {
+        return 0;
+    }
+    auto middle = heights.begin() + heights.size() / 2;
+    std::nth_element(heights.begin(), middle, heights.end());
+    return *middle;
+}
+
+double get_mean_word_confidence(const std::vector<OcrParagraph>& paragraphs)
+{
+    double sum = 0;
+    std::size_t count = 0;
+    for (const auto& paragraph : paragraphs) {
+        for (const auto& line : paragraph.lines) {
+            for (const auto& word : line.words) {
+                sum += word.confidence;
+                count++;
+            }
+        }
+    }
+    return count == 0 ? 0 : sum / count;
+}
+
+double get_orientation_of_angle(double angle)
+{
+    auto quarter_turns = static_cast<long>(std::round(angle / deg_to_rad(90)));
+    quarter_turns = ((quarter_turns % 4) + 4) % 4;
+    return quarter_turns * deg_to_rad(90);
+}
+
+} // namespace sanescan
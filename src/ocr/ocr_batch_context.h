@@ -0,0 +1,120 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_OCR_BATCH_CONTEXT_H
+#define SANESCAN_OCR_OCR_BATCH_CONTEXT_H
+
+#include "ocr_paragraph.h"
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sanescan {
+
+/// Properties of the next page that are likely according to the previous pages of a batch
+struct OcrBatchPriors {
+    std::optional<std::vector<std::string>> languages;
+
+    // Page orientation as a multiple of 90 degrees in radians within [0, 2*pi)
+    std::optional<double> orientation;
+
+    std::optional<bool> has_ruled_lines;
+
+    // The typical height of words in pixels, 0 if not known
+    double text_height = 0;
+
+    bool operator==(const OcrBatchPriors&) const = default;
+};
+
+/// Properties of a page determined during recognition. Unset values have not been determined.
+struct OcrPageObservation {
+    std::optional<std::vector<std::string>> languages;
+    std::optional<double> orientation;
+    std::optional<bool> has_ruled_lines;
+    double text_height = 0;
+    double mean_word_confidence = 0;
+
+    // Whether any of the priors have been used to skip detection steps
+    bool used_priors = false;
+};
+
+/*  Carries estimates of page properties across the pages of a batch, e.g. scanned from a single
+    document feeder. A property becomes a prior only after enough consecutive pages agree on it.
+    Periodically a page is recognized without priors to verify them, and all priors are dropped
+    when the word confidence of a page recognized with priors falls notably below the running
+    average. The class is thread-safe as pages of a batch are usually recognized concurrently.
+*/
+class OcrBatchContext {
+public:
+    static constexpr std::size_t DEFAULT_MIN_AGREEING_PAGES = 3;
+    static constexpr std::size_t DEFAULT_VERIFY_INTERVAL = 10;
+    static constexpr double DEFAULT_MAX_CONFIDENCE_DROP = 0.1;
+
+    OcrBatchContext(std::size_t min_agreeing_pages = DEFAULT_MIN_AGREEING_PAGES,
+                    std::size_t verify_interval = DEFAULT_VERIFY_INTERVAL,
+                    double max_confidence_drop = DEFAULT_MAX_CONFIDENCE_DROP);
+
+    /// Returns the priors for the next page. Each call is assumed to start a new page.
+    OcrBatchPriors priors_for_next_page();
+
+    void add_page(const OcrPageObservation& observation);
+
+    /// Drops all estimates
+    void reset();
+
+private:
+    template<class T>
+    struct Estimate {
+        std::optional<T> value;
+        std::size_t agreeing_pages = 0;
+
+        void update(const std::optional<T>& observed);
+    };
+
+    void reset_estimates();
+
+    mutable std::mutex mutex_;
+    std::size_t min_agreeing_pages_ = 0;
+    std::size_t verify_interval_ = 0;
+    double max_confidence_drop_ = 0;
+
+    std::size_t page_count_ = 0;
+    Estimate<std::vector<std::string>> languages_;
+    Estimate<double> orientation_;
+    Estimate<bool> has_ruled_lines_;
+    // Text height varies slightly across pages, so it is agreed on within a tolerance
+    double text_height_ = 0;
+    std::size_t text_height_agreeing_pages_ = 0;
+    std::optional<double> mean_word_confidence_;
+};
+
+/// Returns the median height of the words in the paragraphs, or 0 if there are no words
+double get_median_word_height(const std::vector<OcrParagraph>& paragraphs);
+
+/// Returns the mean confidence of the words in the paragraphs, or 0 if there are no words
+double get_mean_word_confidence(const std::vector<OcrParagraph>& paragraphs);
+
+/// Returns the multiple of 90 degrees nearest to the angle, within [0, 2*pi)
+double get_orientation_of_angle(double angle);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_OCR_BATCH_CONTEXT_H
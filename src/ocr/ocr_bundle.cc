@@ -0,0 +1,378 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr_bundle.h"
+#include "blur_detection.h"
+#include "hocr.h"
+#include "util/image.h"
+#include <opencv2/imgcodecs.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <type_traits>
+
+namespace sanescan {
+
+namespace {
+
+constexpr const char* BUNDLE_MAGIC = "sanescan-ocr-bundle";
+constexpr int BUNDLE_FORMAT_VERSION = 1;
+
+constexpr const char* MANIFEST_FILENAME = "manifest.txt";
+constexpr const char* SOURCE_IMAGE_FILENAME = "source.png";
+constexpr const char* OLD_IMAGE_FILENAME = "old_adjusted_image.png";
+constexpr const char* OLD_PARAGRAPHS_FILENAME = "old_paragraphs.hocr";
+constexpr const char* REFERENCE_IMAGE_FILENAME = "reference_adjusted_image.png";
+constexpr const char* REFERENCE_PARAGRAPHS_FILENAME = "reference_paragraphs.hocr";
+
+constexpr double DEFAULT_CAPTURE_MIN_DURATION_SEC = 10;
+
+// Calls f(name, field) for each field of OcrOptions
+template<class Options, class F>
+void visit_ocr_options(Options& options, F&& f)
+{
+    f("profile", options.profile);
+    f("languages", options.languages);
+    f("detect_languages", options.detect_languages);
+    f("fix_text_rotation", options.fix_text_rotation);
+    f("fix_text_rotation_min_text_fraction", options.fix_text_rotation_min_text_fraction);
+    f("fix_text_rotation_max_angle_diff", options.fix_text_rotation_max_angle_diff);
+    f("keep_image_size_after_rotation", options.keep_image_size_after_rotation);
+    f("fix_page_orientation", options.fix_page_orientation);
+    f("fix_page_orientation_min_text_fraction", options.fix_page_orientation_min_text_fraction);
+    f("fix_page_orientation_max_angle_diff", options.fix_page_orientation_max_angle_diff);
+    f("min_word_confidence", options.min_word_confidence);
+    f("blur_detection_coef", options.blur_detection_coef);
+    f("regions", options.regions);
+    f("rerecognize_low_confidence_lines", options.rerecognize_low_confidence_lines);
+    f("rerecognize_max_word_confidence", options.rerecognize_max_word_confidence);
+    f("rerecognize_scale", options.rerecognize_scale);
+    f("geometric_edits", options.geometric_edits);
+}
+
+void write_ocr_options(std::ostream& stream, const std::string& prefix, const OcrOptions& options)
+{
+    visit_ocr_options(options, [&](const char* name, const auto& value)
+    {
+        using T = std::decay_t<decltype(value)>;
+        stream << prefix << name;
+        if constexpr (std::is_same_v<T, std::vector<OcrBox>>) {
+            for (const auto& box : value) {
+                stream << " " << box.x1 << " " << box.y1 << " " << box.x2 << " " << box.y2;
+            }
+        } else if constexpr (std::is_same_v<T, std::vector<std::string>>) {
+            for (const auto& str : value) {
+                stream << " " << str;
+            }
+        } else if constexpr (std::is_same_v<T, std::vector<OcrGeometricEdit>>) {
+            for (const auto& edit : value) {
+                stream << " " << edit;
+            }
+        } else {
+            stream << " " << value;
+        }
+        stream << "\n";
+    });
+}
+
+using Manifest = std::map<std::string, std::string>;
+
+const std::string& get_manifest_value(const Manifest& manifest, const std::string& key)
+{
+    auto it = manifest.find(key);
+    if (it == manifest.end()) {
+        throw OcrBundleException("Bundle manifest does not contain " + key);
+    }
+    return it->second;
+}
+
+template<class T>
+T parse_manifest_value(const Manifest& manifest, const std::string& key)
+{
+    std::istringstream stream(get_manifest_value(manifest, key));
+    stream.imbue(std::locale::classic());
+    T value{};
+    if (!(stream >> value)) {
+        throw OcrBundleException("Could not parse bundle manifest value of " + key);
+    }
+    return value;
+}
+
+OcrOptions read_ocr_options(const Manifest& manifest, const std::string& prefix)
+{
+    OcrOptions options;
+    visit_ocr_options(options, [&](const char* name, auto& value)
+    {
+        using T = std::decay_t<decltype(value)>;
+        auto key = prefix + name;
+        if (!manifest.contains(key)) {
+            // The bundle has been written by an older version, keep the default value
+            return;
+        }
+        if constexpr (std::is_same_v<T, std::vector<OcrBox>>) {
+            std::istringstream stream(get_manifest_value(manifest, key));
+            OcrBox box;
+            value.clear();
+            while (stream >> box.x1 >> box.y1 >> box.x2 >> box.y2) {
+                value.push_back(box);
+            }
+        } else if constexpr (std::is_same_v<T, std::vector<std::string>>) {
+            std::istringstream stream(get_manifest_value(manifest, key));
+            std::string str;
+            value.clear();
+            while (stream >> str) {
+                value.push_back(str);
+            }
+        } else if constexpr (std::is_same_v<T, std::vector<OcrGeometricEdit>>) {
+            std::istringstream stream(get_manifest_value(manifest, key));
+            OcrGeometricEdit edit;
+            value.clear();
+            while (stream >> edit) {
+                value.push_back(edit);
+            }
+        } else {
+            value = parse_manifest_value<T>(manifest, key);
+        }
+    });
+    return options;
+}
+
+cv::Mat read_image(const std::filesystem::path& path)
+{
+    auto image = cv::imread(path.string(), cv::IMREAD_UNCHANGED);
+    if (image.data == nullptr) {
+        throw OcrBundleException("Could not read bundle image " + path.string());
+    }
+    return image;
+}
+
+void write_image(const std::filesystem::path& path, const cv::Mat& image)
+{
+    if (!cv::imwrite(path.string(), image)) {
+        throw OcrBundleException("Could not write bundle image " + path.string());
+    }
+}
+
+void write_results(std::ostream& stream, const std::filesystem::path& path,
+                   const std::string& prefix, const std::string& image_filename,
+                   const std::string& paragraphs_filename, const std::optional<OcrResults>& results)
+{
+    stream << "has_" << prefix << " " << results.has_value() << "\n";
+    if (!results.has_value()) {
+        return;
+    }
+    stream << prefix << ".adjust_angle " << results->adjust_angle << "\n";
+    write_image(path / image_filename, results->adjusted_image);
+
+    std::ofstream hocr_stream(path / paragraphs_filename);
+    write_hocr(hocr_stream, results->paragraphs);
+}
+
+std::optional<OcrResults> read_results(const Manifest& manifest, const std::filesystem::path& path,
+                                       const std::string& prefix,
+                                       const std::string& image_filename,
+                                       const std::string& paragraphs_filename)
+{
+    auto key = "has_" + prefix;
+    // Bundles written by older versions may not contain the key
+    if (!manifest.contains(key) || !parse_manifest_value<bool>(manifest, key)) {
+        return {};
+    }
+
+    OcrResults results;
+    results.adjust_angle = parse_manifest_value<double>(manifest, prefix + ".adjust_angle");
+    results.adjusted_image = read_image(path / image_filename);
+    results.adjusted_image_gray = image_color_to_gray(results.adjusted_image);
+    results.blur_data = compute_blur_data(results.adjusted_image_gray);
+
+    std::ifstream hocr_stream(path / paragraphs_filename);
+    if (!hocr_stream) {
+        throw OcrBundleException("Could not open bundle " + prefix + " in " + path.string());
+    }
+    results.paragraphs = read_hocr(hocr_stream);
+    return results;
+}
+
+void write_priors(std::ostream& stream, const std::optional<OcrBatchPriors>& priors)
+{
+    stream << "has_priors " << priors.has_value() << "\n";
+    if (!priors.has_value()) {
+        return;
+    }
+    if (priors->languages.has_value()) {
+        stream << "priors.languages";
+        for (const auto& language : priors->languages.value()) {
+            stream << " " << language;
+        }
+        stream << "\n";
+    }
+    if (priors->orientation.has_value()) {
+        stream << "priors.orientation " << priors->orientation.value() << "\n";
+    }
+    if (priors->has_ruled_lines.has_value()) {
+        stream << "priors.has_ruled_lines " << priors->has_ruled_lines.value() << "\n";
+    }
+    stream << "priors.text_height " << priors->text_height << "\n";
+}
+
+std::optional<OcrBatchPriors> read_priors(const Manifest& manifest)
+{
+    if (!manifest.contains("has_priors") || !parse_manifest_value<bool>(manifest, "has_priors")) {
+        return {};
+    }
+
+    OcrBatchPriors priors;
+    if (manifest.contains("priors.languages")) {
+        std::istringstream stream(get_manifest_value(manifest, "priors.languages"));
+        std::string language;
+        priors.languages.emplace();
+        while (stream >> language) {
+            priors.languages->push_back(language);
+        }
+    }
+    if (manifest.contains("priors.orientation")) {
+        priors.orientation = parse_manifest_value<double>(manifest, "priors.orientation");
+    }
+    if (manifest.contains("priors.has_ruled_lines")) {
+        priors.has_ruled_lines = parse_manifest_value<bool>(manifest, "priors.has_ruled_lines");
+    }
+    priors.text_height = parse_manifest_value<double>(manifest, "priors.text_height");
+    return priors;
+}
+
+} // namespace
+
+std::optional<OcrCaptureOptions> ocr_capture_options_from_env()
+{
+    const char* dir = std::getenv(OCR_CAPTURE_DIR_ENV_VARIABLE);
+    if (dir == nullptr || *dir == '\0') {
+        return {};
+    }
+
+    OcrCaptureOptions options;
+    options.output_dir = dir;
+    options.min_duration_sec = DEFAULT_CAPTURE_MIN_DURATION_SEC;
+
+    const char* min_duration = std::getenv(OCR_CAPTURE_MIN_DURATION_ENV_VARIABLE);
+    if (min_duration != nullptr && *min_duration != '\0') {
+        options.min_duration_sec = std::strtod(min_duration, nullptr);
+    }
+    return options;
+}
+
+void write_ocr_bundle(const std::filesystem::path& path, const OcrBundle& bundle)
+{
+    std::filesystem::create_directories(path);
+
+    std::ofstream stream(path / MANIFEST_FILENAME);
+    if (!stream) {
+        throw OcrBundleException("Could not write bundle manifest to " + path.string());
+    }
+    stream.imbue(std::locale::classic());
+    stream.precision(17);
+
+    stream << BUNDLE_MAGIC << " " << BUNDLE_FORMAT_VERSION << "\n"
+           << "sanescan_version " << bundle.sanescan_version << "\n"
+           << "tesseract_version " << bundle.tesseract_version << "\n"
+           << "duration " << bundle.duration_sec << "\n"
+           << "stage_count " << bundle.stage_timings.size() << "\n";
+    for (std::size_t i = 0; i < bundle.stage_timings.size(); ++i) {
+        const auto& timing = bundle.stage_timings[i];
+        stream << "stage." << i << " " << timing.name << " " << timing.duration_sec << "\n";
+    }
+    write_ocr_options(stream, "options.", bundle.options);
+    write_ocr_options(stream, "old_options.", bundle.old_options);
+
+    write_image(path / SOURCE_IMAGE_FILENAME, bundle.source_image);
+
+    write_results(stream, path, "old_results", OLD_IMAGE_FILENAME, OLD_PARAGRAPHS_FILENAME,
+                  bundle.old_results);
+    write_results(stream, path, "reference", REFERENCE_IMAGE_FILENAME,
+                  REFERENCE_PARAGRAPHS_FILENAME, bundle.reference);
+    write_priors(stream, bundle.priors);
+}
+
+OcrBundle read_ocr_bundle(const std::filesystem::path& path)
+{
+    std::ifstream stream(path / MANIFEST_FILENAME);
+    if (!stream) {
+        throw OcrBundleException("Could not open bundle manifest in " + path.string());
+    }
+
+    std::string magic;
+    int version = 0;
+    stream >> magic >> version;
+    if (magic != BUNDLE_MAGIC || version != BUNDLE_FORMAT_VERSION) {
+        throw OcrBundleException("Unsupported bundle format in " + path.string());
+    }
+
+    Manifest manifest;
+    std::string line;
+    while (std::getline(stream, line)) {
+        auto space_pos = line.find(' ');
+        if (space_pos == std::string::npos) {
+            if (!line.empty()) {
+                manifest[line] = "";
+            }
+            continue;
+        }
+        manifest[line.substr(0, space_pos)] = line.substr(space_pos + 1);
+    }
+
+    OcrBundle bundle;
+    bundle.sanescan_version = get_manifest_value(manifest, "sanescan_version");
+    bundle.tesseract_version = get_manifest_value(manifest, "tesseract_version");
+    bundle.duration_sec = parse_manifest_value<double>(manifest, "duration");
+
+    auto stage_count = parse_manifest_value<std::size_t>(manifest, "stage_count");
+    for (std::size_t i = 0; i < stage_count; ++i) {
+        std::istringstream stage_stream(get_manifest_value(manifest,
+                                                           "stage." + std::to_string(i)));
+        stage_stream.imbue(std::locale::classic());
+        OcrStageTiming timing;
+        if (!(stage_stream >> timing.name >> timing.duration_sec)) {
+            throw OcrBundleException("Could not parse bundle stage timing");
+        }
+        bundle.stage_timings.push_back(timing);
+    }
+
+    bundle.options = read_ocr_options(manifest, "options.");
+    bundle.old_options = read_ocr_options(manifest, "old_options.");
+    bundle.source_image = read_image(path / SOURCE_IMAGE_FILENAME);
+
+    bundle.old_results = read_results(manifest, path, "old_results", OLD_IMAGE_FILENAME,
+                                      OLD_PARAGRAPHS_FILENAME);
+    bundle.reference = read_results(manifest, path, "reference", REFERENCE_IMAGE_FILENAME,
+                                    REFERENCE_PARAGRAPHS_FILENAME);
+    bundle.priors = read_priors(manifest);
+    return bundle;
+}
+
+void setup_ocr_bundle_run(OcrPipelineRun& run, const OcrBundle& bundle)
+{
+    if (bundle.reference.has_value()) {
+        run.set_reference(bundle.reference.value());
+    }
+    if (bundle.priors.has_value()) {
+        run.set_priors(bundle.priors.value());
+    }
+}
+
+} // namespace sanescan
@@ -0,0 +1,100 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_OCR_BUNDLE_H
+#define SANESCAN_OCR_OCR_BUNDLE_H
+
+#include "ocr_options.h"
+#include "ocr_pipeline_run.h"
+#include "ocr_results.h"
+#include <opencv2/core/mat.hpp>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace sanescan {
+
+class OcrBundleException : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/** A self-contained record of a single OCR pipeline run: everything that is needed to repeat it
+    via OcrPipelineRun, plus information about the environment and the timings of the original
+    run.
+
+    A bundle is stored as a directory containing a manifest.txt text file, the source image and,
+    if present, the prior and reference results.
+*/
+struct OcrBundle {
+    cv::Mat source_image;
+    OcrOptions options;
+    OcrOptions old_options;
+
+    /** Only adjusted_image, adjust_angle and paragraphs are stored. The remaining data is
+        recomputed when reading the bundle.
+    */
+    std::optional<OcrResults> old_results;
+
+    /** The results of a previous scan of the same page that were given to the run as reference,
+        see OcrPipelineRun::set_reference(). Stored the same way as old_results.
+    */
+    std::optional<OcrResults> reference;
+
+    /// The priors of the batch of pages that were in effect during the run, if any
+    std::optional<OcrBatchPriors> priors;
+
+    std::string sanescan_version;
+    std::string tesseract_version;
+    double duration_sec = 0;
+    std::vector<OcrStageTiming> stage_timings;
+};
+
+/// Settings of capturing of slow OCR runs
+struct OcrCaptureOptions {
+    std::filesystem::path output_dir;
+    // Only runs that take at least this long are captured
+    double min_duration_sec = 0;
+};
+
+/// Environment variable enabling capture. Its value is the directory to store the bundles to.
+inline constexpr const char* OCR_CAPTURE_DIR_ENV_VARIABLE = "SANESCAN_OCR_CAPTURE_DIR";
+
+/// Environment variable overriding the minimum duration in seconds of captured runs
+inline constexpr const char* OCR_CAPTURE_MIN_DURATION_ENV_VARIABLE =
+        "SANESCAN_OCR_CAPTURE_MIN_DURATION";
+
+/// Returns capture options as configured by environment variables, if capture is enabled.
+std::optional<OcrCaptureOptions> ocr_capture_options_from_env();
+
+/// Writes the bundle to the given directory, which is created if it does not exist.
+void write_ocr_bundle(const std::filesystem::path& path, const OcrBundle& bundle);
+
+OcrBundle read_ocr_bundle(const std::filesystem::path& path);
+
+/** Sets the reference results and the priors of the bundle to the run, so that it takes the
+    same path through the pipeline as the captured run.
+*/
+void setup_ocr_bundle_run(OcrPipelineRun& run, const OcrBundle& bundle);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_OCR_BUNDLE_H
@@ -0,0 +1,337 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr_geometry.h"
+#include "ocr_results.h"
+#include "util/math.h"
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <tuple>
+
+namespace sanescan {
+
+namespace {
+
+constexpr OcrGeometricEditType ALL_EDIT_TYPES[] = {
+    OcrGeometricEditType::ROTATE_90_CW,
+    OcrGeometricEditType::ROTATE_90_CCW,
+    OcrGeometricEditType::ROTATE_180,
+    OcrGeometricEditType::FLIP_HORIZONTAL,
+    OcrGeometricEditType::FLIP_VERTICAL,
+    OcrGeometricEditType::CROP,
+};
+
+struct PointD {
+    double x = 0;
+    double y = 0;
+};
+
+OcrBox clip_crop_to_image(const OcrBox& crop, int width, int height)
+{
+    return OcrBox{std::clamp(crop.x1, 0, width), std::clamp(crop.y1, 0, height),
+                  std::clamp(crop.x2, 0, width), std::clamp(crop.y2, 0, height)};
+}
+
+// Maps a point within an image of the given size. Box corners are mapped the same way, so the
+// exclusive bottom-right corner of a box works as expected.
+PointD map_point(const PointD& p, const OcrGeometricEdit& edit, int width, int height)
+{
+    switch (edit.type) {
+        case OcrGeometricEditType::ROTATE_90_CW: return {height - p.y, p.x};
+        case OcrGeometricEditType::ROTATE_90_CCW: return {p.y, width - p.x};
+        case OcrGeometricEditType::ROTATE_180: return {width - p.x, height - p.y};
+        case OcrGeometricEditType::FLIP_HORIZONTAL: return {width - p.x, p.y};
+        case OcrGeometricEditType::FLIP_VERTICAL: return {p.x, height - p.y};
+        case OcrGeometricEditType::CROP: {
+            auto crop = clip_crop_to_image(edit.crop, width, height);
+            return {p.x - crop.x1, p.y - crop.y1};
+        }
+        default:
+            throw std::invalid_argument("Unknown geometric edit type");
+    }
+}
+
+// Maps a direction vector. The translation part of the edit does not affect directions.
+PointD map_direction(const PointD& d, const OcrGeometricEdit& edit)
+{
+    switch (edit.type) {
+        case OcrGeometricEditType::ROTATE_90_CW: return {-d.y, d.x};
+        case OcrGeometricEditType::ROTATE_90_CCW: return {d.y, -d.x};
+        case OcrGeometricEditType::ROTATE_180: return {-d.x, -d.y};
+        case OcrGeometricEditType::FLIP_HORIZONTAL: return {-d.x, d.y};
+        case OcrGeometricEditType::FLIP_VERTICAL: return {d.x, -d.y};
+        case OcrGeometricEditType::CROP: return d;
+        default:
+            throw std::invalid_argument("Unknown geometric edit type");
+    }
+}
+
+std::pair<int, int> get_edited_size(const OcrGeometricEdit& edit, int width, int height)
+{
+    switch (edit.type) {
+        case OcrGeometricEditType::ROTATE_90_CW:
+        case OcrGeometricEditType::ROTATE_90_CCW:
+            return {height, width};
+        case OcrGeometricEditType::CROP: {
+            auto crop = clip_crop_to_image(edit.crop, width, height);
+            return {std::max(crop.width(), 0), std::max(crop.height(), 0)};
+        }
+        default:
+            return {width, height};
+    }
+}
+
+// The origin of the baseline is relative to the bottom left corner of the box, which may end up
+// in a different corner of the box after the edit.
+OcrBaseline map_baseline(const OcrBaseline& baseline, const OcrBox& box, const OcrBox& new_box,
+                         const OcrGeometricEdit& edit, int width, int height)
+{
+    auto origin = map_point(PointD{box.x1 + baseline.x, box.y2 + baseline.y}, edit, width, height);
+    auto direction = map_direction(PointD{std::cos(baseline.angle), std::sin(baseline.angle)},
+                                   edit);
+    return OcrBaseline{origin.x - new_box.x1, origin.y - new_box.y2,
+                       std::atan2(direction.y, direction.x)};
+}
+
+bool box_intersects(const OcrBox& box, const OcrBox& area)
+{
+    return box.x1 < area.x2 && area.x1 < box.x2 && box.y1 < area.y2 && area.y1 < box.y2;
+}
+
+void apply_edit_to_word(OcrWord& word, const OcrGeometricEdit& edit, int width, int height)
+{
+    auto word_box = apply_geometric_edit(word.box, edit, width, height);
+    word.baseline = map_baseline(word.baseline, word.box, word_box, edit, width, height);
+    word.box = word_box;
+    for (auto& char_box : word.char_boxes) {
+        char_box = apply_geometric_edit(char_box, edit, width, height);
+    }
+}
+
+void apply_edit_to_line(OcrLine& line, const OcrGeometricEdit& edit, int width, int height)
+{
+    auto line_box = apply_geometric_edit(line.box, edit, width, height);
+    line.baseline = map_baseline(line.baseline, line.box, line_box, edit, width, height);
+    line.box = line_box;
+    for (auto& word : line.words) {
+        apply_edit_to_word(word, edit, width, height);
+    }
+}
+
+// Returns the edit that rotates the given number of clockwise quarter turns back. Applied to an
+// image of zero size the edit rotates around the origin.
+OcrGeometricEdit get_leveling_edit(int quarter_turns)
+{
+    OcrGeometricEdit edit;
+    switch (quarter_turns) {
+        case 1: edit.type = OcrGeometricEditType::ROTATE_90_CCW; break;
+        case 2: edit.type = OcrGeometricEditType::ROTATE_180; break;
+        case 3: edit.type = OcrGeometricEditType::ROTATE_90_CW; break;
+        default:
+            throw std::invalid_argument("Quarter turn count must be within [1, 3]");
+    }
+    return edit;
+}
+
+} // namespace
+
+const char* ocr_geometric_edit_type_to_string(OcrGeometricEditType type)
+{
+    switch (type) {
+        case OcrGeometricEditType::ROTATE_90_CW: return "rotate_90_cw";
+        case OcrGeometricEditType::ROTATE_90_CCW: return "rotate_90_ccw";
+        case OcrGeometricEditType::ROTATE_180: return "rotate_180";
+        case OcrGeometricEditType::FLIP_HORIZONTAL: return "flip_horizontal";
+        case OcrGeometricEditType::FLIP_VERTICAL: return "flip_vertical";
+        case OcrGeometricEditType::CROP: return "crop";
+        default: throw std::invalid_argument("Unknown geometric edit type");
+    }
+}
+
+std::optional<OcrGeometricEditType> parse_ocr_geometric_edit_type(const std::string& str)
+{
+    for (auto type : ALL_EDIT_TYPES) {
+        if (str == ocr_geometric_edit_type_to_string(type)) {
+            return type;
+        }
+    }
+    return {};
+}
+
+std::ostream& operator<<(std::ostream& stream, const OcrGeometricEdit& edit)
+{
+    return stream << ocr_geometric_edit_type_to_string(edit.type) << " "
+                  << edit.crop.x1 << " " << edit.crop.y1 << " "
+                  << edit.crop.x2 << " " << edit.crop.y2;
+}
+
+std::istream& operator>>(std::istream& stream, OcrGeometricEdit& edit)
+{
+    std::string str;
+    OcrBox crop;
+    if (!(stream >> str >> crop.x1 >> crop.y1 >> crop.x2 >> crop.y2)) {
+        return stream;
+    }
+    auto type = parse_ocr_geometric_edit_type(str);
+    if (!type.has_value()) {
+        stream.setstate(std::ios_base::failbit);
+        return stream;
+    }
+    edit.type = type.value();
+    edit.crop = crop;
+    return stream;
+}
+
+cv::Mat apply_geometric_edit(const cv::Mat& image, const OcrGeometricEdit& edit)
+{
+    cv::Mat result;
+    switch (edit.type) {
+        case OcrGeometricEditType::ROTATE_90_CW:
+            cv::rotate(image, result, cv::ROTATE_90_CLOCKWISE);
+            break;
+        case OcrGeometricEditType::ROTATE_90_CCW:
+            cv::rotate(image, result, cv::ROTATE_90_COUNTERCLOCKWISE);
+            break;
+        case OcrGeometricEditType::ROTATE_180:
+            cv::rotate(image, result, cv::ROTATE_180);
+            break;
+        case OcrGeometricEditType::FLIP_HORIZONTAL:
+            cv::flip(image, result, 1);
+            break;
+        case OcrGeometricEditType::FLIP_VERTICAL:
+            cv::flip(image, result, 0);
+            break;
+        case OcrGeometricEditType::CROP: {
+            auto crop = clip_crop_to_image(edit.crop, image.size.p[1], image.size.p[0]);
+            if (crop.width() <= 0 || crop.height() <= 0) {
+                throw std::invalid_argument("Crop area does not intersect the image");
+            }
+            // The data is copied so that the result is continuous, as expected e.g. by PDF export
+            result = image(cv::Rect(crop.x1, crop.y1, crop.width(), crop.height())).clone();
+            break;
+        }
+        default:
+            throw std::invalid_argument("Unknown geometric edit type");
+    }
+    return result;
+}
+
+OcrBox apply_geometric_edit(const OcrBox& box, const OcrGeometricEdit& edit,
+                            int width, int height)
+{
+    auto p1 = map_point(PointD{static_cast<double>(box.x1), static_cast<double>(box.y1)},
+                        edit, width, height);
+    auto p2 = map_point(PointD{static_cast<double>(box.x2), static_cast<double>(box.y2)},
+                        edit, width, height);
+    OcrBox result{static_cast<std::int32_t>(std::min(p1.x, p2.x)),
+                  static_cast<std::int32_t>(std::min(p1.y, p2.y)),
+                  static_cast<std::int32_t>(std::max(p1.x, p2.x)),
+                  static_cast<std::int32_t>(std::max(p1.y, p2.y))};
+
+    if (edit.type == OcrGeometricEditType::CROP) {
+        auto [new_width, new_height] = get_edited_size(edit, width, height);
+        result = OcrBox{std::clamp(result.x1, 0, new_width), std::clamp(result.y1, 0, new_height),
+                        std::clamp(result.x2, 0, new_width), std::clamp(result.y2, 0, new_height)};
+    }
+    return result;
+}
+
+void apply_geometric_edit(std::vector<OcrParagraph>& paragraphs, const OcrGeometricEdit& edit,
+                          int width, int height)
+{
+    if (edit.type == OcrGeometricEditType::CROP) {
+        auto crop = clip_crop_to_image(edit.crop, width, height);
+        for (auto& paragraph : paragraphs) {
+            for (auto& line : paragraph.lines) {
+                std::erase_if(line.words, [&](const OcrWord& word)
+                {
+                    return !box_intersects(word.box, crop);
+                });
+            }
+            std::erase_if(paragraph.lines, [](const OcrLine& line) { return line.words.empty(); });
+        }
+        std::erase_if(paragraphs, [](const OcrParagraph& par) { return par.lines.empty(); });
+    }
+
+    for (auto& paragraph : paragraphs) {
+        paragraph.box = apply_geometric_edit(paragraph.box, edit, width, height);
+        for (auto& line : paragraph.lines) {
+            apply_edit_to_line(line, edit, width, height);
+        }
+    }
+}
+
+int get_baseline_quarter_turns(double angle)
+{
+    auto quarter_turns = static_cast<int>(std::lround(angle / deg_to_rad(90)));
+    return ((quarter_turns % 4) + 4) % 4;
+}
+
+void level_ocr_word(OcrWord& word, int quarter_turns)
+{
+    if (quarter_turns != 0) {
+        apply_edit_to_word(word, get_leveling_edit(quarter_turns), 0, 0);
+    }
+}
+
+void level_ocr_line(OcrLine& line, int quarter_turns)
+{
+    if (quarter_turns != 0) {
+        apply_edit_to_line(line, get_leveling_edit(quarter_turns), 0, 0);
+    }
+}
+
+cv::Mat apply_geometric_edits(const cv::Mat& image, const std::vector<OcrGeometricEdit>& edits)
+{
+    auto result = image;
+    for (const auto& edit : edits) {
+        result = apply_geometric_edit(result, edit);
+    }
+    return result;
+}
+
+void apply_geometric_edits(OcrResults& results, const std::vector<OcrGeometricEdit>& edits,
+                           int width, int height)
+{
+    if (edits.empty()) {
+        return;
+    }
+
+    for (const auto& edit : edits) {
+        apply_geometric_edit(results.paragraphs, edit, width, height);
+        apply_geometric_edit(results.adjusted_paragraphs, edit, width, height);
+        for (auto& box : results.blurred_words) {
+            box = apply_geometric_edit(box, edit, width, height);
+        }
+        if (edit.type == OcrGeometricEditType::CROP) {
+            std::erase_if(results.blurred_words, [](const OcrBox& box)
+            {
+                return box.width() <= 0 || box.height() <= 0;
+            });
+        }
+        std::tie(width, height) = get_edited_size(edit, width, height);
+    }
+    results.adjusted_index.reset();
+}
+
+} // namespace sanescan
@@ -0,0 +1,100 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_OCR_GEOMETRY_H
+#define SANESCAN_OCR_OCR_GEOMETRY_H
+
+#include "ocr_box.h"
+#include "ocr_paragraph.h"
+#include <opencv2/core/mat.hpp>
+#include <compare>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sanescan {
+
+struct OcrResults;
+
+enum class OcrGeometricEditType {
+    ROTATE_90_CW,
+    ROTATE_90_CCW,
+    ROTATE_180,
+    FLIP_HORIZONTAL,
+    FLIP_VERTICAL,
+    CROP,
+};
+
+/*  A geometric edit of a page whose image is a pure transform of the image before the edit.
+    Such edits can be applied to existing OCR results without recognizing the page again.
+*/
+struct OcrGeometricEdit {
+    OcrGeometricEditType type = OcrGeometricEditType::ROTATE_90_CW;
+
+    // The area to keep in the coordinates of the image before the edit. Used only by CROP.
+    OcrBox crop;
+
+    auto operator<=>(const OcrGeometricEdit&) const = default;
+};
+
+const char* ocr_geometric_edit_type_to_string(OcrGeometricEditType type);
+std::optional<OcrGeometricEditType> parse_ocr_geometric_edit_type(const std::string& str);
+
+// The edit is written as its type followed by the coordinates of the crop area
+std::ostream& operator<<(std::ostream& stream, const OcrGeometricEdit& edit);
+std::istream& operator>>(std::istream& stream, OcrGeometricEdit& edit);
+
+cv::Mat apply_geometric_edit(const cv::Mat& image, const OcrGeometricEdit& edit);
+
+/// Maps a box in an image of the given size to the coordinates of the edited image
+OcrBox apply_geometric_edit(const OcrBox& box, const OcrGeometricEdit& edit,
+                            int width, int height);
+
+/** Maps all boxes and baselines of the paragraphs in an image of the given size to the
+    coordinates of the edited image. When cropping, words outside the crop area are removed
+    together with lines and paragraphs that become empty and the rest of the boxes are clipped.
+*/
+void apply_geometric_edit(std::vector<OcrParagraph>& paragraphs, const OcrGeometricEdit& edit,
+                          int width, int height);
+
+/// Returns the number of clockwise quarter turns within [0, 3] that is closest to the angle
+int get_baseline_quarter_turns(double angle);
+
+/** Rotates the boxes and baselines counter-clockwise by the given number of quarter turns around
+    the origin of the image, so that e.g. a line on a page rotated by 90 degrees becomes roughly
+    horizontal. The resulting coordinates may be negative. Code that lays out text along the
+    baseline works on leveled lines and words and rotates the result back.
+*/
+void level_ocr_word(OcrWord& word, int quarter_turns);
+void level_ocr_line(OcrLine& line, int quarter_turns);
+
+/// Applies the edits to the image in order
+cv::Mat apply_geometric_edits(const cv::Mat& image, const std::vector<OcrGeometricEdit>& edits);
+
+/** Applies the edits to the boxes of the results whose adjusted image has the given size. The
+    images and the blur detection data are left to the caller, as they may be shared with other
+    threads. The spatial index is reset.
+*/
+void apply_geometric_edits(OcrResults& results, const std::vector<OcrGeometricEdit>& edits,
+                           int width, int height);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_OCR_GEOMETRY_H
@@ -0,0 +1,98 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr_languages.h"
+#include <algorithm>
+#include <map>
+
+namespace sanescan {
+
+namespace {
+
+const std::map<std::string, std::string>& get_language_scripts()
+{
+    static const std::map<std::string, std::string> scripts = {
+        {"ara", "Arabic"}, {"fas", "Arabic"}, {"urd", "Arabic"},
+        {"hye", "Armenian"},
+        {"ben", "Bengali"},
+        {"bel", "Cyrillic"}, {"bul", "Cyrillic"}, {"kaz", "Cyrillic"}, {"mkd", "Cyrillic"},
+        {"rus", "Cyrillic"}, {"srp", "Cyrillic"}, {"ukr", "Cyrillic"},
+        {"hin", "Devanagari"}, {"mar", "Devanagari"}, {"nep", "Devanagari"},
+        {"san", "Devanagari"},
+        {"kat", "Georgian"},
+        {"ell", "Greek"},
+        {"chi_sim", "Han"}, {"chi_tra", "Han"},
+        {"heb", "Hebrew"},
+        {"jpn", "Japanese"},
+        {"kor", "Korean"},
+        {"ces", "Latin"}, {"cat", "Latin"}, {"dan", "Latin"}, {"deu", "Latin"}, {"eng", "Latin"},
+        {"est", "Latin"}, {"fin", "Latin"}, {"fra", "Latin"}, {"hrv", "Latin"}, {"hun", "Latin"},
+        {"isl", "Latin"}, {"ita", "Latin"}, {"lav", "Latin"}, {"lit", "Latin"}, {"nld", "Latin"},
+        {"nor", "Latin"}, {"pol", "Latin"}, {"por", "Latin"}, {"ron", "Latin"}, {"slk", "Latin"},
+        {"slv", "Latin"}, {"spa", "Latin"}, {"swe", "Latin"}, {"tur", "Latin"}, {"vie", "Latin"},
+        {"tha", "Thai"},
+    };
+    return scripts;
+}
+
+} // namespace
+
+std::string get_language_script(const std::string& language)
+{
+    const auto& scripts = get_language_scripts();
+    auto it = scripts.find(language);
+    if (it == scripts.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+std::vector<std::string> select_languages_for_scripts(const std::vector<std::string>& candidates,
+                                                      const std::vector<std::string>& scripts)
+{
+    std::vector<std::string> result;
+    bool any_known_script_matched = false;
+    for (const auto& language : candidates) {
+        auto script = get_language_script(language);
+        if (script.empty()) {
+            result.push_back(language);
+        } else if (std::find(scripts.begin(), scripts.end(), script) != scripts.end()) {
+            result.push_back(language);
+            any_known_script_matched = true;
+        }
+    }
+    if (!any_known_script_matched) {
+        return candidates;
+    }
+    return result;
+}
+
+std::string join_languages(const std::vector<std::string>& languages)
+{
+    std::string result;
+    for (const auto& language : languages) {
+        if (!result.empty()) {
+            result += '+';
+        }
+        result += language;
+    }
+    return result;
+}
+
+} // namespace sanescan
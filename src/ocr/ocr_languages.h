@@ -0,0 +1,47 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_OCR_LANGUAGES_H
+#define SANESCAN_OCR_OCR_LANGUAGES_H
+
+#include <string>
+#include <vector>
+
+namespace sanescan {
+
+/** Returns the name of the script of the given Tesseract language as reported by the Tesseract
+    script detection, e.g. "Latin" for "eng". Returns an empty string for unknown languages.
+*/
+std::string get_language_script(const std::string& language);
+
+/** Returns the languages out of the given candidates that are written in any of the given
+    scripts. Candidates whose script is not known are always included, as there's no way to tell
+    whether they are needed. If no candidate with a known script matches, e.g. because no script
+    has been detected, all candidates are returned, as recognition with all of them is the best
+    that can be done. The order of the candidates is preserved.
+*/
+std::vector<std::string> select_languages_for_scripts(const std::vector<std::string>& candidates,
+                                                      const std::vector<std::string>& scripts);
+
+/// Joins languages into a string accepted by Tesseract, e.g. "eng+deu"
+std::string join_languages(const std::vector<std::string>& languages);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_OCR_LANGUAGES_H
@@ -19,15 +19,33 @@
 #ifndef SANESCAN_OCR_OCR_OPTIONS_H
 #define SANESCAN_OCR_OCR_OPTIONS_H
 
+#include "ocr_box.h"
 #include "ocr_word.h"
 #include "ocr_baseline.h"
+#include "ocr_geometry.h"
+#include "ocr_profile.h"
 #include "util/math.h"
+#include <string>
 #include <vector>
 #include <iosfwd>
 
 namespace sanescan {
 
 struct OcrOptions {
+    /*  The trade-off between speed and accuracy. The profile selects the recognition models, the
+        page segmentation mode, the resolution the images are normalized to and whether line
+        erasure and blur detection are performed. See get_ocr_profile_settings().
+    */
+    OcrProfile profile = OcrProfile::BALANCED;
+
+    /*  Tesseract languages to recognize, e.g. "eng". Each loaded language increases the time
+        to initialize a recognizer and its memory usage. Therefore, if detect_languages is true
+        and more than one language is given, the scripts of the text are detected on a small
+        sample of the page first and only the languages written in these scripts are loaded.
+    */
+    std::vector<std::string> languages = {"eng"};
+    bool detect_languages = true;
+
     /*  True if the source image should be rotated to fix slight text skep (e.g. due to the
         scanned image being placed slightly incorrectly). This is only done if
         both of the following hold:
@@ -62,6 +80,32 @@ struct OcrOptions {
     //  Coefficient for blur detection
     double blur_detection_coef = 0.1;
 
+    /*  Areas of the source image to recognize. If empty, the whole image is recognized.
+        Otherwise only the text within the areas is recognized, which is much faster for e.g.
+        forms where only specific fields are of interest. The results are in the coordinates of
+        the whole image. Text rotation and page orientation are not adjusted in this case.
+    */
+    std::vector<OcrBox> regions;
+
+    /*  True if lines containing words with confidence below rerecognize_max_word_confidence
+        should be recognized once more using an alternate strategy: the line is cropped from the
+        image without line erasure, upscaled by rerecognize_scale and recognized as a single
+        line of text. The new result is kept only if it scores higher than the original one.
+        This recovers most of the accuracy of a more expensive whole page pass while processing
+        only the affected lines. On noisy pages most lines may be affected, thus this is disabled
+        by default.
+    */
+    bool rerecognize_low_confidence_lines = false;
+    double rerecognize_max_word_confidence = 0.6;
+    double rerecognize_scale = 2;
+
+    /*  Rotations, flips and crops of the page. They are applied in order to the adjusted image
+        and the recognized text after the recognition. If only edits are appended to the options
+        of an already recognized page, the existing results are transformed instead of
+        recognizing the page again.
+    */
+    std::vector<OcrGeometricEdit> geometric_edits;
+
     std::strong_ordering operator<=>(const OcrOptions& other) const = default;
 };
 
@@ -18,66 +18,597 @@
 
 #include "line_erasure.h"
 #include "ocr_pipeline_run.h"
+#include "line_rerecognition.h"
+#include "ocr_geometry.h"
+#include "ocr_languages.h"
+#include "ocr_registration.h"
 #include "ocr_results_evaluator.h"
 #include "ocr_utils.h"
 #include "util/image.h"
+#include "util/math.h"
+#include "util/telemetry.h"
+#include "util/trace.h"
 #include "tesseract.h"
+#include "tesseract_recognizer_pool.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 
 namespace sanescan {
 
+namespace {
+
+// The number of horizontal bands of the page that are used to detect scripts of the text and the
+// height of each band as a fraction of the page height
+constexpr int SCRIPT_SAMPLE_BAND_COUNT = 3;
+constexpr double SCRIPT_SAMPLE_BAND_HEIGHT = 0.1;
+constexpr double MIN_SCRIPT_CONFIDENCE = 1;
+
+// Limits for reusing the results of a previous scan of the same page. Larger rotations are
+// better handled by the full pipeline which straightens the image, and when large parts of the
+// page have changed it's faster to recognize the whole page at once. The scan resolution may
+// differ, so the scale is only checked for sanity.
+constexpr double MAX_REFERENCE_ROTATION_DEG = 1;
+constexpr double MIN_REFERENCE_SCALE = 0.2;
+constexpr double MAX_REFERENCE_SCALE = 5;
+constexpr double MAX_REFERENCE_CHANGED_FRACTION = 0.5;
+constexpr std::size_t MAX_REFERENCE_CHANGED_AREAS = 50;
+
+// Tesseract recognizes text of this height well. When the typical text of a batch is much larger,
+// pages are downscaled to speed up recognition.
+constexpr double PRIOR_MAX_TEXT_HEIGHT = 100;
+constexpr double PRIOR_TARGET_TEXT_HEIGHT = 50;
+constexpr double MIN_ADJUST_ANGLE = 1e-6;
+
+// Records the duration of a pipeline stage to the trace, the telemetry registry and to the list
+// of stage timings
+class StageScope {
+public:
+    StageScope(std::vector<OcrStageTiming>& timings, const char* name) :
+        timings_{timings},
+        name_{name},
+        span_{"ocr", name},
+        start_{std::chrono::steady_clock::now()}
+    {}
+
+    ~StageScope()
+    {
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start_;
+        timings_.push_back(OcrStageTiming{name_, duration.count()});
+        TelemetryRegistry::instance().histogram(std::string("ocr.stage.") + name_)
+                .record(duration.count());
+    }
+
+    StageScope(const StageScope&) = delete;
+    StageScope& operator=(const StageScope&) = delete;
+
+private:
+    std::vector<OcrStageTiming>& timings_;
+    const char* name_ = nullptr;
+    TraceSpan span_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+OcrBox scale_box(const OcrBox& box, double scale)
+{
+    return OcrBox{static_cast<std::int32_t>(std::round(box.x1 * scale)),
+                  static_cast<std::int32_t>(std::round(box.y1 * scale)),
+                  static_cast<std::int32_t>(std::round(box.x2 * scale)),
+                  static_cast<std::int32_t>(std::round(box.y2 * scale))};
+}
+
+cv::Mat downscale_for_recognition(const cv::Mat& image, double scale)
+{
+    if (scale == 1) {
+        return image;
+    }
+    cv::Mat result;
+    cv::resize(image, result, cv::Size(), scale, scale, cv::INTER_AREA);
+    return result;
+}
+
+} // namespace
+
 OcrPipelineRun::OcrPipelineRun(const cv::Mat& source_image,
                                const OcrOptions& options,
                                const OcrOptions& old_options,
                                const std::optional<OcrResults>& old_results) :
     source_image_{source_image},
     options_{options},
-    old_options_{old_options}
+    old_options_{old_options},
+    profile_settings_{get_ocr_profile_settings(options.profile)}
 {
     mode_ = get_mode(options, old_options, old_results);
     if (mode_ == Mode::ONLY_PARAGRAPHS) {
         results_ = old_results.value();
+    } else if (mode_ == Mode::GEOMETRIC_EDITS) {
+        results_ = old_results.value();
+        pending_edits_.assign(options.geometric_edits.begin() + old_options.geometric_edits.size(),
+                              options.geometric_edits.end());
+    } else {
+        pending_edits_ = options.geometric_edits;
     }
 }
 
+OcrResults& OcrPipelineRun::results()
+{
+    if (edited_images_.has_value()) {
+        results_.adjusted_image = std::move(edited_images_->image);
+        results_.adjusted_image_gray = std::move(edited_images_->image_gray);
+        results_.blur_data = std::move(edited_images_->blur_data);
+        edited_images_.reset();
+    }
+    return results_;
+}
+
+void OcrPipelineRun::set_progress_callbacks(
+        std::function<OcrBox()> get_priority_area,
+        std::function<void(const std::vector<OcrParagraph>&)> on_partial_results)
+{
+    get_priority_area_ = std::move(get_priority_area);
+    on_partial_results_ = std::move(on_partial_results);
+}
+
+void OcrPipelineRun::set_reference(const OcrResults& reference)
+{
+    reference_ = reference;
+}
+
+void OcrPipelineRun::set_batch_context(std::shared_ptr<OcrBatchContext> context)
+{
+    batch_context_ = std::move(context);
+}
+
+void OcrPipelineRun::set_priors(const OcrBatchPriors& priors)
+{
+    fixed_priors_ = priors;
+}
+
 void OcrPipelineRun::execute()
 {
+    SANESCAN_TRACE_SPAN("ocr", "pipeline_run");
+    auto start_time = std::chrono::steady_clock::now();
+    stage_timings_.clear();
     if (mode_ == Mode::FULL) {
-        TesseractRecognizer recognizer{"/usr/share/tesseract-ocr/4.00/tessdata/"};
-        results_.paragraphs = recognizer.recognize(source_image_);
-
-        // Handle the case when all text within the image is rotated slightly due to the input data
-        // scan just being rotated. In such case whole image will be rotated to address the following
-        // issues:
-        //
-        // - Most PDF readers can't select rotated text properly
-        // - The OCR accuracy is compromised for rotated text.
-        //
-        // TODO: Ideally we should detect cases when the text in the source image is legitimately
-        // rotated and the rotation is not just the artifact of rotation. In such case the accuracy of
-        // OCR will still be improved if rotate the source image just for OCR and then rotate the
-        // results back.
-        results_.adjust_angle = text_rotation_adjustment(source_image_, results_.paragraphs,
-                                                         options_);
-        results_.adjusted_image = source_image_;
-
-        if (results_.adjust_angle != 0) {
-            results_.adjusted_image = image_rotate_centered(results_.adjusted_image,
-                                                            results_.adjust_angle);
-        }
-        results_.adjusted_image_gray = image_color_to_gray(results_.adjusted_image);
-        auto adjusted_image_no_lines = results_.adjusted_image.clone();
-        erase_straight_vh_lines(adjusted_image_no_lines, results_.adjusted_image_gray,
-                                4, 4, 100);
-
-        // FIXME: removal of horizontal and vertical lines requires OCR to be redone. This could
-        // potentially be avoided.
-        results_.paragraphs = recognizer.recognize(adjusted_image_no_lines);
-        results_.blur_data = compute_blur_data(results_.adjusted_image_gray);
-    }
-    results_.adjusted_paragraphs = evaluate_paragraphs(results_.paragraphs,
-                                                       options_.min_word_confidence);
-    results_.blurred_words = detect_blur_areas(results_.blur_data, results_.adjusted_paragraphs,
-                                               options_.blur_detection_coef);
+        if (!pending_edits_.empty()) {
+            // Partial results would be in the coordinates of the image before the edits
+            on_partial_results_ = {};
+        }
+
+        priors_ = {};
+        observation_ = {};
+        if (options_.regions.empty()) {
+            if (batch_context_) {
+                priors_ = batch_context_->priors_for_next_page();
+            } else if (fixed_priors_.has_value()) {
+                priors_ = fixed_priors_.value();
+            }
+            if (priors_.text_height > PRIOR_MAX_TEXT_HEIGHT) {
+                observation_.used_priors = true;
+            }
+        }
+
+        TesseractRecognizerConfig config;
+        config.model_type = profile_settings_.model_type;
+        config.page_seg_mode = profile_settings_.page_seg_mode;
+        if (options_.detect_languages && options_.languages.size() > 1) {
+            // The prior is ignored if the candidate languages have changed since it was detected
+            auto is_candidate = [this](const std::string& language)
+            {
+                return std::find(options_.languages.begin(), options_.languages.end(),
+                                 language) != options_.languages.end();
+            };
+            if (priors_.languages.has_value() &&
+                    std::all_of(priors_.languages->begin(), priors_.languages->end(),
+                                is_candidate)) {
+                config.languages = join_languages(priors_.languages.value());
+                observation_.used_priors = true;
+            } else {
+                StageScope stage{stage_timings_, "detect_languages"};
+                auto languages = detect_languages();
+                config.languages = join_languages(languages);
+                observation_.languages = languages;
+            }
+        } else {
+            config.languages = join_languages(options_.languages);
+        }
+
+        TesseractRecognizerPool::Handle recognizer;
+        {
+            StageScope stage{stage_timings_, "init_recognizer"};
+            recognizer = TesseractRecognizerPool::instance().acquire(config);
+        }
+        if (options_.regions.empty()) {
+            // The reference image has any geometric edits already applied to it, so it can't
+            // be registered against the source image reliably
+            bool use_reference = reference_.has_value() && options_.geometric_edits.empty();
+            if (!use_reference || !reuse_reference_results(*recognizer)) {
+                recognize_full_image(*recognizer);
+
+                // Only pages that have been recognized as a whole are representative of the batch
+                if (batch_context_) {
+                    observation_.text_height = get_median_word_height(results_.paragraphs);
+                    observation_.mean_word_confidence =
+                            get_mean_word_confidence(results_.paragraphs);
+                    batch_context_->add_page(observation_);
+                }
+            }
+        } else {
+            recognize_regions(*recognizer);
+        }
+        if (options_.rerecognize_low_confidence_lines) {
+            StageScope stage{stage_timings_, "rerecognize_lines"};
+            rerecognize_low_confidence_lines(*recognizer);
+        }
+    }
+    if (!pending_edits_.empty()) {
+        StageScope stage{stage_timings_, "apply_geometric_edits"};
+        apply_pending_edits();
+    }
+    {
+        StageScope stage{stage_timings_, "evaluate_paragraphs"};
+        results_.adjusted_paragraphs = evaluate_paragraphs(results_.paragraphs,
+                                                           options_.min_word_confidence);
+    }
+
+    // Geometric edits map the blurred words of the old results exactly, so they are detected
+    // again only if the options they depend on have changed.
+    bool keep_blurred_words = mode_ == Mode::GEOMETRIC_EDITS &&
+            options_.min_word_confidence == old_options_.min_word_confidence &&
+            options_.blur_detection_coef == old_options_.blur_detection_coef;
+
+    if (profile_settings_.detect_blur) {
+        if (!keep_blurred_words) {
+            const auto& blur_data = get_blur_data();
+            StageScope stage{stage_timings_, "detect_blur_areas"};
+            results_.blurred_words = detect_blur_areas(blur_data, results_.adjusted_paragraphs,
+                                                       options_.blur_detection_coef);
+        }
+    } else {
+        results_.blurred_words.clear();
+    }
+    {
+        StageScope stage{stage_timings_, "build_spatial_index"};
+        results_.adjusted_index = std::make_shared<const OcrSpatialIndex>(
+                    results_.adjusted_paragraphs, results_.blurred_words);
+    }
+
+    static auto& run_histogram = TelemetryRegistry::instance().histogram("ocr.pipeline_run");
+    static auto& pages_counter = TelemetryRegistry::instance().counter("ocr.pages_completed");
+    run_histogram.record(std::chrono::steady_clock::now() - start_time);
+    pages_counter.add();
+}
+
+void OcrPipelineRun::recognize_full_image(TesseractRecognizer& recognizer)
+{
+    std::optional<StageScope> stage{std::in_place, stage_timings_, "initial_recognize"};
+
+    // If the pages of the batch are consistently rotated, the initial recognition is done on the
+    // image rotated according to the prior. If the prior is wrong, the rotation is detected below
+    // the same way as without the prior.
+    double prior_orientation = 0;
+    if (options_.fix_page_orientation && priors_.orientation.has_value()) {
+        prior_orientation = priors_.orientation.value();
+    }
+    auto initial_image = source_image_;
+    if (prior_orientation != 0) {
+        initial_image = image_rotate_centered(source_image_, prior_orientation);
+        observation_.used_priors = true;
+    }
+
+    auto scale = get_recognition_scale(initial_image);
+    auto recognition_image = downscale_for_recognition(initial_image, scale);
+    bool recognized_by_blocks = on_partial_results_ && prior_orientation == 0;
+    if (recognized_by_blocks) {
+        // The initial recognition is done on the source image, so the partial results can
+        // be shown on top of it while the rest of the pipeline is running.
+        std::function<OcrBox()> get_priority_area;
+        if (get_priority_area_) {
+            get_priority_area = [this, scale]() { return scale_box(get_priority_area_(), scale); };
+        }
+        results_.paragraphs = recognizer.recognize_by_blocks(
+                    recognition_image, get_priority_area,
+                    [this, scale](const std::vector<OcrParagraph>& paragraphs)
+        {
+            auto scaled_paragraphs = paragraphs;
+            if (scale != 1) {
+                scale_paragraphs(scaled_paragraphs, 1 / scale);
+            }
+            on_partial_results_(evaluate_paragraphs(scaled_paragraphs,
+                                                    options_.min_word_confidence));
+        });
+        if (scale != 1) {
+            scale_paragraphs(results_.paragraphs, 1 / scale);
+        }
+    } else {
+        results_.paragraphs = recognize_scaled(recognizer, initial_image);
+    }
+
+    // Handle the case when all text within the image is rotated slightly due to the input data
+    // scan just being rotated. In such case whole image will be rotated to address the following
+    // issues:
+    //
+    // - Most PDF readers can't select rotated text properly
+    // - The OCR accuracy is compromised for rotated text.
+    //
+    // TODO: Ideally we should detect cases when the text in the source image is legitimately
+    // rotated and the rotation is not just the artifact of rotation. In such case the accuracy of
+    // OCR will still be improved if rotate the source image just for OCR and then rotate the
+    // results back.
+    stage.emplace(stage_timings_, "adjust_rotation");
+    auto residual_angle = text_rotation_adjustment(initial_image, results_.paragraphs, options_);
+    results_.adjust_angle = prior_orientation + residual_angle;
+    if (prior_orientation != 0) {
+        // A wrong prior is undone by the residual angle, which may leave a rounding error
+        results_.adjust_angle = near_zero_fmod(results_.adjust_angle, deg_to_rad(360));
+        if (std::abs(results_.adjust_angle) < MIN_ADJUST_ANGLE) {
+            results_.adjust_angle = 0;
+        }
+    }
+    if (options_.fix_page_orientation) {
+        observation_.orientation = get_orientation_of_angle(results_.adjust_angle);
+    }
+
+    if (residual_angle == 0) {
+        results_.adjusted_image = initial_image;
+    } else {
+        results_.adjusted_image = image_rotate_centered(source_image_, results_.adjust_angle);
+    }
+    results_.adjusted_image_gray = image_color_to_gray(results_.adjusted_image);
+
+    // Line erasure is skipped if the previous pages of the batch consistently had no lines
+    bool erase_lines = profile_settings_.erase_lines;
+    if (erase_lines && priors_.has_ruled_lines == false) {
+        erase_lines = false;
+        observation_.used_priors = true;
+    }
+
+    bool lines_erased = false;
+    auto adjusted_image_no_lines = results_.adjusted_image;
+    if (erase_lines) {
+        stage.emplace(stage_timings_, "erase_lines");
+        adjusted_image_no_lines = results_.adjusted_image.clone();
+        lines_erased = erase_straight_vh_lines(adjusted_image_no_lines,
+                                               results_.adjusted_image_gray, 4, 4, 100);
+        observation_.has_ruled_lines = lines_erased;
+    }
+
+    // FIXME: removal of horizontal and vertical lines requires OCR to be redone. This could
+    // potentially be avoided.
+    //
+    // Recognition by blocks produces different results than recognition of the whole page, so
+    // its results are never final.
+    if (lines_erased || residual_angle != 0 || recognized_by_blocks) {
+        stage.emplace(stage_timings_, "final_recognize");
+        results_.paragraphs = recognize_scaled(recognizer, adjusted_image_no_lines);
+    }
+    // Otherwise the initial recognition was done on the same image and its results are final
+}
+
+void OcrPipelineRun::recognize_regions(TesseractRecognizer& recognizer)
+{
+    // The regions are defined in the coordinates of the source image, so the image is not
+    // adjusted in any way.
+    results_.adjust_angle = 0;
+    results_.adjusted_image = source_image_;
+    results_.adjusted_image_gray = image_color_to_gray(results_.adjusted_image);
+    results_.paragraphs.clear();
+
+    recognize_areas(recognizer, options_.regions);
+}
+
+void OcrPipelineRun::recognize_areas(TesseractRecognizer& recognizer,
+                                     const std::vector<OcrBox>& areas)
+{
+    cv::Rect image_rect{0, 0, source_image_.size.p[1], source_image_.size.p[0]};
+    for (const auto& region : areas) {
+        auto rect = cv::Rect{region.x1, region.y1, region.width(), region.height()} & image_rect;
+        if (rect.empty()) {
+            continue;
+        }
+
+        StageScope stage{stage_timings_, "recognize_region"};
+        auto region_image = source_image_(rect).clone();
+        if (profile_settings_.erase_lines) {
+            erase_straight_vh_lines(region_image, results_.adjusted_image_gray(rect),
+                                    4, 4, 100);
+        }
+
+        auto paragraphs = recognize_scaled(recognizer, region_image);
+        translate_paragraphs(paragraphs, rect.x, rect.y);
+        if (on_partial_results_) {
+            on_partial_results_(evaluate_paragraphs(paragraphs, options_.min_word_confidence));
+        }
+        results_.paragraphs.insert(results_.paragraphs.end(),
+                                   paragraphs.begin(), paragraphs.end());
+    }
+}
+
+bool OcrPipelineRun::reuse_reference_results(TesseractRecognizer& recognizer)
+{
+    static auto& reused_counter = TelemetryRegistry::instance().counter("ocr.reference_reused");
+    static auto& rejected_counter =
+            TelemetryRegistry::instance().counter("ocr.reference_rejected");
+
+    std::optional<StageScope> stage{std::in_place, stage_timings_, "register_reference"};
+    auto source_gray = image_color_to_gray(source_image_);
+    auto homography = register_images(reference_->adjusted_image_gray, source_gray);
+    if (!homography.has_value()) {
+        rejected_counter.add();
+        return false;
+    }
+
+    auto [angle, scale] = get_homography_rotation_scale(*homography);
+    if (std::abs(rad_to_deg(angle)) > MAX_REFERENCE_ROTATION_DEG ||
+            scale < MIN_REFERENCE_SCALE || scale > MAX_REFERENCE_SCALE) {
+        rejected_counter.add();
+        return false;
+    }
+
+    auto paragraphs = transform_paragraphs(reference_->paragraphs, *homography);
+    auto changed_areas = extend_areas_to_lines(
+                find_changed_areas(reference_->adjusted_image_gray, source_gray, *homography),
+                paragraphs);
+
+    double changed_pixels = 0;
+    for (const auto& area : changed_areas) {
+        changed_pixels += static_cast<double>(area.width()) * area.height();
+    }
+    double total_pixels = static_cast<double>(source_image_.size.p[0]) * source_image_.size.p[1];
+    if (changed_areas.size() > MAX_REFERENCE_CHANGED_AREAS ||
+            changed_pixels > total_pixels * MAX_REFERENCE_CHANGED_FRACTION) {
+        rejected_counter.add();
+        return false;
+    }
+    reused_counter.add();
+    stage.reset();
+
+    // The source image is close enough to the reference which has already been straightened,
+    // so it's used as is.
+    results_.adjust_angle = 0;
+    results_.adjusted_image = source_image_;
+    results_.adjusted_image_gray = source_gray;
+
+    remove_words_in_areas(paragraphs, changed_areas);
+    results_.paragraphs = std::move(paragraphs);
+    if (on_partial_results_) {
+        on_partial_results_(evaluate_paragraphs(results_.paragraphs,
+                                                options_.min_word_confidence));
+    }
+    recognize_areas(recognizer, changed_areas);
+    return true;
+}
+
+std::vector<std::string> OcrPipelineRun::detect_languages()
+{
+    // Script detection uses a separate small model, so it's much cheaper to initialize than
+    // a recognizer with all candidate languages loaded.
+    TesseractRecognizerConfig detector_config;
+    detector_config.page_seg_mode = OcrPageSegMode::OSD_ONLY;
+    detector_config.languages = "osd";
+    auto detector = TesseractRecognizerPool::instance().acquire(detector_config);
+
+    int width = source_image_.size.p[1];
+    int height = source_image_.size.p[0];
+    int band_height = std::max(1, static_cast<int>(height * SCRIPT_SAMPLE_BAND_HEIGHT));
+
+    std::vector<std::string> scripts;
+    for (int i = 0; i < SCRIPT_SAMPLE_BAND_COUNT; ++i) {
+        int band_center = height * (i + 1) / (SCRIPT_SAMPLE_BAND_COUNT + 1);
+        auto band = cv::Rect{0, band_center - band_height / 2, width, band_height} &
+                cv::Rect{0, 0, width, height};
+        if (band.empty()) {
+            continue;
+        }
+
+        auto detection = detector->detect_script(source_image_(band));
+        if (!detection.has_value() || detection->confidence < MIN_SCRIPT_CONFIDENCE) {
+            continue;
+        }
+        if (std::find(scripts.begin(), scripts.end(), detection->script) == scripts.end()) {
+            scripts.push_back(detection->script);
+        }
+    }
+
+    return select_languages_for_scripts(options_.languages, scripts);
+}
+
+double OcrPipelineRun::get_recognition_scale(const cv::Mat& image) const
+{
+    double scale = 1;
+    auto max_pixels = profile_settings_.max_recognition_megapixels * 1e6;
+    double pixels = static_cast<double>(image.size.p[0]) * image.size.p[1];
+    if (max_pixels > 0 && pixels > max_pixels) {
+        scale = std::sqrt(max_pixels / pixels);
+    }
+    if (priors_.text_height > PRIOR_MAX_TEXT_HEIGHT) {
+        scale = std::min(scale, PRIOR_TARGET_TEXT_HEIGHT / priors_.text_height);
+    }
+    return scale;
+}
+
+std::vector<OcrParagraph> OcrPipelineRun::recognize_scaled(TesseractRecognizer& recognizer,
+                                                          const cv::Mat& image)
+{
+    auto scale = get_recognition_scale(image);
+    auto paragraphs = recognizer.recognize(downscale_for_recognition(image, scale));
+    if (scale != 1) {
+        scale_paragraphs(paragraphs, 1 / scale);
+    }
+    return paragraphs;
+}
+
+void OcrPipelineRun::rerecognize_low_confidence_lines(TesseractRecognizer& recognizer)
+{
+    static auto& lines_counter = TelemetryRegistry::instance().counter("ocr.rerecognized_lines");
+    static auto& improved_lines_counter =
+            TelemetryRegistry::instance().counter("ocr.rerecognized_lines_improved");
+
+    // The paragraphs are in the coordinates of the adjusted image. The image with lines erased
+    // is not used, because line erasure sometimes damages the text itself.
+    const auto& image = results_.adjusted_image;
+    cv::Rect image_rect{0, 0, image.size.p[1], image.size.p[0]};
+    auto scale = options_.rerecognize_scale;
+
+    auto locations = find_low_confidence_lines(results_.paragraphs,
+                                               options_.rerecognize_max_word_confidence);
+    for (const auto& location : locations) {
+        auto& line = results_.paragraphs[location.paragraph].lines[location.line];
+
+        // Tesseract recognizes text that touches image edges poorly, so some margin is kept
+        auto margin = std::max(line.box.height() / 4, 2);
+        auto rect = cv::Rect{line.box.x1 - margin, line.box.y1 - margin,
+                             line.box.width() + margin * 2,
+                             line.box.height() + margin * 2} & image_rect;
+        if (rect.empty()) {
+            continue;
+        }
+
+        cv::Mat line_image;
+        cv::resize(image(rect), line_image, cv::Size(), scale, scale, cv::INTER_CUBIC);
+
+        auto paragraphs = recognizer.recognize_single_line(line_image);
+        scale_paragraphs(paragraphs, 1 / scale);
+        translate_paragraphs(paragraphs, rect.x, rect.y);
+
+        lines_counter.add();
+        if (replace_line_words_if_better(line, get_words_within_line(paragraphs, line.box))) {
+            improved_lines_counter.add();
+        }
+    }
+}
+
+void OcrPipelineRun::apply_pending_edits()
+{
+    apply_geometric_edits(results_, pending_edits_, results_.adjusted_image.size.p[1],
+                          results_.adjusted_image.size.p[0]);
+
+    EditedImages edited;
+    edited.image = apply_geometric_edits(results_.adjusted_image, pending_edits_);
+    edited.image_gray = apply_geometric_edits(results_.adjusted_image_gray, pending_edits_);
+
+    if (mode_ == Mode::GEOMETRIC_EDITS) {
+        // The images of the old results are shared with the thread that created the run, so
+        // releasing them here would race on their reference counts. The blur detection data
+        // depends on the orientation of the image and is recomputed only when it's needed.
+        edited_images_ = std::move(edited);
+        return;
+    }
+    results_.adjusted_image = std::move(edited.image);
+    results_.adjusted_image_gray = std::move(edited.image_gray);
+}
+
+const BlurDetectData& OcrPipelineRun::get_blur_data()
+{
+    auto& blur_data = edited_images_.has_value() ? edited_images_->blur_data
+                                                 : results_.blur_data;
+    if (blur_data.image.empty()) {
+        StageScope stage{stage_timings_, "compute_blur_data"};
+        blur_data = compute_blur_data(edited_images_.has_value() ? edited_images_->image_gray
+                                                                 : results_.adjusted_image_gray);
+    }
+    return blur_data;
 }
 
 OcrPipelineRun::Mode OcrPipelineRun::get_mode(const OcrOptions& new_options,
@@ -95,10 +626,20 @@ OcrPipelineRun::Mode OcrPipelineRun::get_mode(const OcrOptions& new_options,
     old_options_for_full.min_word_confidence = 0;
     old_options_for_full.blur_detection_coef = 0;
 
-    if (new_options_for_full != old_options_for_full) {
-        return Mode::FULL;
+    if (new_options_for_full == old_options_for_full) {
+        return Mode::ONLY_PARAGRAPHS;
+    }
+
+    // Geometric edits appended to the existing ones transform the old results exactly
+    const auto& new_edits = new_options.geometric_edits;
+    const auto& old_edits = old_options.geometric_edits;
+    new_options_for_full.geometric_edits.clear();
+    old_options_for_full.geometric_edits.clear();
+    if (new_options_for_full == old_options_for_full && new_edits.size() > old_edits.size() &&
+            std::equal(old_edits.begin(), old_edits.end(), new_edits.begin())) {
+        return Mode::GEOMETRIC_EDITS;
     }
-    return Mode::ONLY_PARAGRAPHS;
+    return Mode::FULL;
 }
 
 
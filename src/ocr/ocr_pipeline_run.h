@@ -19,12 +19,25 @@
 #ifndef SANESCAN_OCR_OCR_PIPELINE_RUN_H
 #define SANESCAN_OCR_OCR_PIPELINE_RUN_H
 
+#include "ocr_batch_context.h"
 #include "ocr_options.h"
+#include "ocr_profile.h"
 #include "ocr_results.h"
+#include <functional>
+#include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace sanescan {
 
+class TesseractRecognizer;
+
+struct OcrStageTiming {
+    std::string name;
+    double duration_sec = 0;
+};
+
 class OcrPipelineRun {
 public:
     OcrPipelineRun(const cv::Mat& source_image,
@@ -32,26 +45,123 @@ public:
                    const OcrOptions& old_options,
                    const std::optional<OcrResults>& old_results);
 
+    /** Sets callbacks that are used to publish partial results while the recognition is in
+        progress. Both are called from the thread that executes the run.
+
+        on_partial_results is called with the paragraphs of each recognized text block, filtered
+        according to min_word_confidence. get_priority_area returns the area whose text should
+        be recognized first. All coordinates are in the coordinates of the source image.
+
+        The final results may differ from the partial ones, because the image may be adjusted
+        after the initial recognition.
+    */
+    void set_progress_callbacks(
+            std::function<OcrBox()> get_priority_area,
+            std::function<void(const std::vector<OcrParagraph>&)> on_partial_results);
+
+    /** Sets the results of a previous scan of the same page. If the source image can be
+        registered against the reference image, then only the areas that have changed are
+        recognized and the rest of the text is taken from the reference results. Only full
+        image recognition without explicit regions or geometric edits uses the reference.
+    */
+    void set_reference(const OcrResults& reference);
+
+    /** Sets the context of the batch the page belongs to. The priors of the context are used to
+        skip or narrow detection steps and the properties of the page are added to the context
+        once the whole page has been recognized. If the priors include page orientation other
+        than upright, partial results are not published.
+    */
+    void set_batch_context(std::shared_ptr<OcrBatchContext> context);
+
+    /** Sets the priors to use instead of the priors of a batch context, e.g. when replaying a
+        captured run. Ignored if a batch context is set.
+    */
+    void set_priors(const OcrBatchPriors& priors);
+
+    /// Returns the priors used by the last execute() call
+    const OcrBatchPriors& priors() const { return priors_; }
+
     void execute();
 
-    OcrResults& results() { return results_; }
+    /** Returns the results of the last execute() call. When geometric edits are applied to old
+        results, the edited images are moved into the results only here, because the images of
+        the old results may still be used by the thread that created the run. Thus this function
+        must be called from that thread.
+    */
+    OcrResults& results();
+
+    /// Returns the durations of the stages of the last execute() call in execution order
+    const std::vector<OcrStageTiming>& stage_timings() const { return stage_timings_; }
 
 private:
 
     enum class Mode {
         ONLY_PARAGRAPHS,
+        // The old results only need additional geometric edits applied to them
+        GEOMETRIC_EDITS,
         FULL,
     };
 
     Mode get_mode(const OcrOptions& new_options, const OcrOptions& old_options,
                   const std::optional<OcrResults>& old_results);
 
+    void recognize_full_image(TesseractRecognizer& recognizer);
+    void recognize_regions(TesseractRecognizer& recognizer);
+
+    // Recognizes the given areas of the source image and appends the results to the paragraphs
+    void recognize_areas(TesseractRecognizer& recognizer, const std::vector<OcrBox>& areas);
+
+    /*  Builds the results from the reference results by recognizing only the changed areas of
+        the source image. Returns false if the reference can't be used, in which case the
+        results are not modified.
+    */
+    bool reuse_reference_results(TesseractRecognizer& recognizer);
+    void rerecognize_low_confidence_lines(TesseractRecognizer& recognizer);
+
+    /*  Returns the candidate languages from the options that are written in the scripts
+        detected on a sample of the source image.
+    */
+    std::vector<std::string> detect_languages();
+
+    // Returns the factor the image is downscaled by before recognition according to the profile
+    double get_recognition_scale(const cv::Mat& image) const;
+
+    // Recognizes the image downscaled according to the profile. The results are in the
+    // coordinates of the given image.
+    std::vector<OcrParagraph> recognize_scaled(TesseractRecognizer& recognizer,
+                                               const cv::Mat& image);
+
+    void apply_pending_edits();
+
+    // Returns the blur detection data of the adjusted image, computing it if needed
+    const BlurDetectData& get_blur_data();
+
+    struct EditedImages {
+        cv::Mat image;
+        cv::Mat image_gray;
+        BlurDetectData blur_data;
+    };
+
     cv::Mat source_image_;
     OcrOptions options_;
     OcrOptions old_options_;
+    OcrProfileSettings profile_settings_;
     Mode mode_ = Mode::FULL;
+    // The geometric edits that still need to be applied to the results
+    std::vector<OcrGeometricEdit> pending_edits_;
+    // The images of the old results after the geometric edits, see results()
+    std::optional<EditedImages> edited_images_;
+    std::optional<OcrResults> reference_;
+    std::shared_ptr<OcrBatchContext> batch_context_;
+    std::optional<OcrBatchPriors> fixed_priors_;
+    OcrBatchPriors priors_;
+    OcrPageObservation observation_;
+
+    std::function<OcrBox()> get_priority_area_;
+    std::function<void(const std::vector<OcrParagraph>&)> on_partial_results_;
 
     OcrResults results_;
+    std::vector<OcrStageTiming> stage_timings_;
 };
 
 } // namespace sanescan
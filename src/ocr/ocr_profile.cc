@@ -0,0 +1,92 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr_profile.h"
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace sanescan {
+
+OcrProfileSettings get_ocr_profile_settings(OcrProfile profile)
+{
+    OcrProfileSettings settings;
+    switch (profile) {
+        case OcrProfile::FAST:
+            // Skipping line erasure allows to avoid the second recognition pass when the image
+            // does not need to be rotated.
+            settings.model_type = OcrModelType::FAST;
+            settings.page_seg_mode = OcrPageSegMode::SPARSE_TEXT;
+            settings.max_recognition_megapixels = 4;
+            settings.erase_lines = false;
+            settings.detect_blur = false;
+            break;
+        case OcrProfile::BALANCED:
+            break;
+        case OcrProfile::BEST:
+            settings.model_type = OcrModelType::BEST;
+            settings.page_seg_mode = OcrPageSegMode::AUTO_OSD;
+            break;
+        default:
+            throw std::invalid_argument("Unknown OCR profile");
+    }
+    return settings;
+}
+
+const char* ocr_profile_to_string(OcrProfile profile)
+{
+    switch (profile) {
+        case OcrProfile::FAST: return "fast";
+        case OcrProfile::BALANCED: return "balanced";
+        case OcrProfile::BEST: return "best";
+        default: throw std::invalid_argument("Unknown OCR profile");
+    }
+}
+
+std::optional<OcrProfile> parse_ocr_profile(const std::string& str)
+{
+    for (auto profile : {OcrProfile::FAST, OcrProfile::BALANCED, OcrProfile::BEST}) {
+        if (str == ocr_profile_to_string(profile)) {
+            return profile;
+        }
+    }
+    return {};
+}
+
+std::ostream& operator<<(std::ostream& stream, OcrProfile profile)
+{
+    return stream << ocr_profile_to_string(profile);
+}
+
+std::istream& operator>>(std::istream& stream, OcrProfile& profile)
+{
+    std::string str;
+    if (!(stream >> str)) {
+        return stream;
+    }
+    auto parsed = parse_ocr_profile(str);
+    if (!parsed.has_value()) {
+        stream.setstate(std::ios_base::failbit);
+        return stream;
+    }
+    profile = parsed.value();
+    return stream;
+}
+
+} // namespace sanescan
@@ -0,0 +1,81 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_OCR_PROFILE_H
+#define SANESCAN_OCR_OCR_PROFILE_H
+
+#include <compare>
+#include <iosfwd>
+#include <optional>
+#include <string>
+
+namespace sanescan {
+
+/// Named trade-offs between OCR speed and accuracy
+enum class OcrProfile {
+    FAST,
+    BALANCED,
+    BEST,
+};
+
+/// The variants of the Tesseract models, each packaged as a separate tessdata directory
+enum class OcrModelType {
+    FAST,     // tessdata_fast
+    STANDARD, // tessdata
+    BEST,     // tessdata_best
+};
+
+enum class OcrPageSegMode {
+    SPARSE_TEXT,
+    SPARSE_TEXT_OSD,
+    AUTO_OSD,
+    OSD_ONLY,
+};
+
+struct OcrProfileSettings {
+    OcrModelType model_type = OcrModelType::STANDARD;
+    OcrPageSegMode page_seg_mode = OcrPageSegMode::SPARSE_TEXT_OSD;
+
+    /*  If larger than zero, images with more pixels are downscaled to this size before
+        recognition. The results are scaled back to the coordinates of the original image. The
+        scanned resolution is not known at OCR time, so the limit is expressed in the number of
+        pixels: 4 megapixels correspond to an A4 page at 200 dpi.
+    */
+    double max_recognition_megapixels = 0;
+
+    // Whether straight horizontal and vertical lines are erased before the final recognition.
+    bool erase_lines = true;
+
+    // Whether blurry words are detected
+    bool detect_blur = true;
+
+    auto operator<=>(const OcrProfileSettings&) const = default;
+};
+
+OcrProfileSettings get_ocr_profile_settings(OcrProfile profile);
+
+const char* ocr_profile_to_string(OcrProfile profile);
+std::optional<OcrProfile> parse_ocr_profile(const std::string& str);
+
+std::ostream& operator<<(std::ostream& stream, OcrProfile profile);
+std::istream& operator>>(std::istream& stream, OcrProfile& profile);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_OCR_PROFILE_H
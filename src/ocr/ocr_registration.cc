@@ -0,0 +1,309 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr_registration.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace sanescan {
+
+namespace {
+
+// The size of the longer side of the images that are used to match the features
+constexpr double REGISTRATION_IMAGE_SIZE = 1000;
+constexpr int MAX_FEATURE_COUNT = 2000;
+constexpr float MATCH_RATIO_THRESHOLD = 0.75f;
+constexpr std::size_t MIN_INLIER_COUNT = 30;
+constexpr double MIN_INLIER_FRACTION = 0.3;
+constexpr double RANSAC_REPROJECTION_THRESHOLD = 3;
+
+// Pixel differences below this threshold are considered to be noise from resampling and scanning
+constexpr int CHANGED_PIXEL_THRESHOLD = 48;
+
+// The radius of the neighbourhood in the downscaled image that is merged into changed areas
+constexpr int CHANGED_AREA_DILATION_RADIUS = 3;
+
+double get_downscale_factor(const cv::Mat& image)
+{
+    auto size = std::max(image.size.p[0], image.size.p[1]);
+    return std::min(1.0, REGISTRATION_IMAGE_SIZE / size);
+}
+
+cv::Mat downscale(const cv::Mat& image, double factor)
+{
+    if (factor == 1) {
+        return image;
+    }
+    cv::Mat result;
+    cv::resize(image, result, cv::Size(), factor, factor, cv::INTER_AREA);
+    return result;
+}
+
+cv::Matx33d scaling_matrix(double scale)
+{
+    return cv::Matx33d{scale, 0, 0,
+                       0, scale, 0,
+                       0, 0, 1};
+}
+
+cv::Point2d apply_homography(const cv::Matx33d& h, double x, double y)
+{
+    auto w = h(2, 0) * x + h(2, 1) * y + h(2, 2);
+    return {(h(0, 0) * x + h(0, 1) * y + h(0, 2)) / w,
+            (h(1, 0) * x + h(1, 1) * y + h(1, 2)) / w};
+}
+
+OcrBox transform_box(const OcrBox& box, const cv::Matx33d& h)
+{
+    cv::Point2d corners[] = {
+        apply_homography(h, box.x1, box.y1),
+        apply_homography(h, box.x2, box.y1),
+        apply_homography(h, box.x1, box.y2),
+        apply_homography(h, box.x2, box.y2),
+    };
+    double x1 = corners[0].x, y1 = corners[0].y, x2 = corners[0].x, y2 = corners[0].y;
+    for (const auto& corner : corners) {
+        x1 = std::min(x1, corner.x);
+        y1 = std::min(y1, corner.y);
+        x2 = std::max(x2, corner.x);
+        y2 = std::max(y2, corner.y);
+    }
+    return OcrBox{static_cast<std::int32_t>(std::round(x1)),
+                  static_cast<std::int32_t>(std::round(y1)),
+                  static_cast<std::int32_t>(std::round(x2)),
+                  static_cast<std::int32_t>(std::round(y2))};
+}
+
+bool boxes_intersect(const OcrBox& a, const OcrBox& b)
+{
+    return a.x1 < b.x2 && b.x1 < a.x2 && a.y1 < b.y2 && b.y1 < a.y2;
+}
+
+OcrBox box_union(const OcrBox& a, const OcrBox& b)
+{
+    return OcrBox{std::min(a.x1, b.x1), std::min(a.y1, b.y1),
+                  std::max(a.x2, b.x2), std::max(a.y2, b.y2)};
+}
+
+} // namespace
+
+std::optional<cv::Matx33d> register_images(const cv::Mat& reference_gray,
+                                           const cv::Mat& image_gray)
+{
+    auto reference_factor = get_downscale_factor(reference_gray);
+    auto image_factor = get_downscale_factor(image_gray);
+    auto small_reference = downscale(reference_gray, reference_factor);
+    auto small_image = downscale(image_gray, image_factor);
+
+    auto orb = cv::ORB::create(MAX_FEATURE_COUNT);
+    std::vector<cv::KeyPoint> reference_keypoints, image_keypoints;
+    cv::Mat reference_descriptors, image_descriptors;
+    orb->detectAndCompute(small_reference, cv::noArray(),
+                          reference_keypoints, reference_descriptors);
+    orb->detectAndCompute(small_image, cv::noArray(), image_keypoints, image_descriptors);
+    if (reference_keypoints.size() < MIN_INLIER_COUNT ||
+            image_keypoints.size() < MIN_INLIER_COUNT) {
+        return {};
+    }
+
+    cv::BFMatcher matcher{cv::NORM_HAMMING};
+    std::vector<std::vector<cv::DMatch>> knn_matches;
+    matcher.knnMatch(reference_descriptors, image_descriptors, knn_matches, 2);
+
+    // Lowe's ratio test rejects ambiguous matches which are common on text
+    std::vector<cv::Point2f> reference_points, image_points;
+    for (const auto& matches : knn_matches) {
+        if (matches.size() < 2 ||
+                matches[0].distance > MATCH_RATIO_THRESHOLD * matches[1].distance) {
+            continue;
+        }
+        reference_points.push_back(reference_keypoints[matches[0].queryIdx].pt);
+        image_points.push_back(image_keypoints[matches[0].trainIdx].pt);
+    }
+    if (reference_points.size() < MIN_INLIER_COUNT) {
+        return {};
+    }
+
+    std::vector<unsigned char> inlier_mask;
+    cv::Mat homography = cv::findHomography(reference_points, image_points, cv::RANSAC,
+                                            RANSAC_REPROJECTION_THRESHOLD, inlier_mask);
+    if (homography.empty()) {
+        return {};
+    }
+    auto inlier_count = static_cast<std::size_t>(
+                std::count(inlier_mask.begin(), inlier_mask.end(), 1));
+    if (inlier_count < MIN_INLIER_COUNT ||
+            inlier_count < MIN_INLIER_FRACTION * reference_points.size()) {
+        return {};
+    }
+
+    // Convert the homography between the downscaled images to the full images
+    return scaling_matrix(1 / image_factor) * cv::Matx33d(homography) *
+            scaling_matrix(reference_factor);
+}
+
+std::pair<double, double> get_homography_rotation_scale(const cv::Matx33d& homography)
+{
+    auto h = homography * (1 / homography(2, 2));
+    auto angle = std::atan2(h(1, 0), h(0, 0));
+    auto scale = std::sqrt(std::abs(h(0, 0) * h(1, 1) - h(0, 1) * h(1, 0)));
+    return {angle, scale};
+}
+
+std::vector<OcrBox> find_changed_areas(const cv::Mat& reference_gray, const cv::Mat& image_gray,
+                                       const cv::Matx33d& homography)
+{
+    auto reference_factor = get_downscale_factor(reference_gray);
+    auto factor = get_downscale_factor(image_gray);
+    auto small_reference = downscale(reference_gray, reference_factor);
+    auto small_image = downscale(image_gray, factor);
+    cv::Size small_size{small_image.size.p[1], small_image.size.p[0]};
+
+    cv::Matx33d small_homography = scaling_matrix(factor) * homography *
+            scaling_matrix(1 / reference_factor);
+    cv::Mat warped_reference;
+    cv::warpPerspective(small_reference, warped_reference, small_homography, small_size,
+                        cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0));
+
+    cv::Mat reference_coverage;
+    cv::warpPerspective(cv::Mat(small_reference.size(), CV_8U, cv::Scalar(255)),
+                        reference_coverage, small_homography, small_size,
+                        cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar(0));
+
+    // Slight blur suppresses the differences caused by resampling and scanner noise
+    cv::Mat blurred_image, blurred_reference;
+    cv::GaussianBlur(small_image, blurred_image, cv::Size(3, 3), 0);
+    cv::GaussianBlur(warped_reference, blurred_reference, cv::Size(3, 3), 0);
+
+    cv::Mat diff;
+    cv::absdiff(blurred_image, blurred_reference, diff);
+    cv::Mat changed;
+    cv::threshold(diff, changed, CHANGED_PIXEL_THRESHOLD, 255, cv::THRESH_BINARY);
+    changed.setTo(255, reference_coverage == 0);
+
+    auto kernel_size = CHANGED_AREA_DILATION_RADIUS * 2 + 1;
+    cv::dilate(changed, changed,
+               cv::getStructuringElement(cv::MORPH_RECT, cv::Size(kernel_size, kernel_size)));
+
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(changed, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+    std::vector<OcrBox> areas;
+    cv::Rect full_rect{0, 0, image_gray.size.p[1], image_gray.size.p[0]};
+    for (const auto& contour : contours) {
+        auto rect = cv::boundingRect(contour);
+        cv::Rect full{static_cast<int>(std::floor(rect.x / factor)),
+                      static_cast<int>(std::floor(rect.y / factor)),
+                      static_cast<int>(std::ceil(rect.width / factor)),
+                      static_cast<int>(std::ceil(rect.height / factor))};
+        full &= full_rect;
+        if (!full.empty()) {
+            areas.push_back(OcrBox{full.x, full.y, full.x + full.width, full.y + full.height});
+        }
+    }
+    return areas;
+}
+
+std::vector<OcrParagraph> transform_paragraphs(const std::vector<OcrParagraph>& paragraphs,
+                                               const cv::Matx33d& homography)
+{
+    auto [angle, scale] = get_homography_rotation_scale(homography);
+
+    auto transform_baseline = [angle, scale](OcrBaseline& baseline)
+    {
+        baseline.x *= scale;
+        baseline.y *= scale;
+        baseline.angle += angle;
+    };
+
+    auto result = paragraphs;
+    for (auto& paragraph : result) {
+        paragraph.box = transform_box(paragraph.box, homography);
+        for (auto& line : paragraph.lines) {
+            line.box = transform_box(line.box, homography);
+            transform_baseline(line.baseline);
+            for (auto& word : line.words) {
+                word.box = transform_box(word.box, homography);
+                transform_baseline(word.baseline);
+                word.font_size *= scale;
+                for (auto& char_box : word.char_boxes) {
+                    char_box = transform_box(char_box, homography);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<OcrBox> extend_areas_to_lines(const std::vector<OcrBox>& areas,
+                                          const std::vector<OcrParagraph>& paragraphs)
+{
+    std::vector<OcrBox> result;
+    for (auto area : areas) {
+        for (const auto& paragraph : paragraphs) {
+            for (const auto& line : paragraph.lines) {
+                if (boxes_intersect(line.box, area)) {
+                    area = box_union(area, line.box);
+                }
+            }
+        }
+
+        // Merge with any previous areas that now overlap. Merging may create new overlaps, so
+        // the search is restarted after each merge.
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (auto it = result.begin(); it != result.end(); ++it) {
+                if (boxes_intersect(*it, area)) {
+                    area = box_union(area, *it);
+                    result.erase(it);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        result.push_back(area);
+    }
+    return result;
+}
+
+void remove_words_in_areas(std::vector<OcrParagraph>& paragraphs,
+                           const std::vector<OcrBox>& areas)
+{
+    auto is_in_areas = [&](const OcrWord& word)
+    {
+        return std::any_of(areas.begin(), areas.end(), [&](const OcrBox& area)
+        {
+            return boxes_intersect(word.box, area);
+        });
+    };
+
+    for (auto& paragraph : paragraphs) {
+        for (auto& line : paragraph.lines) {
+            std::erase_if(line.words, is_in_areas);
+        }
+        std::erase_if(paragraph.lines, [](const OcrLine& line) { return line.words.empty(); });
+    }
+    std::erase_if(paragraphs, [](const OcrParagraph& par) { return par.lines.empty(); });
+}
+
+} // namespace sanescan
@@ -0,0 +1,69 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_OCR_REGISTRATION_H
+#define SANESCAN_OCR_OCR_REGISTRATION_H
+
+#include "ocr_paragraph.h"
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/matx.hpp>
+#include <optional>
+#include <vector>
+
+namespace sanescan {
+
+/** Estimates the homography that maps the coordinates of the reference image to the coordinates
+    of the image, e.g. when the same page has been scanned twice. Both images must be 8-bit gray.
+    The features are matched on downscaled copies of the images, but the returned homography is
+    in the coordinates of the full images. Returns nothing if the images could not be registered
+    reliably.
+*/
+std::optional<cv::Matx33d> register_images(const cv::Mat& reference_gray,
+                                           const cv::Mat& image_gray);
+
+/// Returns the rotation angle of the homography in radians and its average scale
+std::pair<double, double> get_homography_rotation_scale(const cv::Matx33d& homography);
+
+/** Returns the areas of the image that differ from the reference image mapped through the
+    homography. Areas of the image that are not covered by the reference image are also
+    returned. The areas are in the coordinates of the image.
+*/
+std::vector<OcrBox> find_changed_areas(const cv::Mat& reference_gray, const cv::Mat& image_gray,
+                                       const cv::Matx33d& homography);
+
+/** Maps all boxes of the paragraphs through the homography. Each box is replaced by the
+    bounding box of its mapped corners, so the results are precise only for homographies that
+    are close to a similarity transform.
+*/
+std::vector<OcrParagraph> transform_paragraphs(const std::vector<OcrParagraph>& paragraphs,
+                                               const cv::Matx33d& homography);
+
+/** Extends each area to cover the lines of the paragraphs that intersect it, so that the lines
+    can be recognized again as a whole. Areas that overlap after extension are merged.
+*/
+std::vector<OcrBox> extend_areas_to_lines(const std::vector<OcrBox>& areas,
+                                          const std::vector<OcrParagraph>& paragraphs);
+
+/// Removes words intersecting any of the areas. Lines and paragraphs left empty are removed.
+void remove_words_in_areas(std::vector<OcrParagraph>& paragraphs,
+                           const std::vector<OcrBox>& areas);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_OCR_REGISTRATION_H
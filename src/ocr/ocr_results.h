@@ -21,7 +21,9 @@
 
 #include "blur_detection.h"
 #include "ocr_paragraph.h"
+#include "ocr_spatial_index.h"
 #include <opencv2/core/mat.hpp>
+#include <memory>
 #include <vector>
 
 namespace sanescan {
@@ -44,11 +46,15 @@ struct OcrResults {
     // Paragraphs without false positives which have been excluded
     std::vector<OcrParagraph> adjusted_paragraphs;
 
-    // Internal data for blur detection computed from adjusted_image.
+    // Internal data for blur detection computed from adjusted_image. Empty until it's needed.
     BlurDetectData blur_data;
 
     // Words that are blurred.
     std::vector<OcrBox> blurred_words;
+
+    // Spatial index over adjusted_paragraphs and blurred_words. The index is immutable and thus
+    // shared between copies of the results.
+    std::shared_ptr<const OcrSpatialIndex> adjusted_index;
 };
 
 } // namespace sanescan
@@ -0,0 +1,307 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr_search_index.h"
+#include <algorithm>
+#include <cctype>
+#include <istream>
+#include <ostream>
+#include <tuple>
+
+namespace sanescan {
+
+namespace {
+
+constexpr const char* FORMAT_HEADER = "sanescan-search-index";
+constexpr int FORMAT_VERSION = 1;
+
+bool is_ascii_punct_or_space(char c)
+{
+    auto uc = static_cast<unsigned char>(c);
+    return uc < 0x80 && !std::isalnum(uc);
+}
+
+std::vector<std::string_view> split_on_whitespace(std::string_view str)
+{
+    std::vector<std::string_view> result;
+    std::size_t pos = 0;
+    while (pos < str.size()) {
+        auto begin = str.find_first_not_of(" \t\r\n", pos);
+        if (begin == std::string_view::npos) {
+            break;
+        }
+        auto end = str.find_first_of(" \t\r\n", begin);
+        if (end == std::string_view::npos) {
+            end = str.size();
+        }
+        result.push_back(str.substr(begin, end - begin));
+        pos = end;
+    }
+    return result;
+}
+
+} // namespace
+
+std::string normalize_search_term(std::string_view word)
+{
+    while (!word.empty() && is_ascii_punct_or_space(word.front())) {
+        word.remove_prefix(1);
+    }
+    while (!word.empty() && is_ascii_punct_or_space(word.back())) {
+        word.remove_suffix(1);
+    }
+
+    std::string result{word};
+    for (auto& c : result) {
+        auto uc = static_cast<unsigned char>(c);
+        if (uc < 0x80) {
+            c = static_cast<char>(std::tolower(uc));
+        }
+    }
+    return result;
+}
+
+unsigned bounded_edit_distance(std::string_view a, std::string_view b, unsigned max_distance,
+                               bool prefix)
+{
+    auto length_diff = std::max(a.size(), b.size()) - std::min(a.size(), b.size());
+    if (!prefix && length_diff > max_distance) {
+        return max_distance + 1;
+    }
+
+    // Standard dynamic programming approach keeping only one row of the distance matrix.
+    // row[i] holds the distance between a[0..i] and the part of b processed so far.
+    std::vector<unsigned> row(a.size() + 1);
+    for (std::size_t i = 0; i <= a.size(); ++i) {
+        row[i] = i;
+    }
+
+    unsigned best = row[a.size()];
+    for (std::size_t j = 0; j < b.size(); ++j) {
+        unsigned diag = row[0];
+        row[0] = j + 1;
+        unsigned row_min = row[0];
+        for (std::size_t i = 1; i <= a.size(); ++i) {
+            unsigned above = row[i];
+            row[i] = std::min({above + 1, row[i - 1] + 1,
+                               diag + (a[i - 1] == b[j] ? 0 : 1)});
+            diag = above;
+            row_min = std::min(row_min, row[i]);
+        }
+
+        best = prefix ? std::min(best, row[a.size()]) : row[a.size()];
+
+        // Distances never decrease from one row to the next, so the distance to the rest of b
+        // can't get within the limit anymore.
+        if (row_min > max_distance) {
+            return prefix ? std::min(best, max_distance + 1) : max_distance + 1;
+        }
+    }
+    return std::min(best, max_distance + 1);
+}
+
+OcrSearchIndex::OcrSearchIndex() = default;
+OcrSearchIndex::~OcrSearchIndex() = default;
+
+void OcrSearchIndex::set_page(unsigned page_id, const std::vector<OcrParagraph>& paragraphs)
+{
+    remove_page(page_id);
+
+    std::vector<Entry> entries;
+    for (std::size_t ip = 0; ip < paragraphs.size(); ++ip) {
+        const auto& lines = paragraphs[ip].lines;
+        for (std::size_t il = 0; il < lines.size(); ++il) {
+            const auto& words = lines[il].words;
+            for (std::size_t iw = 0; iw < words.size(); ++iw) {
+                OcrWordRef ref{static_cast<std::uint32_t>(ip), static_cast<std::uint32_t>(il),
+                               static_cast<std::uint32_t>(iw)};
+                entries.push_back(Entry{ref, words[iw].box, words[iw].content});
+            }
+        }
+    }
+    add_entries(page_id, std::move(entries));
+}
+
+void OcrSearchIndex::add_entries(unsigned page_id, std::vector<Entry> entries)
+{
+    auto& page_entries = pages_[page_id];
+    page_entries = std::move(entries);
+    for (std::uint32_t i = 0; i < page_entries.size(); ++i) {
+        auto term = normalize_search_term(page_entries[i].text);
+        if (term.empty()) {
+            continue;
+        }
+        terms_[term].push_back(Posting{page_id, i});
+    }
+}
+
+void OcrSearchIndex::remove_page(unsigned page_id)
+{
+    auto page_it = pages_.find(page_id);
+    if (page_it == pages_.end()) {
+        return;
+    }
+
+    for (const auto& entry : page_it->second) {
+        auto it = terms_.find(normalize_search_term(entry.text));
+        if (it == terms_.end()) {
+            // Either an empty term or all postings have been removed already
+            continue;
+        }
+        std::erase_if(it->second, [&](const auto& p) { return p.page_id == page_id; });
+        if (it->second.empty()) {
+            terms_.erase(it);
+        }
+    }
+    pages_.erase(page_it);
+}
+
+bool OcrSearchIndex::has_page(unsigned page_id) const
+{
+    return pages_.count(page_id) != 0;
+}
+
+std::vector<OcrSearchHit> OcrSearchIndex::search(std::string_view query,
+                                                 const OcrSearchOptions& options) const
+{
+    std::vector<OcrSearchHit> hits;
+    for (auto term : split_on_whitespace(query)) {
+        search_term(normalize_search_term(term), options, hits);
+    }
+
+    // The same word may be matched by multiple terms. Only the closest match is kept.
+    std::sort(hits.begin(), hits.end(), [](const auto& a, const auto& b)
+    {
+        return std::tie(a.page_id, a.word, a.edit_distance) <
+                std::tie(b.page_id, b.word, b.edit_distance);
+    });
+    hits.erase(std::unique(hits.begin(), hits.end(), [](const auto& a, const auto& b)
+    {
+        return a.page_id == b.page_id && a.word == b.word;
+    }), hits.end());
+
+    std::stable_sort(hits.begin(), hits.end(), [](const auto& a, const auto& b)
+    {
+        return a.edit_distance < b.edit_distance;
+    });
+    if (hits.size() > options.max_hits) {
+        hits.resize(options.max_hits);
+    }
+    return hits;
+}
+
+void OcrSearchIndex::search_term(std::string_view term, const OcrSearchOptions& options,
+                                 std::vector<OcrSearchHit>& hits) const
+{
+    if (term.empty()) {
+        return;
+    }
+
+    auto add_hits = [&](const std::vector<Posting>& postings, unsigned distance)
+    {
+        for (const auto& posting : postings) {
+            const auto& entry = pages_.at(posting.page_id).at(posting.entry_index);
+            hits.push_back(OcrSearchHit{posting.page_id, entry.word, entry.box, entry.text,
+                                        distance});
+        }
+    };
+
+    if (options.max_edit_distance == 0) {
+        if (!options.prefix) {
+            auto it = terms_.find(term);
+            if (it != terms_.end()) {
+                add_hits(it->second, 0);
+            }
+            return;
+        }
+        for (auto it = terms_.lower_bound(term);
+             it != terms_.end() && it->first.starts_with(term); ++it)
+        {
+            add_hits(it->second, 0);
+        }
+        return;
+    }
+
+    auto max_distance = options.max_edit_distance;
+    for (const auto& [indexed_term, postings] : terms_) {
+        // Cheap length checks first to avoid computing edit distance for most of the terms
+        if (indexed_term.size() + max_distance < term.size()) {
+            continue;
+        }
+        if (!options.prefix && indexed_term.size() > term.size() + max_distance) {
+            continue;
+        }
+        auto distance = bounded_edit_distance(term, indexed_term, max_distance, options.prefix);
+        if (distance <= max_distance) {
+            add_hits(postings, distance);
+        }
+    }
+}
+
+void OcrSearchIndex::write(std::ostream& output) const
+{
+    output << FORMAT_HEADER << ' ' << FORMAT_VERSION << '\n';
+    for (const auto& [page_id, entries] : pages_) {
+        output << "page " << page_id << ' ' << entries.size() << '\n';
+        for (const auto& entry : entries) {
+            output << entry.word.paragraph << ' ' << entry.word.line << ' ' << entry.word.word
+                   << ' ' << entry.box.x1 << ' ' << entry.box.y1
+                   << ' ' << entry.box.x2 << ' ' << entry.box.y2
+                   << ' ' << entry.text.size() << ' ' << entry.text << '\n';
+        }
+    }
+}
+
+OcrSearchIndex OcrSearchIndex::read(std::istream& input)
+{
+    std::string header;
+    int version = 0;
+    input >> header >> version;
+    if (!input || header != FORMAT_HEADER || version != FORMAT_VERSION) {
+        throw OcrSearchIndexException("Unsupported search index format");
+    }
+
+    OcrSearchIndex index;
+    std::string tag;
+    while (input >> tag) {
+        unsigned page_id = 0;
+        std::size_t count = 0;
+        if (tag != "page" || !(input >> page_id >> count)) {
+            throw OcrSearchIndexException("Could not read search index page");
+        }
+
+        std::vector<Entry> entries(count);
+        for (auto& entry : entries) {
+            std::size_t text_size = 0;
+            input >> entry.word.paragraph >> entry.word.line >> entry.word.word
+                  >> entry.box.x1 >> entry.box.y1 >> entry.box.x2 >> entry.box.y2
+                  >> text_size;
+            // Skip the single separator character
+            input.get();
+            entry.text.resize(text_size);
+            input.read(entry.text.data(), text_size);
+            if (!input) {
+                throw OcrSearchIndexException("Could not read search index entry");
+            }
+        }
+        index.add_entries(page_id, std::move(entries));
+    }
+    return index;
+}
+
+} // namespace sanescan
@@ -0,0 +1,122 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SANESCAN_OCR_OCR_SEARCH_INDEX_H
+#define SANESCAN_OCR_OCR_SEARCH_INDEX_H
+
+#include "ocr_paragraph.h"
+#include "ocr_spatial_index.h"
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sanescan {
+
+class OcrSearchIndexException : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct OcrSearchOptions {
+    // If true, words that start with the search term match
+    bool prefix = true;
+
+    // Maximum number of single byte insertions, deletions or substitutions between the search
+    // term and a matching word.
+    unsigned max_edit_distance = 0;
+
+    // Maximum number of returned hits
+    std::size_t max_hits = 1000;
+};
+
+struct OcrSearchHit {
+    unsigned page_id = 0;
+    OcrWordRef word;
+    OcrBox box;
+    std::string text;
+    unsigned edit_distance = 0;
+
+    bool operator==(const OcrSearchHit&) const = default;
+};
+
+/** Inverted index over the words of OCR results of multiple pages. Pages are identified by
+    arbitrary IDs and can be added, replaced or removed individually, so that the index can be
+    kept up to date as OCR results of individual pages change.
+
+    Words are matched case-insensitively (for ASCII characters only) after stripping leading and
+    trailing punctuation.
+*/
+class OcrSearchIndex {
+public:
+    OcrSearchIndex();
+    ~OcrSearchIndex();
+
+    /// Sets the words of a page, replacing any words that the page had previously.
+    void set_page(unsigned page_id, const std::vector<OcrParagraph>& paragraphs);
+
+    void remove_page(unsigned page_id);
+
+    bool has_page(unsigned page_id) const;
+
+    /** Searches for words matching the query. Each whitespace-separated term of the query is
+        matched separately. Hits are sorted by edit distance, page ID and reading order.
+    */
+    std::vector<OcrSearchHit> search(std::string_view query,
+                                     const OcrSearchOptions& options = {}) const;
+
+    /// Writes the index in a simple text format that can be read by read()
+    void write(std::ostream& output) const;
+
+    /// Reads an index that has been written by write(). Throws OcrSearchIndexException on error.
+    static OcrSearchIndex read(std::istream& input);
+
+private:
+    struct Entry {
+        OcrWordRef word;
+        OcrBox box;
+        std::string text;
+    };
+
+    struct Posting {
+        unsigned page_id = 0;
+        std::uint32_t entry_index = 0;
+    };
+
+    void add_entries(unsigned page_id, std::vector<Entry> entries);
+    void search_term(std::string_view term, const OcrSearchOptions& options,
+                     std::vector<OcrSearchHit>& hits) const;
+
+    std::map<unsigned, std::vector<Entry>> pages_;
+    std::map<std::string, std::vector<Posting>, std::less<>> terms_;
+};
+
+/// Converts a word to the form that is used for matching. Returns empty string if nothing is left.
+std::string normalize_search_term(std::string_view word);
+
+/** Returns the edit distance between a and b, or max_distance + 1 if it is larger than
+    max_distance. If prefix is true, the distance to the closest prefix of b is computed.
+*/
+unsigned bounded_edit_distance(std::string_view a, std::string_view b, unsigned max_distance,
+                               bool prefix);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_OCR_SEARCH_INDEX_H
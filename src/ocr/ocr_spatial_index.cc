@@ -0,0 +1,266 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr_spatial_index.h"
+#include <algorithm>
+#include <limits>
+
+namespace sanescan {
+
+namespace {
+
+bool box_contains(const OcrBox& box, std::int32_t x, std::int32_t y)
+{
+    return box.x1 <= x && x < box.x2 && box.y1 <= y && y < box.y2;
+}
+
+bool boxes_intersect(const OcrBox& a, const OcrBox& b)
+{
+    return a.x1 < b.x2 && b.x1 < a.x2 && a.y1 < b.y2 && b.y1 < a.y2;
+}
+
+// The minimum size of a grid cell in pixels
+constexpr std::int32_t MIN_CELL_SIZE = 8;
+
+// The maximum number of grid cells per indexed box. Prevents excessive memory use when a small
+// number of boxes is spread across a large area.
+constexpr std::size_t MAX_CELLS_PER_BOX = 4;
+
+} // namespace
+
+OcrBoxGrid::OcrBoxGrid(std::vector<OcrBox> boxes) :
+    boxes_{std::move(boxes)}
+{
+    if (boxes_.empty()) {
+        return;
+    }
+
+    std::int32_t min_x = std::numeric_limits<std::int32_t>::max();
+    std::int32_t min_y = std::numeric_limits<std::int32_t>::max();
+    std::int32_t max_x = std::numeric_limits<std::int32_t>::min();
+    std::int32_t max_y = std::numeric_limits<std::int32_t>::min();
+    double total_size = 0;
+
+    for (const auto& box : boxes_) {
+        min_x = std::min(min_x, box.x1);
+        min_y = std::min(min_y, box.y1);
+        max_x = std::max(max_x, box.x2);
+        max_y = std::max(max_y, box.y2);
+        total_size += std::max(box.width(), box.height());
+    }
+
+    // Cells of approximately the size of a typical box result in each box being registered in
+    // a small number of cells and each cell containing a small number of boxes.
+    origin_x_ = min_x;
+    origin_y_ = min_y;
+    cell_size_ = std::max(MIN_CELL_SIZE,
+                          static_cast<std::int32_t>(total_size / boxes_.size()));
+
+    auto max_cells = MAX_CELLS_PER_BOX * boxes_.size() + 64;
+    while (true) {
+        cols_ = (max_x - min_x) / cell_size_ + 1;
+        rows_ = (max_y - min_y) / cell_size_ + 1;
+        if (static_cast<std::size_t>(cols_) * rows_ <= max_cells) {
+            break;
+        }
+        cell_size_ *= 2;
+    }
+
+    auto for_each_cell = [this](const OcrBox& box, auto&& fn)
+    {
+        auto cx1 = cell_x(box.x1);
+        auto cy1 = cell_y(box.y1);
+        auto cx2 = cell_x(std::max(box.x1, box.x2 - 1));
+        auto cy2 = cell_y(std::max(box.y1, box.y2 - 1));
+        for (auto cy = cy1; cy <= cy2; ++cy) {
+            for (auto cx = cx1; cx <= cx2; ++cx) {
+                fn(cy * cols_ + cx);
+            }
+        }
+    };
+
+    // Boxes are stored in compressed form: first the number of boxes in each cell is computed,
+    // then the boxes are written into a single array.
+    cell_offsets_.assign(cols_ * rows_ + 1, 0);
+    for (const auto& box : boxes_) {
+        for_each_cell(box, [&](std::size_t cell) { cell_offsets_[cell + 1]++; });
+    }
+    for (std::size_t i = 1; i < cell_offsets_.size(); ++i) {
+        cell_offsets_[i] += cell_offsets_[i - 1];
+    }
+
+    cell_items_.resize(cell_offsets_.back());
+    std::vector<std::uint32_t> cell_fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (std::uint32_t i = 0; i < boxes_.size(); ++i) {
+        for_each_cell(boxes_[i], [&](std::size_t cell) { cell_items_[cell_fill[cell]++] = i; });
+    }
+}
+
+std::int32_t OcrBoxGrid::cell_x(std::int32_t x) const
+{
+    return std::clamp((x - origin_x_) / cell_size_, 0, cols_ - 1);
+}
+
+std::int32_t OcrBoxGrid::cell_y(std::int32_t y) const
+{
+    return std::clamp((y - origin_y_) / cell_size_, 0, rows_ - 1);
+}
+
+std::vector<std::uint32_t> OcrBoxGrid::query_point(std::int32_t x, std::int32_t y) const
+{
+    std::vector<std::uint32_t> result;
+    if (boxes_.empty() || x < origin_x_ || y < origin_y_) {
+        return result;
+    }
+
+    auto cell = cell_y(y) * cols_ + cell_x(x);
+    for (auto i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+        auto index = cell_items_[i];
+        if (box_contains(boxes_[index], x, y)) {
+            result.push_back(index);
+        }
+    }
+    // Boxes are inserted into cells in index order, thus the result is already sorted
+    return result;
+}
+
+std::vector<std::uint32_t> OcrBoxGrid::query_rect(const OcrBox& rect) const
+{
+    std::vector<std::uint32_t> result;
+    if (boxes_.empty() || rect.x2 <= origin_x_ || rect.y2 <= origin_y_) {
+        return result;
+    }
+
+    auto cx1 = cell_x(rect.x1);
+    auto cy1 = cell_y(rect.y1);
+    auto cx2 = cell_x(std::max(rect.x1, rect.x2 - 1));
+    auto cy2 = cell_y(std::max(rect.y1, rect.y2 - 1));
+
+    for (auto cy = cy1; cy <= cy2; ++cy) {
+        for (auto cx = cx1; cx <= cx2; ++cx) {
+            auto cell = cy * cols_ + cx;
+            for (auto i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+                auto index = cell_items_[i];
+                if (boxes_intersect(boxes_[index], rect)) {
+                    result.push_back(index);
+                }
+            }
+        }
+    }
+
+    // Boxes spanning several cells are found more than once
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+OcrSpatialIndex::OcrSpatialIndex(const std::vector<OcrParagraph>& paragraphs,
+                                 const std::vector<OcrBox>& blurred_words)
+{
+    std::vector<OcrBox> word_boxes;
+    std::vector<OcrBox> char_boxes;
+
+    for (std::uint32_t ip = 0; ip < paragraphs.size(); ++ip) {
+        const auto& paragraph = paragraphs[ip];
+        for (std::uint32_t il = 0; il < paragraph.lines.size(); ++il) {
+            const auto& line = paragraph.lines[il];
+            for (std::uint32_t iw = 0; iw < line.words.size(); ++iw) {
+                const auto& word = line.words[iw];
+                OcrWordRef ref{ip, il, iw};
+                word_refs_.push_back(ref);
+                word_boxes.push_back(word.box);
+
+                for (std::uint32_t ic = 0; ic < word.char_boxes.size(); ++ic) {
+                    char_refs_.push_back(OcrCharRef{ref, ic});
+                    char_boxes.push_back(word.char_boxes[ic]);
+                }
+            }
+        }
+    }
+
+    words_ = OcrBoxGrid{std::move(word_boxes)};
+    chars_ = OcrBoxGrid{std::move(char_boxes)};
+    blurred_words_ = OcrBoxGrid{blurred_words};
+}
+
+std::vector<OcrWordRef> OcrSpatialIndex::words_at(std::int32_t x, std::int32_t y) const
+{
+    std::vector<OcrWordRef> result;
+    for (auto index : words_.query_point(x, y)) {
+        result.push_back(word_refs_[index]);
+    }
+    return result;
+}
+
+std::vector<OcrWordRef> OcrSpatialIndex::words_in_rect(const OcrBox& rect) const
+{
+    // Word refs are stored in reading order, so sorted indices produce results in reading order
+    std::vector<OcrWordRef> result;
+    for (auto index : words_.query_rect(rect)) {
+        result.push_back(word_refs_[index]);
+    }
+    return result;
+}
+
+std::vector<OcrCharRef> OcrSpatialIndex::chars_at(std::int32_t x, std::int32_t y) const
+{
+    std::vector<OcrCharRef> result;
+    for (auto index : chars_.query_point(x, y)) {
+        result.push_back(char_refs_[index]);
+    }
+    return result;
+}
+
+std::vector<std::uint32_t> OcrSpatialIndex::blurred_words_at(std::int32_t x, std::int32_t y) const
+{
+    return blurred_words_.query_point(x, y);
+}
+
+std::vector<std::uint32_t> OcrSpatialIndex::blurred_words_in_rect(const OcrBox& rect) const
+{
+    return blurred_words_.query_rect(rect);
+}
+
+const OcrWord& get_word(const std::vector<OcrParagraph>& paragraphs, const OcrWordRef& ref)
+{
+    return paragraphs.at(ref.paragraph).lines.at(ref.line).words.at(ref.word);
+}
+
+std::string get_text_in_reading_order(const std::vector<OcrParagraph>& paragraphs,
+                                      const std::vector<OcrWordRef>& words)
+{
+    std::string result;
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        const auto& ref = words[i];
+        if (i > 0) {
+            const auto& prev_ref = words[i - 1];
+            if (prev_ref.paragraph != ref.paragraph) {
+                result += "\n\n";
+            } else if (prev_ref.line != ref.line) {
+                result += "\n";
+            } else {
+                result += " ";
+            }
+        }
+        result += get_word(paragraphs, ref).content;
+    }
+    return result;
+}
+
+} // namespace sanescan
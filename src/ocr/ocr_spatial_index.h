@@ -0,0 +1,123 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_OCR_SPATIAL_INDEX_H
+#define SANESCAN_OCR_OCR_SPATIAL_INDEX_H
+
+#include "ocr_paragraph.h"
+#include <compare>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sanescan {
+
+/// Identifies a word within a list of paragraphs. Comparison order corresponds to reading order.
+struct OcrWordRef {
+    std::uint32_t paragraph = 0;
+    std::uint32_t line = 0;
+    std::uint32_t word = 0;
+
+    auto operator<=>(const OcrWordRef&) const = default;
+};
+
+/// Identifies a character box within a list of paragraphs.
+struct OcrCharRef {
+    OcrWordRef word;
+    std::uint32_t char_index = 0;
+
+    auto operator<=>(const OcrCharRef&) const = default;
+};
+
+/** A uniform grid over a set of boxes. Each box is registered in all cells it overlaps, so that
+    queries only need to look into the cells covered by the query area.
+*/
+class OcrBoxGrid {
+public:
+    OcrBoxGrid() = default;
+    explicit OcrBoxGrid(std::vector<OcrBox> boxes);
+
+    const std::vector<OcrBox>& boxes() const { return boxes_; }
+
+    /// Returns sorted indices of boxes that contain the given point.
+    std::vector<std::uint32_t> query_point(std::int32_t x, std::int32_t y) const;
+
+    /// Returns sorted indices of boxes that intersect the given rectangle.
+    std::vector<std::uint32_t> query_rect(const OcrBox& rect) const;
+
+private:
+    std::int32_t cell_x(std::int32_t x) const;
+    std::int32_t cell_y(std::int32_t y) const;
+
+    std::vector<OcrBox> boxes_;
+    std::int32_t origin_x_ = 0;
+    std::int32_t origin_y_ = 0;
+    std::int32_t cell_size_ = 1;
+    std::int32_t cols_ = 0;
+    std::int32_t rows_ = 0;
+
+    // Box indices of cell i are stored in cell_items_[cell_offsets_[i]..cell_offsets_[i+1]]
+    std::vector<std::uint32_t> cell_offsets_;
+    std::vector<std::uint32_t> cell_items_;
+};
+
+/** Spatial index over words, characters and blurred areas of OCR results. The index refers to
+    the paragraphs it has been built from by position, so it must be rebuilt whenever the
+    paragraphs change.
+*/
+class OcrSpatialIndex {
+public:
+    OcrSpatialIndex() = default;
+    OcrSpatialIndex(const std::vector<OcrParagraph>& paragraphs,
+                    const std::vector<OcrBox>& blurred_words);
+
+    /// Returns words whose boxes contain the given point, in reading order.
+    std::vector<OcrWordRef> words_at(std::int32_t x, std::int32_t y) const;
+
+    /// Returns words whose boxes intersect the given rectangle, in reading order.
+    std::vector<OcrWordRef> words_in_rect(const OcrBox& rect) const;
+
+    /// Returns character boxes that contain the given point.
+    std::vector<OcrCharRef> chars_at(std::int32_t x, std::int32_t y) const;
+
+    /// Returns indices of blurred word boxes that contain the given point.
+    std::vector<std::uint32_t> blurred_words_at(std::int32_t x, std::int32_t y) const;
+
+    /// Returns indices of blurred word boxes that intersect the given rectangle.
+    std::vector<std::uint32_t> blurred_words_in_rect(const OcrBox& rect) const;
+
+private:
+    std::vector<OcrWordRef> word_refs_;
+    std::vector<OcrCharRef> char_refs_;
+    OcrBoxGrid words_;
+    OcrBoxGrid chars_;
+    OcrBoxGrid blurred_words_;
+};
+
+const OcrWord& get_word(const std::vector<OcrParagraph>& paragraphs, const OcrWordRef& ref);
+
+/** Returns the text of the given words. The words must be sorted in reading order. Words within
+    a line are separated by spaces, lines by newlines and paragraphs by empty lines.
+*/
+std::string get_text_in_reading_order(const std::vector<OcrParagraph>& paragraphs,
+                                      const std::vector<OcrWordRef>& words);
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_OCR_SPATIAL_INDEX_H
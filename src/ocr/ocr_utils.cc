@@ -389,4 +389,72 @@ double text_rotation_adjustment(const cv::Mat& image,
     return 0;
 }
 
+void translate_paragraphs(std::vector<OcrParagraph>& paragraphs,
+                          std::int32_t dx, std::int32_t dy)
+{
+    auto translate_box = [dx, dy](OcrBox& box)
+    {
+        box.x1 += dx;
+        box.y1 += dy;
+        box.x2 += dx;
+        box.y2 += dy;
+    };
+
+    // Baselines are relative to the boxes, so they don't need to be changed
+    for (auto& paragraph : paragraphs) {
+        translate_box(paragraph.box);
+        for (auto& line : paragraph.lines) {
+            translate_box(line.box);
+            for (auto& word : line.words) {
+                translate_box(word.box);
+                for (auto& char_box : word.char_boxes) {
+                    translate_box(char_box);
+                }
+            }
+        }
+    }
+}
+
+void scale_paragraphs(std::vector<OcrParagraph>& paragraphs, double scale)
+{
+    auto scale_box = [scale](OcrBox& box)
+    {
+        box.x1 = static_cast<std::int32_t>(std::round(box.x1 * scale));
+        box.y1 = static_cast<std::int32_t>(std::round(box.y1 * scale));
+        box.x2 = static_cast<std::int32_t>(std::round(box.x2 * scale));
+        box.y2 = static_cast<std::int32_t>(std::round(box.y2 * scale));
+    };
+
+    // Angles are not affected by uniform scaling
+    auto scale_baseline = [scale](OcrBaseline& baseline)
+    {
+        baseline.x *= scale;
+        baseline.y *= scale;
+    };
+
+    for (auto& paragraph : paragraphs) {
+        scale_box(paragraph.box);
+        for (auto& line : paragraph.lines) {
+            scale_box(line.box);
+            scale_baseline(line.baseline);
+            for (auto& word : line.words) {
+                scale_box(word.box);
+                scale_baseline(word.baseline);
+                word.font_size *= scale;
+                for (auto& char_box : word.char_boxes) {
+                    scale_box(char_box);
+                }
+            }
+        }
+    }
+}
+
+std::size_t count_utf8_chars(std::string_view str)
+{
+    return std::count_if(str.begin(), str.end(), [](char ch)
+    {
+        return (static_cast<unsigned char>(ch) & 0xc0) != 0x80;
+    });
+}
+
 } // namespace sanescan
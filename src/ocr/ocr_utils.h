@@ -21,6 +21,7 @@
 
 #include "ocr_options.h"
 #include "ocr_paragraph.h"
+#include <string_view>
 
 namespace sanescan {
 
@@ -59,6 +60,16 @@ double text_rotation_adjustment(const cv::Mat& image,
                                 const std::vector<OcrParagraph>& recognized,
                                 const OcrOptions& options);
 
+// Moves all boxes of the given paragraphs by the given offset.
+void translate_paragraphs(std::vector<OcrParagraph>& paragraphs,
+                          std::int32_t dx, std::int32_t dy);
+
+// Scales all boxes, baselines and font sizes of the given paragraphs by the given factor.
+void scale_paragraphs(std::vector<OcrParagraph>& paragraphs, double scale);
+
+// Returns the number of code points in the given UTF-8 encoded string.
+std::size_t count_utf8_chars(std::string_view str);
+
 } // namespace sanescan
 
 #endif // SANESCAN_OCR_OCR_WORD_H
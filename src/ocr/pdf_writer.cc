@@ -32,8 +32,11 @@
 */
 
 #include "pdf_writer.h"
+#include "ocr_geometry.h"
 #include "pdf_canvas.h"
 #include "pdf_ttf_font.h"
+#include "util/math.h"
+#include "util/trace.h"
 
 #include <algorithm>
 
@@ -48,12 +51,14 @@ PdfWriter::PdfWriter(std::ostream& stream, WritePdfFlags flags) :
 
 PdfWriter::~PdfWriter()
 {
+    SANESCAN_TRACE_SPAN("pdf", "close_document");
     doc_.Close();
 }
 
 
 void PdfWriter::write_header()
 {
+    SANESCAN_TRACE_SPAN("pdf", "write_header");
     type0_font_ = doc_.GetObjects()->CreateObject("Font");
     auto* cid_font_type2 = doc_.GetObjects()->CreateObject("Font");
     auto* cmap_file = doc_.GetObjects()->CreateObject();
@@ -76,6 +81,7 @@ void PdfWriter::write_header()
 
 void PdfWriter::write_page(const cv::Mat& image, const std::vector<OcrParagraph>& recognized)
 {
+    SANESCAN_TRACE_SPAN("pdf", "write_page");
     if (type0_font_ == nullptr) {
         throw std::runtime_error("write_header must be called before calling write_page");
     }
@@ -83,25 +89,10 @@ void PdfWriter::write_page(const cv::Mat& image, const std::vector<OcrParagraph>
     auto width = image.size.p[1];
     auto height = image.size.p[0];
 
-    auto* page = doc_.CreatePage(PoDoFo::PdfRect(0, 0, width, height));
-
-    std::string font_ident = "font_ident";
-
     PoDoFo::PdfImage image_data(&doc_, "image-");
-    page->AddResource(image_data.GetIdentifier(), image_data.GetObjectReference(), "XObject");
-    page->AddResource(PoDoFo::PdfName(font_ident), type0_font_->Reference(), "Font");
-    if (debug_font_ != nullptr) {
-        page->AddResource(debug_font_->GetIdentifier(), debug_font_->GetObject()->Reference(),
-                          "Font");
-    }
-
-    auto page_contents_data = get_contents_data_for_image(image_data.GetIdentifier().GetName(),
-                                                      width, height);
-    page_contents_data += get_contents_data_for_text(font_ident, width, height, recognized);
-
-    PoDoFo::PdfMemoryInputStream page_contents_stream(page_contents_data.c_str(),
-                                                       page_contents_data.size());
-    page->GetContents()->GetStream()->SetRawData(&page_contents_stream);
+    WrittenImage written_image{image_data.GetIdentifier(), image_data.GetObjectReference(),
+                               width, height};
+    write_page_contents(written_image, recognized);
 
     PoDoFo::PdfMemoryInputStream image_data_stream(reinterpret_cast<char*>(image.data),
                                                    image.elemSize1() *
@@ -114,6 +105,48 @@ void PdfWriter::write_page(const cv::Mat& image, const std::vector<OcrParagraph>
     }
 
     image_data.SetImageData(width, height, image.elemSize1() * 8, &image_data_stream);
+    page_images_.push_back(written_image);
+}
+
+void PdfWriter::write_page_with_image_of(std::size_t page_index,
+                                         const std::vector<OcrParagraph>& recognized)
+{
+    SANESCAN_TRACE_SPAN("pdf", "write_page_with_image_of");
+    if (type0_font_ == nullptr) {
+        throw std::runtime_error("write_header must be called before calling write_page");
+    }
+    if (page_index >= page_images_.size()) {
+        throw std::runtime_error("Page with image to share has not been written yet");
+    }
+
+    // Copied, because page_images_ is modified below
+    auto written_image = page_images_[page_index];
+    write_page_contents(written_image, recognized);
+    page_images_.push_back(written_image);
+}
+
+void PdfWriter::write_page_contents(const WrittenImage& image,
+                                    const std::vector<OcrParagraph>& recognized)
+{
+    auto* page = doc_.CreatePage(PoDoFo::PdfRect(0, 0, image.width, image.height));
+
+    std::string font_ident = "font_ident";
+
+    page->AddResource(image.identifier, image.reference, "XObject");
+    page->AddResource(PoDoFo::PdfName(font_ident), type0_font_->Reference(), "Font");
+    if (debug_font_ != nullptr) {
+        page->AddResource(debug_font_->GetIdentifier(), debug_font_->GetObject()->Reference(),
+                          "Font");
+    }
+
+    auto page_contents_data = get_contents_data_for_image(image.identifier.GetName(),
+                                                          image.width, image.height);
+    page_contents_data += get_contents_data_for_text(font_ident, image.width, image.height,
+                                                     recognized);
+
+    PoDoFo::PdfMemoryInputStream page_contents_stream(page_contents_data.c_str(),
+                                                       page_contents_data.size());
+    page->GetContents()->GetStream()->SetRawData(&page_contents_stream);
 }
 
 void PdfWriter::setup_type0_font(PoDoFo::PdfObject* type0_font, PoDoFo::PdfObject* cid_font_type2,
@@ -250,6 +283,34 @@ void PdfWriter::write_line_to_canvas(PdfCanvas& canvas, const std::string& font_
                                      double width, double height,
                                      const OcrLine& line,
                                      std::size_t paragraph_index, std::size_t line_index)
+{
+    auto quarter_turns = get_baseline_quarter_turns(line.baseline.angle);
+    if (quarter_turns == 0) {
+        write_leveled_line_to_canvas(canvas, font_ident, width, height, line,
+                                     paragraph_index, line_index);
+        return;
+    }
+
+    // Lines at a quarter turn, e.g. on pages rotated by 90 degrees, are written as horizontal
+    // lines, as the positioning below divides by the cosine of the baseline angle. The leveled
+    // line is written as if the image had zero size and then rotated back onto the page.
+    auto leveled_line = line;
+    level_ocr_line(leveled_line, quarter_turns);
+
+    auto angle = quarter_turns * deg_to_rad(90);
+    canvas.save_state();
+    canvas.set_ctm(std::cos(angle), -std::sin(angle), std::sin(angle), std::cos(angle),
+                   0, height);
+    write_leveled_line_to_canvas(canvas, font_ident, 0, 0, leveled_line,
+                                 paragraph_index, line_index);
+    canvas.restore_state();
+    canvas.separator();
+}
+
+void PdfWriter::write_leveled_line_to_canvas(PdfCanvas& canvas, const std::string& font_ident,
+                                             double width, double height,
+                                             const OcrLine& line,
+                                             std::size_t paragraph_index, std::size_t line_index)
 {
     canvas.begin_text();
 
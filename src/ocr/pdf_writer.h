@@ -40,7 +40,24 @@ public:
     void write_header();
     void write_page(const cv::Mat& image, const std::vector<OcrParagraph>& recognized);
 
+    /** Writes a page that displays the same image XObject as a previously written page. The
+        image data is stored only once in the output. The page index is in the order the pages
+        have been written.
+    */
+    void write_page_with_image_of(std::size_t page_index,
+                                  const std::vector<OcrParagraph>& recognized);
+
 private:
+    struct WrittenImage {
+        PoDoFo::PdfName identifier;
+        PoDoFo::PdfReference reference;
+        int width = 0;
+        int height = 0;
+    };
+
+    void write_page_contents(const WrittenImage& image,
+                             const std::vector<OcrParagraph>& recognized);
+
     void setup_type0_font(PoDoFo::PdfObject* type0_font, PoDoFo::PdfObject* cid_font_type2,
                           PoDoFo::PdfObject* cmap_file);
 
@@ -63,11 +80,19 @@ private:
                               double width, double height, const OcrLine& line,
                               std::size_t paragraph_index, std::size_t line_index);
 
+    // Same as write_line_to_canvas(), except that the line must be roughly horizontal
+    void write_leveled_line_to_canvas(PdfCanvas& canvas, const std::string& font_ident,
+                                      double width, double height, const OcrLine& line,
+                                      std::size_t paragraph_index, std::size_t line_index);
+
     PoDoFo::PdfOutputDevice output_dev_;
     PoDoFo::PdfStreamedDocument doc_;
     PoDoFo::PdfObject* type0_font_ = nullptr;
     PoDoFo::PdfFont* debug_font_ = nullptr;
     WritePdfFlags flags_;
+
+    // The images of all written pages in write order
+    std::vector<WrittenImage> page_images_;
 };
 
 } // namespace sanescan
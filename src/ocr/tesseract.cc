@@ -19,18 +19,21 @@
 #include "tesseract.h"
 #include "ocr_utils.h"
 #include "tesseract_renderer.h"
+#include "tesseract_renderer_utils.h"
 #include "util/image.h"
 #include "util/math.h"
 
 #include <leptonica/allheaders.h>
 #include <opencv2/imgcodecs.hpp>
 #include <tesseract/baseapi.h>
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
 
 namespace sanescan {
 
-namespace {
-
 PIX* cv_mat_to_pix(const cv::Mat& image)
 {
     if (image.size.dims() != 2) {
@@ -92,21 +95,92 @@ PIX* cv_mat_to_pix(const cv::Mat& image)
     return pix;
 }
 
+std::string tesseract_version()
+{
+    return tesseract::TessBaseAPI::Version();
+}
+
+namespace {
+
+constexpr const char* TESSDATA_PARENT_PATH = "/usr/share/tesseract-ocr/4.00/";
+
+const char* get_tessdata_dir_name(OcrModelType model_type)
+{
+    switch (model_type) {
+        case OcrModelType::FAST: return "tessdata_fast";
+        case OcrModelType::STANDARD: return "tessdata";
+        case OcrModelType::BEST: return "tessdata_best";
+        default: throw std::invalid_argument("Unknown model type");
+    }
+}
+
+tesseract::PageSegMode to_tesseract_page_seg_mode(OcrPageSegMode mode)
+{
+    switch (mode) {
+        case OcrPageSegMode::SPARSE_TEXT: return tesseract::PSM_SPARSE_TEXT;
+        case OcrPageSegMode::SPARSE_TEXT_OSD: return tesseract::PSM_SPARSE_TEXT_OSD;
+        case OcrPageSegMode::AUTO_OSD: return tesseract::PSM_AUTO_OSD;
+        case OcrPageSegMode::OSD_ONLY: return tesseract::PSM_OSD_ONLY;
+        default: throw std::invalid_argument("Unknown page segmentation mode");
+    }
+}
+
+struct PixDeleter {
+    void operator()(PIX* pix) { pixDestroy(&pix); }
+};
+
+// Clears the image and the recognition state of Tesseract on scope exit. This way a recognizer
+// is returned to TesseractRecognizerPool in a clean state even if the recognition fails.
+class TesseractClearGuard {
+public:
+    explicit TesseractClearGuard(tesseract::TessBaseAPI& tesseract) : tesseract_{tesseract} {}
+    TesseractClearGuard(const TesseractClearGuard&) = delete;
+    TesseractClearGuard& operator=(const TesseractClearGuard&) = delete;
+    ~TesseractClearGuard() { tesseract_.Clear(); }
+
+private:
+    tesseract::TessBaseAPI& tesseract_;
+};
+
+std::int64_t box_distance_squared(const OcrBox& a, const OcrBox& b)
+{
+    std::int64_t dx = std::max({0, a.x1 - b.x2, b.x1 - a.x2});
+    std::int64_t dy = std::max({0, a.y1 - b.y2, b.y1 - a.y2});
+    return dx * dx + dy * dy;
+}
+
 } // namespace
 
+std::string get_tessdata_path(OcrModelType model_type)
+{
+    std::filesystem::path path = TESSDATA_PARENT_PATH;
+    path /= get_tessdata_dir_name(model_type);
+    std::error_code ec;
+    if (model_type != OcrModelType::STANDARD && !std::filesystem::is_directory(path, ec)) {
+        return get_tessdata_path(OcrModelType::STANDARD);
+    }
+    return path.string() + "/";
+}
+
 struct TesseractRecognizer::Private {
     tesseract::TessBaseAPI tesseract;
+    TesseractRecognizerConfig config;
+    tesseract::PageSegMode page_seg_mode = tesseract::PSM_SPARSE_TEXT_OSD;
 };
 
-TesseractRecognizer::TesseractRecognizer(const std::string& tesseract_datapath) :
+TesseractRecognizer::TesseractRecognizer(const TesseractRecognizerConfig& config) :
     data_{std::make_unique<Private>()}
 {
-    if (data_->tesseract.Init(tesseract_datapath.c_str(), "eng",
+    data_->config = config;
+    data_->page_seg_mode = to_tesseract_page_seg_mode(config.page_seg_mode);
+
+    auto datapath = get_tessdata_path(config.model_type);
+    if (data_->tesseract.Init(datapath.c_str(), config.languages.c_str(),
                               tesseract::OEM_LSTM_ONLY) != 0) {
         throw std::runtime_error("Tesseract could not initialize");
     }
 
-    data_->tesseract.SetPageSegMode(tesseract::PSM_SPARSE_TEXT_OSD);
+    data_->tesseract.SetPageSegMode(data_->page_seg_mode);
 }
 
 TesseractRecognizer::~TesseractRecognizer() = default;
@@ -123,5 +197,119 @@ std::vector<OcrParagraph> TesseractRecognizer::recognize(const cv::Mat& image)
     return renderer.get_paragraphs();
 }
 
+std::vector<OcrParagraph> TesseractRecognizer::recognize_single_line(const cv::Mat& image)
+{
+    std::unique_ptr<PIX, PixDeleter> pix{cv_mat_to_pix(image)};
+    auto& tesseract = data_->tesseract;
+    tesseract.SetPageSegMode(tesseract::PSM_SINGLE_LINE);
+    tesseract.SetImage(pix.get());
+
+    auto rc = tesseract.Recognize(nullptr);
+    std::vector<OcrParagraph> paragraphs;
+    if (rc == 0) {
+        TesseractRenderer::append_paragraphs(&tesseract, paragraphs);
+    }
+    tesseract.Clear();
+    tesseract.SetPageSegMode(data_->page_seg_mode);
+
+    if (rc != 0) {
+        throw std::runtime_error("Failed to recognize line");
+    }
+    return paragraphs;
+}
+
+std::optional<OcrScriptDetection> TesseractRecognizer::detect_script(const cv::Mat& image)
+{
+    std::unique_ptr<PIX, PixDeleter> pix{cv_mat_to_pix(image)};
+    auto& tesseract = data_->tesseract;
+    tesseract.SetImage(pix.get());
+
+    int orientation_deg = 0;
+    float orientation_confidence = 0;
+    const char* script_name = nullptr;
+    float script_confidence = 0;
+    auto success = tesseract.DetectOrientationScript(&orientation_deg, &orientation_confidence,
+                                                     &script_name, &script_confidence);
+    tesseract.Clear();
+
+    if (!success || script_name == nullptr) {
+        return {};
+    }
+    return OcrScriptDetection{script_name, script_confidence};
+}
+
+const TesseractRecognizerConfig& TesseractRecognizer::config() const
+{
+    return data_->config;
+}
+
+std::vector<OcrParagraph> TesseractRecognizer::recognize_by_blocks(
+        const cv::Mat& image,
+        const std::function<OcrBox()>& get_priority_area,
+        const std::function<void(const std::vector<OcrParagraph>&)>& on_block_recognized)
+{
+    std::unique_ptr<PIX, PixDeleter> pix{cv_mat_to_pix(image)};
+    auto& tesseract = data_->tesseract;
+    TesseractClearGuard clear_guard{tesseract};
+    tesseract.SetImage(pix.get());
+
+    std::vector<OcrBox> blocks;
+    {
+        std::unique_ptr<tesseract::PageIterator> it(tesseract.AnalyseLayout());
+        if (it) {
+            do {
+                if (!is_text_block_type(it->BlockType())) {
+                    continue;
+                }
+                int left, top, right, bottom;
+                if (it->BoundingBox(tesseract::RIL_BLOCK, &left, &top, &right, &bottom)) {
+                    blocks.push_back(OcrBox{left, top, right, bottom});
+                }
+            } while (it->Next(tesseract::RIL_BLOCK));
+        }
+    }
+
+    std::vector<std::vector<OcrParagraph>> block_paragraphs(blocks.size());
+    std::vector<bool> block_done(blocks.size(), false);
+
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        auto priority_area = get_priority_area ? get_priority_area() : OcrBox{};
+        bool has_priority_area = priority_area.width() > 0 && priority_area.height() > 0;
+
+        // Picks the first block in layout order among the blocks closest to the priority area
+        std::size_t next = blocks.size();
+        auto next_distance = std::numeric_limits<std::int64_t>::max();
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            if (block_done[b]) {
+                continue;
+            }
+            auto distance = has_priority_area ? box_distance_squared(blocks[b], priority_area) : 0;
+            if (distance < next_distance) {
+                next = b;
+                next_distance = distance;
+            }
+        }
+
+        const auto& box = blocks[next];
+        tesseract.SetRectangle(box.x1, box.y1, box.width(), box.height());
+        if (tesseract.Recognize(nullptr) != 0) {
+            throw std::runtime_error("Failed to recognize block");
+        }
+        TesseractRenderer::append_paragraphs(&tesseract, block_paragraphs[next]);
+        block_done[next] = true;
+
+        if (on_block_recognized) {
+            on_block_recognized(block_paragraphs[next]);
+        }
+    }
+
+    std::vector<OcrParagraph> paragraphs;
+    for (auto& paragraphs_in_block : block_paragraphs) {
+        std::move(paragraphs_in_block.begin(), paragraphs_in_block.end(),
+                  std::back_inserter(paragraphs));
+    }
+    return paragraphs;
+}
+
 } // namespace sanescan
 
@@ -21,20 +21,81 @@
 
 #include "ocr_paragraph.h"
 #include "ocr_options.h"
+#include "ocr_profile.h"
 #include "ocr_results.h"
 #include <opencv2/core/mat.hpp>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
+struct Pix;
+
 namespace sanescan {
 
+/** Converts 8-bit 1 or 3 channel image to a 32-bit leptonica image. The caller takes ownership
+    of the returned image and must release it via pixDestroy().
+*/
+Pix* cv_mat_to_pix(const cv::Mat& image);
+
+/// Returns the version of the Tesseract library
+std::string tesseract_version();
+
+/** Returns the directory containing the Tesseract models of the given type. If the models of
+    the requested type are not installed, the directory of the standard models is returned.
+*/
+std::string get_tessdata_path(OcrModelType model_type);
+
+struct TesseractRecognizerConfig {
+    OcrModelType model_type = OcrModelType::STANDARD;
+    OcrPageSegMode page_seg_mode = OcrPageSegMode::SPARSE_TEXT_OSD;
+
+    // Languages to load in the format accepted by Tesseract, e.g. "eng+deu"
+    std::string languages = "eng";
+
+    auto operator<=>(const TesseractRecognizerConfig&) const = default;
+};
+
+struct OcrScriptDetection {
+    // The script name as used by Tesseract, e.g. "Latin"
+    std::string script;
+    double confidence = 0;
+};
+
 class TesseractRecognizer {
 public:
-    TesseractRecognizer(const std::string& tesseract_datapath);
+    explicit TesseractRecognizer(const TesseractRecognizerConfig& config = {});
     ~TesseractRecognizer();
 
     std::vector<OcrParagraph> recognize(const cv::Mat& image);
 
+    /** Recognizes the image assuming that it contains a single line of text. This is useful to
+        redo the recognition of individual lines that have been recognized poorly in the context
+        of the whole page.
+    */
+    std::vector<OcrParagraph> recognize_single_line(const cv::Mat& image);
+
+    /** Recognizes text in the image one layout block at a time. The paragraphs are returned in
+        layout order just like recognize() does. Additionally, on_block_recognized is called with
+        the paragraphs of each block as soon as the block is recognized.
+
+        Blocks closest to the area returned by get_priority_area are recognized first. The
+        function is called before each block, so the priority area may change while recognition
+        is in progress. An empty area means that blocks are recognized in layout order.
+    */
+    std::vector<OcrParagraph> recognize_by_blocks(
+            const cv::Mat& image,
+            const std::function<OcrBox()>& get_priority_area,
+            const std::function<void(const std::vector<OcrParagraph>&)>& on_block_recognized);
+
+    /** Detects the dominant script of the text in the image. The recognizer must be created
+        with the "osd" language. Returns nothing if the script could not be detected.
+    */
+    std::optional<OcrScriptDetection> detect_script(const cv::Mat& image);
+
+    const TesseractRecognizerConfig& config() const;
+
 private:
     struct Private;
     std::unique_ptr<Private> data_;
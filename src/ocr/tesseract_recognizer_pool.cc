@@ -0,0 +1,109 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "tesseract_recognizer_pool.h"
+#include "util/telemetry.h"
+#include <algorithm>
+#include <thread>
+
+namespace sanescan {
+
+void TesseractRecognizerPool::Releaser::operator()(TesseractRecognizer* recognizer) const
+{
+    pool->release(recognizer);
+}
+
+TesseractRecognizerPool& TesseractRecognizerPool::instance()
+{
+    static auto thread_count = std::max(1u, std::thread::hardware_concurrency());
+    static TesseractRecognizerPool pool{thread_count, thread_count * 2};
+    return pool;
+}
+
+TesseractRecognizerPool::TesseractRecognizerPool(std::size_t max_idle_per_config,
+                                                 std::size_t max_idle_total) :
+    max_idle_per_config_{max_idle_per_config},
+    max_idle_total_{max_idle_total}
+{
+}
+
+TesseractRecognizerPool::~TesseractRecognizerPool() = default;
+
+TesseractRecognizerPool::Handle
+    TesseractRecognizerPool::acquire(const TesseractRecognizerConfig& config)
+{
+    static auto& hits_counter = TelemetryRegistry::instance().counter("ocr.recognizer_pool.hits");
+    static auto& misses_counter =
+            TelemetryRegistry::instance().counter("ocr.recognizer_pool.misses");
+    {
+        std::lock_guard lock{mutex_};
+        auto it = idle_recognizers_.find(config);
+        if (it != idle_recognizers_.end() && !it->second.recognizers.empty()) {
+            auto recognizer = std::move(it->second.recognizers.back());
+            it->second.recognizers.pop_back();
+            idle_count_--;
+            hits_counter.add();
+            return Handle{recognizer.release(), Releaser{this}};
+        }
+    }
+
+    // Initialization is slow, so it is done without holding the lock
+    misses_counter.add();
+    return Handle{new TesseractRecognizer(config), Releaser{this}};
+}
+
+void TesseractRecognizerPool::clear()
+{
+    std::lock_guard lock{mutex_};
+    idle_recognizers_.clear();
+    idle_count_ = 0;
+}
+
+void TesseractRecognizerPool::release(TesseractRecognizer* recognizer)
+{
+    // Recognizers are destroyed without holding the lock
+    std::vector<std::unique_ptr<TesseractRecognizer>> to_destroy;
+    to_destroy.emplace_back(recognizer);
+
+    std::lock_guard lock{mutex_};
+    auto& idle = idle_recognizers_[recognizer->config()];
+    idle.last_release = ++release_counter_;
+    if (idle.recognizers.size() >= max_idle_per_config_) {
+        return;
+    }
+    idle.recognizers.push_back(std::move(to_destroy.back()));
+    to_destroy.pop_back();
+    idle_count_++;
+
+    while (idle_count_ > max_idle_total_) {
+        auto lru_it = idle_recognizers_.end();
+        for (auto it = idle_recognizers_.begin(); it != idle_recognizers_.end(); ++it) {
+            if (!it->second.recognizers.empty() &&
+                    (lru_it == idle_recognizers_.end() ||
+                     it->second.last_release < lru_it->second.last_release)) {
+                lru_it = it;
+            }
+        }
+        to_destroy.push_back(std::move(lru_it->second.recognizers.back()));
+        lru_it->second.recognizers.pop_back();
+        idle_count_--;
+    }
+}
+
+} // namespace sanescan
@@ -0,0 +1,80 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_OCR_TESSERACT_RECOGNIZER_POOL_H
+#define SANESCAN_OCR_TESSERACT_RECOGNIZER_POOL_H
+
+#include "tesseract.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sanescan {
+
+/*  Keeps initialized recognizers for reuse. Initialization of a recognizer loads the language
+    models which takes a significant fraction of the time needed to recognize a page. Idle
+    recognizers are kept separately for each configuration, e.g. for each set of languages. When
+    the total number of idle recognizers exceeds the limit, the recognizers of the least recently
+    used configurations are destroyed first, so the memory usage stays proportional to what is
+    actually in use.
+*/
+class TesseractRecognizerPool {
+    struct Releaser {
+        TesseractRecognizerPool* pool = nullptr;
+        void operator()(TesseractRecognizer* recognizer) const;
+    };
+
+public:
+    using Handle = std::unique_ptr<TesseractRecognizer, Releaser>;
+
+    static TesseractRecognizerPool& instance();
+
+    TesseractRecognizerPool(std::size_t max_idle_per_config, std::size_t max_idle_total);
+    ~TesseractRecognizerPool();
+
+    /** Returns an idle recognizer with the given configuration or creates a new one. The
+        recognizer is returned to the pool when the handle is destroyed.
+    */
+    Handle acquire(const TesseractRecognizerConfig& config);
+
+    /// Destroys all idle recognizers
+    void clear();
+
+private:
+    void release(TesseractRecognizer* recognizer);
+
+    struct IdleRecognizers {
+        std::vector<std::unique_ptr<TesseractRecognizer>> recognizers;
+        std::uint64_t last_release = 0;
+    };
+
+    std::mutex mutex_;
+    std::size_t max_idle_per_config_ = 0;
+    std::size_t max_idle_total_ = 0;
+    std::size_t idle_count_ = 0;
+    std::uint64_t release_counter_ = 0;
+    std::map<TesseractRecognizerConfig, IdleRecognizers> idle_recognizers_;
+};
+
+} // namespace sanescan
+
+#endif // SANESCAN_OCR_TESSERACT_RECOGNIZER_POOL_H
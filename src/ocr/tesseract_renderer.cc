@@ -18,6 +18,7 @@
 
 #include "tesseract_renderer.h"
 #include "tesseract_renderer_utils.h"
+#include "ocr_utils.h"
 #include <tesseract/baseapi.h>
 #include <memory>
 #include <stdexcept>
@@ -36,28 +37,27 @@ bool TesseractRenderer::BeginDocumentHandler()
 }
 
 bool TesseractRenderer::AddImageHandler(tesseract::TessBaseAPI *api)
+{
+    append_paragraphs(api, paragraphs_);
+    return true;
+}
+
+void TesseractRenderer::append_paragraphs(tesseract::TessBaseAPI* api,
+                                          std::vector<OcrParagraph>& paragraphs)
 {
     std::unique_ptr<tesseract::ResultIterator> it(api->GetIterator());
+    if (!it) {
+        return;
+    }
 
     OcrParagraph* curr_par = nullptr;
     OcrLine* curr_line = nullptr;
     float curr_row_height = 0;
 
     while (!it->Empty(tesseract::RIL_BLOCK)) {
-        int left, top, right, bottom;
-        auto block_type = it->BlockType();
-        switch (block_type) {
-            case tesseract::PT_FLOWING_IMAGE:
-            case tesseract::PT_HEADING_IMAGE:
-            case tesseract::PT_PULLOUT_IMAGE:
-            case tesseract::PT_HORZ_LINE:
-            case tesseract::PT_VERT_LINE:
-            case tesseract::PT_NOISE: {
-                it->Next(tesseract::RIL_BLOCK);
-                continue;
-            }
-            default:
-                break;
+        if (!is_text_block_type(it->BlockType())) {
+            it->Next(tesseract::RIL_BLOCK);
+            continue;
         }
 
         if (it->Empty(tesseract::RIL_WORD)) {
@@ -66,8 +66,8 @@ bool TesseractRenderer::AddImageHandler(tesseract::TessBaseAPI *api)
         }
 
         if (it->IsAtBeginningOf(tesseract::RIL_PARA)) {
-            paragraphs_.emplace_back();
-            curr_par = &paragraphs_.back();
+            paragraphs.emplace_back();
+            curr_par = &paragraphs.back();
             curr_par->box = get_box_for_level(it, tesseract::RIL_PARA);
         }
 
@@ -98,16 +98,23 @@ bool TesseractRenderer::AddImageHandler(tesseract::TessBaseAPI *api)
         curr_word.font_size = curr_row_height;
         curr_word.confidence = it->Confidence(tesseract::RIL_WORD) / 100.0;
 
+        // The text of the word is the concatenation of the text of its symbols, so it's retrieved
+        // once per word instead of allocating a separate string for each symbol. Only the boxes
+        // are retrieved for each symbol.
+        std::unique_ptr<const char[]> word_text(it->GetUTF8Text(tesseract::RIL_WORD));
+        bool has_text = word_text && word_text[0] != 0;
+        if (has_text) {
+            curr_word.content.assign(word_text.get());
+            curr_word.char_boxes.reserve(count_utf8_chars(curr_word.content));
+        }
+
         do {
-            std::unique_ptr<const char[]> grapheme(it->GetUTF8Text(tesseract::RIL_SYMBOL));
-            if (grapheme && grapheme[0] != 0) {
+            if (has_text) {
                 curr_word.char_boxes.push_back(get_box_for_level(it, tesseract::RIL_SYMBOL));
-                curr_word.content += grapheme.get();
             }
             it->Next(tesseract::RIL_SYMBOL);
         } while (!it->Empty(tesseract::RIL_BLOCK) && !it->IsAtBeginningOf(tesseract::RIL_WORD));
     }
-    return true;
 }
 
 bool TesseractRenderer::EndDocumentHandler()
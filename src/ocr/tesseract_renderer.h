@@ -29,6 +29,12 @@ public:
     explicit TesseractRenderer();
 
     const std::vector<OcrParagraph>& get_paragraphs() const { return paragraphs_; }
+
+    /** Appends paragraphs from the current recognition results of the given Tesseract instance.
+        Blocks that don't contain text are skipped.
+    */
+    static void append_paragraphs(tesseract::TessBaseAPI* api,
+                                  std::vector<OcrParagraph>& paragraphs);
 protected:
     bool BeginDocumentHandler() override;
     bool AddImageHandler(tesseract::TessBaseAPI *api) override;
@@ -27,6 +27,21 @@
 
 namespace sanescan {
 
+inline bool is_text_block_type(decltype(tesseract::PT_NOISE) type)
+{
+    switch (type) {
+        case tesseract::PT_FLOWING_IMAGE:
+        case tesseract::PT_HEADING_IMAGE:
+        case tesseract::PT_PULLOUT_IMAGE:
+        case tesseract::PT_HORZ_LINE:
+        case tesseract::PT_VERT_LINE:
+        case tesseract::PT_NOISE:
+            return false;
+        default:
+            return true;
+    }
+}
+
 inline OcrBox get_box_for_level(const std::unique_ptr<tesseract::ResultIterator>& it,
                                 tesseract::PageIteratorLevel level)
 {
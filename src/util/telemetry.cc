@@ -0,0 +1,203 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "telemetry.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+namespace sanescan {
+
+namespace {
+
+std::size_t get_bucket_index(std::uint64_t duration_us)
+{
+    return std::min<std::size_t>(std::bit_width(duration_us),
+                                 TelemetryHistogram::BUCKET_COUNT - 1);
+}
+
+// Returns the upper bound of the durations that fall into the bucket
+double get_bucket_upper_bound_sec(std::size_t index)
+{
+    return static_cast<double>(std::uint64_t{1} << index) / 1e6;
+}
+
+void write_json_string(std::ostream& stream, const std::string& str)
+{
+    stream << '"';
+    for (auto ch : str) {
+        if (ch == '"' || ch == '\\') {
+            stream << '\\';
+        }
+        stream << ch;
+    }
+    stream << '"';
+}
+
+} // namespace
+
+void TelemetryHistogram::record(double duration_sec)
+{
+    auto duration_us = static_cast<std::uint64_t>(std::max(0.0, duration_sec * 1e6));
+    buckets_[get_bucket_index(duration_us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(duration_us, std::memory_order_relaxed);
+
+    auto prev_max = max_us_.load(std::memory_order_relaxed);
+    while (prev_max < duration_us &&
+           !max_us_.compare_exchange_weak(prev_max, duration_us, std::memory_order_relaxed)) {
+    }
+}
+
+TelemetryHistogramSnapshot TelemetryHistogram::snapshot() const
+{
+    std::array<std::uint64_t, BUCKET_COUNT> buckets;
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+        buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += buckets[i];
+    }
+
+    TelemetryHistogramSnapshot result;
+    result.count = total;
+    result.sum_sec = sum_us_.load(std::memory_order_relaxed) / 1e6;
+    result.max_sec = max_us_.load(std::memory_order_relaxed) / 1e6;
+
+    auto percentile = [&](double fraction)
+    {
+        auto rank = static_cast<std::uint64_t>(std::ceil(fraction * total));
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+            cumulative += buckets[i];
+            if (cumulative >= rank && cumulative > 0) {
+                return std::min(get_bucket_upper_bound_sec(i), result.max_sec);
+            }
+        }
+        return result.max_sec;
+    };
+
+    result.p50_sec = percentile(0.5);
+    result.p90_sec = percentile(0.9);
+    result.p99_sec = percentile(0.99);
+    return result;
+}
+
+TelemetryRegistry::TelemetryRegistry() :
+    start_time_{std::chrono::steady_clock::now()}
+{
+}
+
+TelemetryRegistry& TelemetryRegistry::instance()
+{
+    static TelemetryRegistry registry;
+    return registry;
+}
+
+TelemetryCounter& TelemetryRegistry::counter(const std::string& name)
+{
+    std::lock_guard lock{mutex_};
+    auto& ptr = counters_[name];
+    if (!ptr) {
+        ptr = std::make_unique<TelemetryCounter>();
+    }
+    return *ptr;
+}
+
+TelemetryGauge& TelemetryRegistry::gauge(const std::string& name)
+{
+    std::lock_guard lock{mutex_};
+    auto& ptr = gauges_[name];
+    if (!ptr) {
+        ptr = std::make_unique<TelemetryGauge>();
+    }
+    return *ptr;
+}
+
+TelemetryHistogram& TelemetryRegistry::histogram(const std::string& name)
+{
+    std::lock_guard lock{mutex_};
+    auto& ptr = histograms_[name];
+    if (!ptr) {
+        ptr = std::make_unique<TelemetryHistogram>();
+    }
+    return *ptr;
+}
+
+TelemetrySnapshot TelemetryRegistry::snapshot() const
+{
+    std::lock_guard lock{mutex_};
+
+    TelemetrySnapshot result;
+    std::chrono::duration<double> uptime = std::chrono::steady_clock::now() - start_time_;
+    result.uptime_sec = uptime.count();
+    for (const auto& [name, counter] : counters_) {
+        result.counters[name] = counter->value();
+    }
+    for (const auto& [name, gauge] : gauges_) {
+        result.gauges[name] = gauge->value();
+    }
+    for (const auto& [name, histogram] : histograms_) {
+        result.histograms[name] = histogram->snapshot();
+    }
+    return result;
+}
+
+void write_telemetry_json(std::ostream& stream, const TelemetrySnapshot& snapshot)
+{
+    stream.imbue(std::locale::classic());
+    stream << std::setprecision(9);
+    stream << "{\n  \"uptime_sec\": " << snapshot.uptime_sec << ",\n  \"counters\": {";
+
+    const char* separator = "";
+    for (const auto& [name, value] : snapshot.counters) {
+        stream << separator << "\n    ";
+        write_json_string(stream, name);
+        stream << ": " << value;
+        separator = ",";
+    }
+
+    stream << "\n  },\n  \"gauges\": {";
+    separator = "";
+    for (const auto& [name, value] : snapshot.gauges) {
+        stream << separator << "\n    ";
+        write_json_string(stream, name);
+        stream << ": " << value;
+        separator = ",";
+    }
+
+    stream << "\n  },\n  \"histograms\": {";
+    separator = "";
+    for (const auto& [name, h] : snapshot.histograms) {
+        stream << separator << "\n    ";
+        write_json_string(stream, name);
+        stream << ": {\"count\": " << h.count
+               << ", \"sum_sec\": " << h.sum_sec
+               << ", \"mean_sec\": " << h.mean_sec()
+               << ", \"p50_sec\": " << h.p50_sec
+               << ", \"p90_sec\": " << h.p90_sec
+               << ", \"p99_sec\": " << h.p99_sec
+               << ", \"max_sec\": " << h.max_sec << "}";
+        separator = ",";
+    }
+    stream << "\n  }\n}\n";
+}
+
+} // namespace sanescan
@@ -0,0 +1,164 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_UTIL_TELEMETRY_H
+#define SANESCAN_UTIL_TELEMETRY_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*  Process-wide registry of runtime metrics. Unlike tracing, telemetry is always enabled and is
+    intended for live inspection of the application, so all updates are lock-free atomic
+    operations. Metrics are looked up by name once and the returned references stay valid for
+    the lifetime of the process.
+*/
+
+namespace sanescan {
+
+/// A monotonically increasing value, e.g. the number of processed pages
+class TelemetryCounter {
+public:
+    void add(std::uint64_t value = 1) { value_.fetch_add(value, std::memory_order_relaxed); }
+    std::uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> value_ = 0;
+};
+
+/// A value that may go up and down, e.g. the length of a queue
+class TelemetryGauge {
+public:
+    void set(std::int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(std::int64_t value) { value_.fetch_add(value, std::memory_order_relaxed); }
+    std::int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> value_ = 0;
+};
+
+struct TelemetryHistogramSnapshot {
+    std::uint64_t count = 0;
+    double sum_sec = 0;
+    double max_sec = 0;
+    double p50_sec = 0;
+    double p90_sec = 0;
+    double p99_sec = 0;
+
+    double mean_sec() const { return count == 0 ? 0 : sum_sec / count; }
+};
+
+/** A histogram of durations with exponential buckets. Bucket i contains durations in the range
+    [2^(i-1), 2^i) microseconds, so the percentiles are accurate within a factor of 2.
+*/
+class TelemetryHistogram {
+public:
+    static constexpr std::size_t BUCKET_COUNT = 32;
+
+    void record(double duration_sec);
+
+    template<class Duration>
+    void record(Duration duration)
+    {
+        record(std::chrono::duration<double>(duration).count());
+    }
+
+    TelemetryHistogramSnapshot snapshot() const;
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> buckets_ = {};
+    std::atomic<std::uint64_t> count_ = 0;
+    std::atomic<std::uint64_t> sum_us_ = 0;
+    std::atomic<std::uint64_t> max_us_ = 0;
+};
+
+struct TelemetrySnapshot {
+    double uptime_sec = 0;
+    std::map<std::string, std::uint64_t> counters;
+    std::map<std::string, std::int64_t> gauges;
+    std::map<std::string, TelemetryHistogramSnapshot> histograms;
+};
+
+class TelemetryRegistry {
+public:
+    static TelemetryRegistry& instance();
+
+    TelemetryCounter& counter(const std::string& name);
+    TelemetryGauge& gauge(const std::string& name);
+    TelemetryHistogram& histogram(const std::string& name);
+
+    TelemetrySnapshot snapshot() const;
+
+private:
+    TelemetryRegistry();
+
+    mutable std::mutex mutex_;
+    std::chrono::steady_clock::time_point start_time_;
+    std::map<std::string, std::unique_ptr<TelemetryCounter>> counters_;
+    std::map<std::string, std::unique_ptr<TelemetryGauge>> gauges_;
+    std::map<std::string, std::unique_ptr<TelemetryHistogram>> histograms_;
+};
+
+void write_telemetry_json(std::ostream& stream, const TelemetrySnapshot& snapshot);
+
+/** Locks the mutex and records how long the caller had to wait if the mutex was contended.
+    Uncontended acquisitions are counted in acquisitions so that the fraction of contended ones
+    can be computed.
+*/
+template<class Mutex>
+std::unique_lock<Mutex> lock_with_telemetry(Mutex& mutex, TelemetryCounter& acquisitions,
+                                            TelemetryHistogram& contended_waits)
+{
+    acquisitions.add();
+    std::unique_lock lock{mutex, std::try_to_lock};
+    if (!lock.owns_lock()) {
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        contended_waits.record(std::chrono::steady_clock::now() - start);
+    }
+    return lock;
+}
+
+/// Telemetry of a mutex as used by lock_with_telemetry()
+struct TelemetryMutexStats {
+    explicit TelemetryMutexStats(const std::string& prefix) :
+        acquisitions{TelemetryRegistry::instance().counter(prefix + ".lock_acquisitions")},
+        contended_waits{TelemetryRegistry::instance().histogram(prefix + ".lock_wait")}
+    {}
+
+    TelemetryCounter& acquisitions;
+    TelemetryHistogram& contended_waits;
+};
+
+template<class Mutex>
+std::unique_lock<Mutex> lock_with_telemetry(Mutex& mutex, TelemetryMutexStats& stats)
+{
+    return lock_with_telemetry(mutex, stats.acquisitions, stats.contended_waits);
+}
+
+} // namespace sanescan
+
+#endif // SANESCAN_UTIL_TELEMETRY_H
@@ -0,0 +1,246 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "trace.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace sanescan {
+
+namespace internal {
+std::atomic<bool> g_trace_enabled = false;
+} // namespace internal
+
+namespace {
+
+struct TraceEvent {
+    // Chrome trace event phase: 'X' for complete events, 'i' for instant, 'C' for counters
+    char phase = 'X';
+    const char* category = nullptr;
+    const char* name = nullptr;
+    std::int64_t timestamp_us = 0;
+    std::int64_t duration_us = 0;
+    double value = 0;
+    int thread_id = 0;
+};
+
+struct TraceState {
+    std::mutex mutex;
+    std::string output_path;
+    std::vector<TraceEvent> events;
+    std::vector<std::pair<int, std::string>> thread_names;
+};
+
+TraceState& get_trace_state()
+{
+    static TraceState state;
+    return state;
+}
+
+std::chrono::steady_clock::time_point get_trace_epoch()
+{
+    static auto epoch = std::chrono::steady_clock::now();
+    return epoch;
+}
+
+int get_trace_thread_id()
+{
+    static std::atomic<int> next_thread_id = 1;
+    thread_local int thread_id = next_thread_id++;
+    return thread_id;
+}
+
+void add_event(TraceEvent&& event)
+{
+    auto& state = get_trace_state();
+    std::lock_guard lock{state.mutex};
+    if (!trace_enabled()) {
+        return;
+    }
+    state.events.push_back(std::move(event));
+}
+
+void write_json_string(std::ostream& stream, const std::string& str)
+{
+    stream << '"';
+    for (auto ch : str) {
+        switch (ch) {
+            case '"': stream << "\\\""; break;
+            case '\\': stream << "\\\\"; break;
+            case '\n': stream << "\\n"; break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    stream << ' ';
+                } else {
+                    stream << ch;
+                }
+        }
+    }
+    stream << '"';
+}
+
+void write_trace(std::ostream& stream, const std::vector<TraceEvent>& events,
+                 const std::vector<std::pair<int, std::string>>& thread_names)
+{
+    stream.imbue(std::locale::classic());
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    auto separator = [&]()
+    {
+        if (!first) {
+            stream << ",\n";
+        }
+        first = false;
+    };
+
+    for (const auto& [thread_id, name] : thread_names) {
+        separator();
+        stream << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread_id
+               << ",\"args\":{\"name\":";
+        write_json_string(stream, name);
+        stream << "}}";
+    }
+
+    for (const auto& event : events) {
+        separator();
+        stream << "{\"ph\":\"" << event.phase << "\",\"name\":";
+        write_json_string(stream, event.name);
+        if (event.category != nullptr) {
+            stream << ",\"cat\":";
+            write_json_string(stream, event.category);
+        }
+        stream << ",\"pid\":1,\"tid\":" << event.thread_id << ",\"ts\":" << event.timestamp_us;
+        switch (event.phase) {
+            case 'X':
+                stream << ",\"dur\":" << event.duration_us;
+                break;
+            case 'i':
+                stream << ",\"s\":\"t\"";
+                break;
+            case 'C':
+                stream << ",\"args\":{\"value\":" << std::setprecision(15) << event.value << "}";
+                break;
+            default:
+                break;
+        }
+        stream << "}";
+    }
+    stream << "\n]}\n";
+}
+
+} // namespace
+
+std::int64_t trace_now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - get_trace_epoch()).count();
+}
+
+void trace_start(const std::string& output_path)
+{
+    get_trace_epoch();
+    auto& state = get_trace_state();
+    std::lock_guard lock{state.mutex};
+    state.output_path = output_path;
+    state.events.clear();
+    internal::g_trace_enabled = true;
+}
+
+bool trace_start_from_env()
+{
+    const char* path = std::getenv(TRACE_ENV_VARIABLE);
+    if (path == nullptr || *path == '\0') {
+        return false;
+    }
+    trace_start(path);
+    return true;
+}
+
+void trace_stop()
+{
+    auto& state = get_trace_state();
+    std::vector<TraceEvent> events;
+    std::vector<std::pair<int, std::string>> thread_names;
+    std::string output_path;
+    {
+        std::lock_guard lock{state.mutex};
+        if (!trace_enabled()) {
+            return;
+        }
+        internal::g_trace_enabled = false;
+        std::swap(events, state.events);
+        thread_names = state.thread_names;
+        output_path = state.output_path;
+    }
+
+    std::ofstream stream(output_path);
+    if (!stream) {
+        throw std::runtime_error("Could not open trace output file " + output_path);
+    }
+    write_trace(stream, events, thread_names);
+}
+
+void trace_set_thread_name(const std::string& name)
+{
+    auto thread_id = get_trace_thread_id();
+    auto& state = get_trace_state();
+    std::lock_guard lock{state.mutex};
+    for (auto& [id, existing_name] : state.thread_names) {
+        if (id == thread_id) {
+            existing_name = name;
+            return;
+        }
+    }
+    state.thread_names.emplace_back(thread_id, name);
+}
+
+void trace_complete(const char* category, const char* name,
+                    std::int64_t start_us, std::int64_t end_us)
+{
+    if (!trace_enabled()) {
+        return;
+    }
+    add_event(TraceEvent{'X', category, name, start_us, end_us - start_us, 0,
+                         get_trace_thread_id()});
+}
+
+void trace_instant(const char* category, const char* name)
+{
+    if (!trace_enabled()) {
+        return;
+    }
+    add_event(TraceEvent{'i', category, name, trace_now_us(), 0, 0, get_trace_thread_id()});
+}
+
+void trace_counter(const char* name, double value)
+{
+    if (!trace_enabled()) {
+        return;
+    }
+    add_event(TraceEvent{'C', nullptr, name, trace_now_us(), 0, value, get_trace_thread_id()});
+}
+
+} // namespace sanescan
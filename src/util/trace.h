@@ -0,0 +1,108 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef SANESCAN_UTIL_TRACE_H
+#define SANESCAN_UTIL_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/*  Lightweight tracing that produces Chrome trace-event JSON files viewable in chrome://tracing
+    or https://ui.perfetto.dev. When tracing is disabled, spans and counters cost a single relaxed
+    atomic load.
+
+    All category and name arguments must be string literals or otherwise outlive the trace, as
+    only the pointers are stored.
+*/
+
+namespace sanescan {
+
+namespace internal {
+extern std::atomic<bool> g_trace_enabled;
+} // namespace internal
+
+/// The environment variable that enables tracing. Its value is the path to the output file.
+inline constexpr const char* TRACE_ENV_VARIABLE = "SANESCAN_TRACE";
+
+inline bool trace_enabled()
+{
+    return internal::g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+/// Returns the current time in microseconds in the timebase of the trace
+std::int64_t trace_now_us();
+
+/// Starts recording the trace. The results are written to output_path when trace_stop is called.
+void trace_start(const std::string& output_path);
+
+/// Starts recording the trace if TRACE_ENV_VARIABLE is set. Returns true if tracing was started.
+bool trace_start_from_env();
+
+/// Stops recording the trace and writes it to the file. Does nothing if tracing is not enabled.
+void trace_stop();
+
+/// Sets the name of the current thread as shown in the trace viewer
+void trace_set_thread_name(const std::string& name);
+
+/// Records a span that started and finished at the given times
+void trace_complete(const char* category, const char* name,
+                    std::int64_t start_us, std::int64_t end_us);
+
+/// Records a single point in time
+void trace_instant(const char* category, const char* name);
+
+/// Records the current value of a counter
+void trace_counter(const char* name, double value);
+
+/// Records a span covering the lifetime of the object
+class TraceSpan {
+public:
+    TraceSpan(const char* category, const char* name) :
+        category_{category},
+        name_{name},
+        start_us_{trace_enabled() ? trace_now_us() : -1}
+    {}
+
+    ~TraceSpan()
+    {
+        if (start_us_ >= 0) {
+            trace_complete(category_, name_, start_us_, trace_now_us());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* category_ = nullptr;
+    const char* name_ = nullptr;
+    std::int64_t start_us_ = -1;
+};
+
+} // namespace sanescan
+
+#define SANESCAN_TRACE_CONCAT_IMPL(a, b) a##b
+#define SANESCAN_TRACE_CONCAT(a, b) SANESCAN_TRACE_CONCAT_IMPL(a, b)
+
+/// Records a span covering the rest of the enclosing scope
+#define SANESCAN_TRACE_SPAN(category, name) \
+    ::sanescan::TraceSpan SANESCAN_TRACE_CONCAT(sanescan_trace_span_, __LINE__){category, name}
+
+#endif // SANESCAN_UTIL_TRACE_H
@@ -0,0 +1,107 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "../ocr/ocr_test_utils.h"
+#include "gui/font_metrics_cache.h"
+#include "gui/ocr_overlay_data.h"
+#include "ocr/ocr_geometry.h"
+#include <QtGui/QGuiApplication>
+#include <gtest/gtest.h>
+#include <cmath>
+
+namespace sanescan {
+
+namespace {
+
+void ensure_application()
+{
+    // Fonts can't be used without an application. The offscreen platform does not need a display.
+    static int argc = 1;
+    static char arg0[] = "unittest";
+    static char* argv[] = {arg0, nullptr};
+    if (QGuiApplication::instance() == nullptr) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+        static QGuiApplication app{argc, argv};
+    }
+}
+
+OcrOverlayData prepare_test_overlay(const std::vector<OcrParagraph>& paragraphs)
+{
+    ensure_application();
+    FontMetricsCache metrics_cache{"times"};
+    OcrResults results;
+    results.adjusted_paragraphs = paragraphs;
+    return prepare_ocr_overlay(results, metrics_cache);
+}
+
+void expect_near(const QPointF& p1, const QPointF& p2)
+{
+    EXPECT_NEAR(p1.x(), p2.x(), 1e-3);
+    EXPECT_NEAR(p1.y(), p2.y(), 1e-3);
+}
+
+} // namespace
+
+TEST(OcrOverlayData, WordsOfRotatedPage)
+{
+    auto paragraphs = make_single_line_paragraphs();
+    auto overlay = prepare_test_overlay(paragraphs);
+
+    OcrGeometricEdit edit;
+    edit.type = OcrGeometricEditType::ROTATE_90_CW;
+    apply_geometric_edit(paragraphs, edit, 200, 100);
+    auto rotated_overlay = prepare_test_overlay(paragraphs);
+
+    // The overlay of the rotated page must be the overlay of the original page rotated the same
+    // way as the image: (x, y) maps to (100 - y, x).
+    QTransform page_transform;
+    page_transform.translate(100, 0);
+    page_transform.rotate(90);
+
+    ASSERT_EQ(overlay.words.size(), 2);
+    ASSERT_EQ(rotated_overlay.words.size(), 2);
+    for (std::size_t i = 0; i < overlay.words.size(); ++i) {
+        const auto& word = overlay.words[i];
+        const auto& rotated_word = rotated_overlay.words[i];
+
+        EXPECT_EQ(rotated_word.box, page_transform.mapRect(word.box));
+
+        ASSERT_EQ(rotated_word.background.size(), word.background.size());
+        for (int ip = 0; ip < word.background.size(); ++ip) {
+            expect_near(rotated_word.background[ip], page_transform.map(word.background[ip]));
+        }
+
+        ASSERT_EQ(rotated_word.glyph_runs.size(), word.glyph_runs.size());
+        for (std::size_t ir = 0; ir < word.glyph_runs.size(); ++ir) {
+            auto expected_transform = word.glyph_runs[ir].transform * page_transform;
+            const auto& transform = rotated_word.glyph_runs[ir].transform;
+            expect_near(transform.map(QPointF(0, 0)), expected_transform.map(QPointF(0, 0)));
+            expect_near(transform.map(QPointF(10, 0)), expected_transform.map(QPointF(10, 0)));
+            expect_near(transform.map(QPointF(0, 10)), expected_transform.map(QPointF(0, 10)));
+        }
+
+        ASSERT_EQ(rotated_word.char_boxes.size(), word.char_boxes.size());
+        for (std::size_t ic = 0; ic < word.char_boxes.size(); ++ic) {
+            EXPECT_EQ(rotated_word.char_boxes[ic], page_transform.mapRect(word.char_boxes[ic]));
+        }
+
+        EXPECT_TRUE(rotated_overlay.bounds.contains(rotated_word.background.boundingRect()));
+    }
+}
+
+} // namespace sanescan
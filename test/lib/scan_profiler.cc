@@ -0,0 +1,133 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "lib/scan_profiler.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace sanescan {
+
+namespace {
+
+ScanProfileResult make_result(const ScanProfileConfig& config, double total_duration_sec)
+{
+    ScanReadStats stats;
+    stats.total_bytes = 1000;
+    stats.total_duration_sec = total_duration_sec;
+    return ScanProfileResult{config, stats, {}};
+}
+
+SaneOptionDescriptor make_descriptor(const std::string& name, SaneValueType type)
+{
+    SaneOptionDescriptor desc;
+    desc.name = name;
+    desc.type = type;
+    desc.size = 1;
+    return desc;
+}
+
+} // namespace
+
+TEST(ScanProfiler, ParseDimension)
+{
+    auto dimension = parse_scan_profile_dimension("mode=Color,Gray");
+    ASSERT_EQ(dimension.option_name, "mode");
+    ASSERT_EQ(dimension.values, std::vector<std::string>({"Color", "Gray"}));
+
+    ASSERT_THROW(parse_scan_profile_dimension("mode"), std::invalid_argument);
+    ASSERT_THROW(parse_scan_profile_dimension("=Color"), std::invalid_argument);
+    ASSERT_THROW(parse_scan_profile_dimension("mode=Color,,Gray"), std::invalid_argument);
+}
+
+TEST(ScanProfiler, BuildMatrix)
+{
+    auto matrix = build_scan_profile_matrix({{"mode", {"Color", "Gray"}},
+                                             {"resolution", {"150", "300"}}});
+    std::vector<ScanProfileConfig> expected = {
+        {{"mode", "Color"}, {"resolution", "150"}},
+        {{"mode", "Color"}, {"resolution", "300"}},
+        {{"mode", "Gray"}, {"resolution", "150"}},
+        {{"mode", "Gray"}, {"resolution", "300"}},
+    };
+    ASSERT_EQ(matrix, expected);
+
+    ASSERT_EQ(build_scan_profile_matrix({}), std::vector<ScanProfileConfig>({{}}));
+}
+
+TEST(ScanProfiler, ParseOptionValue)
+{
+    auto desc_int = make_descriptor("resolution", SaneValueType::INT);
+    ASSERT_EQ(parse_sane_option_value(desc_int, "300"), SaneOptionValue(300));
+    ASSERT_THROW(parse_sane_option_value(desc_int, "300dpi"), std::invalid_argument);
+
+    auto desc_float = make_descriptor("br-y", SaneValueType::FLOAT);
+    ASSERT_EQ(parse_sane_option_value(desc_float, "50.5"), SaneOptionValue(50.5));
+
+    auto desc_bool = make_descriptor("preview", SaneValueType::BOOL);
+    ASSERT_EQ(parse_sane_option_value(desc_bool, "yes"), SaneOptionValue(true));
+    ASSERT_THROW(parse_sane_option_value(desc_bool, "maybe"), std::invalid_argument);
+
+    auto desc_string = make_descriptor("mode", SaneValueType::STRING);
+    desc_string.constraint = SaneConstraintStringList{{"Color", "Gray"}};
+    ASSERT_EQ(parse_sane_option_value(desc_string, "Gray"), SaneOptionValue(std::string("Gray")));
+    ASSERT_THROW(parse_sane_option_value(desc_string, "Lineart"), std::invalid_argument);
+}
+
+TEST(ScanProfiler, OptionValuesInRange)
+{
+    auto desc = make_descriptor("resolution", SaneValueType::INT);
+    desc.constraint = SaneConstraintIntList{{75, 150, 300, 600, 1200}};
+    ASSERT_EQ(get_option_values_in_range(desc, 300, 600),
+              std::vector<std::string>({"300", "600"}));
+
+    desc.constraint = SaneConstraintIntRange{50, 1200, 1};
+    ASSERT_EQ(get_option_values_in_range(desc, 250, 450),
+              std::vector<std::string>({"250", "300", "400", "450"}));
+    ASSERT_EQ(get_option_values_in_range(desc, 1300, 1400), std::vector<std::string>());
+}
+
+TEST(ScanProfiler, FindFastest)
+{
+    std::vector<ScanProfileResult> results = {
+        make_result({{"mode", "Color"}, {"resolution", "150"}}, 5),
+        make_result({{"mode", "Color"}, {"resolution", "300"}}, 20),
+        make_result({{"mode", "Gray"}, {"resolution", "300"}}, 10),
+        ScanProfileResult{{{"mode", "Gray"}, {"resolution", "600"}}, {}, "I/O error"},
+    };
+    ASSERT_EQ(find_fastest_scan_profile_result(results, 300), 2);
+    ASSERT_EQ(find_fastest_scan_profile_result(results, 100), 0);
+    ASSERT_FALSE(find_fastest_scan_profile_result(results, 600).has_value());
+}
+
+TEST(ScanProfiler, WriteTable)
+{
+    std::vector<ScanProfileResult> results = {
+        make_result({{"mode", "Color"}}, 5),
+        ScanProfileResult{{{"mode", "Gray"}}, {}, "I/O error"},
+    };
+    std::ostringstream stream;
+    write_scan_profile_table(stream, results);
+    auto expected = R"(mode   first line (s)  total (s)  MB/s  stalls  max stall (s)
+Color  0.00            5.00       0.00  0       0.00
+Gray   failed: I/O error
+)";
+    ASSERT_EQ(stream.str(), expected);
+}
+
+} // namespace sanescan
@@ -0,0 +1,102 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "lib/scan_read_stats.h"
+#include <gtest/gtest.h>
+
+namespace sanescan {
+
+namespace {
+
+using Clock = ScanReadStatsCollector::Clock;
+
+Clock::time_point at_ms(Clock::time_point start, int ms)
+{
+    return start + std::chrono::milliseconds(ms);
+}
+
+} // namespace
+
+TEST(ScanReadStats, NoData)
+{
+    ScanReadStatsCollector collector;
+    auto start = Clock::now();
+    collector.start(start);
+    collector.set_line_bytes(100);
+    collector.add_read(at_ms(start, 500), 0);
+
+    auto stats = collector.stats();
+    ASSERT_EQ(stats.total_bytes, 0);
+    ASSERT_EQ(stats.time_to_first_line_sec, 0);
+    ASSERT_EQ(stats.sustained_bytes_per_sec, 0);
+}
+
+TEST(ScanReadStats, FirstLineAndSustainedRate)
+{
+    ScanReadStatsCollector collector;
+    auto start = Clock::now();
+    collector.start(start);
+    collector.set_line_bytes(100);
+    collector.add_read(at_ms(start, 1000), 50);
+    collector.add_read(at_ms(start, 2000), 150);
+    collector.add_read(at_ms(start, 2050), 1000);
+    collector.add_read(at_ms(start, 2100), 1000);
+
+    auto stats = collector.stats();
+    ASSERT_EQ(stats.total_bytes, 2200);
+    ASSERT_NEAR(stats.time_to_first_line_sec, 2, 1e-9);
+    ASSERT_NEAR(stats.total_duration_sec, 2.1, 1e-9);
+    ASSERT_NEAR(stats.sustained_bytes_per_sec, 20000, 1e-6);
+    // The gap before the first complete line is warm-up, not a stall
+    ASSERT_EQ(stats.stall_count, 0);
+}
+
+TEST(ScanReadStats, Stalls)
+{
+    ScanReadStatsCollector collector{std::chrono::milliseconds(100)};
+    auto start = Clock::now();
+    collector.start(start);
+    collector.set_line_bytes(100);
+    collector.add_read(at_ms(start, 100), 100);
+    collector.add_read(at_ms(start, 150), 100);
+    collector.add_read(at_ms(start, 400), 100);
+    collector.add_read(at_ms(start, 450), 0);
+    collector.add_read(at_ms(start, 900), 100);
+    collector.add_read(at_ms(start, 950), 100);
+
+    auto stats = collector.stats();
+    ASSERT_EQ(stats.stall_count, 2);
+    ASSERT_NEAR(stats.max_stall_sec, 0.5, 1e-9);
+    ASSERT_NEAR(stats.total_stall_sec, 0.75, 1e-9);
+}
+
+TEST(ScanReadStats, StartResets)
+{
+    ScanReadStatsCollector collector;
+    auto start = Clock::now();
+    collector.start(start);
+    collector.set_line_bytes(100);
+    collector.add_read(at_ms(start, 100), 1000);
+
+    collector.start(at_ms(start, 1000));
+    auto stats = collector.stats();
+    ASSERT_EQ(stats.total_bytes, 0);
+    ASSERT_EQ(stats.total_duration_sec, 0);
+}
+
+} // namespace sanescan
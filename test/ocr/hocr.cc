@@ -135,4 +135,34 @@ TEST(Hocr, ParseSimpleFile)
     ASSERT_EQ(read_hocr(input), expected);
 }
 
+TEST(Hocr, WriteReadPreservesContent)
+{
+    OcrWord word_per_char;
+    word_per_char.box = {10, 10, 40, 20};
+    word_per_char.char_boxes = {{10, 10, 20, 20}, {20, 10, 30, 20}, {30, 10, 40, 20}};
+    word_per_char.content = "a\xc3\xa4b";
+
+    OcrWord word_mismatched;
+    word_mismatched.box = {50, 10, 70, 20};
+    word_mismatched.char_boxes = {{50, 10, 70, 20}};
+    word_mismatched.content = "xyz";
+
+    OcrLine line;
+    line.box = {10, 10, 70, 20};
+    line.words = {word_per_char, word_mismatched};
+
+    std::stringstream stream;
+    write_hocr(stream, {OcrParagraph{{line}, line.box}});
+    auto paragraphs = read_hocr(stream);
+
+    ASSERT_EQ(paragraphs.size(), 1);
+    ASSERT_EQ(paragraphs[0].lines.size(), 1);
+    const auto& words = paragraphs[0].lines[0].words;
+    ASSERT_EQ(words.size(), 2);
+    ASSERT_EQ(words[0].content, "a\xc3\xa4b");
+    ASSERT_EQ(words[0].char_boxes, word_per_char.char_boxes);
+    ASSERT_EQ(words[1].content, "xyz");
+    ASSERT_EQ(words[1].char_boxes, word_mismatched.char_boxes);
+}
+
 } // namespace sanescan
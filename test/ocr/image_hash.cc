@@ -0,0 +1,97 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr/image_hash.h"
+#include <opencv2/imgproc.hpp>
+#include <gtest/gtest.h>
+
+namespace sanescan {
+
+namespace {
+
+cv::Mat make_page_image(const cv::Rect& figure)
+{
+    cv::Mat image(800, 600, CV_8U, cv::Scalar(255));
+    for (int y = 60; y < 740; y += 50) {
+        cv::rectangle(image, cv::Rect(50, y, 500, 20), cv::Scalar(0), cv::FILLED);
+    }
+    cv::rectangle(image, figure, cv::Scalar(96), cv::FILLED);
+    return image;
+}
+
+} // namespace
+
+TEST(ImageHash, IdenticalImages)
+{
+    auto image = make_page_image(cv::Rect(50, 50, 200, 200));
+    auto hash = compute_image_hash(image);
+    ASSERT_EQ(hash, compute_image_hash(image.clone()));
+    ASSERT_EQ(get_hash_distance(hash, hash), 0);
+    ASSERT_TRUE(are_images_near_identical(image, image));
+}
+
+TEST(ImageHash, ResizedImages)
+{
+    auto image = make_page_image(cv::Rect(50, 50, 200, 200));
+    cv::Mat resized;
+    cv::resize(image, resized, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+    ASSERT_LE(get_hash_distance(compute_image_hash(image), compute_image_hash(resized)), 32);
+    ASSERT_TRUE(are_images_near_identical(image, resized));
+}
+
+TEST(ImageHash, DifferentImages)
+{
+    auto image = make_page_image(cv::Rect(50, 50, 200, 200));
+    auto other = make_page_image(cv::Rect(350, 500, 200, 200));
+    ASSERT_GT(get_hash_distance(compute_image_hash(image), compute_image_hash(other)), 8);
+    ASSERT_FALSE(are_images_near_identical(image, other));
+}
+
+TEST(ImageHash, DifferentAspectRatio)
+{
+    auto image = make_page_image(cv::Rect(50, 50, 200, 200));
+    ASSERT_FALSE(are_images_near_identical(image, image(cv::Rect(0, 0, 600, 700))));
+}
+
+TEST(ImageHash, IdenticalImagesAtFullResolution)
+{
+    auto image = make_page_image(cv::Rect(50, 50, 200, 200));
+    cv::Mat noisy = image + cv::Scalar(4);
+    ASSERT_TRUE(are_images_identical(image, noisy));
+
+    // A small mark is not visible at low resolution, but the images are no longer identical
+    cv::Mat marked = image.clone();
+    cv::rectangle(marked, cv::Rect(400, 100, 6, 10), cv::Scalar(0), cv::FILLED);
+    ASSERT_TRUE(are_images_near_identical(image, marked));
+    ASSERT_FALSE(are_images_identical(image, marked));
+
+    cv::Mat resized;
+    cv::resize(image, resized, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+    ASSERT_FALSE(are_images_identical(image, resized));
+}
+
+TEST(ImageHash, GetHashDistance)
+{
+    ImageHash a;
+    ImageHash b;
+    b.bits[0] = 0b1011;
+    b.bits[7] = std::uint64_t{1} << 63;
+    ASSERT_EQ(get_hash_distance(a, b), 4);
+}
+
+} // namespace sanescan
@@ -0,0 +1,105 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr_test_utils.h"
+#include "ocr/line_rerecognition.h"
+#include <gtest/gtest.h>
+
+namespace sanescan {
+
+TEST(LineRerecognition, GetLineScore)
+{
+    OcrLine line;
+    ASSERT_EQ(get_line_score(line), 0);
+
+    line.words = {
+        make_word("abcd", {}, 0.5),
+        make_word("\xc4\x85\xc4\x8d", {}, 1.0), // two 2-byte characters
+    };
+    ASSERT_DOUBLE_EQ(get_line_score(line), 4.0 / 6);
+}
+
+TEST(LineRerecognition, IsLineLengthChangeAcceptable)
+{
+    ASSERT_TRUE(is_line_length_change_acceptable(4, 6));
+    ASSERT_FALSE(is_line_length_change_acceptable(4, 7));
+    ASSERT_TRUE(is_line_length_change_acceptable(40, 50));
+    ASSERT_FALSE(is_line_length_change_acceptable(40, 51));
+    ASSERT_FALSE(is_line_length_change_acceptable(40, 29));
+}
+
+TEST(LineRerecognition, FindLowConfidenceLines)
+{
+    OcrLine good_line;
+    good_line.words = {make_word("good", {}, 0.9), make_word("line", {}, 0.8)};
+    OcrLine bad_line;
+    bad_line.words = {make_word("bad", {}, 0.9), make_word("l1ne", {}, 0.2)};
+
+    std::vector<OcrParagraph> paragraphs(2);
+    paragraphs[0].lines = {good_line, bad_line};
+    paragraphs[1].lines = {bad_line, good_line, bad_line};
+
+    ASSERT_EQ(find_low_confidence_lines(paragraphs, 0.5),
+              (std::vector<OcrLineLocation>{{0, 1}, {1, 0}, {1, 2}}));
+    ASSERT_TRUE(find_low_confidence_lines(paragraphs, 0.1).empty());
+}
+
+TEST(LineRerecognition, GetWordsWithinLine)
+{
+    OcrLine line_above;
+    line_above.words = {make_word("above", {0, 0, 50, 18}, 0.9)};
+    OcrLine line;
+    line.words = {
+        make_word("second", {60, 22, 120, 40}, 0.9),
+        make_word("first", {0, 20, 50, 40}, 0.9),
+    };
+    OcrLine line_below;
+    line_below.words = {make_word("below", {0, 38, 50, 60}, 0.9)};
+
+    std::vector<OcrParagraph> paragraphs(2);
+    paragraphs[0].lines = {line_above, line};
+    paragraphs[1].lines = {line_below};
+
+    auto words = get_words_within_line(paragraphs, OcrBox{0, 20, 120, 40});
+    ASSERT_EQ(words.size(), 2);
+    ASSERT_EQ(words[0].content, "first");
+    ASSERT_EQ(words[1].content, "second");
+}
+
+TEST(LineRerecognition, ReplaceLineWordsIfBetter)
+{
+    OcrLine line;
+    line.words = {make_word("go0d", {}, 0.9), make_word("w0rds", {}, 0.2)};
+
+    // Dropping part of the text is worse even if the remaining words are more confident
+    ASSERT_FALSE(replace_line_words_if_better(line, {make_word("good", {}, 0.95)}));
+    ASSERT_EQ(line.words[0].content, "go0d");
+
+    // Junk picked up from the neighbouring lines is not accepted even if it's confident
+    ASSERT_FALSE(replace_line_words_if_better(line, {make_word("good", {}, 0.9),
+                                                     make_word("words", {}, 0.8),
+                                                     make_word("~~~~~~~~", {}, 0.9)}));
+    ASSERT_EQ(line.words.size(), 2);
+
+    ASSERT_TRUE(replace_line_words_if_better(line, {make_word("good", {}, 0.9),
+                                                    make_word("words", {}, 0.8)}));
+    ASSERT_EQ(line.words.size(), 2);
+    ASSERT_EQ(line.words[1].content, "words");
+}
+
+} // namespace sanescan
@@ -0,0 +1,154 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr/ocr_batch_context.h"
+#include "util/math.h"
+#include <gtest/gtest.h>
+
+namespace sanescan {
+
+namespace {
+
+OcrPageObservation make_observation(const std::vector<std::string>& languages,
+                                    double orientation, bool has_ruled_lines,
+                                    double confidence = 0.9)
+{
+    OcrPageObservation observation;
+    observation.languages = languages;
+    observation.orientation = orientation;
+    observation.has_ruled_lines = has_ruled_lines;
+    observation.text_height = 30;
+    observation.mean_word_confidence = confidence;
+    return observation;
+}
+
+} // namespace
+
+TEST(OcrBatchContext, NoPriorsUntilPagesAgree)
+{
+    OcrBatchContext context{3, 0};
+    auto priors = context.priors_for_next_page();
+    ASSERT_FALSE(priors.languages.has_value());
+    ASSERT_FALSE(priors.orientation.has_value());
+    ASSERT_FALSE(priors.has_ruled_lines.has_value());
+    ASSERT_EQ(priors.text_height, 0);
+
+    context.add_page(make_observation({"eng"}, 0, false));
+    context.add_page(make_observation({"lit"}, 0, false));
+    priors = context.priors_for_next_page();
+    ASSERT_EQ(priors.text_height, 0);
+
+    context.add_page(make_observation({"eng"}, 0, false));
+    priors = context.priors_for_next_page();
+    ASSERT_FALSE(priors.languages.has_value());
+    ASSERT_EQ(priors.orientation, 0);
+    ASSERT_EQ(priors.has_ruled_lines, false);
+    ASSERT_DOUBLE_EQ(priors.text_height, 30);
+
+    context.add_page(make_observation({"eng"}, 0, true));
+    context.add_page(make_observation({"eng"}, 0, true));
+    priors = context.priors_for_next_page();
+    ASSERT_EQ(priors.languages, std::vector<std::string>{"eng"});
+    ASSERT_FALSE(priors.has_ruled_lines.has_value());
+}
+
+TEST(OcrBatchContext, UndeterminedPropertiesKeepEstimates)
+{
+    OcrBatchContext context{2, 0};
+    context.add_page(make_observation({"eng"}, 0, false));
+    context.add_page(make_observation({"eng"}, 0, false));
+
+    OcrPageObservation observation;
+    observation.mean_word_confidence = 0.9;
+    observation.used_priors = true;
+    context.add_page(observation);
+
+    auto priors = context.priors_for_next_page();
+    ASSERT_EQ(priors.languages, std::vector<std::string>{"eng"});
+    ASSERT_EQ(priors.has_ruled_lines, false);
+}
+
+TEST(OcrBatchContext, TextHeightAgreesWithinTolerance)
+{
+    OcrBatchContext context{2, 0};
+    auto observation = make_observation({"eng"}, 0, false);
+    context.add_page(observation);
+    observation.text_height = 32;
+    context.add_page(observation);
+    ASSERT_DOUBLE_EQ(context.priors_for_next_page().text_height, 30.4);
+
+    observation.text_height = 60;
+    context.add_page(observation);
+    ASSERT_EQ(context.priors_for_next_page().text_height, 0);
+
+    context.add_page(observation);
+    ASSERT_DOUBLE_EQ(context.priors_for_next_page().text_height, 60);
+}
+
+TEST(OcrBatchContext, VerifyInterval)
+{
+    OcrBatchContext context{1, 3};
+    context.add_page(make_observation({"eng"}, 0, false));
+    ASSERT_TRUE(context.priors_for_next_page().languages.has_value());
+    ASSERT_TRUE(context.priors_for_next_page().languages.has_value());
+    ASSERT_FALSE(context.priors_for_next_page().languages.has_value());
+    ASSERT_TRUE(context.priors_for_next_page().languages.has_value());
+}
+
+TEST(OcrBatchContext, ResetOnConfidenceDrop)
+{
+    OcrBatchContext context{1, 0, 0.1};
+    context.add_page(make_observation({"eng"}, 0, false, 0.9));
+
+    auto observation = make_observation({"eng"}, 0, false, 0.85);
+    observation.used_priors = true;
+    context.add_page(observation);
+    ASSERT_TRUE(context.priors_for_next_page().languages.has_value());
+
+    observation.mean_word_confidence = 0.5;
+    context.add_page(observation);
+    ASSERT_FALSE(context.priors_for_next_page().languages.has_value());
+}
+
+TEST(OcrBatchContext, GetOrientationOfAngle)
+{
+    ASSERT_DOUBLE_EQ(get_orientation_of_angle(deg_to_rad(2)), 0);
+    ASSERT_DOUBLE_EQ(get_orientation_of_angle(deg_to_rad(-2)), 0);
+    ASSERT_DOUBLE_EQ(get_orientation_of_angle(deg_to_rad(178)), deg_to_rad(180));
+    ASSERT_DOUBLE_EQ(get_orientation_of_angle(deg_to_rad(-90)), deg_to_rad(270));
+    ASSERT_DOUBLE_EQ(get_orientation_of_angle(deg_to_rad(361)), 0);
+}
+
+TEST(OcrBatchContext, GetMedianWordHeightAndConfidence)
+{
+    std::vector<OcrParagraph> paragraphs(1);
+    paragraphs[0].lines.resize(1);
+    ASSERT_EQ(get_median_word_height(paragraphs), 0);
+    ASSERT_EQ(get_mean_word_confidence(paragraphs), 0);
+
+    for (auto [height, confidence] : {std::pair{10, 0.5}, {30, 1.0}, {20, 0.75}}) {
+        OcrWord word;
+        word.box = {0, 0, 10, height};
+        word.confidence = confidence;
+        paragraphs[0].lines[0].words.push_back(word);
+    }
+    ASSERT_EQ(get_median_word_height(paragraphs), 20);
+    ASSERT_DOUBLE_EQ(get_mean_word_confidence(paragraphs), 0.75);
+}
+
+} // namespace sanescan
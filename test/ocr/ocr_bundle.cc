@@ -0,0 +1,165 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr/ocr_bundle.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+
+namespace sanescan {
+
+namespace {
+
+std::filesystem::path get_temp_bundle_path(const std::string& name)
+{
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(path);
+    return path;
+}
+
+cv::Mat make_test_image()
+{
+    cv::Mat image(10, 20, CV_8UC3);
+    for (int y = 0; y < image.rows; ++y) {
+        for (int x = 0; x < image.cols; ++x) {
+            image.at<cv::Vec3b>(y, x) = cv::Vec3b(x * 10, y * 20, x + y);
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+TEST(OcrBundle, WriteReadWithoutOldResults)
+{
+    auto path = get_temp_bundle_path("sanescan_test_bundle_no_old");
+
+    OcrBundle bundle;
+    bundle.source_image = make_test_image();
+    bundle.options.fix_text_rotation = false;
+    bundle.options.min_word_confidence = 0.75;
+    bundle.options.regions = {{1, 2, 3, 4}, {5, 6, 7, 8}};
+    bundle.options.profile = OcrProfile::FAST;
+    bundle.options.languages = {"eng", "lit"};
+    bundle.options.geometric_edits = {{OcrGeometricEditType::ROTATE_90_CW, {}},
+                                      {OcrGeometricEditType::CROP, {10, 20, 30, 40}}};
+    bundle.old_options.blur_detection_coef = 0.125;
+    bundle.sanescan_version = "1.2.3";
+    bundle.tesseract_version = "5.0.0 beta";
+    bundle.duration_sec = 12.5;
+    bundle.stage_timings = {{"initial_recognize", 10.25}, {"final_recognize", 2.25}};
+
+    write_ocr_bundle(path, bundle);
+    auto read = read_ocr_bundle(path);
+    std::filesystem::remove_all(path);
+
+    ASSERT_EQ(read.options, bundle.options);
+    ASSERT_EQ(read.old_options, bundle.old_options);
+    ASSERT_FALSE(read.old_results.has_value());
+    ASSERT_FALSE(read.reference.has_value());
+    ASSERT_FALSE(read.priors.has_value());
+    ASSERT_EQ(read.sanescan_version, bundle.sanescan_version);
+    ASSERT_EQ(read.tesseract_version, bundle.tesseract_version);
+    ASSERT_EQ(read.duration_sec, bundle.duration_sec);
+    ASSERT_EQ(read.stage_timings.size(), 2);
+    ASSERT_EQ(read.stage_timings[0].name, "initial_recognize");
+    ASSERT_EQ(read.stage_timings[0].duration_sec, 10.25);
+    ASSERT_EQ(read.stage_timings[1].name, "final_recognize");
+    ASSERT_EQ(read.stage_timings[1].duration_sec, 2.25);
+    ASSERT_EQ(cv::norm(read.source_image, bundle.source_image, cv::NORM_INF), 0);
+}
+
+TEST(OcrBundle, WriteReadWithOldResults)
+{
+    auto path = get_temp_bundle_path("sanescan_test_bundle_old");
+
+    OcrWord word;
+    word.box = {1, 2, 9, 8};
+    word.char_boxes = {{1, 2, 5, 8}, {5, 2, 9, 8}};
+    word.content = "ab";
+    word.font_size = 6;
+
+    OcrLine line;
+    line.box = {1, 2, 9, 8};
+    line.words = {word};
+
+    OcrResults old_results;
+    old_results.adjusted_image = make_test_image();
+    old_results.adjust_angle = 0.25;
+    old_results.paragraphs = {OcrParagraph{{line}, {1, 2, 9, 8}}};
+
+    OcrBundle bundle;
+    bundle.source_image = make_test_image();
+    bundle.old_results = old_results;
+
+    write_ocr_bundle(path, bundle);
+    auto read = read_ocr_bundle(path);
+    std::filesystem::remove_all(path);
+
+    ASSERT_TRUE(read.old_results.has_value());
+    ASSERT_EQ(read.old_results->adjust_angle, 0.25);
+    ASSERT_EQ(cv::norm(read.old_results->adjusted_image, old_results.adjusted_image,
+                       cv::NORM_INF), 0);
+    ASSERT_EQ(read.old_results->adjusted_image_gray.channels(), 1);
+    ASSERT_EQ(read.old_results->paragraphs.size(), 1);
+    ASSERT_EQ(read.old_results->paragraphs[0].lines.size(), 1);
+    const auto& read_word = read.old_results->paragraphs[0].lines[0].words.at(0);
+    ASSERT_EQ(read_word.content, "ab");
+    ASSERT_EQ(read_word.box, word.box);
+    ASSERT_EQ(read_word.char_boxes, word.char_boxes);
+}
+
+TEST(OcrBundle, WriteReadWithReferenceAndPriors)
+{
+    auto path = get_temp_bundle_path("sanescan_test_bundle_reference");
+
+    OcrResults reference;
+    reference.adjusted_image = make_test_image();
+    reference.adjust_angle = -0.5;
+
+    OcrBatchPriors priors;
+    priors.languages = std::vector<std::string>{"eng", "lit"};
+    priors.orientation = 3.14159265358979;
+    priors.text_height = 24.5;
+
+    OcrBundle bundle;
+    bundle.source_image = make_test_image();
+    bundle.reference = reference;
+    bundle.priors = priors;
+
+    write_ocr_bundle(path, bundle);
+    auto read = read_ocr_bundle(path);
+    std::filesystem::remove_all(path);
+
+    ASSERT_FALSE(read.old_results.has_value());
+    ASSERT_TRUE(read.reference.has_value());
+    ASSERT_EQ(read.reference->adjust_angle, -0.5);
+    ASSERT_EQ(cv::norm(read.reference->adjusted_image, reference.adjusted_image,
+                       cv::NORM_INF), 0);
+    ASSERT_TRUE(read.reference->paragraphs.empty());
+    ASSERT_TRUE(read.priors.has_value());
+    ASSERT_EQ(read.priors.value(), priors);
+}
+
+TEST(OcrBundle, ReadMissingBundleThrows)
+{
+    auto path = get_temp_bundle_path("sanescan_test_bundle_missing");
+    ASSERT_THROW(read_ocr_bundle(path), OcrBundleException);
+}
+
+} // namespace sanescan
@@ -0,0 +1,203 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr_test_utils.h"
+#include "ocr/ocr_geometry.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <numbers>
+#include <sstream>
+
+namespace sanescan {
+
+namespace {
+
+OcrGeometricEdit make_edit(OcrGeometricEditType type)
+{
+    OcrGeometricEdit edit;
+    edit.type = type;
+    return edit;
+}
+
+OcrGeometricEdit make_crop(const OcrBox& crop)
+{
+    OcrGeometricEdit edit;
+    edit.type = OcrGeometricEditType::CROP;
+    edit.crop = crop;
+    return edit;
+}
+
+} // namespace
+
+TEST(OcrGeometry, ApplyToBox)
+{
+    OcrBox box{10, 20, 40, 30};
+    ASSERT_EQ(apply_geometric_edit(box, make_edit(OcrGeometricEditType::ROTATE_90_CW), 100, 200),
+              OcrBox(170, 10, 180, 40));
+    ASSERT_EQ(apply_geometric_edit(box, make_edit(OcrGeometricEditType::ROTATE_90_CCW), 100, 200),
+              OcrBox(20, 60, 30, 90));
+    ASSERT_EQ(apply_geometric_edit(box, make_edit(OcrGeometricEditType::ROTATE_180), 100, 200),
+              OcrBox(60, 170, 90, 180));
+    ASSERT_EQ(apply_geometric_edit(box, make_edit(OcrGeometricEditType::FLIP_HORIZONTAL),
+                                   100, 200),
+              OcrBox(60, 20, 90, 30));
+    ASSERT_EQ(apply_geometric_edit(box, make_edit(OcrGeometricEditType::FLIP_VERTICAL), 100, 200),
+              OcrBox(10, 170, 40, 180));
+    ASSERT_EQ(apply_geometric_edit(box, make_crop({20, 10, 80, 190}), 100, 200),
+              OcrBox(0, 10, 20, 20));
+}
+
+TEST(OcrGeometry, RotateForwardAndBackward)
+{
+    OcrBox box{10, 20, 40, 30};
+    auto rotated = apply_geometric_edit(box, make_edit(OcrGeometricEditType::ROTATE_90_CW),
+                                        100, 200);
+    ASSERT_EQ(apply_geometric_edit(rotated, make_edit(OcrGeometricEditType::ROTATE_90_CCW),
+                                   200, 100),
+              box);
+}
+
+TEST(OcrGeometry, ApplyToParagraphsRotate)
+{
+    OcrLine line;
+    line.box = {10, 20, 110, 40};
+    line.baseline = {0, -5, 0};
+    line.words = {make_word("abc", {10, 20, 50, 40})};
+    line.words[0].baseline = {0, -5, 0};
+    line.words[0].char_boxes = {{10, 20, 20, 40}};
+
+    std::vector<OcrParagraph> paragraphs(1);
+    paragraphs[0].box = {10, 20, 110, 40};
+    paragraphs[0].lines = {line};
+
+    apply_geometric_edit(paragraphs, make_edit(OcrGeometricEditType::ROTATE_90_CW), 200, 100);
+
+    ASSERT_EQ(paragraphs[0].box, OcrBox(60, 10, 80, 110));
+    const auto& result_line = paragraphs[0].lines[0];
+    ASSERT_EQ(result_line.box, OcrBox(60, 10, 80, 110));
+    // The baseline origin (10, 35) maps to (65, 10), which is relative to (60, 110)
+    ASSERT_NEAR(result_line.baseline.x, 5, 1e-9);
+    ASSERT_NEAR(result_line.baseline.y, -100, 1e-9);
+    ASSERT_NEAR(result_line.baseline.angle, std::numbers::pi / 2, 1e-9);
+    ASSERT_EQ(result_line.words[0].box, OcrBox(60, 10, 80, 50));
+    ASSERT_EQ(result_line.words[0].char_boxes[0], OcrBox(60, 10, 80, 20));
+}
+
+TEST(OcrGeometry, BaselineQuarterTurns)
+{
+    ASSERT_EQ(get_baseline_quarter_turns(0), 0);
+    ASSERT_EQ(get_baseline_quarter_turns(0.7), 0);
+    ASSERT_EQ(get_baseline_quarter_turns(std::numbers::pi / 2), 1);
+    ASSERT_EQ(get_baseline_quarter_turns(std::numbers::pi), 2);
+    ASSERT_EQ(get_baseline_quarter_turns(-std::numbers::pi), 2);
+    ASSERT_EQ(get_baseline_quarter_turns(-std::numbers::pi / 2 + 0.1), 3);
+    ASSERT_EQ(get_baseline_quarter_turns(2 * std::numbers::pi - 0.1), 0);
+}
+
+TEST(OcrGeometry, LevelRotatedLine)
+{
+    auto edits = {OcrGeometricEditType::ROTATE_90_CW, OcrGeometricEditType::ROTATE_90_CCW,
+                  OcrGeometricEditType::ROTATE_180};
+    for (auto edit_type : edits) {
+        auto paragraphs = make_single_line_paragraphs();
+        const auto line = paragraphs[0].lines[0];
+        apply_geometric_edit(paragraphs, make_edit(edit_type), 200, 100);
+
+        auto leveled_line = paragraphs[0].lines[0];
+        auto quarter_turns = get_baseline_quarter_turns(leveled_line.baseline.angle);
+        ASSERT_NE(quarter_turns, 0);
+        level_ocr_line(leveled_line, quarter_turns);
+
+        // The leveled line is the original line up to a translation
+        auto dx = leveled_line.box.x1 - line.box.x1;
+        auto dy = leveled_line.box.y1 - line.box.y1;
+        ASSERT_EQ(leveled_line.box, OcrBox(10 + dx, 20 + dy, 110 + dx, 40 + dy));
+        ASSERT_NEAR(leveled_line.baseline.x, 0, 1e-9);
+        ASSERT_NEAR(leveled_line.baseline.y, -5, 1e-9);
+        ASSERT_NEAR(leveled_line.baseline.angle, 0, 1e-9);
+        ASSERT_EQ(leveled_line.words.size(), 2);
+        for (std::size_t i = 0; i < line.words.size(); ++i) {
+            const auto& word = line.words[i];
+            const auto& leveled_word = leveled_line.words[i];
+            ASSERT_EQ(leveled_word.box, OcrBox(word.box.x1 + dx, word.box.y1 + dy,
+                                               word.box.x2 + dx, word.box.y2 + dy));
+            ASSERT_NEAR(leveled_word.baseline.y, -5, 1e-9);
+            ASSERT_EQ(leveled_word.char_boxes.size(), word.char_boxes.size());
+            ASSERT_EQ(leveled_word.char_boxes[1].x1, word.char_boxes[1].x1 + dx);
+        }
+    }
+}
+
+TEST(OcrGeometry, ApplyToParagraphsCrop)
+{
+    OcrLine line1;
+    line1.box = {10, 20, 110, 40};
+    line1.baseline = {0, -5, 0.01};
+    line1.words = {make_word("abc", {10, 20, 50, 40}), make_word("def", {60, 20, 110, 40})};
+
+    OcrLine line2;
+    line2.box = {10, 60, 110, 80};
+    line2.words = {make_word("ghi", {10, 60, 110, 80})};
+
+    std::vector<OcrParagraph> paragraphs(2);
+    paragraphs[0].box = {10, 20, 110, 40};
+    paragraphs[0].lines = {line1};
+    paragraphs[1].box = {10, 60, 110, 80};
+    paragraphs[1].lines = {line2};
+
+    apply_geometric_edit(paragraphs, make_crop({55, 10, 120, 50}), 200, 100);
+
+    ASSERT_EQ(paragraphs.size(), 1);
+    ASSERT_EQ(paragraphs[0].box, OcrBox(0, 10, 55, 30));
+    ASSERT_EQ(paragraphs[0].lines.size(), 1);
+    const auto& result_line = paragraphs[0].lines[0];
+    ASSERT_EQ(result_line.words.size(), 1);
+    ASSERT_EQ(result_line.words[0].content, "def");
+    ASSERT_EQ(result_line.words[0].box, OcrBox(5, 10, 55, 30));
+    ASSERT_NEAR(result_line.baseline.x, -45, 1e-9);
+    ASSERT_NEAR(result_line.baseline.y, -5, 1e-9);
+    ASSERT_NEAR(result_line.baseline.angle, 0.01, 1e-9);
+}
+
+TEST(OcrGeometry, StreamRoundTrip)
+{
+    std::vector<OcrGeometricEdit> edits = {
+        make_edit(OcrGeometricEditType::ROTATE_90_CCW),
+        make_crop({1, 2, 3, 4}),
+    };
+    std::stringstream stream;
+    for (const auto& edit : edits) {
+        stream << edit << " ";
+    }
+
+    std::vector<OcrGeometricEdit> parsed;
+    OcrGeometricEdit edit;
+    while (stream >> edit) {
+        parsed.push_back(edit);
+    }
+    ASSERT_EQ(parsed, edits);
+}
+
+TEST(OcrGeometry, StreamInvalidType)
+{
+    std::stringstream stream("unknown 0 0 0 0");
+    OcrGeometricEdit edit;
+    ASSERT_FALSE(stream >> edit);
+}
+
+} // namespace sanescan
@@ -0,0 +1,54 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr/ocr_languages.h"
+#include <gtest/gtest.h>
+
+namespace sanescan {
+
+TEST(OcrLanguages, GetLanguageScript)
+{
+    ASSERT_EQ(get_language_script("eng"), "Latin");
+    ASSERT_EQ(get_language_script("rus"), "Cyrillic");
+    ASSERT_EQ(get_language_script("chi_sim"), "Han");
+    ASSERT_EQ(get_language_script("unknown"), "");
+}
+
+TEST(OcrLanguages, SelectLanguagesForScripts)
+{
+    std::vector<std::string> candidates = {"eng", "rus", "custom", "lit", "ell"};
+
+    ASSERT_EQ(select_languages_for_scripts(candidates, {"Latin"}),
+              (std::vector<std::string>{"eng", "custom", "lit"}));
+    ASSERT_EQ(select_languages_for_scripts(candidates, {"Greek", "Cyrillic"}),
+              (std::vector<std::string>{"rus", "custom", "ell"}));
+    // Candidates with unknown script alone are not enough, e.g. equ is not used without eng
+    ASSERT_EQ(select_languages_for_scripts(candidates, {}), candidates);
+    ASSERT_EQ(select_languages_for_scripts(candidates, {"Arabic"}), candidates);
+    ASSERT_EQ(select_languages_for_scripts({"eng", "equ"}, {}),
+              (std::vector<std::string>{"eng", "equ"}));
+}
+
+TEST(OcrLanguages, JoinLanguages)
+{
+    ASSERT_EQ(join_languages({}), "");
+    ASSERT_EQ(join_languages({"eng"}), "eng");
+    ASSERT_EQ(join_languages({"eng", "deu", "lit"}), "eng+deu+lit");
+}
+
+} // namespace sanescan
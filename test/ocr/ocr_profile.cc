@@ -0,0 +1,62 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr/ocr_profile.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace sanescan {
+
+TEST(OcrProfile, ToStringAndParse)
+{
+    for (auto profile : {OcrProfile::FAST, OcrProfile::BALANCED, OcrProfile::BEST}) {
+        ASSERT_EQ(parse_ocr_profile(ocr_profile_to_string(profile)), profile);
+    }
+    ASSERT_EQ(parse_ocr_profile("Fast"), std::nullopt);
+    ASSERT_EQ(parse_ocr_profile(""), std::nullopt);
+}
+
+TEST(OcrProfile, StreamOperators)
+{
+    std::stringstream stream;
+    stream << OcrProfile::BEST;
+    ASSERT_EQ(stream.str(), "best");
+
+    OcrProfile profile = OcrProfile::FAST;
+    stream >> profile;
+    ASSERT_FALSE(stream.fail());
+    ASSERT_EQ(profile, OcrProfile::BEST);
+
+    std::istringstream invalid_stream("unknown");
+    invalid_stream >> profile;
+    ASSERT_TRUE(invalid_stream.fail());
+    ASSERT_EQ(profile, OcrProfile::BEST);
+}
+
+TEST(OcrProfile, BalancedProfileUsesDefaults)
+{
+    ASSERT_EQ(get_ocr_profile_settings(OcrProfile::BALANCED), OcrProfileSettings{});
+
+    auto fast = get_ocr_profile_settings(OcrProfile::FAST);
+    ASSERT_EQ(fast.model_type, OcrModelType::FAST);
+    ASSERT_FALSE(fast.erase_lines);
+    ASSERT_FALSE(fast.detect_blur);
+    ASSERT_GT(fast.max_recognition_megapixels, 0);
+}
+
+} // namespace sanescan
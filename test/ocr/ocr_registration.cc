@@ -0,0 +1,138 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr_test_utils.h"
+#include "ocr/ocr_registration.h"
+#include <opencv2/imgproc.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+
+namespace sanescan {
+
+namespace {
+
+cv::Mat make_page_image()
+{
+    cv::Mat image(600, 400, CV_8U, cv::Scalar(255));
+    for (int y = 40; y < 560; y += 40) {
+        for (int x = 20; x < 360; x += 60) {
+            cv::rectangle(image, cv::Rect(x, y, 40, 15), cv::Scalar(0), cv::FILLED);
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+TEST(OcrRegistration, GetHomographyRotationScale)
+{
+    auto angle = 0.1;
+    cv::Matx33d h{2 * std::cos(angle), -2 * std::sin(angle), 10,
+                  2 * std::sin(angle), 2 * std::cos(angle), 20,
+                  0, 0, 1};
+    auto [result_angle, result_scale] = get_homography_rotation_scale(h);
+    ASSERT_NEAR(result_angle, angle, 1e-9);
+    ASSERT_NEAR(result_scale, 2, 1e-9);
+}
+
+TEST(OcrRegistration, TransformParagraphs)
+{
+    OcrLine line;
+    line.box = {10, 20, 110, 40};
+    line.words = {make_word("abc", {10, 20, 50, 40}), make_word("def", {60, 20, 110, 40})};
+    line.words[0].font_size = 10;
+    line.words[0].char_boxes = {{10, 20, 20, 40}};
+    line.baseline = {1, -2, 0.01};
+
+    std::vector<OcrParagraph> paragraphs(1);
+    paragraphs[0].box = {10, 20, 110, 40};
+    paragraphs[0].lines = {line};
+
+    cv::Matx33d h{2, 0, 5,
+                  0, 2, -5,
+                  0, 0, 1};
+    auto result = transform_paragraphs(paragraphs, h);
+    ASSERT_EQ(result.size(), 1);
+    ASSERT_EQ(result[0].box, OcrBox(25, 35, 225, 75));
+    ASSERT_EQ(result[0].lines[0].box, OcrBox(25, 35, 225, 75));
+    ASSERT_EQ(result[0].lines[0].baseline, OcrBaseline(2, -4, 0.01));
+
+    const auto& words = result[0].lines[0].words;
+    ASSERT_EQ(words[0].box, OcrBox(25, 35, 105, 75));
+    ASSERT_EQ(words[0].char_boxes, std::vector<OcrBox>{OcrBox(25, 35, 45, 75)});
+    ASSERT_DOUBLE_EQ(words[0].font_size, 20);
+    ASSERT_EQ(words[1].box, OcrBox(125, 35, 225, 75));
+    ASSERT_EQ(words[1].content, "def");
+}
+
+TEST(OcrRegistration, ExtendAreasToLines)
+{
+    std::vector<OcrParagraph> paragraphs(1);
+    paragraphs[0].lines.resize(2);
+    paragraphs[0].lines[0].box = {10, 20, 110, 40};
+    paragraphs[0].lines[1].box = {10, 60, 110, 80};
+
+    auto result = extend_areas_to_lines({OcrBox{50, 25, 55, 30}, OcrBox{200, 200, 210, 210},
+                                         OcrBox{100, 35, 105, 65}},
+                                        paragraphs);
+    ASSERT_EQ(result, (std::vector<OcrBox>{OcrBox{200, 200, 210, 210},
+                                           OcrBox{10, 20, 110, 80}}));
+}
+
+TEST(OcrRegistration, RemoveWordsInAreas)
+{
+    OcrLine line1;
+    line1.words = {make_word("abc", {10, 20, 50, 40}), make_word("def", {60, 20, 110, 40})};
+    OcrLine line2;
+    line2.words = {make_word("ghi", {10, 60, 50, 80})};
+
+    std::vector<OcrParagraph> paragraphs(2);
+    paragraphs[0].lines = {line1};
+    paragraphs[1].lines = {line2};
+
+    remove_words_in_areas(paragraphs, {OcrBox{55, 0, 200, 45}, OcrBox{0, 55, 20, 65}});
+    ASSERT_EQ(paragraphs.size(), 1);
+    ASSERT_EQ(paragraphs[0].lines.size(), 1);
+    ASSERT_EQ(paragraphs[0].lines[0].words.size(), 1);
+    ASSERT_EQ(paragraphs[0].lines[0].words[0].content, "abc");
+}
+
+TEST(OcrRegistration, FindChangedAreasIdentical)
+{
+    auto image = make_page_image();
+    auto areas = find_changed_areas(image, image, cv::Matx33d::eye());
+    ASSERT_TRUE(areas.empty());
+}
+
+TEST(OcrRegistration, FindChangedAreasSingleChange)
+{
+    auto reference = make_page_image();
+    auto image = reference.clone();
+    cv::rectangle(image, cv::Rect(150, 300, 100, 30), cv::Scalar(128), cv::FILLED);
+
+    auto areas = find_changed_areas(reference, image, cv::Matx33d::eye());
+    ASSERT_EQ(areas.size(), 1);
+    ASSERT_LE(areas[0].x1, 150);
+    ASSERT_LE(areas[0].y1, 300);
+    ASSERT_GE(areas[0].x2, 250);
+    ASSERT_GE(areas[0].y2, 330);
+    ASSERT_LT(areas[0].width(), 120);
+    ASSERT_LT(areas[0].height(), 50);
+}
+
+} // namespace sanescan
@@ -0,0 +1,152 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr/ocr_search_index.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace sanescan {
+
+namespace {
+
+std::vector<OcrParagraph> make_paragraphs(const std::vector<std::string>& words)
+{
+    OcrLine line;
+    std::int32_t x = 0;
+    for (const auto& content : words) {
+        OcrWord word;
+        word.content = content;
+        word.box = OcrBox{x, 0, x + 10, 10};
+        line.words.push_back(word);
+        x += 20;
+    }
+    OcrParagraph paragraph;
+    paragraph.lines = {line};
+    return {paragraph};
+}
+
+std::vector<std::string> hit_texts(const std::vector<OcrSearchHit>& hits)
+{
+    std::vector<std::string> result;
+    for (const auto& hit : hits) {
+        result.push_back(std::to_string(hit.page_id) + ":" + hit.text);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(OcrSearchIndex, NormalizeTerm)
+{
+    ASSERT_EQ(normalize_search_term("Invoice"), "invoice");
+    ASSERT_EQ(normalize_search_term("(INV-123),"), "inv-123");
+    ASSERT_EQ(normalize_search_term("..."), "");
+    ASSERT_EQ(normalize_search_term("Žodis"), "Žodis");
+}
+
+TEST(OcrSearchIndex, EditDistance)
+{
+    ASSERT_EQ(bounded_edit_distance("abc", "abc", 2, false), 0u);
+    ASSERT_EQ(bounded_edit_distance("abc", "abd", 2, false), 1u);
+    ASSERT_EQ(bounded_edit_distance("abc", "ab", 2, false), 1u);
+    ASSERT_EQ(bounded_edit_distance("abc", "xyz", 2, false), 3u);
+    ASSERT_EQ(bounded_edit_distance("abc", "abcdef", 2, false), 3u);
+    ASSERT_EQ(bounded_edit_distance("abc", "abcdef", 2, true), 0u);
+    ASSERT_EQ(bounded_edit_distance("abd", "abcdef", 2, true), 1u);
+    ASSERT_EQ(bounded_edit_distance("abc", "", 5, true), 3u);
+}
+
+TEST(OcrSearchIndex, ExactAndPrefixSearch)
+{
+    OcrSearchIndex index;
+    index.set_page(1, make_paragraphs({"Invoice", "number", "INV-1234"}));
+    index.set_page(2, make_paragraphs({"inv-1299", "total"}));
+
+    OcrSearchOptions exact;
+    exact.prefix = false;
+    ASSERT_EQ(hit_texts(index.search("invoice", exact)),
+              (std::vector<std::string>{"1:Invoice"}));
+    ASSERT_EQ(hit_texts(index.search("inv", exact)), (std::vector<std::string>{}));
+
+    ASSERT_EQ(hit_texts(index.search("inv")),
+              (std::vector<std::string>{"1:Invoice", "1:INV-1234", "2:inv-1299"}));
+    ASSERT_EQ(hit_texts(index.search("inv-12")),
+              (std::vector<std::string>{"1:INV-1234", "2:inv-1299"}));
+
+    auto hits = index.search("total");
+    ASSERT_EQ(hits.size(), 1u);
+    ASSERT_EQ(hits[0].page_id, 2u);
+    ASSERT_EQ(hits[0].word, (OcrWordRef{0, 0, 1}));
+    ASSERT_EQ(hits[0].box, (OcrBox{20, 0, 30, 10}));
+}
+
+TEST(OcrSearchIndex, FuzzySearch)
+{
+    OcrSearchIndex index;
+    index.set_page(1, make_paragraphs({"invoice", "lnvoice", "invoices", "involve"}));
+
+    OcrSearchOptions options;
+    options.prefix = false;
+    options.max_edit_distance = 1;
+    auto hits = index.search("invoice", options);
+    ASSERT_EQ(hit_texts(hits),
+              (std::vector<std::string>{"1:invoice", "1:lnvoice", "1:invoices"}));
+    ASSERT_EQ(hits[0].edit_distance, 0u);
+    ASSERT_EQ(hits[1].edit_distance, 1u);
+
+    options.prefix = true;
+    ASSERT_EQ(hit_texts(index.search("invoi", options)),
+              (std::vector<std::string>{"1:invoice", "1:invoices", "1:lnvoice", "1:involve"}));
+}
+
+TEST(OcrSearchIndex, UpdateAndRemovePages)
+{
+    OcrSearchIndex index;
+    index.set_page(1, make_paragraphs({"alpha", "beta"}));
+    index.set_page(2, make_paragraphs({"alpha"}));
+    ASSERT_EQ(index.search("alpha").size(), 2u);
+
+    index.set_page(1, make_paragraphs({"gamma"}));
+    ASSERT_EQ(hit_texts(index.search("alpha")), (std::vector<std::string>{"2:alpha"}));
+    ASSERT_TRUE(index.search("beta").empty());
+    ASSERT_EQ(hit_texts(index.search("gamma")), (std::vector<std::string>{"1:gamma"}));
+
+    index.remove_page(2);
+    ASSERT_FALSE(index.has_page(2));
+    ASSERT_TRUE(index.search("alpha").empty());
+}
+
+TEST(OcrSearchIndex, WriteRead)
+{
+    OcrSearchIndex index;
+    index.set_page(3, make_paragraphs({"first", "two words", ""}));
+    index.set_page(7, make_paragraphs({"second"}));
+
+    std::stringstream stream;
+    index.write(stream);
+    auto read_index = OcrSearchIndex::read(stream);
+
+    ASSERT_EQ(read_index.search("first"), index.search("first"));
+    ASSERT_EQ(read_index.search("second"), index.search("second"));
+    ASSERT_EQ(hit_texts(read_index.search("two")), (std::vector<std::string>{"3:two words"}));
+
+    std::stringstream invalid_stream{"something else"};
+    ASSERT_THROW(OcrSearchIndex::read(invalid_stream), OcrSearchIndexException);
+}
+
+} // namespace sanescan
@@ -0,0 +1,107 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ocr_test_utils.h"
+#include "ocr/ocr_spatial_index.h"
+#include <gtest/gtest.h>
+
+namespace sanescan {
+
+namespace {
+
+std::vector<OcrParagraph> make_paragraphs()
+{
+    OcrLine line1;
+    line1.words.push_back(make_word_with_char_boxes("ab", OcrBox{10, 10, 30, 20}));
+    line1.words.push_back(make_word_with_char_boxes("cd", OcrBox{40, 10, 60, 20}));
+    OcrLine line2;
+    line2.words.push_back(make_word_with_char_boxes("ef", OcrBox{10, 30, 30, 40}));
+
+    OcrParagraph par1;
+    par1.lines = {line1, line2};
+
+    OcrLine line3;
+    line3.words.push_back(make_word_with_char_boxes("ghij", OcrBox{500, 500, 900, 520}));
+    OcrParagraph par2;
+    par2.lines = {line3};
+    return {par1, par2};
+}
+
+} // namespace
+
+TEST(OcrBoxGrid, Empty)
+{
+    OcrBoxGrid grid;
+    ASSERT_TRUE(grid.query_point(0, 0).empty());
+    ASSERT_TRUE(grid.query_rect(OcrBox{0, 0, 100, 100}).empty());
+}
+
+TEST(OcrBoxGrid, PointQueries)
+{
+    OcrBoxGrid grid{{OcrBox{0, 0, 10, 10}, OcrBox{5, 5, 15, 15}, OcrBox{1000, 1000, 1010, 1010}}};
+    ASSERT_EQ(grid.query_point(0, 0), (std::vector<std::uint32_t>{0}));
+    ASSERT_EQ(grid.query_point(7, 7), (std::vector<std::uint32_t>{0, 1}));
+    ASSERT_EQ(grid.query_point(10, 10), (std::vector<std::uint32_t>{1}));
+    ASSERT_EQ(grid.query_point(15, 15), (std::vector<std::uint32_t>{}));
+    ASSERT_EQ(grid.query_point(1005, 1001), (std::vector<std::uint32_t>{2}));
+    ASSERT_EQ(grid.query_point(-5, -5), (std::vector<std::uint32_t>{}));
+    ASSERT_EQ(grid.query_point(5000, 5000), (std::vector<std::uint32_t>{}));
+}
+
+TEST(OcrBoxGrid, RectQueries)
+{
+    OcrBoxGrid grid{{OcrBox{0, 0, 10, 10}, OcrBox{5, 5, 500, 15}, OcrBox{1000, 1000, 1010, 1010}}};
+    ASSERT_EQ(grid.query_rect(OcrBox{0, 0, 2000, 2000}), (std::vector<std::uint32_t>{0, 1, 2}));
+    ASSERT_EQ(grid.query_rect(OcrBox{200, 0, 300, 100}), (std::vector<std::uint32_t>{1}));
+    ASSERT_EQ(grid.query_rect(OcrBox{10, 10, 20, 20}), (std::vector<std::uint32_t>{1}));
+    ASSERT_EQ(grid.query_rect(OcrBox{-100, -100, 0, 0}), (std::vector<std::uint32_t>{}));
+    ASSERT_EQ(grid.query_rect(OcrBox{990, 990, 1001, 1001}), (std::vector<std::uint32_t>{2}));
+}
+
+TEST(OcrSpatialIndex, WordsAndChars)
+{
+    auto paragraphs = make_paragraphs();
+    OcrSpatialIndex index{paragraphs, {OcrBox{500, 500, 900, 520}}};
+
+    ASSERT_EQ(index.words_at(45, 15), (std::vector<OcrWordRef>{{0, 0, 1}}));
+    ASSERT_EQ(index.words_at(35, 15), (std::vector<OcrWordRef>{}));
+    ASSERT_EQ(index.words_at(600, 510), (std::vector<OcrWordRef>{{1, 0, 0}}));
+
+    ASSERT_EQ(index.chars_at(25, 35), (std::vector<OcrCharRef>{{{0, 1, 0}, 1}}));
+
+    ASSERT_EQ(index.blurred_words_at(600, 510), (std::vector<std::uint32_t>{0}));
+    ASSERT_EQ(index.blurred_words_at(20, 15), (std::vector<std::uint32_t>{}));
+    ASSERT_EQ(index.blurred_words_in_rect(OcrBox{0, 0, 1000, 1000}),
+              (std::vector<std::uint32_t>{0}));
+}
+
+TEST(OcrSpatialIndex, TextInReadingOrder)
+{
+    auto paragraphs = make_paragraphs();
+    OcrSpatialIndex index{paragraphs, {}};
+
+    auto words = index.words_in_rect(OcrBox{0, 0, 1000, 1000});
+    ASSERT_EQ(words.size(), 4);
+    ASSERT_EQ(get_text_in_reading_order(paragraphs, words), "ab cd\nef\n\nghij");
+
+    words = index.words_in_rect(OcrBox{35, 5, 600, 600});
+    ASSERT_EQ(get_text_in_reading_order(paragraphs, words), "cd\n\nghij");
+}
+
+} // namespace sanescan
@@ -0,0 +1,70 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SANESCAN_TEST_OCR_OCR_TEST_UTILS_H
+#define SANESCAN_TEST_OCR_OCR_TEST_UTILS_H
+
+#include "ocr/ocr_paragraph.h"
+#include "ocr/ocr_word.h"
+#include <string>
+#include <vector>
+
+namespace sanescan {
+
+inline OcrWord make_word(const std::string& content, const OcrBox& box, double confidence = 1)
+{
+    OcrWord word;
+    word.content = content;
+    word.box = box;
+    word.confidence = confidence;
+    return word;
+}
+
+// Same as make_word(), except that the word box is split into equal character boxes
+inline OcrWord make_word_with_char_boxes(const std::string& content, const OcrBox& box)
+{
+    auto word = make_word(content, box);
+    auto char_width = box.width() / static_cast<std::int32_t>(content.size());
+    for (std::size_t i = 0; i < content.size(); ++i) {
+        std::int32_t x1 = box.x1 + char_width * i;
+        word.char_boxes.push_back(OcrBox{x1, box.y1, x1 + char_width, box.y2});
+    }
+    return word;
+}
+
+/*  Returns a single horizontal line containing words "abc" at (10, 20)-(49, 40) and "def" at
+    (70, 20)-(109, 40) whose baselines are 5 pixels above the bottom of the boxes. The line fits
+    into a 200x100 image.
+*/
+inline std::vector<OcrParagraph> make_single_line_paragraphs()
+{
+    OcrLine line;
+    line.box = {10, 20, 110, 40};
+    line.baseline = {0, -5, 0};
+    line.words = {make_word_with_char_boxes("abc", {10, 20, 49, 40}),
+                  make_word_with_char_boxes("def", {70, 20, 109, 40})};
+    for (auto& word : line.words) {
+        word.baseline = {0, -5, 0};
+        word.font_size = 20;
+    }
+    return {OcrParagraph{{line}, line.box}};
+}
+
+} // namespace sanescan
+
+#endif // SANESCAN_TEST_OCR_OCR_TEST_UTILS_H
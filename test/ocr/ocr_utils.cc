@@ -155,4 +155,66 @@ TEST(GetDominantAngle, BetterValueShiftsOffWorseValues)
     EXPECT_NEAR(r.second, 15.0 / 21.0, 1e-6);
 }
 
+TEST(TranslateParagraphs, MovesAllBoxes)
+{
+    OcrWord word;
+    word.box = OcrBox{10, 20, 30, 40};
+    word.char_boxes = {OcrBox{10, 20, 20, 40}, OcrBox{20, 20, 30, 40}};
+    word.baseline = OcrBaseline{0, -2, 0};
+    OcrLine line;
+    line.box = OcrBox{10, 20, 30, 40};
+    line.words = {word};
+    OcrParagraph paragraph;
+    paragraph.box = OcrBox{5, 15, 35, 45};
+    paragraph.lines = {line};
+    std::vector<OcrParagraph> paragraphs = {paragraph};
+
+    translate_paragraphs(paragraphs, 100, 200);
+
+    const auto& result = paragraphs.front();
+    ASSERT_EQ(result.box, (OcrBox{105, 215, 135, 245}));
+    ASSERT_EQ(result.lines[0].box, (OcrBox{110, 220, 130, 240}));
+    ASSERT_EQ(result.lines[0].words[0].box, (OcrBox{110, 220, 130, 240}));
+    ASSERT_EQ(result.lines[0].words[0].char_boxes,
+              (std::vector<OcrBox>{OcrBox{110, 220, 120, 240}, OcrBox{120, 220, 130, 240}}));
+    ASSERT_EQ(result.lines[0].words[0].baseline, (OcrBaseline{0, -2, 0}));
+}
+
+TEST(ScaleParagraphs, ScalesBoxesBaselinesAndFontSizes)
+{
+    OcrWord word;
+    word.box = OcrBox{10, 20, 30, 41};
+    word.char_boxes = {OcrBox{10, 20, 20, 41}, OcrBox{20, 20, 30, 41}};
+    word.baseline = OcrBaseline{1, -2, 0.1};
+    word.font_size = 12;
+    OcrLine line;
+    line.box = OcrBox{10, 20, 30, 41};
+    line.baseline = OcrBaseline{0, -3, 0.1};
+    line.words = {word};
+    OcrParagraph paragraph;
+    paragraph.box = OcrBox{6, 16, 34, 44};
+    paragraph.lines = {line};
+    std::vector<OcrParagraph> paragraphs = {paragraph};
+
+    scale_paragraphs(paragraphs, 0.5);
+
+    const auto& result = paragraphs.front();
+    ASSERT_EQ(result.box, (OcrBox{3, 8, 17, 22}));
+    ASSERT_EQ(result.lines[0].box, (OcrBox{5, 10, 15, 21}));
+    ASSERT_EQ(result.lines[0].baseline, (OcrBaseline{0, -1.5, 0.1}));
+    ASSERT_EQ(result.lines[0].words[0].box, (OcrBox{5, 10, 15, 21}));
+    ASSERT_EQ(result.lines[0].words[0].char_boxes,
+              (std::vector<OcrBox>{OcrBox{5, 10, 10, 21}, OcrBox{10, 10, 15, 21}}));
+    ASSERT_EQ(result.lines[0].words[0].baseline, (OcrBaseline{0.5, -1, 0.1}));
+    ASSERT_EQ(result.lines[0].words[0].font_size, 6);
+}
+
+TEST(CountUtf8Chars, CountsCodePoints)
+{
+    ASSERT_EQ(count_utf8_chars(""), 0);
+    ASSERT_EQ(count_utf8_chars("abc"), 3);
+    ASSERT_EQ(count_utf8_chars("\xc4\x85\xc4\x8d"), 2);
+    ASSERT_EQ(count_utf8_chars("a\xe2\x82\xac\xf0\x9f\x98\x80"), 3);
+}
+
 } // namespace sanescan
@@ -0,0 +1,173 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2021  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ocr_test_utils.h"
+#include "ocr/ocr_geometry.h"
+#include "ocr/pdf.h"
+#include <gtest/gtest.h>
+#include <opencv2/core/mat.hpp>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace sanescan {
+
+namespace {
+
+using Matrix = std::array<double, 6>;
+
+constexpr Matrix IDENTITY_MATRIX = {1, 0, 0, 1, 0, 0};
+
+// Returns m1 x m2 as defined for PDF transformation matrices
+Matrix multiply(const Matrix& m1, const Matrix& m2)
+{
+    return {
+        m1[0] * m2[0] + m1[1] * m2[2],
+        m1[0] * m2[1] + m1[1] * m2[3],
+        m1[2] * m2[0] + m1[3] * m2[2],
+        m1[2] * m2[1] + m1[3] * m2[3],
+        m1[4] * m2[0] + m1[5] * m2[2] + m2[4],
+        m1[4] * m2[1] + m1[5] * m2[3] + m2[5],
+    };
+}
+
+struct ShownText {
+    // The start of the text in page coordinates
+    double x = 0;
+    double y = 0;
+    // The direction of the text in page coordinates
+    double dir_x = 0;
+    double dir_y = 0;
+};
+
+struct PageText {
+    std::vector<ShownText> words;
+    std::vector<double> horizontal_stretches;
+};
+
+/*  Interprets the text operators of the page contents written by write_pdf(). Only the start of
+    each word is tracked, i.e. the position of the first text shown after moving the text position.
+*/
+PageText interpret_page_contents(const std::string& pdf)
+{
+    // The page contents start with drawing of the page image
+    auto begin = pdf.rfind("q ", pdf.find(" cm /"));
+    auto end = pdf.find("endstream", begin);
+    if (begin == std::string::npos || end == std::string::npos) {
+        throw std::runtime_error("Could not find page contents");
+    }
+
+    PageText result;
+    std::vector<Matrix> ctm_stack = {IDENTITY_MATRIX};
+    Matrix line_matrix = IDENTITY_MATRIX;
+    bool word_started = false;
+    std::vector<double> operands;
+
+    std::istringstream stream(pdf.substr(begin, end - begin));
+    std::string token;
+    while (stream >> token) {
+        char* parse_end = nullptr;
+        auto value = std::strtod(token.c_str(), &parse_end);
+        if (parse_end != token.c_str() && *parse_end == '\0') {
+            if (!std::isfinite(value)) {
+                throw std::runtime_error("Non-finite operand " + token);
+            }
+            operands.push_back(value);
+            continue;
+        }
+
+        if (token == "q") {
+            ctm_stack.push_back(ctm_stack.back());
+        } else if (token == "Q") {
+            ctm_stack.pop_back();
+        } else if (token == "cm") {
+            ctm_stack.back() = multiply(Matrix{operands[0], operands[1], operands[2],
+                                               operands[3], operands[4], operands[5]},
+                                        ctm_stack.back());
+        } else if (token == "Tm") {
+            line_matrix = Matrix{operands[0], operands[1], operands[2], operands[3],
+                                 operands[4], operands[5]};
+            word_started = false;
+        } else if (token == "Td") {
+            line_matrix = multiply(Matrix{1, 0, 0, 1, operands[0], operands[1]}, line_matrix);
+            word_started = false;
+        } else if (token == "Tz") {
+            result.horizontal_stretches.push_back(operands[0]);
+        } else if (token == "Tj" && !word_started) {
+            auto m = multiply(line_matrix, ctm_stack.back());
+            auto length = std::hypot(m[0], m[1]);
+            result.words.push_back({m[4], m[5], m[0] / length, m[1] / length});
+            word_started = true;
+        }
+        operands.clear();
+    }
+    return result;
+}
+
+std::string write_test_pdf(const std::vector<OcrParagraph>& paragraphs, int width, int height)
+{
+    cv::Mat image(height, width, CV_8UC3, cv::Scalar(255, 255, 255));
+    std::ostringstream stream;
+    write_pdf(stream, image, paragraphs);
+    return stream.str();
+}
+
+void expect_pdf_text(const PageText& text, double x1, double y1, double x2, double y2,
+                     double dir_x, double dir_y)
+{
+    ASSERT_EQ(text.words.size(), 2);
+    EXPECT_NEAR(text.words[0].x, x1, 0.5);
+    EXPECT_NEAR(text.words[0].y, y1, 0.5);
+    EXPECT_NEAR(text.words[1].x, x2, 0.5);
+    EXPECT_NEAR(text.words[1].y, y2, 0.5);
+    for (const auto& word : text.words) {
+        EXPECT_NEAR(word.dir_x, dir_x, 1e-6);
+        EXPECT_NEAR(word.dir_y, dir_y, 1e-6);
+    }
+    for (auto stretch : text.horizontal_stretches) {
+        EXPECT_GT(stretch, 0);
+        EXPECT_LT(stretch, 1000);
+    }
+}
+
+} // namespace
+
+TEST(Pdf, WriteHorizontalLine)
+{
+    auto text = interpret_page_contents(write_test_pdf(make_single_line_paragraphs(), 200, 100));
+    // Word baselines start at (10, 35) and (70, 35) in the image
+    expect_pdf_text(text, 10, 65, 70, 65, 1, 0);
+}
+
+TEST(Pdf, WriteLineOfRotatedPage)
+{
+    OcrGeometricEdit edit;
+    edit.type = OcrGeometricEditType::ROTATE_90_CW;
+    auto paragraphs = make_single_line_paragraphs();
+    apply_geometric_edit(paragraphs, edit, 200, 100);
+
+    auto text = interpret_page_contents(write_test_pdf(paragraphs, 100, 200));
+    // Word baselines start at (65, 10) and (65, 70) in the image and the text goes downwards
+    expect_pdf_text(text, 65, 190, 65, 130, 0, -1);
+}
+
+} // namespace sanescan
@@ -0,0 +1,109 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "util/telemetry.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace sanescan {
+
+TEST(Telemetry, RegistryReturnsStableMetrics)
+{
+    auto& registry = TelemetryRegistry::instance();
+    auto& counter = registry.counter("test.registry.counter");
+    ASSERT_EQ(&counter, &registry.counter("test.registry.counter"));
+    ASSERT_NE(&counter, &registry.counter("test.registry.other_counter"));
+
+    counter.add();
+    counter.add(2);
+    auto& gauge = registry.gauge("test.registry.gauge");
+    gauge.set(10);
+    gauge.add(-3);
+
+    auto snapshot = registry.snapshot();
+    ASSERT_EQ(snapshot.counters.at("test.registry.counter"), 3);
+    ASSERT_EQ(snapshot.gauges.at("test.registry.gauge"), 7);
+}
+
+TEST(Telemetry, HistogramPercentiles)
+{
+    TelemetryHistogram histogram;
+    ASSERT_EQ(histogram.snapshot().count, 0);
+    ASSERT_EQ(histogram.snapshot().p99_sec, 0);
+
+    for (int i = 0; i < 98; ++i) {
+        histogram.record(0.001);
+    }
+    histogram.record(0.5);
+    histogram.record(2.0);
+
+    auto snapshot = histogram.snapshot();
+    ASSERT_EQ(snapshot.count, 100);
+    ASSERT_NEAR(snapshot.sum_sec, 2.598, 1e-6);
+    ASSERT_DOUBLE_EQ(snapshot.max_sec, 2.0);
+    // Bucket bounds are powers of two microseconds, so 1ms is reported as 1.024ms
+    ASSERT_DOUBLE_EQ(snapshot.p50_sec, 0.001024);
+    ASSERT_DOUBLE_EQ(snapshot.p90_sec, 0.001024);
+    ASSERT_GE(snapshot.p99_sec, 0.5);
+    ASSERT_LE(snapshot.p99_sec, 1.0);
+}
+
+TEST(Telemetry, ConcurrentUpdates)
+{
+    TelemetryCounter counter;
+    TelemetryHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]()
+        {
+            for (int i = 0; i < 1000; ++i) {
+                counter.add();
+                histogram.record(0.0001);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(counter.value(), 4000);
+    ASSERT_EQ(histogram.snapshot().count, 4000);
+}
+
+TEST(Telemetry, WriteJson)
+{
+    TelemetrySnapshot snapshot;
+    snapshot.uptime_sec = 1.5;
+    snapshot.counters["pages"] = 3;
+    snapshot.gauges["queue \"length\""] = -1;
+    snapshot.histograms["latency"] = TelemetryHistogramSnapshot{2, 1.0, 0.75, 0.5, 0.75, 0.75};
+
+    std::stringstream stream;
+    write_telemetry_json(stream, snapshot);
+    auto contents = stream.str();
+
+    ASSERT_NE(contents.find(R"("uptime_sec": 1.5)"), std::string::npos);
+    ASSERT_NE(contents.find(R"("pages": 3)"), std::string::npos);
+    ASSERT_NE(contents.find(R"("queue \"length\"": -1)"), std::string::npos);
+    ASSERT_NE(contents.find(R"("latency": {"count": 2, "sum_sec": 1, "mean_sec": 0.5)"),
+              std::string::npos);
+}
+
+} // namespace sanescan
@@ -0,0 +1,86 @@
+/*  SPDX-License-Identifier: GPL-3.0-or-later
+
+    Copyright (C) 2022  Povilas Kanapickas <povilas@radix.lt>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "util/trace.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace sanescan {
+
+namespace {
+
+std::string read_file(const std::filesystem::path& path)
+{
+    std::ifstream stream(path);
+    std::stringstream contents;
+    contents << stream.rdbuf();
+    return contents.str();
+}
+
+} // namespace
+
+TEST(Trace, DisabledByDefault)
+{
+    ASSERT_FALSE(trace_enabled());
+    {
+        SANESCAN_TRACE_SPAN("test", "span");
+        trace_counter("counter", 1);
+    }
+    ASSERT_FALSE(trace_enabled());
+}
+
+TEST(Trace, WritesEvents)
+{
+    auto path = std::filesystem::temp_directory_path() / "sanescan_trace_test.json";
+
+    trace_start(path.string());
+    ASSERT_TRUE(trace_enabled());
+    trace_set_thread_name("main \"thread\"");
+    {
+        SANESCAN_TRACE_SPAN("test", "outer");
+        std::thread([]()
+        {
+            SANESCAN_TRACE_SPAN("test", "in_thread");
+        }).join();
+        trace_instant("test", "instant");
+        trace_counter("counter", 42);
+    }
+    trace_stop();
+    ASSERT_FALSE(trace_enabled());
+
+    // Events after the trace is stopped are ignored
+    trace_counter("ignored_counter", 1);
+
+    auto contents = read_file(path);
+    std::filesystem::remove(path);
+
+    ASSERT_TRUE(contents.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    ASSERT_NE(contents.find(R"("name":"thread_name","pid":1,"tid":)"), std::string::npos);
+    ASSERT_NE(contents.find(R"("args":{"name":"main \"thread\""})"), std::string::npos);
+    ASSERT_NE(contents.find(R"({"ph":"X","name":"outer","cat":"test")"), std::string::npos);
+    ASSERT_NE(contents.find(R"({"ph":"X","name":"in_thread","cat":"test")"), std::string::npos);
+    ASSERT_NE(contents.find(R"({"ph":"i","name":"instant","cat":"test")"), std::string::npos);
+    ASSERT_NE(contents.find(R"("args":{"value":42})"), std::string::npos);
+    ASSERT_EQ(contents.find("ignored_counter"), std::string::npos);
+}
+
+} // namespace sanescan